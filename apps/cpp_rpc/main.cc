@@ -36,7 +36,9 @@
 
 #include "../../src/support/socket.h"
 #include "../../src/support/utils.h"
+#include "rpc_proxy.h"
 #include "rpc_server.h"
+#include "rpc_tracker.h"
 
 #if defined(_WIN32)
 #include "win32_process.h"
@@ -61,6 +63,29 @@ static const string kUsage =
     "  Example\n"
     "  ./tvm_rpc server --host=0.0.0.0 --port=9000 --port-end=9090 "
     " --tracker=127.0.0.1:9190 --key=rasp"
+    "\n"
+    "\n"
+    " tracker      - Start the tracker\n"
+    "--host        - The hostname of the tracker, Default=0.0.0.0\n"
+    "--port        - The port of the tracker, Default=9190\n"
+    "--port-end    - The end search port of the tracker, Default=9199\n"
+    "--stop-key    - The key a client must send to stop the tracker. Default=\"\"\n"
+    "--timeout     - Seconds a waiting server may stay silent before it is dropped, "
+    "0 disables. Default=30\n"
+    "--silent      - Whether to run in silent mode. Default=False\n"
+    "\n"
+    " proxy        - Start the proxy\n"
+    "--host        - The hostname of the proxy, Default=0.0.0.0\n"
+    "--port        - The port of the proxy, Default=9090\n"
+    "--port-end    - The end search port of the proxy, Default=9199\n"
+    "--tracker     - The RPC tracker address in host:port format e.g. 10.1.1.2:9190 Default=\"\"\n"
+    "--timeout-client - Seconds a client waits for its server. Default=600\n"
+    "--timeout-server - Seconds a server waits for its client. Default=600\n"
+    "--silent      - Whether to run in silent mode. Default=False\n"
+    "\n"
+    "  Example\n"
+    "  ./tvm_rpc tracker --port=9190\n"
+    "  ./tvm_rpc proxy --port=9090 --tracker=127.0.0.1:9190"
     "\n";
 
 /*!
@@ -168,48 +193,81 @@ bool ValidateTracker(string& tracker) {
 }
 
 /*!
- * \brief ParseCmdArgs parses the command line arguments.
+ * \brief ParseListenArgs parses the options shared by the server, tracker and proxy.
  * \param argc arg counter
  * \param argv arg values
- * \param args the output structure which holds the parsed values
+ * \param host The hostname to listen on.
+ * \param port The start of the port search range.
+ * \param port_end The end of the port search range.
+ * \param silent Whether to run in silent mode.
  */
-void ParseCmdArgs(int argc, char* argv[], struct RpcServerArgs& args) {
-  const string silent = GetCmdOption(argc, argv, "--silent", true);
-  if (!silent.empty()) {
-    args.silent = true;
+void ParseListenArgs(int argc, char* argv[], string* host, int* port, int* port_end,
+                     bool* silent) {
+  const string silent_opt = GetCmdOption(argc, argv, "--silent", true);
+  if (!silent_opt.empty()) {
+    *silent = true;
     // Only errors and fatal is logged
     dmlc::InitLogging("--minloglevel=2");
   }
 
-  const string host = GetCmdOption(argc, argv, "--host=");
-  if (!host.empty()) {
-    if (!ValidateIP(host)) {
+  const string host_opt = GetCmdOption(argc, argv, "--host=");
+  if (!host_opt.empty()) {
+    if (!ValidateIP(host_opt)) {
       LOG(WARNING) << "Wrong host address format.";
       LOG(INFO) << kUsage;
       exit(1);
     }
-    args.host = host;
+    *host = host_opt;
   }
 
-  const string port = GetCmdOption(argc, argv, "--port=");
-  if (!port.empty()) {
-    if (!IsNumber(port) || stoi(port) > 65535) {
+  const string port_opt = GetCmdOption(argc, argv, "--port=");
+  if (!port_opt.empty()) {
+    if (!IsNumber(port_opt) || stoi(port_opt) > 65535) {
       LOG(WARNING) << "Wrong port number.";
       LOG(INFO) << kUsage;
       exit(1);
     }
-    args.port = stoi(port);
+    *port = stoi(port_opt);
   }
 
-  const string port_end = GetCmdOption(argc, argv, "--port-end=");
-  if (!port_end.empty()) {
-    if (!IsNumber(port_end) || stoi(port_end) > 65535) {
+  const string port_end_opt = GetCmdOption(argc, argv, "--port-end=");
+  if (!port_end_opt.empty()) {
+    if (!IsNumber(port_end_opt) || stoi(port_end_opt) > 65535) {
       LOG(WARNING) << "Wrong port-end number.";
       LOG(INFO) << kUsage;
       exit(1);
     }
-    args.port_end = stoi(port_end);
+    *port_end = stoi(port_end_opt);
+  }
+}
+
+/*!
+ * \brief ParseSeconds parses a duration option in seconds.
+ * \param argc arg counter
+ * \param argv arg values
+ * \param option command line option to search for.
+ * \param value The parsed value, unchanged if the option is absent.
+ */
+void ParseSeconds(int argc, char* argv[], const string& option, int* value) {
+  const string seconds = GetCmdOption(argc, argv, option);
+  if (!seconds.empty()) {
+    if (!IsNumber(seconds)) {
+      LOG(WARNING) << "Wrong " << option.substr(0, option.size() - 1) << " value.";
+      LOG(INFO) << kUsage;
+      exit(1);
+    }
+    *value = stoi(seconds);
   }
+}
+
+/*!
+ * \brief ParseCmdArgs parses the command line arguments.
+ * \param argc arg counter
+ * \param argv arg values
+ * \param args the output structure which holds the parsed values
+ */
+void ParseCmdArgs(int argc, char* argv[], struct RpcServerArgs& args) {
+  ParseListenArgs(argc, argv, &args.host, &args.port, &args.port_end, &args.silent);
 
   string tracker = GetCmdOption(argc, argv, "--tracker=");
   if (!tracker.empty()) {
@@ -286,6 +344,63 @@ int RpcServer(int argc, char* argv[]) {
   return 0;
 }
 
+/*!
+ * \brief RpcTracker Starts the RPC tracker.
+ * \param argc arg counter
+ * \param argv arg values
+ * \return result of operation.
+ */
+int RpcTracker(int argc, char* argv[]) {
+  string host = "0.0.0.0";
+  int port = 9190;
+  int port_end = 9199;
+  int timeout = 30;
+  bool silent = false;
+  ParseListenArgs(argc, argv, &host, &port, &port_end, &silent);
+  ParseSeconds(argc, argv, "--timeout=", &timeout);
+  const string stop_key = GetCmdOption(argc, argv, "--stop-key=");
+
+  LOG(INFO) << "Starting CPP Tracker, Press Ctrl+C to stop.";
+#if defined(__linux__) || defined(__ANDROID__)
+  // Ctrl+C handler
+  HandleCtrlC();
+#endif
+  RPCTrackerCreate(host, port, port_end, stop_key, timeout, silent);
+  return 0;
+}
+
+/*!
+ * \brief RpcProxy Starts the RPC proxy.
+ * \param argc arg counter
+ * \param argv arg values
+ * \return result of operation.
+ */
+int RpcProxy(int argc, char* argv[]) {
+  string host = "0.0.0.0";
+  int port = 9090;
+  int port_end = 9199;
+  int timeout_client = 600;
+  int timeout_server = 600;
+  bool silent = false;
+  ParseListenArgs(argc, argv, &host, &port, &port_end, &silent);
+  ParseSeconds(argc, argv, "--timeout-client=", &timeout_client);
+  ParseSeconds(argc, argv, "--timeout-server=", &timeout_server);
+  string tracker = GetCmdOption(argc, argv, "--tracker=");
+  if (!tracker.empty() && !ValidateTracker(tracker)) {
+    LOG(WARNING) << "Wrong tracker address format.";
+    LOG(INFO) << kUsage;
+    exit(1);
+  }
+
+  LOG(INFO) << "Starting CPP Proxy, Press Ctrl+C to stop.";
+#if defined(__linux__) || defined(__ANDROID__)
+  // Ctrl+C handler
+  HandleCtrlC();
+#endif
+  RPCProxyCreate(host, port, port_end, tracker, timeout_client, timeout_server, silent);
+  return 0;
+}
+
 /*!
  * \brief main The main function.
  * \param argc arg counter
@@ -307,6 +422,12 @@ int main(int argc, char* argv[]) {
   if (0 == strcmp(argv[1], "server")) {
     return RpcServer(argc, argv);
   }
+  if (0 == strcmp(argv[1], "tracker")) {
+    return RpcTracker(argc, argv);
+  }
+  if (0 == strcmp(argv[1], "proxy")) {
+    return RpcProxy(argc, argv);
+  }
 
   LOG(INFO) << kUsage;
 
@@ -0,0 +1,527 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rpc_event_loop.h
+ * \brief Single threaded event loop shared by the RPC tracker and proxy.
+ *
+ *  The loop waits on epoll on Linux and falls back to poll on other
+ *  platforms. Sockets are level triggered, each readiness event reads at
+ *  most one chunk so that a busy connection cannot starve the others.
+ */
+#ifndef TVM_APPS_CPP_RPC_EVENT_LOOP_H_
+#define TVM_APPS_CPP_RPC_EVENT_LOOP_H_
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+#include <tvm/runtime/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../src/support/socket.h"
+
+namespace tvm {
+namespace runtime {
+
+/*! \brief A readiness based event loop with one shot timers. */
+class EventLoop {
+ public:
+  using SockType = support::TCPSocket::SockType;
+  using Clock = std::chrono::steady_clock;
+  /*!
+   * \brief Callback on socket readiness.
+   *  Errors and hang ups are reported as readable so that the next receive observes them.
+   */
+  using Handler = std::function<void(bool readable, bool writable)>;
+
+  EventLoop() {
+#if defined(__linux__)
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) support::Socket::Error("epoll_create1");
+#endif
+  }
+
+  ~EventLoop() {
+#if defined(__linux__)
+    close(epoll_fd_);
+#endif
+  }
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  /*!
+   * \brief Start watching a socket.
+   * \param fd The socket.
+   * \param read Whether to watch for read readiness.
+   * \param write Whether to watch for write readiness.
+   * \param handler The callback.
+   */
+  void Watch(SockType fd, bool read, bool write, Handler handler) {
+    ICHECK(!token_of_.count(fd)) << "Socket is already watched";
+    auto entry = std::make_shared<Entry>();
+    entry->fd = fd;
+    entry->read = read;
+    entry->write = write;
+    entry->token = ++next_token_;
+    entry->handler = std::move(handler);
+    token_of_[fd] = entry->token;
+    entries_[entry->token] = entry;
+#if defined(__linux__)
+    epoll_event ev = MakeEvent(*entry);
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) support::Socket::Error("epoll_ctl");
+#endif
+  }
+
+  /*!
+   * \brief Change the readiness a watched socket waits for.
+   * \param fd The socket.
+   * \param read Whether to watch for read readiness.
+   * \param write Whether to watch for write readiness.
+   */
+  void Update(SockType fd, bool read, bool write) {
+    auto it = token_of_.find(fd);
+    ICHECK(it != token_of_.end()) << "Socket is not watched";
+    Entry* entry = entries_.at(it->second).get();
+    if (entry->read == read && entry->write == write) return;
+    entry->read = read;
+    entry->write = write;
+#if defined(__linux__)
+    epoll_event ev = MakeEvent(*entry);
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) != 0) support::Socket::Error("epoll_ctl");
+#endif
+  }
+
+  /*!
+   * \brief Stop watching a socket, must be called before the socket is closed.
+   *  Events of the socket already collected in the current iteration are dropped.
+   * \param fd The socket.
+   */
+  void Remove(SockType fd) {
+    auto it = token_of_.find(fd);
+    if (it == token_of_.end()) return;
+#if defined(__linux__)
+    epoll_event ev;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &ev);
+#endif
+    entries_.erase(it->second);
+    token_of_.erase(it);
+  }
+
+  /*!
+   * \brief Run a function once after a delay.
+   * \param seconds The delay.
+   * \param f The function.
+   */
+  void CallLater(double seconds, std::function<void()> f) {
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(seconds));
+    timers_.push(Timer{deadline, ++next_timer_, std::move(f)});
+  }
+
+  /*! \brief Make Run return after the current iteration. */
+  void Stop() { running_ = false; }
+
+  /*! \brief Dispatch events until Stop is called. */
+  void Run() {
+    running_ = true;
+    std::vector<std::pair<uint64_t, uint32_t>> ready;
+    while (running_) {
+      ready.clear();
+      Wait(NextTimeoutMs(), &ready);
+      for (const auto& kv : ready) {
+        auto it = entries_.find(kv.first);
+        if (it == entries_.end()) continue;
+        // Keep the handler alive while it possibly removes itself.
+        std::shared_ptr<Entry> entry = it->second;
+        entry->handler((kv.second & kReadable) != 0, (kv.second & kWritable) != 0);
+        if (!running_) return;
+      }
+      RunDueTimers();
+    }
+  }
+
+ private:
+  static constexpr uint32_t kReadable = 1;
+  static constexpr uint32_t kWritable = 2;
+
+  struct Entry {
+    SockType fd;
+    bool read;
+    bool write;
+    uint64_t token;
+    Handler handler;
+  };
+
+  struct Timer {
+    Clock::time_point deadline;
+    uint64_t seq;
+    std::function<void()> f;
+    bool operator<(const Timer& other) const {
+      // std::priority_queue is a max heap, the earliest deadline goes first.
+      if (deadline != other.deadline) return deadline > other.deadline;
+      return seq > other.seq;
+    }
+  };
+
+  int NextTimeoutMs() const {
+    if (timers_.empty()) return -1;
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(timers_.top().deadline -
+                                                                      Clock::now())
+                    .count();
+    // Round up so that the timer is due when the wait returns.
+    return static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(wait + 1, 60000)));
+  }
+
+  void RunDueTimers() {
+    auto now = Clock::now();
+    while (running_ && !timers_.empty() && timers_.top().deadline <= now) {
+      std::function<void()> f = std::move(const_cast<Timer&>(timers_.top()).f);
+      timers_.pop();
+      f();
+    }
+  }
+
+#if defined(__linux__)
+  static epoll_event MakeEvent(const Entry& entry) {
+    epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = (entry.read ? EPOLLIN : 0) | (entry.write ? EPOLLOUT : 0);
+    ev.data.u64 = entry.token;
+    return ev;
+  }
+
+  void Wait(int timeout_ms, std::vector<std::pair<uint64_t, uint32_t>>* ready) {
+    events_.resize(std::max<size_t>(64, std::min<size_t>(entries_.size(), 4096)));
+    int n = epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()), timeout_ms);
+    if (n < 0) {
+      if (errno == EINTR) return;
+      support::Socket::Error("epoll_wait");
+    }
+    for (int i = 0; i < n; ++i) {
+      uint32_t flags = 0;
+      if (events_[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) flags |= kReadable;
+      if (events_[i].events & EPOLLOUT) flags |= kWritable;
+      uint64_t token = events_[i].data.u64;
+      ready->emplace_back(token, flags);
+    }
+  }
+
+  int epoll_fd_{-1};
+  std::vector<epoll_event> events_;
+#else
+  void Wait(int timeout_ms, std::vector<std::pair<uint64_t, uint32_t>>* ready) {
+    std::vector<pollfd> fds;
+    std::vector<uint64_t> tokens;
+    fds.reserve(entries_.size());
+    tokens.reserve(entries_.size());
+    for (const auto& kv : entries_) {
+      pollfd pfd;
+      pfd.fd = kv.second->fd;
+      pfd.events = (kv.second->read ? POLLIN : 0) | (kv.second->write ? POLLOUT : 0);
+      pfd.revents = 0;
+      fds.push_back(pfd);
+      tokens.push_back(kv.first);
+    }
+    int n = poll(fds.data(), fds.size(), timeout_ms);
+    if (n < 0) {
+      if (support::Socket::GetLastErrorCode() == EINTR) return;
+      support::Socket::Error("poll");
+    }
+    for (size_t i = 0; i < fds.size(); ++i) {
+      uint32_t flags = 0;
+      if (fds[i].revents & (POLLIN | POLLERR | POLLHUP)) flags |= kReadable;
+      if (fds[i].revents & POLLOUT) flags |= kWritable;
+      if (flags) ready->emplace_back(tokens[i], flags);
+    }
+  }
+#endif
+
+  bool running_{false};
+  uint64_t next_token_{0};
+  uint64_t next_timer_{0};
+  std::unordered_map<SockType, uint64_t> token_of_;
+  std::unordered_map<uint64_t, std::shared_ptr<Entry>> entries_;
+  std::priority_queue<Timer> timers_;
+};
+
+/*!
+ * \brief A non-blocking connection driven by an EventLoop.
+ *
+ *  Outgoing bytes are buffered and flushed as the socket becomes writable,
+ *  incoming bytes are handed to OnData as they arrive.
+ */
+class EventConnection : public std::enable_shared_from_this<EventConnection> {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param loop The event loop.
+   * \param sock The connected socket, the connection takes ownership.
+   * \param peer_host The host of the peer.
+   */
+  EventConnection(EventLoop* loop, support::TCPSocket sock, std::string peer_host)
+      : loop_(loop), sock_(sock), peer_host_(std::move(peer_host)) {
+    last_active_ = EventLoop::Clock::now();
+  }
+
+  virtual ~EventConnection() {
+    if (!sock_.IsClosed()) sock_.Close();
+  }
+
+  /*! \brief Register the connection with the loop. */
+  void Start() {
+    sock_.SetNonBlock(true);
+    sock_.SetKeepAlive(true);
+    std::shared_ptr<EventConnection> self = shared_from_this();
+    loop_->Watch(sock_.sockfd, true, PendingBytes() != 0, [self](bool readable, bool writable) {
+      if (writable) self->OnWritable();
+      if (readable) self->OnReadable();
+    });
+  }
+
+  /*!
+   * \brief Connect the socket to an address and register the connection with the loop.
+   *  The connect completes in the background, bytes written meanwhile are sent once it does.
+   * \param addr The address to connect to.
+   * \return Whether the connect was started, the connection is closed otherwise.
+   */
+  bool StartConnect(const support::SockAddr& addr) {
+    sock_.SetNonBlock(true);
+    connecting_ = !sock_.Connect(addr);
+    if (connecting_ && !ConnectInProgress()) {
+      LOG(INFO) << "Connect to " << addr.AsString() << " failed with error "
+                << support::Socket::GetLastErrorCode();
+      sock_.Close();
+      closed_ = true;
+      return false;
+    }
+    Start();
+    UpdateWatch();
+    return true;
+  }
+
+  /*!
+   * \brief Queue bytes to the peer.
+   * \param data The data.
+   * \param size The number of bytes.
+   */
+  void Write(const void* data, size_t size) {
+    if (closed_) return;
+    out_.append(static_cast<const char*>(data), size);
+    Flush();
+  }
+
+  /*!
+   * \brief Queue a [int32 size][bytes] message to the peer.
+   * \param data The message.
+   */
+  void WriteMessage(const std::string& data) {
+    int32_t len = static_cast<int32_t>(data.size());
+    Write(&len, sizeof(len));
+    Write(data.data(), data.size());
+  }
+
+  /*! \brief Close the connection now, pending output is dropped. */
+  void Close() {
+    if (closed_) return;
+    // The loop may hold the last reference to this connection.
+    std::shared_ptr<EventConnection> self = shared_from_this();
+    closed_ = true;
+    loop_->Remove(sock_.sockfd);
+    sock_.Close();
+    out_.clear();
+    out_offset_ = 0;
+    OnClose();
+  }
+
+  /*! \brief Close the connection once the pending output has been sent. */
+  void CloseAfterFlush() {
+    if (closed_) return;
+    close_after_flush_ = true;
+    read_paused_ = true;
+    if (PendingBytes() == 0) {
+      Close();
+    } else {
+      UpdateWatch();
+    }
+  }
+
+  /*!
+   * \brief Stop or resume reading from the peer.
+   * \param paused Whether reading is paused.
+   */
+  void SetReadPaused(bool paused) {
+    if (closed_ || close_after_flush_) return;
+    read_paused_ = paused;
+    UpdateWatch();
+  }
+
+  /*! \return The number of bytes queued but not yet sent. */
+  size_t PendingBytes() const { return out_.size() - out_offset_; }
+  /*! \return Whether the connection is closed. */
+  bool closed() const { return closed_; }
+  /*! \return The host of the peer. */
+  const std::string& peer_host() const { return peer_host_; }
+  /*! \return The last time data arrived from the peer. */
+  EventLoop::Clock::time_point last_active() const { return last_active_; }
+
+ protected:
+  /*!
+   * \brief Called with bytes received from the peer.
+   * \param data The received bytes.
+   * \param size The number of bytes.
+   */
+  virtual void OnData(const char* data, size_t size) = 0;
+  /*! \brief Called once when the connection is closed. */
+  virtual void OnClose() {}
+  /*! \brief Called when all queued bytes have been sent. */
+  virtual void OnDrain() {}
+
+  /*! \brief The event loop. */
+  EventLoop* loop_;
+
+ private:
+  static constexpr size_t kChunkSize = 64 << 10;
+
+  static bool ConnectInProgress() {
+    int errsv = support::Socket::GetLastErrorCode();
+#ifdef _WIN32
+    return errsv == WSAEWOULDBLOCK;
+#else
+    return errsv == EINPROGRESS || errsv == EINTR;
+#endif
+  }
+
+  void UpdateWatch() {
+    if (closed_) return;
+    if (connecting_) {
+      loop_->Update(sock_.sockfd, false, true);
+      return;
+    }
+    loop_->Update(sock_.sockfd, !read_paused_, PendingBytes() != 0);
+  }
+
+  void Flush() {
+    if (connecting_) {
+      UpdateWatch();
+      return;
+    }
+    while (PendingBytes() != 0) {
+      ssize_t n = sock_.Send(out_.data() + out_offset_, PendingBytes());
+      if (n < 0) {
+        if (support::Socket::LastErrorWouldBlock()) break;
+        Close();
+        return;
+      }
+      out_offset_ += n;
+    }
+    if (PendingBytes() == 0) {
+      out_.clear();
+      out_offset_ = 0;
+    } else if (out_offset_ > out_.size() / 2) {
+      out_.erase(0, out_offset_);
+      out_offset_ = 0;
+    }
+    UpdateWatch();
+  }
+
+  void OnWritable() {
+    if (closed_) return;
+    if (connecting_) {
+      int err = sock_.GetSockError();
+      if (err != 0) {
+        LOG(INFO) << "Connect to " << peer_host_ << " failed with error " << err;
+        Close();
+        return;
+      }
+      connecting_ = false;
+    }
+    Flush();
+    if (closed_ || PendingBytes() != 0) return;
+    if (close_after_flush_) {
+      Close();
+    } else {
+      OnDrain();
+    }
+  }
+
+  void OnReadable() {
+    // A paused connection can still see a pending event of this iteration.
+    if (closed_ || read_paused_) return;
+    char buf[kChunkSize];
+    ssize_t n = sock_.Recv(buf, sizeof(buf));
+    if (n < 0 && support::Socket::LastErrorWouldBlock()) return;
+    if (n <= 0) {
+      Close();
+      return;
+    }
+    last_active_ = EventLoop::Clock::now();
+    OnData(buf, static_cast<size_t>(n));
+  }
+
+  support::TCPSocket sock_;
+  std::string peer_host_;
+  std::string out_;
+  size_t out_offset_{0};
+  bool closed_{false};
+  bool connecting_{false};
+  bool close_after_flush_{false};
+  bool read_paused_{false};
+  EventLoop::Clock::time_point last_active_;
+};
+
+/*!
+ * \brief Create a non-blocking listen socket on the first free port of a range.
+ * \param sock The socket to create.
+ * \param host The hostname to bind.
+ * \param port_start The start of the port range.
+ * \param port_end The end of the port range, exclusive.
+ * \return The bound port.
+ */
+inline int CreateListenSocket(support::TCPSocket* sock, const std::string& host, int port_start,
+                              int port_end) {
+  sock->Create(support::SockAddr(host.c_str(), port_start).ss_family());
+#if !defined(_WIN32)
+  // Restarting must not wait for the sockets of the last run to leave TIME_WAIT. Windows lets
+  // active sockets share the port with this option, so it is only set elsewhere.
+  int reuse = 1;
+  setsockopt(sock->sockfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+#endif
+  int port = sock->TryBindHost(host, port_start, port_end);
+  ICHECK_NE(port, -1) << "cannot bind to any port in [" << port_start << ", " << port_end << ")";
+  sock->Listen(1024);
+  sock->SetNonBlock(true);
+  return port;
+}
+
+}  // namespace runtime
+}  // namespace tvm
+#endif  // TVM_APPS_CPP_RPC_EVENT_LOOP_H_
@@ -0,0 +1,608 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rpc_proxy.cc
+ * \brief RPC Proxy implementation.
+ *
+ *  Both ends start with [RPC magic][int32 key length][key] where the key is
+ *  "server:<match key>" or "client:<match key>". Once a server and a client
+ *  with the same match key are paired, each receives [RPC success][int32
+ *  key length][key of the other end] and the proxy forwards bytes between
+ *  them, pausing a side whose peer is not draining its data.
+ */
+#define PICOJSON_USE_INT64
+#include "rpc_proxy.h"
+
+#if !defined(_WIN32)
+#include <signal.h>
+#endif
+#include <picojson.h>
+
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../src/runtime/rpc/rpc_endpoint.h"
+#include "../../src/support/socket.h"
+#include "rpc_event_loop.h"
+
+namespace tvm {
+namespace runtime {
+namespace {
+
+/*! \brief Longest key accepted during the handshake. */
+constexpr int32_t kMaxKeyLength = 4096;
+/*! \brief Bytes queued towards one end before the other end stops being read. */
+constexpr size_t kMaxPendingBytes = 4 << 20;
+/*! \brief Seconds between two tracker updates. */
+constexpr double kUpdateTrackerPeriod = 2;
+/*! \brief Seconds a server key handed out by the tracker may stay unused. */
+constexpr double kTimeoutAlloc = 5;
+
+std::string HostOf(const support::SockAddr& addr) {
+  std::string host = addr.AsString();
+  return host.substr(0, host.rfind(':'));
+}
+
+class RPCProxy;
+
+/*! \brief One end of a proxied RPC session. */
+class ProxyConnection : public EventConnection {
+ public:
+  ProxyConnection(RPCProxy* proxy, EventLoop* loop, support::TCPSocket sock, std::string peer_host)
+      : EventConnection(loop, sock, std::move(peer_host)), proxy_(proxy) {}
+
+  /*! \return The key sent by this end. */
+  const std::string& rpc_key() const { return rpc_key_; }
+  /*! \return Whether this end is a server. */
+  bool is_server() const { return rpc_key_.rfind("server:", 0) == 0; }
+  /*! \return The name of this end used in logs. */
+  std::string name() const { return "TCPSocketProxy:" + peer_host() + ":" + rpc_key_; }
+
+  /*!
+   * \brief Start forwarding between this end and the other.
+   * \param other The other end.
+   */
+  void PairWith(std::shared_ptr<ProxyConnection> other) {
+    int32_t code = kRPCSuccess;
+    int32_t keylen = static_cast<int32_t>(other->rpc_key().size());
+    Write(&code, sizeof(code));
+    Write(&keylen, sizeof(keylen));
+    Write(other->rpc_key().data(), other->rpc_key().size());
+    forward_ = std::move(other);
+  }
+
+  /*!
+   * \brief Reply an error code and close.
+   * \param code The error code.
+   */
+  void Reject(int32_t code) {
+    Write(&code, sizeof(code));
+    CloseAfterFlush();
+  }
+
+  /*! \brief The key used for matching. */
+  std::string match_key;
+  /*! \brief Whether alloc_time is set. */
+  bool allocated{false};
+  /*! \brief When the tracker first reported the key of this server as taken. */
+  EventLoop::Clock::time_point alloc_time;
+
+ protected:
+  void OnData(const char* data, size_t size) final;
+  void OnClose() final;
+  void OnDrain() final {
+    if (forward_) forward_->SetReadPaused(false);
+  }
+
+ private:
+  RPCProxy* proxy_;
+  std::string in_;
+  std::string rpc_key_;
+  bool handshake_done_{false};
+  std::shared_ptr<ProxyConnection> forward_;
+};
+
+/*!
+ * \brief The connection of the proxy to the tracker.
+ *
+ *  Requests are pipelined, the tracker answers them in order. The first four
+ *  bytes of the reply are the tracker magic, then each reply is a
+ *  [int32 size][json] message.
+ */
+class TrackerConnection : public EventConnection {
+ public:
+  /*! \brief Called with each reply of the tracker. */
+  using FReply = std::function<void(const std::string& reply)>;
+
+  TrackerConnection(RPCProxy* proxy, EventLoop* loop, std::string tracker_addr)
+      : EventConnection(loop, CreateSocket(tracker_addr), tracker_addr), proxy_(proxy) {}
+
+  /*!
+   * \brief Send a request.
+   * \param request The json request.
+   * \param freply The callback of the reply.
+   */
+  void Request(const std::string& request, FReply freply) {
+    if (closed()) return;
+    pending_replies_.push_back(std::move(freply));
+    WriteMessage(request);
+  }
+
+  /*! \return The number of requests waiting for their reply. */
+  size_t NumPendingReplies() const { return pending_replies_.size(); }
+
+ protected:
+  void OnData(const char* data, size_t size) final;
+  void OnClose() final;
+
+ private:
+  static support::TCPSocket CreateSocket(const std::string& tracker_addr) {
+    support::TCPSocket sock;
+    sock.Create(support::SockAddr(tracker_addr).ss_family());
+    return sock;
+  }
+
+  RPCProxy* proxy_;
+  std::string in_;
+  bool magic_checked_{false};
+  std::deque<FReply> pending_replies_;
+};
+
+/*! \brief The proxy state shared by all connections. */
+class RPCProxy {
+ public:
+  RPCProxy(std::string host, int port_search_start, int port_search_end, std::string tracker_addr,
+           int timeout_client, int timeout_server)
+      : host_(std::move(host)),
+        port_search_start_(port_search_start),
+        port_search_end_(port_search_end),
+        tracker_addr_(std::move(tracker_addr)),
+        timeout_client_(timeout_client),
+        timeout_server_(timeout_server),
+        gen_(std::random_device{}()),
+        dis_(0.0, 1.0) {}
+
+  ~RPCProxy() {
+    if (!listen_sock_.IsClosed()) listen_sock_.Close();
+  }
+
+  /*! \brief Bind the listen socket and serve forever. */
+  void Start() {
+    my_port_ = CreateListenSocket(&listen_sock_, host_, port_search_start_, port_search_end_);
+    LOG(INFO) << "RPCProxy: client port bind to " << host_ << ":" << my_port_;
+    loop_.Watch(listen_sock_.sockfd, true, false, [this](bool, bool) { AcceptAll(); });
+    if (!tracker_addr_.empty()) {
+      LOG(INFO) << "Tracker address:" << tracker_addr_;
+      loop_.CallLater(kUpdateTrackerPeriod, [this]() { UpdateTracker(true); });
+    }
+    loop_.Run();
+  }
+
+  /*!
+   * \brief Report an end that completed the handshake.
+   * \param conn The connection.
+   */
+  void HandlerReady(std::shared_ptr<ProxyConnection> conn) {
+    LOG(INFO) << "Handler ready " << conn->name();
+    if (!tracker_addr_.empty()) {
+      HandlerReadyTrackerMode(std::move(conn));
+    } else {
+      HandlerReadyProxyMode(std::move(conn));
+    }
+  }
+
+  /*! \brief Forget the tracker connection once it is lost, it is reopened by the next update. */
+  void OnTrackerLost() {
+    LOG(INFO) << "Lost tracker connection, try reconnect in " << kUpdateTrackerPeriod << " sec";
+    tracker_.reset();
+    key_set_.clear();
+    RegenerateServerKeys(ServerKeys());
+  }
+
+  /*!
+   * \brief Drop a closed end from the pools.
+   * \param conn The connection.
+   */
+  void RemoveConnection(ProxyConnection* conn) {
+    if (conn->match_key.empty()) return;
+    for (auto* pool : {&client_pool_, &server_pool_}) {
+      auto it = pool->find(conn->match_key);
+      if (it != pool->end() && it->second.get() == conn) pool->erase(it);
+    }
+  }
+
+ private:
+  using Pool = std::unordered_map<std::string, std::shared_ptr<ProxyConnection>>;
+
+  void AcceptAll() {
+    while (true) {
+      support::SockAddr addr;
+      socklen_t addrlen = sizeof(addr.addr);
+      support::TCPSocket sock(
+          accept(listen_sock_.sockfd, reinterpret_cast<sockaddr*>(&addr.addr), &addrlen));
+      if (sock.IsClosed()) {
+        if (!support::Socket::LastErrorWouldBlock() &&
+            support::Socket::GetLastErrorCode() != EINTR) {
+          LOG(WARNING) << "Accept failed with error " << support::Socket::GetLastErrorCode();
+        }
+        return;
+      }
+      auto conn = std::make_shared<ProxyConnection>(this, &loop_, sock, HostOf(addr));
+      conn->Start();
+    }
+  }
+
+  void PairUp(std::shared_ptr<ProxyConnection> lhs, std::shared_ptr<ProxyConnection> rhs) {
+    lhs->PairWith(rhs);
+    rhs->PairWith(lhs);
+    LOG(INFO) << "Pairup connect " << lhs->name() << " and " << rhs->name();
+  }
+
+  void HandlerReadyProxyMode(std::shared_ptr<ProxyConnection> conn) {
+    bool is_server = conn->is_server();
+    Pool* pool_src = is_server ? &client_pool_ : &server_pool_;
+    Pool* pool_dst = is_server ? &server_pool_ : &client_pool_;
+    int timeout = is_server ? timeout_server_ : timeout_client_;
+    const std::string key = conn->match_key;
+
+    auto it = pool_src->find(key);
+    if (it != pool_src->end()) {
+      std::shared_ptr<ProxyConnection> other = it->second;
+      pool_src->erase(it);
+      PairUp(other, conn);
+      return;
+    }
+    if (pool_dst->count(key)) {
+      LOG(INFO) << "Duplicate connection with same key=" << key;
+      conn->Reject(kRPCDuplicate);
+      return;
+    }
+    (*pool_dst)[key] = conn;
+    std::weak_ptr<ProxyConnection> weak = conn;
+    loop_.CallLater(timeout, [pool_dst, key, weak]() {
+      std::shared_ptr<ProxyConnection> conn = weak.lock();
+      auto it = pool_dst->find(key);
+      if (conn && it != pool_dst->end() && it->second == conn) {
+        LOG(INFO) << "Timeout client connection " << conn->name()
+                  << ", cannot find match key=" << key;
+        pool_dst->erase(it);
+        conn->Reject(kRPCMismatch);
+      }
+    });
+  }
+
+  void HandlerReadyTrackerMode(std::shared_ptr<ProxyConnection> conn) {
+    if (conn->is_server()) {
+      std::string key = RandomKey(conn->match_key);
+      conn->match_key = key;
+      server_pool_[key] = conn;
+      tracker_pending_puts_.push_back(key);
+      UpdateTracker(false);
+      return;
+    }
+    auto it = server_pool_.find(conn->match_key);
+    if (it != server_pool_.end()) {
+      std::shared_ptr<ProxyConnection> server = it->second;
+      server_pool_.erase(it);
+      PairUp(server, conn);
+    } else {
+      conn->Reject(kRPCMismatch);
+    }
+  }
+
+  std::string RandomKey(const std::string& prefix) {
+    while (true) {
+      std::string key = prefix + ":" + std::to_string(dis_(gen_));
+      if (!server_pool_.count(key)) return key;
+    }
+  }
+
+  /*!
+   * \brief Give the servers a fresh key so that keys handed out but never used are invalidated.
+   * \param keys The keys to regenerate.
+   * \return The new keys.
+   */
+  std::vector<std::string> RegenerateServerKeys(const std::vector<std::string>& keys) {
+    std::vector<std::string> new_keys;
+    for (const std::string& key : keys) {
+      auto it = server_pool_.find(key);
+      if (it == server_pool_.end()) continue;
+      std::shared_ptr<ProxyConnection> conn = it->second;
+      server_pool_.erase(it);
+      std::string new_key = RandomKey(key.substr(0, key.rfind(':')));
+      conn->match_key = new_key;
+      server_pool_[new_key] = conn;
+      new_keys.push_back(new_key);
+    }
+    return new_keys;
+  }
+
+  std::vector<std::string> ServerKeys() const {
+    std::vector<std::string> keys;
+    for (const auto& kv : server_pool_) keys.push_back(kv.first);
+    return keys;
+  }
+
+  /*!
+   * \brief Send a request whose reply must be the success code.
+   *  The tracker connection is dropped on any other reply.
+   * \param request The json request.
+   */
+  void RequestExpectSuccess(const std::string& request) {
+    std::weak_ptr<TrackerConnection> weak = tracker_;
+    tracker_->Request(request, [weak](const std::string& reply) {
+      picojson::value status;
+      std::string err = picojson::parse(status, reply);
+      if (err.empty() && status.is<int64_t>() &&
+          status.get<int64_t>() == static_cast<int64_t>(TrackerCode::kSuccess)) {
+        return;
+      }
+      LOG(INFO) << "Unexpected tracker reply " << reply;
+      if (std::shared_ptr<TrackerConnection> tracker = weak.lock()) tracker->Close();
+    });
+  }
+
+  /*! \brief Open the tracker connection, all keys are reported again once it is up. */
+  void ConnectTracker() {
+    try {
+      tracker_ = std::make_shared<TrackerConnection>(this, &loop_, tracker_addr_);
+    } catch (const std::exception& err) {
+      LOG(INFO) << "Cannot connect to tracker " << tracker_addr_ << ": " << err.what();
+      return;
+    }
+    if (!tracker_->StartConnect(support::SockAddr(tracker_addr_))) {
+      tracker_.reset();
+      return;
+    }
+    int32_t magic = kRPCTrackerMagic;
+    tracker_->Write(&magic, sizeof(magic));
+    // just connect to tracker, need to update all keys
+    tracker_pending_puts_ = ServerKeys();
+  }
+
+  /*!
+   * \brief Periodically update tracker information, regenerate a key if it is not in the
+   *  tracker anymore and there is no in-coming connection after kTimeoutAlloc.
+   * \param reply The pending match keys reported by the tracker.
+   */
+  void OnPendingMatchKeys(const std::string& reply) {
+    picojson::value pending;
+    std::string err = picojson::parse(pending, reply);
+    if (!err.empty() || !pending.is<picojson::array>()) {
+      LOG(INFO) << "Invalid tracker reply " << reply;
+      tracker_->Close();
+      return;
+    }
+    std::set<std::string> pending_keys;
+    for (const auto& v : pending.get<picojson::array>()) {
+      if (v.is<std::string>()) pending_keys.insert(v.get<std::string>());
+    }
+    auto now = EventLoop::Clock::now();
+    std::vector<std::string> update_keys;
+    for (const auto& kv : server_pool_) {
+      if (pending_keys.count(kv.first)) continue;
+      ProxyConnection* conn = kv.second.get();
+      if (!conn->allocated) {
+        conn->allocated = true;
+        conn->alloc_time = now;
+      } else if (now - conn->alloc_time > std::chrono::duration<double>(kTimeoutAlloc)) {
+        update_keys.push_back(kv.first);
+        conn->allocated = false;
+      }
+    }
+    if (!update_keys.empty()) {
+      LOG(INFO) << "RPCProxy: No incoming conn on " << update_keys.size()
+                << " keys, regenerate keys...";
+      for (std::string& key : RegenerateServerKeys(update_keys)) {
+        tracker_pending_puts_.push_back(std::move(key));
+      }
+    }
+    ReportPendingPuts();
+  }
+
+  /*! \brief Report the new server keys to the tracker. */
+  void ReportPendingPuts() {
+    bool need_update_info = false;
+    // report new connections
+    for (const std::string& key : tracker_pending_puts_) {
+      std::string rpc_key = key.substr(0, key.rfind(':'));
+      picojson::array addr{picojson::value(static_cast<int64_t>(my_port_)), picojson::value(key)};
+      picojson::array put{picojson::value(static_cast<int64_t>(TrackerCode::kPut)),
+                          picojson::value(rpc_key), picojson::value(addr), picojson::value()};
+      RequestExpectSuccess(picojson::value(put).serialize());
+      if (key_set_.insert(rpc_key).second) need_update_info = true;
+    }
+    if (need_update_info) {
+      std::string keylist;
+      for (const std::string& key : key_set_) {
+        keylist += (keylist.empty() ? "" : ",") + key;
+      }
+      picojson::object cinfo;
+      cinfo["key"] = picojson::value("server:proxy[" + keylist + "]");
+      cinfo["addr"] = picojson::value(
+          picojson::array{picojson::value(), picojson::value(static_cast<int64_t>(my_port_))});
+      picojson::array update{picojson::value(static_cast<int64_t>(TrackerCode::kUpdateInfo)),
+                             picojson::value(cinfo)};
+      RequestExpectSuccess(picojson::value(update).serialize());
+    }
+    tracker_pending_puts_.clear();
+  }
+
+  /*!
+   * \brief Talk to the tracker without blocking the loop, replies are handled as they arrive.
+   * \param period_update Whether this is the periodic update rather than a new server.
+   */
+  void UpdateTracker(bool period_update) {
+    if (period_update) {
+      loop_.CallLater(kUpdateTrackerPeriod, [this]() { UpdateTracker(true); });
+    }
+    if (tracker_ == nullptr) ConnectTracker();
+    if (tracker_ == nullptr) return;
+    if (!period_update) {
+      ReportPendingPuts();
+    } else if (tracker_->NumPendingReplies() == 0) {
+      // Skip the query while the tracker has not answered the previous ones.
+      std::ostringstream ss;
+      ss << "[" << static_cast<int>(TrackerCode::kGetPendingMatchKeys) << "]";
+      tracker_->Request(ss.str(), [this](const std::string& reply) { OnPendingMatchKeys(reply); });
+    }
+  }
+
+  std::string host_;
+  int port_search_start_;
+  int port_search_end_;
+  int my_port_{0};
+  std::string tracker_addr_;
+  int timeout_client_;
+  int timeout_server_;
+  EventLoop loop_;
+  support::TCPSocket listen_sock_;
+  std::shared_ptr<TrackerConnection> tracker_;
+  Pool client_pool_;
+  Pool server_pool_;
+  std::vector<std::string> tracker_pending_puts_;
+  std::set<std::string> key_set_;
+  std::mt19937 gen_;
+  std::uniform_real_distribution<double> dis_;
+};
+
+void ProxyConnection::OnData(const char* data, size_t size) {
+  if (forward_) {
+    forward_->Write(data, size);
+    if (forward_->PendingBytes() > kMaxPendingBytes) SetReadPaused(true);
+    return;
+  }
+  if (handshake_done_) {
+    // Both ends wait for the pairing reply before they send anything.
+    LOG(INFO) << "Invalid RPC protocol, too many bytes " << name();
+    Close();
+    return;
+  }
+  in_.append(data, size);
+  if (in_.size() < 2 * sizeof(int32_t)) return;
+  int32_t magic, keylen;
+  std::memcpy(&magic, in_.data(), sizeof(magic));
+  std::memcpy(&keylen, in_.data() + sizeof(magic), sizeof(keylen));
+  if (magic != kRPCMagic || keylen <= 0 || keylen > kMaxKeyLength) {
+    LOG(INFO) << "Invalid RPC handshake from " << peer_host();
+    Close();
+    return;
+  }
+  size_t total = 2 * sizeof(int32_t) + keylen;
+  if (in_.size() < total) return;
+  if (in_.size() > total) {
+    LOG(INFO) << "Invalid RPC protocol, too many bytes " << peer_host();
+    Close();
+    return;
+  }
+  rpc_key_ = in_.substr(2 * sizeof(int32_t));
+  in_.clear();
+  handshake_done_ = true;
+  // match key is used to do the matching
+  std::istringstream is(rpc_key_.size() > 7 ? rpc_key_.substr(7) : "");
+  is >> match_key;
+  if (match_key.empty()) {
+    LOG(INFO) << "Invalid RPC key " << rpc_key_ << " from " << peer_host();
+    Close();
+    return;
+  }
+  proxy_->HandlerReady(std::static_pointer_cast<ProxyConnection>(shared_from_this()));
+}
+
+void ProxyConnection::OnClose() {
+  proxy_->RemoveConnection(this);
+  if (forward_) {
+    // Let the other end receive what is still in flight before it goes away.
+    std::shared_ptr<ProxyConnection> other = std::move(forward_);
+    other->CloseAfterFlush();
+  }
+}
+
+void TrackerConnection::OnData(const char* data, size_t size) {
+  in_.append(data, size);
+  size_t offset = 0;
+  if (!magic_checked_) {
+    if (in_.size() < sizeof(int32_t)) return;
+    int32_t magic;
+    std::memcpy(&magic, in_.data(), sizeof(magic));
+    if (magic != kRPCTrackerMagic) {
+      LOG(ERROR) << peer_host() << " is not RPC Tracker";
+      Close();
+      return;
+    }
+    magic_checked_ = true;
+    offset = sizeof(magic);
+  }
+  while (in_.size() - offset >= sizeof(int32_t)) {
+    int32_t len;
+    std::memcpy(&len, in_.data() + offset, sizeof(len));
+    if (len < 0 || pending_replies_.empty()) {
+      LOG(INFO) << "Invalid tracker reply from " << peer_host();
+      Close();
+      return;
+    }
+    if (in_.size() - offset - sizeof(len) < static_cast<size_t>(len)) break;
+    std::string reply = in_.substr(offset + sizeof(len), len);
+    offset += sizeof(len) + len;
+    FReply freply = std::move(pending_replies_.front());
+    pending_replies_.pop_front();
+    // The callback may close this connection.
+    std::shared_ptr<EventConnection> self = shared_from_this();
+    freply(reply);
+    if (closed()) return;
+  }
+  in_.erase(0, offset);
+}
+
+void TrackerConnection::OnClose() {
+  pending_replies_.clear();
+  proxy_->OnTrackerLost();
+}
+
+}  // namespace
+
+void RPCProxyCreate(std::string host, int port, int port_end, std::string tracker_addr,
+                    int timeout_client, int timeout_server, bool silent) {
+  if (silent) {
+    // Only errors and fatal is logged
+    dmlc::InitLogging("--minloglevel=2");
+  }
+#if !defined(_WIN32)
+  // Peers that vanish must not kill the proxy on the next write.
+  signal(SIGPIPE, SIG_IGN);
+#endif
+  if (host.empty()) host = "0.0.0.0";
+  RPCProxy proxy(std::move(host), port, port_end, std::move(tracker_addr), timeout_client,
+                 timeout_server);
+  proxy.Start();
+}
+
+}  // namespace runtime
+}  // namespace tvm
@@ -0,0 +1,55 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rpc_proxy.h
+ * \brief RPC Proxy implementation.
+ */
+#ifndef TVM_APPS_CPP_RPC_PROXY_H_
+#define TVM_APPS_CPP_RPC_PROXY_H_
+
+#include <string>
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief RPCProxyCreate Creates the RPC Proxy and serves until the process exits.
+ *
+ *  Servers and clients that cannot reach each other both connect to the
+ *  proxy, which pairs them by key and forwards the bytes in between. With
+ *  a tracker the proxy registers every waiting server on it, so clients
+ *  request the servers behind the proxy like any other server.
+ *
+ * \param host The hostname of the proxy, Default=0.0.0.0
+ * \param port The port of the proxy, Default=9090
+ * \param port_end The end search port of the proxy, Default=9199
+ * \param tracker_addr The address of RPC tracker in host:port format e.g. 10.77.1.234:9190
+ *        Default=""
+ * \param timeout_client Seconds a client waits for a server with its key. Default=600
+ * \param timeout_server Seconds a server waits for a client with its key. Default=600
+ * \param silent Whether run in silent mode. Default=True
+ */
+void RPCProxyCreate(std::string host = "", int port = 9090, int port_end = 9199,
+                    std::string tracker_addr = "", int timeout_client = 600,
+                    int timeout_server = 600, bool silent = true);
+
+}  // namespace runtime
+}  // namespace tvm
+#endif  // TVM_APPS_CPP_RPC_PROXY_H_
@@ -0,0 +1,470 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rpc_tracker.cc
+ * \brief RPC Tracker implementation.
+ *
+ *  All connections are served by one event loop thread. Servers report
+ *  resources with PUT, clients REQUEST them by key and are served in
+ *  priority order, ties are broken by the order of the requests.
+ */
+#define PICOJSON_USE_INT64
+#include "rpc_tracker.h"
+
+#if !defined(_WIN32)
+#include <signal.h>
+#endif
+
+#include <picojson.h>
+
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../src/runtime/rpc/rpc_endpoint.h"
+#include "../../src/support/socket.h"
+#include "rpc_event_loop.h"
+
+namespace tvm {
+namespace runtime {
+namespace {
+
+/*! \brief Largest tracker message accepted, the messages are small json documents. */
+constexpr int32_t kMaxTrackerMessageBytes = 16 << 20;
+/*! \brief Seconds a new connection has to send the tracker magic. */
+constexpr double kHandshakeTimeout = 10;
+/*! \brief Seconds between two health checks. */
+constexpr double kHealthCheckPeriod = 1;
+
+std::string HostOf(const support::SockAddr& addr) {
+  std::string host = addr.AsString();
+  return host.substr(0, host.rfind(':'));
+}
+
+picojson::value Code(TrackerCode code) {
+  return picojson::value(static_cast<int64_t>(static_cast<int>(code)));
+}
+
+class RPCTracker;
+class TrackerConnection;
+
+/*! \brief A resource reported by a server. */
+struct TrackerResource {
+  TrackerConnection* owner;
+  std::string key;
+  std::string host;
+  int64_t port;
+  std::string matchkey;
+};
+
+/*! \brief A pending request, ordered by decreasing priority then arrival. */
+struct TrackerRequest {
+  int64_t priority;
+  uint64_t seq;
+  TrackerConnection* conn;
+  bool operator<(const TrackerRequest& other) const {
+    if (priority != other.priority) return priority > other.priority;
+    return seq < other.seq;
+  }
+};
+
+/*! \brief Priority based scheduler of one key, resources are handed out FIFO. */
+class PriorityScheduler {
+ public:
+  void Put(std::shared_ptr<TrackerResource> value) {
+    values_.push_back(std::move(value));
+    Schedule();
+  }
+
+  void Request(TrackerConnection* conn, int64_t priority) {
+    requests_.insert(TrackerRequest{priority, request_cnt_++, conn});
+    Schedule();
+  }
+
+  void Remove(const TrackerResource* value) {
+    for (auto it = values_.begin(); it != values_.end(); ++it) {
+      if (it->get() == value) {
+        values_.erase(it);
+        return;
+      }
+    }
+  }
+
+  void RemoveRequests(const TrackerConnection* conn) {
+    for (auto it = requests_.begin(); it != requests_.end();) {
+      it = it->conn == conn ? requests_.erase(it) : std::next(it);
+    }
+  }
+
+  picojson::value Summary() const {
+    picojson::object res;
+    res["free"] = picojson::value(static_cast<int64_t>(values_.size()));
+    res["pending"] = picojson::value(static_cast<int64_t>(requests_.size()));
+    return picojson::value(res);
+  }
+
+ private:
+  void Schedule();
+
+  std::deque<std::shared_ptr<TrackerResource>> values_;
+  std::set<TrackerRequest> requests_;
+  uint64_t request_cnt_{0};
+};
+
+/*! \brief A connection to a server, client or proxy. */
+class TrackerConnection : public EventConnection {
+ public:
+  TrackerConnection(RPCTracker* tracker, EventLoop* loop, support::TCPSocket sock,
+                    std::string peer_host)
+      : EventConnection(loop, sock, std::move(peer_host)),
+        tracker_(tracker),
+        created_(EventLoop::Clock::now()) {}
+
+  void Reply(const picojson::value& value) { WriteMessage(value.serialize()); }
+
+  /*!
+   * \brief Hand a resource to this client.
+   * \return Whether the resource was delivered.
+   */
+  bool Deliver(const TrackerResource& value) {
+    if (closed()) return false;
+    picojson::array addr{picojson::value(value.host), picojson::value(value.port),
+                         picojson::value(value.matchkey)};
+    Reply(picojson::value(picojson::array{Code(TrackerCode::kSuccess), picojson::value(addr)}));
+    return !closed();
+  }
+
+  bool handshake_done() const { return handshake_done_; }
+  EventLoop::Clock::time_point created() const { return created_; }
+  const picojson::object& info() const { return info_; }
+
+  /*! \brief Match keys of resources of this server that are still free. */
+  std::set<std::string> pending_matchkeys;
+  /*! \brief Resources this server reported. */
+  std::vector<std::shared_ptr<TrackerResource>> put_values;
+  /*! \brief Keys this client requested. */
+  std::set<std::string> requested_keys;
+
+ protected:
+  void OnData(const char* data, size_t size) final;
+  void OnClose() final;
+
+ private:
+  void HandleMessage(const picojson::array& args);
+
+  RPCTracker* tracker_;
+  EventLoop::Clock::time_point created_;
+  bool handshake_done_{false};
+  std::string in_;
+  picojson::object info_;
+};
+
+/*! \brief The tracker state shared by all connections. */
+class RPCTracker {
+ public:
+  RPCTracker(std::string host, int port_search_start, int port_search_end, std::string stop_key,
+             int timeout)
+      : host_(std::move(host)),
+        port_search_start_(port_search_start),
+        port_search_end_(port_search_end),
+        stop_key_(std::move(stop_key)),
+        timeout_(timeout) {}
+
+  ~RPCTracker() {
+    if (!listen_sock_.IsClosed()) listen_sock_.Close();
+  }
+
+  /*! \brief Bind the listen socket and serve until stopped. */
+  void Start() {
+    my_port_ = CreateListenSocket(&listen_sock_, host_, port_search_start_, port_search_end_);
+    LOG(INFO) << "bind to " << host_ << ":" << my_port_;
+    loop_.Watch(listen_sock_.sockfd, true, false, [this](bool, bool) { AcceptAll(); });
+    loop_.CallLater(kHealthCheckPeriod, [this]() { HealthCheck(); });
+    loop_.Run();
+    std::vector<std::shared_ptr<TrackerConnection>> conns;
+    for (const auto& kv : conns_) conns.push_back(kv.second);
+    for (const auto& conn : conns) conn->Close();
+  }
+
+  void Put(const std::string& key, std::shared_ptr<TrackerResource> value) {
+    schedulers_[key].Put(std::move(value));
+  }
+
+  void Request(const std::string& key, TrackerConnection* conn, int64_t priority) {
+    conn->requested_keys.insert(key);
+    schedulers_[key].Request(conn, priority);
+  }
+
+  bool Stop(const std::string& stop_key) {
+    if (stop_key_.empty() || stop_key != stop_key_) return false;
+    LOG(INFO) << "Stopping the tracker";
+    loop_.Stop();
+    return true;
+  }
+
+  void RemoveConnection(TrackerConnection* conn) {
+    for (const auto& value : conn->put_values) {
+      auto it = schedulers_.find(value->key);
+      if (it != schedulers_.end()) it->second.Remove(value.get());
+    }
+    for (const std::string& key : conn->requested_keys) {
+      auto it = schedulers_.find(key);
+      if (it != schedulers_.end()) it->second.RemoveRequests(conn);
+    }
+    conns_.erase(conn);
+  }
+
+  picojson::value Summary() const {
+    picojson::object qinfo;
+    for (const auto& kv : schedulers_) {
+      qinfo[kv.first] = kv.second.Summary();
+    }
+    picojson::array cinfo;
+    // ignore client connections without key
+    for (const auto& kv : conns_) {
+      const picojson::object& info = kv.first->info();
+      auto it = info.find("key");
+      if (it != info.end() && it->second.is<std::string>() &&
+          it->second.get<std::string>().rfind("server", 0) == 0) {
+        cinfo.push_back(picojson::value(info));
+      }
+    }
+    picojson::object res;
+    res["queue_info"] = picojson::value(qinfo);
+    res["server_info"] = picojson::value(cinfo);
+    return picojson::value(res);
+  }
+
+ private:
+  void AcceptAll() {
+    while (true) {
+      support::SockAddr addr;
+      socklen_t addrlen = sizeof(addr.addr);
+      support::TCPSocket sock(
+          accept(listen_sock_.sockfd, reinterpret_cast<sockaddr*>(&addr.addr), &addrlen));
+      if (sock.IsClosed()) {
+        if (!support::Socket::LastErrorWouldBlock() &&
+            support::Socket::GetLastErrorCode() != EINTR) {
+          LOG(WARNING) << "Accept failed with error " << support::Socket::GetLastErrorCode();
+        }
+        return;
+      }
+      auto conn = std::make_shared<TrackerConnection>(this, &loop_, sock, HostOf(addr));
+      conns_[conn.get()] = conn;
+      conn->Start();
+    }
+  }
+
+  void HealthCheck() {
+    auto now = EventLoop::Clock::now();
+    std::vector<std::shared_ptr<TrackerConnection>> stale;
+    for (const auto& kv : conns_) {
+      TrackerConnection* conn = kv.first;
+      if (!conn->handshake_done()) {
+        if (now - conn->created() > std::chrono::duration<double>(kHandshakeTimeout)) {
+          stale.push_back(kv.second);
+        }
+      } else if (timeout_ > 0 && !conn->pending_matchkeys.empty() &&
+                 now - conn->last_active() > std::chrono::seconds(timeout_)) {
+        // Servers waiting for a client poll the tracker every few seconds, a silent one
+        // is gone and its resources must not be handed out.
+        LOG(WARNING) << "Server " << conn->peer_host() << " is not responding, removing "
+                     << conn->pending_matchkeys.size() << " resources";
+        stale.push_back(kv.second);
+      }
+    }
+    for (const auto& conn : stale) conn->Close();
+    loop_.CallLater(kHealthCheckPeriod, [this]() { HealthCheck(); });
+  }
+
+  std::string host_;
+  int port_search_start_;
+  int port_search_end_;
+  int my_port_{0};
+  std::string stop_key_;
+  int timeout_;
+  EventLoop loop_;
+  support::TCPSocket listen_sock_;
+  std::unordered_map<std::string, PriorityScheduler> schedulers_;
+  std::unordered_map<TrackerConnection*, std::shared_ptr<TrackerConnection>> conns_;
+};
+
+void PriorityScheduler::Schedule() {
+  while (!requests_.empty() && !values_.empty()) {
+    std::shared_ptr<TrackerResource> value = values_.front();
+    values_.pop_front();
+    TrackerConnection* conn = requests_.begin()->conn;
+    requests_.erase(requests_.begin());
+    // Delivering can close connections, keep both ends alive until we are done with them.
+    auto owner_ref = value->owner->shared_from_this();
+    auto conn_ref = conn->shared_from_this();
+    if (conn->Deliver(*value)) {
+      value->owner->pending_matchkeys.erase(value->matchkey);
+    } else if (!value->owner->closed()) {
+      values_.push_back(value);
+    }
+  }
+}
+
+void TrackerConnection::OnData(const char* data, size_t size) {
+  in_.append(data, size);
+  size_t offset = 0;
+  if (!handshake_done_) {
+    if (in_.size() < sizeof(int32_t)) return;
+    int32_t magic;
+    std::memcpy(&magic, in_.data(), sizeof(magic));
+    if (magic != kRPCTrackerMagic) {
+      LOG(WARNING) << "Invalid magic from " << peer_host();
+      Close();
+      return;
+    }
+    Write(&magic, sizeof(magic));
+    handshake_done_ = true;
+    offset = sizeof(int32_t);
+  }
+  while (!closed() && in_.size() - offset >= sizeof(int32_t)) {
+    int32_t len;
+    std::memcpy(&len, in_.data() + offset, sizeof(len));
+    if (len < 0 || len > kMaxTrackerMessageBytes) {
+      LOG(WARNING) << "Invalid message size " << len << " from " << peer_host();
+      Close();
+      return;
+    }
+    if (in_.size() - offset - sizeof(int32_t) < static_cast<size_t>(len)) break;
+    picojson::value msg;
+    const char* begin = in_.data() + offset + sizeof(int32_t);
+    std::string err = picojson::parse(msg, begin, begin + len);
+    offset += sizeof(int32_t) + len;
+    if (!err.empty() || !msg.is<picojson::array>() || msg.get<picojson::array>().empty() ||
+        !msg.get<picojson::array>()[0].is<int64_t>()) {
+      LOG(WARNING) << "Invalid message from " << peer_host() << ": " << err;
+      Close();
+      return;
+    }
+    HandleMessage(msg.get<picojson::array>());
+  }
+  if (!closed()) in_.erase(0, offset);
+}
+
+void TrackerConnection::HandleMessage(const picojson::array& args) {
+  auto code = static_cast<TrackerCode>(args[0].get<int64_t>());
+  auto get_string = [&](size_t i) {
+    return args.size() > i && args[i].is<std::string>() ? args[i].get<std::string>() : "";
+  };
+  switch (code) {
+    case TrackerCode::kPut: {
+      if (args.size() < 3 || !args[2].is<picojson::array>() ||
+          args[2].get<picojson::array>().size() != 2) {
+        break;
+      }
+      const picojson::array& addr = args[2].get<picojson::array>();
+      auto value = std::make_shared<TrackerResource>();
+      value->owner = this;
+      value->key = get_string(1);
+      // got custom address (from rpc server)
+      value->host = args.size() >= 4 && args[3].is<std::string>() ? args[3].get<std::string>()
+                                                                  : peer_host();
+      value->port = addr[0].is<int64_t>() ? addr[0].get<int64_t>() : 0;
+      value->matchkey = addr[1].is<std::string>() ? addr[1].get<std::string>() : "";
+      pending_matchkeys.insert(value->matchkey);
+      put_values.push_back(value);
+      tracker_->Put(value->key, value);
+      Reply(Code(TrackerCode::kSuccess));
+      return;
+    }
+    case TrackerCode::kRequest: {
+      int64_t priority = 0;
+      if (args.size() >= 4) {
+        if (args[3].is<int64_t>()) {
+          priority = args[3].get<int64_t>();
+        } else if (args[3].is<double>()) {
+          priority = static_cast<int64_t>(args[3].get<double>());
+        }
+      }
+      tracker_->Request(get_string(1), this, priority);
+      return;
+    }
+    case TrackerCode::kPing: {
+      Reply(Code(TrackerCode::kSuccess));
+      return;
+    }
+    case TrackerCode::kGetPendingMatchKeys: {
+      picojson::array keys;
+      for (const std::string& key : pending_matchkeys) keys.push_back(picojson::value(key));
+      Reply(picojson::value(keys));
+      return;
+    }
+    case TrackerCode::kStop: {
+      // safe stop tracker
+      bool stopped = tracker_->Stop(get_string(1));
+      Reply(Code(stopped ? TrackerCode::kSuccess : TrackerCode::kFail));
+      return;
+    }
+    case TrackerCode::kUpdateInfo: {
+      if (args.size() < 2 || !args[1].is<picojson::object>()) break;
+      picojson::object info = args[1].get<picojson::object>();
+      auto it = info.find("addr");
+      if (it != info.end() && it->second.is<picojson::array>()) {
+        picojson::array& addr = it->second.get<picojson::array>();
+        if (!addr.empty() && addr[0].is<picojson::null>()) addr[0] = picojson::value(peer_host());
+      }
+      for (auto& kv : info) info_[kv.first] = kv.second;
+      Reply(Code(TrackerCode::kSuccess));
+      return;
+    }
+    case TrackerCode::kSummary: {
+      Reply(picojson::value(picojson::array{Code(TrackerCode::kSuccess), tracker_->Summary()}));
+      return;
+    }
+    default:
+      break;
+  }
+  LOG(WARNING) << "Invalid request with code " << args[0].get<int64_t>() << " from "
+               << peer_host();
+  Close();
+}
+
+void TrackerConnection::OnClose() { tracker_->RemoveConnection(this); }
+
+}  // namespace
+
+void RPCTrackerCreate(std::string host, int port, int port_end, std::string stop_key, int timeout,
+                      bool silent) {
+  if (silent) {
+    // Only errors and fatal is logged
+    dmlc::InitLogging("--minloglevel=2");
+  }
+#if !defined(_WIN32)
+  // Peers that vanish must not kill the tracker on the next write.
+  signal(SIGPIPE, SIG_IGN);
+#endif
+  if (host.empty()) host = "0.0.0.0";
+  RPCTracker tracker(std::move(host), port, port_end, std::move(stop_key), timeout);
+  tracker.Start();
+}
+
+}  // namespace runtime
+}  // namespace tvm
@@ -25,7 +25,10 @@
 
 #include <tvm/ffi/object.h>
 
+#include <atomic>
+#include <cstdint>
 #include <cstdlib>
+#include <new>
 #include <type_traits>
 #include <utility>
 
@@ -50,7 +53,6 @@ inline ObjectPtr<T> make_object(Args&&... args);
 // allocator pattern when necessary.
 //
 // Possible future allocator optimizations:
-// - Arena allocator that gives ownership of memory to arena (deleter = nullptr)
 // - Thread-local object pools: one pool per size and alignment requirement.
 // - Can specialize by type of object to give the specific allocator to each object.
 
@@ -195,13 +197,231 @@ class SimpleObjAllocator : public ObjAllocatorBase<SimpleObjAllocator> {
   };
 };
 
+/*!
+ * \brief Arena allocator that bump-allocates objects from large pages.
+ *
+ *  While an ObjectArenaScope is active on the current thread, make_object
+ *  places small objects in the arena of that scope instead of on the heap.
+ *  This removes the malloc/free pair of short-lived nodes that are created
+ *  and dropped in bulk, e.g. by IR mutators.
+ *
+ *  Each page counts the objects that still live in it (plus one reference
+ *  held by the arena while the page is being filled). Objects keep their
+ *  normal reference counting semantics, so they are free to escape the scope:
+ *  when the scope exits, the arena drops its reference and every page that
+ *  still holds surviving objects is handed over to them. Such a page is
+ *  returned to the heap once its last survivor is deleted, which may happen
+ *  on any thread.
+ *
+ * \note Memory of dead objects is only reclaimed at page granularity, so a
+ *  scope is best used around work that mostly produces temporaries.
+ * \sa ObjectArenaScope
+ */
+class ObjectArena : public ObjAllocatorBase<ObjectArena> {
+ public:
+  /*! \brief Size of a regular arena page. */
+  static constexpr size_t kPageSize = 64 << 10;
+  /*! \brief Objects larger than this are always allocated on the heap. */
+  static constexpr size_t kMaxObjectSize = kPageSize / 16;
+
+  ObjectArena() = default;
+  ObjectArena(const ObjectArena&) = delete;
+  ObjectArena& operator=(const ObjectArena&) = delete;
+
+  ~ObjectArena() {
+    if (page_ != nullptr) {
+      DecRefPage(page_);
+    }
+  }
+
+  /*!
+   * \return The arena of the innermost ObjectArenaScope of the calling thread,
+   *  nullptr if there is none.
+   */
+  static ObjectArena* Current() { return ThreadLocalCurrent(); }
+
+  /*! \return Total number of bytes handed out by this arena. */
+  size_t allocated_bytes() const { return allocated_bytes_; }
+
+  /*! \return Number of pages requested by this arena. */
+  size_t num_pages() const { return num_pages_; }
+
+  template <typename T>
+  class Handler {
+   public:
+    template <typename... Args>
+    static T* New(ObjectArena* arena, Args&&... args) {
+      void* data = arena->Allocate(sizeof(T), alignof(T));
+      new (data) T(std::forward<Args>(args)...);
+      return reinterpret_cast<T*>(data);
+    }
+
+    static FObjectDeleter Deleter() { return Deleter_; }
+
+   private:
+    static void Deleter_(TVMFFIObject* objptr) {
+      T* tptr = details::ObjectUnsafe::RawObjectPtrFromUnowned<T>(objptr);
+      tptr->T::~T();
+      ObjectArena::Free(tptr);
+    }
+  };
+
+  template <typename ArrayType, typename ElemType>
+  class ArrayHandler {
+   public:
+    static_assert(alignof(ArrayType) % alignof(ElemType) == 0 &&
+                      sizeof(ArrayType) % alignof(ElemType) == 0,
+                  "element alignment constraint");
+
+    template <typename... Args>
+    static ArrayType* New(ObjectArena* arena, size_t num_elems, Args&&... args) {
+      void* data =
+          arena->Allocate(sizeof(ArrayType) + num_elems * sizeof(ElemType), alignof(ArrayType));
+      new (data) ArrayType(std::forward<Args>(args)...);
+      return reinterpret_cast<ArrayType*>(data);
+    }
+
+    static FObjectDeleter Deleter() { return Deleter_; }
+
+   private:
+    static void Deleter_(TVMFFIObject* objptr) {
+      ArrayType* tptr = details::ObjectUnsafe::RawObjectPtrFromUnowned<ArrayType>(objptr);
+      tptr->ArrayType::~ArrayType();
+      ObjectArena::Free(tptr);
+    }
+  };
+
+ private:
+  /*!
+   * \brief Header at the beginning of each page.
+   *  Every object in the page is prefixed by a pointer back to this header.
+   */
+  struct Page {
+    /*! \brief Number of live objects, plus one if the page is owned by an arena. */
+    std::atomic<int64_t> ref_counter;
+    /*! \brief Total size of the page, including the header. */
+    size_t size;
+    /*! \brief Offset of the first free byte. */
+    size_t offset;
+  };
+
+  /*!
+   * \brief Get the slot that stores the innermost arena of the calling thread.
+   * \note Defined in the ffi library so that all modules share the same slot.
+   */
+  TVM_FFI_EXTRA_CXX_API static ObjectArena*& ThreadLocalCurrent();
+
+  void* Allocate(size_t size, size_t align) {
+    if (align < alignof(Page*)) align = alignof(Page*);
+    if (page_ == nullptr || !TryPlace(page_, size, align)) {
+      if (page_ != nullptr) DecRefPage(page_);
+      size_t min_size = sizeof(Page) + sizeof(Page*) + size + align;
+      page_ = NewPage(min_size > kPageSize ? min_size : kPageSize);
+      ++num_pages_;
+    }
+    uintptr_t base = reinterpret_cast<uintptr_t>(page_);
+    uintptr_t begin = AlignUp(base + page_->offset + sizeof(Page*), align);
+    page_->offset = begin + size - base;
+    page_->ref_counter.fetch_add(1, std::memory_order_relaxed);
+    *reinterpret_cast<Page**>(begin - sizeof(Page*)) = page_;
+    allocated_bytes_ += size;
+    return reinterpret_cast<void*>(begin);
+  }
+
+  static bool TryPlace(const Page* page, size_t size, size_t align) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(page);
+    uintptr_t begin = AlignUp(base + page->offset + sizeof(Page*), align);
+    return begin + size <= base + page->size;
+  }
+
+  static void Free(void* data) {
+    DecRefPage(*reinterpret_cast<Page**>(static_cast<char*>(data) - sizeof(Page*)));
+  }
+
+  static Page* NewPage(size_t size) {
+    Page* page = static_cast<Page*>(::operator new(size));
+    new (page) Page();
+    page->ref_counter.store(1, std::memory_order_relaxed);
+    page->size = size;
+    page->offset = sizeof(Page);
+    return page;
+  }
+
+  static void DecRefPage(Page* page) {
+    if (page->ref_counter.fetch_sub(1, std::memory_order_release) == 1) {
+      std::atomic_thread_fence(std::memory_order_acquire);
+      page->~Page();
+      ::operator delete(page);
+    }
+  }
+
+  static uintptr_t AlignUp(uintptr_t value, size_t align) {
+    return (value + align - 1) / align * align;
+  }
+
+  /*! \brief The page that is currently being filled. */
+  Page* page_{nullptr};
+  /*! \brief Statistics: bytes allocated. */
+  size_t allocated_bytes_{0};
+  /*! \brief Statistics: pages allocated. */
+  size_t num_pages_{0};
+
+  friend class ObjectArenaScope;
+};
+
+/*!
+ * \brief RAII scope that routes make_object on the current thread to a fresh ObjectArena.
+ *
+ * \code
+ *
+ *  {
+ *    ObjectArenaScope scope;
+ *    // nodes created here are allocated from the arena of the scope.
+ *    Stmt body = mutator(func->body);
+ *  }
+ *  // body stays valid after the scope exits.
+ *
+ * \endcode
+ *
+ *  Scopes can be nested; the innermost one is used. A scope only affects the thread that
+ *  created it and must be destroyed on the same thread.
+ */
+class ObjectArenaScope {
+ public:
+  ObjectArenaScope() : prev_(ObjectArena::ThreadLocalCurrent()) {
+    ObjectArena::ThreadLocalCurrent() = &arena_;
+  }
+  ~ObjectArenaScope() { ObjectArena::ThreadLocalCurrent() = prev_; }
+
+  ObjectArenaScope(const ObjectArenaScope&) = delete;
+  ObjectArenaScope& operator=(const ObjectArenaScope&) = delete;
+
+  /*! \return The arena of this scope. */
+  const ObjectArena& arena() const { return arena_; }
+
+ private:
+  ObjectArena arena_;
+  ObjectArena* prev_;
+};
+
 template <typename T, typename... Args>
 inline ObjectPtr<T> make_object(Args&&... args) {
+  if constexpr (sizeof(T) <= ObjectArena::kMaxObjectSize) {
+    if (ObjectArena* arena = ObjectArena::Current()) {
+      return arena->make_object<T>(std::forward<Args>(args)...);
+    }
+  }
   return SimpleObjAllocator().make_object<T>(std::forward<Args>(args)...);
 }
 
 template <typename ArrayType, typename ElemType, typename... Args>
 inline ObjectPtr<ArrayType> make_inplace_array_object(size_t num_elems, Args&&... args) {
+  if (num_elems <= (ObjectArena::kMaxObjectSize - sizeof(ArrayType)) / sizeof(ElemType)) {
+    if (ObjectArena* arena = ObjectArena::Current()) {
+      return arena->make_inplace_array<ArrayType, ElemType>(num_elems,
+                                                            std::forward<Args>(args)...);
+    }
+  }
   return SimpleObjAllocator().make_inplace_array<ArrayType, ElemType>(num_elems,
                                                                       std::forward<Args>(args)...);
 }
@@ -211,5 +431,6 @@ inline ObjectPtr<ArrayType> make_inplace_array_object(size_t num_elems, Args&&..
 // Export the make_object function
 // rationale: ease of use, and no ambiguity
 using ffi::make_object;
+using ffi::ObjectArenaScope;
 }  // namespace tvm
 #endif  // TVM_FFI_MEMORY_H_
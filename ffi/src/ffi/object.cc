@@ -24,6 +24,7 @@
 #include <tvm/ffi/container/map.h>
 #include <tvm/ffi/error.h>
 #include <tvm/ffi/function.h>
+#include <tvm/ffi/memory.h>
 #include <tvm/ffi/reflection/registry.h>
 #include <tvm/ffi/string.h>
 
@@ -405,6 +406,11 @@ void MakeObjectFromPackedArgs(ffi::PackedArgs args, Any* ret) {
   *ret = ObjectRef(ptr);
 }
 
+ObjectArena*& ObjectArena::ThreadLocalCurrent() {
+  static thread_local ObjectArena* current = nullptr;
+  return current;
+}
+
 TVM_FFI_STATIC_INIT_BLOCK({
   namespace refl = tvm::ffi::reflection;
   refl::GlobalDef().def_packed("ffi.MakeObjectFromPackedArgs", MakeObjectFromPackedArgs);
@@ -17,6 +17,7 @@
  * under the License.
  */
 #include <gtest/gtest.h>
+#include <tvm/ffi/container/array.h>
 #include <tvm/ffi/memory.h>
 #include <tvm/ffi/object.h>
 
@@ -103,4 +104,42 @@ TEST(Object, CAPIAccessor) {
   int32_t type_index = TVMFFIObjectGetTypeIndex(obj);
   EXPECT_EQ(type_index, TIntObj::RuntimeTypeIndex());
 }
+
+TEST(Object, ArenaScope) {
+  ObjectPtr<TIntObj> survivor;
+  {
+    ObjectArenaScope scope;
+    EXPECT_EQ(ObjectArena::Current(), &scope.arena());
+    for (int i = 0; i < 10000; ++i) {
+      ObjectPtr<TIntObj> tmp = make_object<TIntObj>(i);
+      EXPECT_EQ(tmp->value, i);
+    }
+    survivor = make_object<TIntObj>(42);
+    EXPECT_GT(scope.arena().num_pages(), 1U);
+    EXPECT_GE(scope.arena().allocated_bytes(), 10001 * sizeof(TIntObj));
+  }
+  EXPECT_TRUE(ObjectArena::Current() == nullptr);
+  EXPECT_EQ(survivor->value, 42);
+  EXPECT_EQ(survivor.use_count(), 1);
+  EXPECT_TRUE(survivor->IsInstance<TNumberObj>());
+}
+
+TEST(Object, ArenaScopeNested) {
+  Array<TInt> arr;
+  {
+    ObjectArenaScope outer;
+    {
+      ObjectArenaScope inner;
+      EXPECT_EQ(ObjectArena::Current(), &inner.arena());
+      arr = Array<TInt>({TInt(1), TInt(2), TInt(3)});
+      EXPECT_EQ(outer.arena().allocated_bytes(), 0U);
+    }
+    EXPECT_EQ(ObjectArena::Current(), &outer.arena());
+    arr.push_back(TInt(4));
+  }
+  EXPECT_EQ(arr.size(), 4U);
+  for (size_t i = 0; i < arr.size(); ++i) {
+    EXPECT_EQ(arr[i]->value, static_cast<int64_t>(i + 1));
+  }
+}
 }  // namespace
@@ -24,6 +24,7 @@
 #ifndef TVM_NODE_SERIALIZATION_H_
 #define TVM_NODE_SERIALIZATION_H_
 
+#include <dmlc/io.h>
 #include <tvm/runtime/base.h>
 #include <tvm/runtime/object.h>
 
@@ -47,5 +48,53 @@ TVM_DLL std::string SaveJSON(ffi::Any node);
  */
 TVM_DLL ffi::Any LoadJSON(std::string json_str);
 
+/*!
+ * \brief Save the node as well as all the node it depends on in the compact binary format.
+ *
+ *  The binary format stores a type table once, encodes fields as varints and
+ *  writes NDArray data as raw blobs aligned to 64 bytes, which makes it
+ *  considerably smaller and faster to load than SaveJSON for large graphs.
+ *
+ * \param node The node to be saved.
+ * \param strm The output stream, the payload is written to it incrementally.
+ */
+TVM_DLL void SaveBinary(ffi::Any node, dmlc::Stream* strm);
+
+/*!
+ * \brief Save the node in the compact binary format.
+ * \param node The node to be saved.
+ * \return The binary payload.
+ */
+TVM_DLL std::string SaveBinary(ffi::Any node);
+
+/*!
+ * \brief Load a node saved by SaveBinary.
+ * \param data The start of the binary payload.
+ * \param size The size of the payload.
+ * \return The loaded node.
+ */
+TVM_DLL ffi::Any LoadBinary(const char* data, size_t size);
+
+/*!
+ * \brief Load a node saved by SaveBinary.
+ * \param blob The binary payload.
+ * \return The loaded node.
+ */
+TVM_DLL ffi::Any LoadBinary(const std::string& blob);
+
+/*!
+ * \brief Load a node from a file written with the payload of SaveBinary.
+ *
+ *  The file is memory mapped and the loaded NDArrays refer to their blobs in
+ *  the mapping instead of copying them, so the data of large constants is only
+ *  read from the file when it is first accessed. Writes to the tensors are
+ *  private to the process. Platforms without mmap, or that need to byte swap
+ *  the data, read the whole file instead.
+ *
+ * \param path The path of the file.
+ * \return The loaded node.
+ */
+TVM_DLL ffi::Any LoadBinaryFile(const std::string& path);
+
 }  // namespace tvm
 #endif  // TVM_NODE_SERIALIZATION_H_
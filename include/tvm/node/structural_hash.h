@@ -263,6 +263,50 @@ class SHashReducer {
   bool map_free_vars_;
 };
 
+/*!
+ * \brief Cache of structural hash values that outlives a single hashing call.
+ *
+ * Attach the cache to a SHashHandlerDefault via SetCache to reuse the hash
+ * of every subtree that was hashed before. Rehashing an IR after a local
+ * rewrite then only revisits the nodes on the rewritten spine, since all
+ * the untouched subtrees are still the same objects.
+ *
+ * The cache is keyed by object identity and holds a reference to every key,
+ * so a cached node can never be mutated in place through copy-on-write, and
+ * is kept alive as long as the cache. A cache should therefore be scoped to
+ * one batch of hashing, such as one round of a search, and not be kept for
+ * the lifetime of a long-lived object.
+ * Hash values that depend on the traversal context, i.e. subtrees that
+ * contain free variables or graph nodes, are stored together with the
+ * context they were computed in and are only reused when it matches.
+ *
+ * \note A cache can only be used by one handler at a time, and only with
+ *  handlers of the same type.
+ */
+class SHashCache {
+ public:
+  /*!
+   * \brief Constructor.
+   * \param max_entries The maximum number of cached nodes, no more nodes
+   *  are cached once the limit is reached.
+   */
+  TVM_DLL explicit SHashCache(size_t max_entries = 1 << 20);
+  TVM_DLL ~SHashCache();
+
+  SHashCache(const SHashCache&) = delete;
+  SHashCache& operator=(const SHashCache&) = delete;
+
+  /*! \brief Drop all cached entries. */
+  TVM_DLL void Clear();
+  /*! \return The number of cached nodes. */
+  TVM_DLL size_t size() const;
+
+ private:
+  class Impl;
+  Impl* impl;
+  friend class SHashHandlerDefault;
+};
+
 /*! \brief The default handler for hash key computation
  *
  * Users can derive from this class and override the DispatchSHash method,
@@ -273,6 +317,12 @@ class SHashHandlerDefault : public SHashReducer::Handler {
   SHashHandlerDefault();
   virtual ~SHashHandlerDefault();
 
+  /*!
+   * \brief Reuse and populate the hash values in cache during Hash.
+   * \param cache The cache, nullptr to disable caching.
+   */
+  void SetCache(SHashCache* cache);
+
   void SHashReduceHashedValue(uint64_t hashed_value) override;
   void SHashReduce(const ObjectRef& key, bool map_free_vars) override;
   void SHashReduceFreeVar(const runtime::Object* var, bool map_free_vars) override;
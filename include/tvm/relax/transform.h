@@ -138,6 +138,12 @@ TVM_DLL Pass RewriteDataflowReshape();
  * signature will have upper bound 1024. And we will use 1024 as its value
  * during memory planning.
  *
+ * With the PassContext config "relax.StaticPlanBlockMemory.offset_packing", the
+ * tensors of a block are packed by offset into one storage per device instead
+ * of reusing whole storages, at symbolic offsets for the symbolic-size ones, and
+ * "relax.StaticPlanBlockMemory.exact_packing_limit" bounds the number of tensors
+ * for which the packing is solved exactly.
+ *
  * \return The pass.
  */
 TVM_DLL Pass StaticPlanBlockMemory();
@@ -188,6 +194,22 @@ TVM_DLL Pass CanonicalizeBindings();
  */
 TVM_DLL Pass EliminateCommonSubexpr(bool call_only = false);
 
+/*!
+ * \brief Remove the copies of tensors that are not needed within functions.
+ *
+ * Ops that return their input unchanged, such as a permute_dims to the same axes, a reshape,
+ * broadcast_to or view to the same shape, or an astype to the same dtype, and call_tir of
+ * PrimFuncs that copy their input element by element, are replaced by their input. Chains of
+ * permute_dims, reshape and view are folded into one op, and removed if they are a round trip.
+ * The bindings left unused are removed.
+ *
+ * \return The Pass.
+ *
+ * \note Replacing a tensor by its input makes them share memory, so it is skipped in the
+ * functions that contain call_tir_inplace.
+ */
+TVM_DLL Pass EliminateRedundantCopies();
+
 /*!
  * \brief Bind params of function of the module to constant tensors.
  *
@@ -506,6 +528,23 @@ class PatternCheckContext : public ObjectRef {
 TVM_DLL Pass Gradient(String func_name, Optional<Array<Var>> require_grads = std::nullopt,
                       int target_index = 0);
 
+/*!
+ * \brief Choose the activations of a function to recompute in its backward pass, and mark them
+ * with start_checkpoint and end_checkpoint for the Gradient pass.
+ *
+ * The activations kept for the backward pass are estimated as the checkpoints plus the largest
+ * segment of activations recomputed together. Among the segmentations whose estimate fits in the
+ * memory budget, the one with the least estimated recomputation is chosen.
+ *
+ * \param func_name The name of the function to be differentiated.
+ * \param memory_budget The memory budget of the activations, in bytes.
+ * \return The Pass.
+ *
+ * \note The function must have only one dataflow block. It is unchanged if it already contains
+ * checkpoint markers.
+ */
+TVM_DLL Pass CheckpointActivations(String func_name, int64_t memory_budget);
+
 /*!
  * \brief Apply pattern matching to each function in the given module, and group matched
  * expressions into a new function. The end result is similar to FuseOps, but fusion is driven
@@ -547,6 +586,17 @@ TVM_DLL Pass MergeCompositeFunctions();
  */
 TVM_DLL Pass FuseTIR();
 
+/*!
+ * \brief Fuse the independent elementwise, injective and reduction kernels at the same depth of a
+ * dataflow block, whose outputs have the same shape, into one PrimFunc. The outer loops that the
+ * fused kernels share are merged, so that the group runs in a single iteration space.
+ *
+ * This pass runs after FuseTIR and fuses the grouped kernels with FuseTIR itself.
+ * \param max_group_size The maximum number of kernels in one fused PrimFunc.
+ * \return The Pass.
+ */
+TVM_DLL Pass HorizontalFuseOps(int max_group_size = 8);
+
 /*!
  * \brief Run codegen.
  * \param target_options pairs of target name and compilation options
@@ -603,6 +653,17 @@ TVM_DLL Pass AlterOpImpl(const Map<String, tir::PrimFunc>& op_impl_map,
  */
 TVM_DLL Pass ConvertLayout(Map<String, Array<String>> desired_layouts);
 
+/*!
+ * \brief Select the layout of each NCHW conv2d among NCHW, NHWC and the NCHW[x]c layouts
+ * blocked by the vector width of the current target, so that the estimated cost of the conv2d
+ * ops and of the layout transforms between them is the least, and convert the layouts.
+ * \param fcost The optional function that estimates the cost of a conv2d call in the given data
+ * and kernel layouts, in cycles. A built-in estimate is used when it is not given.
+ * \return The Pass.
+ * \note Operates only on dataflow blocks. ConvertToDataflow may need to be called first.
+ */
+TVM_DLL Pass SelectLayout(Optional<ffi::Function> fcost = std::nullopt);
+
 /*!
  * \brief A pass that converts consecutive dataflow operations
  *   inside binding blocks into dataflow blocks.
@@ -661,6 +722,14 @@ TVM_DLL Pass ToMixedPrecision(const DataType& out_dtype,
  */
 TVM_DLL Pass RewriteCUDAGraph();
 
+/*!
+ * \brief Rewrite a Relax module for executing with CPU execution plans. The regions found by
+ * RewriteCUDAGraph are lifted the same way, and launched as execution plans that the VM captures
+ * once and replays. The pass is enabled by the "relax.backend.use_cpu_exec_plan" config, and
+ * ignores "relax.backend.use_cuda_graph".
+ */
+TVM_DLL Pass RewriteCPUExecPlan();
+
 /*!
  * \brief The pass is designed for few shot tuning for static shape PrimFuncs. It examines all the
  *  blocks within the PrimFunc and conducts loop fusion, splitting, and other transformations based
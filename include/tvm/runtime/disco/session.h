@@ -97,6 +97,7 @@ enum class DiscoAction : int32_t {
   kCopyToWorker0 = 6,
   kDebugGetFromRemote = 7,
   kDebugSetRegister = 8,
+  kBatch = 9,
 };
 
 /*! \brief Converts the enum class `DiscoAction` to string */
@@ -120,6 +121,8 @@ inline std::string DiscoAction2String(DiscoAction action) {
       return "kDebugGetFromRemote";
     case DiscoAction::kDebugSetRegister:
       return "kDebugSetRegister";
+    case DiscoAction::kBatch:
+      return "kBatch";
   }
   LOG(FATAL) << "ValueError: Unknown DiscoAction: " << static_cast<int>(action);
 }
@@ -225,6 +228,23 @@ class SessionObj : public Object {
   TVM_DLL virtual void SyncWorker(int worker_id) = 0;
   /*! \brief Signal all the workers to shutdown */
   TVM_DLL virtual void Shutdown() = 0;
+  /*!
+   * \brief Start buffering commands on the controler instead of sending them one by one.
+   * The buffered commands are sent to each worker as a single batched message when the batch
+   * ends, when the batch grows too large, or when a reply from a worker is needed.
+   */
+  TVM_DLL virtual void BeginBatch() = 0;
+  /*!
+   * \brief Send the buffered commands and stop batching.
+   * \return A fence that completes once worker-0 executes all commands submitted so far.
+   */
+  TVM_DLL virtual int64_t EndBatch() = 0;
+  /*!
+   * \brief Wait for a fence returned by `EndBatch`. Fences are completed in order, so a single
+   * round-trip to worker-0 completes every fence issued before it.
+   * \param fence The fence to wait for.
+   */
+  TVM_DLL virtual void WaitFence(int64_t fence) = 0;
   /*!
    * \brief Initialize the data plane between workers.
    * \param ccl The name of the communication backend, e.g., nccl, rccl, mpi.
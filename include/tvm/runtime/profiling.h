@@ -594,6 +594,39 @@ ffi::Function WrapTimeEvaluator(ffi::Function f, Device dev, int number, int rep
                                 int cooldown_interval_ms, int repeats_to_cooldown,
                                 int cache_flush_bytes = 0, ffi::Function f_preproc = nullptr);
 
+/*!
+ * \brief Wrap a batch of functions into a timer that repeats each of them
+ *        until its mean runtime is known to a target precision.
+ *
+ * Every round measures one `repeat` of each function that has not converged
+ * yet, so slow drifts of the machine state are spread over all functions
+ * instead of biasing the ones that happen to run last. A function converges
+ * once it has at least `min_repeat` samples and the half-width of the 95%
+ * confidence interval of its mean falls below `target_rel_ci` times the mean.
+ *
+ * The timer takes the arguments shared by all functions and returns a blob
+ * of doubles which holds, for each function in order, the number of samples
+ * `n`, the calibrated `number` of calls per sample, whether it converged,
+ * the confidence interval half-width in seconds and then the `n` samples.
+ *
+ * \param fs The functions to measure, they must accept the same arguments.
+ * \param dev The device.
+ * \param min_repeat The minimum number of samples of each function.
+ * \param max_repeat The maximum number of samples of each function.
+ * \param min_repeat_ms The minimum duration of one sample in milliseconds,
+ *        the number of calls per sample is calibrated to reach it.
+ * \param target_rel_ci The target half-width of the confidence interval
+ *        relative to the mean.
+ * \param cooldown_interval_ms The cooldown interval in milliseconds between rounds.
+ * \param cache_flush_bytes The number of bytes to flush from cache before each sample.
+ * \param f_preproc The function to be executed before each sample.
+ * \return f_timer A timer function.
+ */
+ffi::Function WrapAdaptiveTimeEvaluator(std::vector<ffi::Function> fs, Device dev, int min_repeat,
+                                        int max_repeat, int min_repeat_ms, double target_rel_ci,
+                                        int cooldown_interval_ms, int cache_flush_bytes = 0,
+                                        ffi::Function f_preproc = nullptr);
+
 }  // namespace profiling
 }  // namespace runtime
 }  // namespace tvm
@@ -25,6 +25,7 @@
 #define TVM_RUNTIME_THREADING_BACKEND_H_
 
 #include <tvm/runtime/c_backend_api.h>
+#include <tvm/runtime/object.h>
 
 #include <algorithm>
 #include <functional>
@@ -149,6 +150,128 @@ TVM_DLL void Configure(tvm::runtime::threading::ThreadGroup::AffinityMode mode,
  */
 TVM_DLL int32_t NumThreads();
 
+/*! \brief A NUMA node and the CPUs on it that this process may run on. */
+struct NumaNode {
+  /*! \brief The id of the node. */
+  int id;
+  /*! \brief The CPUs of the node, one hyper-thread of each physical core comes first. */
+  std::vector<unsigned int> cpus;
+  /*! \brief The number of physical cores among the CPUs. */
+  int num_cores;
+};
+
+/*!
+ * \brief Get the NUMA topology of the host.
+ *
+ *  The topology is read from sysfs on first use. Hosts without NUMA
+ *  information report a single node 0 holding every CPU.
+ *
+ * \return The NUMA nodes ordered by id.
+ */
+TVM_DLL const std::vector<NumaNode>& NumaNodes();
+
+/*!
+ * \brief Bind the calling thread and its thread pool to a NUMA node.
+ *
+ *  The pool is recreated with one worker per CPU of the node, the calling
+ *  thread may migrate among the CPUs of the node, and large CPU allocations
+ *  made from the calling thread prefer the memory of the node.
+ *
+ * \param node The id of the NUMA node.
+ * \param nthreads The number of threads to use, 0 uses the physical cores of the node.
+ * \return The number of threads used.
+ */
+TVM_DLL int BindToNumaNode(int node, int nthreads = 0);
+
+/*!
+ * \brief Get the NUMA node the calling thread is bound to.
+ * \return The id of the node, or -1 if the thread is not bound.
+ */
+TVM_DLL int CurrentNumaNode();
+
+/*!
+ * \brief A thread pool that parallel launches can be directed to.
+ *
+ *  Every thread that launches parallel work owns a default pool with
+ *  MaxConcurrency() workers. Models served side by side from one process can
+ *  instead each get a pool sized and pinned for them, so their parallel
+ *  regions run concurrently without oversubscribing the CPUs.
+ *
+ *  All tasks of a launch on the pool run on its workers, so any thread may
+ *  launch on it. Launches from different threads take turns.
+ *
+ * \sa WorkerPoolScope
+ */
+class WorkerPoolNode : public Object {
+ public:
+  class Impl;
+
+  TVM_DLL ~WorkerPoolNode();
+
+  /*! \brief The number of tasks a launch with num_task == 0 is split into. */
+  int NumThreads() const { return num_threads_; }
+
+  /*!
+   * \brief Run a parallel job on the pool, see TVMBackendParallelLaunch.
+   * \param flambda The parallel function to be launched.
+   * \param cdata The closure data.
+   * \param num_task The number of tasks, 0 uses all the threads of the pool.
+   * \return 0 when no error is thrown, -1 when failure happens.
+   */
+  TVM_DLL int Launch(FTVMParallelLambda flambda, void* cdata, int num_task);
+
+  static constexpr const char* _type_key = "runtime.WorkerPool";
+  TVM_DECLARE_FINAL_OBJECT_INFO(WorkerPoolNode, Object);
+
+ private:
+  friend class WorkerPool;
+  /*! \brief The number of threads of the pool. */
+  int num_threads_;
+  /*! \brief The workers, null when OpenMP provides the threads. */
+  std::unique_ptr<Impl> impl_;
+};
+
+/*! \brief Managed reference to WorkerPoolNode. */
+class WorkerPool : public ObjectRef {
+ public:
+  /*!
+   * \brief Create a pool.
+   * \param nthreads The number of threads, 0 uses one per CPU in cpus, or
+   *        MaxConcurrency() when cpus is empty.
+   * \param cpus The CPUs the workers run on. When empty, the workers float over all CPUs.
+   * \param mode How the workers are placed on cpus, kSpecifyOneCorePerThread pins one
+   *        worker per CPU and kSpecifyThreadShareAllCore lets them share all of cpus.
+   */
+  TVM_DLL explicit WorkerPool(
+      int nthreads, std::vector<unsigned int> cpus = {},
+      ThreadGroup::AffinityMode mode = ThreadGroup::kSpecifyOneCorePerThread);
+
+  TVM_DEFINE_OBJECT_REF_METHODS(WorkerPool, ObjectRef, WorkerPoolNode);
+};
+
+/*!
+ * \brief Direct the parallel launches of the calling thread to a pool while in scope.
+ *
+ *  Scopes nest, and a scope without a pool keeps the pool of the enclosing scope.
+ */
+class WorkerPoolScope {
+ public:
+  TVM_DLL explicit WorkerPoolScope(ffi::Optional<WorkerPool> pool);
+  TVM_DLL ~WorkerPoolScope();
+  WorkerPoolScope(const WorkerPoolScope&) = delete;
+  WorkerPoolScope& operator=(const WorkerPoolScope&) = delete;
+
+  /*!
+   * \brief The pool parallel launches of the calling thread go to.
+   * \return The pool, or nullptr when launches go to the default pool of the thread.
+   */
+  TVM_DLL static WorkerPoolNode* Current();
+
+ private:
+  ffi::Optional<WorkerPool> pool_;
+  WorkerPoolNode* prev_;
+};
+
 }  // namespace threading
 
 /*!
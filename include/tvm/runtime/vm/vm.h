@@ -33,6 +33,7 @@
 #include <vector>
 
 #include "../memory/memory_manager.h"
+#include "../threading_backend.h"
 #include "./bytecode.h"
 #include "./executable.h"
 
@@ -117,6 +118,19 @@ class VMExtension : public ObjectRef {
   TVM_DEFINE_OBJECT_REF_METHODS(VMExtension, ObjectRef, VMExtensionNode);
 };
 
+/*!
+ * \brief A call to a packed function made by the VM, recorded so that it can be
+ * replayed without interpreting the bytecode again.
+ */
+struct VMRecordedCall {
+  /*! \brief The function being called. */
+  ffi::Function func;
+  /*! \brief The symbol of the function. */
+  std::string func_symbol;
+  /*! \brief The arguments of the call. */
+  std::vector<ffi::Any> args;
+};
+
 /*!
  * \brief The virtual machine.
  *
@@ -177,6 +191,27 @@ class VirtualMachine : public runtime::ModuleNode {
    */
   virtual void SetInstrument(ffi::Function instrument) = 0;
 
+  /*!
+   * \brief Direct the parallel launches of the functions run by the VM to a thread pool.
+   *
+   * VM instances serving different models from one process can each get their own pool,
+   * so that their parallel regions run concurrently without oversubscribing the CPUs.
+   *
+   * \param pool The pool, or nullopt to use the default pool of the calling thread.
+   */
+  virtual void SetWorkerPool(Optional<threading::WorkerPool> pool) = 0;
+
+  /*!
+   * \brief Record the packed function calls made by the VM.
+   *
+   * While a recorder is set, every Call instruction that calls a packed function is
+   * appended to it together with its arguments. Calls to closures are not recorded
+   * themselves, the calls made inside them are.
+   *
+   * \param calls The recorder, or nullptr to stop recording.
+   */
+  virtual void SetCallRecorder(std::vector<VMRecordedCall>* calls) = 0;
+
   /*!
    * \brief Get or create a VM extension. Once created, the extension will be stored in the VM
    * and held until the VM is destructed.
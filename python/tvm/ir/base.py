@@ -146,6 +146,61 @@ def save_json(node) -> str:
     return _ffi_node_api.SaveJSON(node)
 
 
+def load_binary(blob) -> Object:
+    """Load tvm object from the binary format produced by :py:func:`save_binary`.
+
+    Parameters
+    ----------
+    blob : bytes
+        The binary payload.
+
+    Returns
+    -------
+    node : Object
+        The loaded tvm node.
+    """
+    return _ffi_node_api.LoadBinary(blob)
+
+
+def load_binary_file(path) -> Object:
+    """Load tvm object from a file that holds the payload of :py:func:`save_binary`.
+
+    The file is memory mapped, and the loaded NDArrays refer to the mapping
+    instead of copying their data, so large constants are only read from the
+    file when they are first accessed.
+
+    Parameters
+    ----------
+    path : str
+        The path of the file.
+
+    Returns
+    -------
+    node : Object
+        The loaded tvm node.
+    """
+    return _ffi_node_api.LoadBinaryFile(str(path))
+
+
+def save_binary(node) -> bytes:
+    """Save tvm object in the compact binary format.
+
+    Compared to :py:func:`save_json`, the binary format is smaller and
+    faster to load, in particular for objects that embed large NDArrays.
+
+    Parameters
+    ----------
+    node : Object
+        A TVM object to be saved.
+
+    Returns
+    -------
+    blob : bytes
+        Saved binary payload.
+    """
+    return bytes(_ffi_node_api.SaveBinary(node))
+
+
 def structural_equal(lhs, rhs, map_free_vars=False):
     """Check structural equality of lhs and rhs.
 
@@ -32,6 +32,7 @@ def legalize_passes(target: tvm.target.Target):  # pylint: disable=unused-argume
         tvm.relax.transform.FoldConstant(),
         tvm.relax.transform.FuseOps(),
         tvm.relax.transform.FuseTIR(),
+        tvm.relax.transform.HorizontalFuseOps(),
     ]
 
 
@@ -49,6 +50,7 @@ def finalize_passes(target: tvm.target.Target):  # pylint: disable=unused-argume
     """The default finalization passes for CPU backend."""
     return [
         relax.transform.StaticPlanBlockMemory(),
+        relax.transform.RewriteCPUExecPlan(),
         relax.transform.LowerAllocTensor(),
         relax.transform.KillAfterLastUse(),
         relax.transform.LowerRuntimeBuiltin(),
@@ -28,6 +28,7 @@ from .transform import (
     BundleModelParams,
     CallTIRRewrite,
     CanonicalizeBindings,
+    CheckpointActivations,
     CombineParallelMatmul,
     ComputePrimValue,
     ConvertLayout,
@@ -38,6 +39,7 @@ from .transform import (
     DecomposeOpsForInference,
     DecomposeOpsForTraining,
     EliminateCommonSubexpr,
+    EliminateRedundantCopies,
     ExpandMatmulOfSum,
     ExpandTupleArguments,
     FewShotTuning,
@@ -48,6 +50,7 @@ from .transform import (
     FuseTIR,
     FusionPattern,
     Gradient,
+    HorizontalFuseOps,
     InlinePrivateFunctions,
     KillAfterLastUse,
     LambdaLift,
@@ -70,9 +73,11 @@ from .transform import (
     RemoveUnusedParameters,
     ReorderPermuteDimsAfterConcat,
     ReorderTakeAfterMatmul,
+    RewriteCPUExecPlan,
     RewriteCUDAGraph,
     RewriteDataflowReshape,
     RunCodegen,
+    SelectLayout,
     SplitCallTIRByPattern,
     SplitLayoutRewritePreproc,
     StaticPlanBlockMemory,
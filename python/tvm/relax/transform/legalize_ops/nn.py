@@ -18,9 +18,11 @@
 """Default legalization function for neural network operators."""
 import logging
 import math
+import re
 from typing import Optional
 
 from tvm import te, tir, topi
+from tvm.target import Target
 
 from ...block_builder import BlockBuilder
 from ...expr import Call, Expr
@@ -76,6 +78,30 @@ def _nn_conv2d(bb: BlockBuilder, call: Call) -> Expr:
             "layouts, and thus cannot be legalized by TOPI"
         )
         return call
+    if (
+        re.fullmatch(r"NCHW\d+c", call.attrs.data_layout)
+        and re.fullmatch(r"OIHW\d+i\d+o", call.attrs.kernel_layout)
+        and call.attrs.groups == 1
+    ):
+        if Target.current(allow_none=True) is None:
+            logging.info("Conv2D in the NCHW[x]c layout is legalized only under a target.")
+            return call
+        return bb.call_te(
+            topi.nn.conv2d_NCHWc,
+            call.args[0],
+            call.args[1],
+            stride=call.attrs.strides,
+            padding=call.attrs.padding,
+            dilation=call.attrs.dilation,
+            layout=call.attrs.data_layout,
+            out_layout=call.attrs.out_layout,
+            out_dtype=(
+                call.attrs.out_dtype
+                if call.attrs.out_dtype != ""
+                else call.args[0].struct_info.dtype
+            ),
+            primfunc_name_hint="conv2d_NCHWc",
+        )
     if len(call.attrs.data_layout) != 4 or len(call.attrs.kernel_layout) != 4:
         logging.info(
             "Conv2D where data layout or kernel layout have channel chunk "
@@ -33,7 +33,7 @@ from tvm.tir import IndexMap, PrimFunc
 
 from . import _ffi_api
 from .legalize_ops.common import LegalizeFunc
-from ..expr import Var
+from ..expr import Call, Var
 
 
 @tvm.ffi.register_object("relax.FunctionPass")
@@ -225,6 +225,38 @@ def Gradient(
     return _ffi_api.Gradient(func_name, require_grads, target_index)  # type: ignore
 
 
+def CheckpointActivations(func_name: str, memory_budget: int) -> tvm.ir.transform.Pass:
+    """Choose the activations of a function to recompute in its backward pass, so that the
+    activations kept for the backward pass fit in a memory budget.
+
+    The activations are split into segments separated by checkpoints. The backward pass keeps
+    the checkpoints and recomputes the activations of a segment when it needs them, so its
+    activation memory is estimated as the size of the checkpoints plus the size of the largest
+    segment. Among the segmentations that fit in the budget, the one with the least estimated
+    recomputation is marked with ``relax.op.grad.start_checkpoint`` and
+    ``relax.op.grad.end_checkpoint``, which the Gradient pass applied next follows.
+
+    The recomputed activations are new variables in the backward pass, so StaticPlanBlockMemory
+    can reuse the memory of the original activations after their last use in the forward pass.
+    The function is left unchanged if it already has checkpoint markers, or if all activations
+    fit in the budget.
+
+    Parameters
+    ----------
+    func_name : str
+        The name of the function to be differentiated. It must have only one dataflow block.
+
+    memory_budget : int
+        The memory budget of the activations kept for the backward pass, in bytes.
+
+    Returns
+    -------
+    ret : tvm.ir.transform.Pass
+        The Pass.
+    """
+    return _ffi_api.CheckpointActivations(func_name, memory_budget)  # type: ignore
+
+
 def ToNonDataflow() -> tvm.ir.transform.Pass:
     """Transform all dataflow structure to non-dataflow version.
 
@@ -335,6 +367,15 @@ def LazyGetInput() -> tvm.ir.transform.Pass:
             A = R.match_cast(A_untyped, R.Tensor([16,32], "float32")
             ...
 
+    To transform the weights of an NDArray cache without loading all
+    of them at once, the callback returned by
+    `vm.builtin.ndarray_cache_stream.as_fget_param` reads the cache
+    shard by shard, and does not keep a reference to the parameters it
+    returns.  Each parameter is then freed once the VM drops it, which
+    `KillAfterLastUse` makes happen right after its last use.  The
+    default pipelines include `KillAfterLastUse`, and a custom pipeline
+    must include it as well to bound the memory of the parameters.
+
     Returns
     -------
     ret : tvm.ir.transform.Pass
@@ -480,6 +521,26 @@ def EliminateCommonSubexpr(call_only=False) -> FunctionPass:
     return _ffi_api.EliminateCommonSubexpr(call_only)  # type: ignore
 
 
+def EliminateRedundantCopies() -> tvm.ir.transform.Pass:
+    """Remove the copies of tensors that are not needed within functions.
+
+    Ops that return their input unchanged, such as a permute_dims to the same axes, a reshape,
+    broadcast_to or view to the same shape, or an astype to the same dtype, and call_tir of
+    PrimFuncs that copy their input element by element, are replaced by their input. Chains of
+    permute_dims, reshape and view are folded into one op, and removed if they are a round trip.
+    The bindings left unused are removed.
+
+    Note: Replacing a tensor by its input makes them share memory, so it is skipped in the
+    functions that contain `call_tir_inplace`.
+
+    Returns
+    -------
+    ret : tvm.transform.Pass
+        The registered pass.
+    """
+    return _ffi_api.EliminateRedundantCopies()  # type: ignore
+
+
 def UpdateVDevice(new_vdevice: tvm.ir.VDevice, index: int) -> tvm.ir.transform.Pass:
     """Update virtual device.
 
@@ -531,6 +592,16 @@ def StaticPlanBlockMemory() -> tvm.ir.transform.Pass:
     signature will have upper bound 1024. And we will use 1024 as its value
     during memory planning.
 
+    By default, a storage is reused as a whole by later tensors. With the
+    PassContext config ``"relax.StaticPlanBlockMemory.offset_packing": True``,
+    the tensors of a block are instead packed by offset into one storage per
+    device, so that several small tensors can share the space of a dead large
+    one. Tensors whose size stays symbolic after applying the upper bounds are
+    placed at symbolic offsets after the constant-size ones. The config
+    ``"relax.StaticPlanBlockMemory.exact_packing_limit"`` (default 8) is the
+    largest number of tensors for which the packing is solved exactly rather
+    than greedily.
+
     Returns
     -------
     ret : tvm.ir.transform.Pass
@@ -795,6 +866,13 @@ def FuseOps(fuse_opt_level=-1) -> tvm.ir.transform.Pass:
 
     Note: ConvertToDataflow may need to be called first to provide dataflow blocks.
 
+    When the "relax.FuseOps.cost_model" option of the pass context is set, the fusion
+    decisions are checked against the estimated flops and memory traffic of the fused
+    PrimFuncs. A group is not grown beyond "relax.FuseOps.max_fused_flops" flops, and a
+    producer is not fused into a consumer that reads each of its outputs several times
+    when recomputing it costs more than materializing it, with one byte of memory traffic
+    weighted as "relax.FuseOps.flops_per_byte" flops.
+
     Parameters
     ----------
     fuse_opt_level : int
@@ -820,6 +898,34 @@ def FuseTIR() -> tvm.ir.transform.Pass:
     return _ffi_api.FuseTIR()  # type: ignore
 
 
+def HorizontalFuseOps(max_group_size: int = 8) -> tvm.ir.transform.Pass:
+    """Fuse independent kernels of a dataflow block into one PrimFunc.
+
+    FuseOps only fuses along producer-consumer edges. This pass groups
+    the `call_tir` bindings of elementwise, broadcast, injective and
+    reduction PrimFuncs that are at the same depth of the dataflow
+    graph, so none of them depends on another, and that produce
+    outputs of the same shape. Each group is fused into one PrimFunc
+    by FuseTIR, and the outer loops the kernels of the group share are
+    merged, so the group is launched once and runs in a single
+    iteration space.
+
+    The pass should run after FuseTIR. It is registered at opt_level 3,
+    and is skipped by pass sequences that run at a lower level.
+
+    Parameters
+    ----------
+    max_group_size : int
+        The maximum number of kernels in one fused PrimFunc.
+
+    Returns
+    -------
+    ret : tvm.transform.Pass
+        The registered pass for horizontal fusion.
+    """
+    return _ffi_api.HorizontalFuseOps(max_group_size)  # type: ignore
+
+
 @tvm.ffi.register_object("relax.transform.PatternCheckContext")
 class PatternCheckContext(Object):
     """
@@ -1381,6 +1487,34 @@ def ConvertLayout(desired_layouts: Dict[str, List[str]]) -> tvm.ir.transform.Pas
     return _ffi_api.ConvertLayout(desired_layouts)  # type: ignore
 
 
+def SelectLayout(
+    fcost: Optional[Callable[[Call, str, str], float]] = None,
+) -> tvm.ir.transform.Pass:
+    """Select the layouts of conv2d ops by their estimated cost and convert them.
+
+    Every conv2d in the NCHW layout may run in NCHW, NHWC or one of the NCHW[x]c layouts
+    blocked by the vector width of the current target. The NCHW[x]c layouts are only
+    considered under an llvm target, which their legalization requires. The pass picks the
+    layouts of all the conv2d ops of a dataflow block together by dynamic programming, taking
+    into account the layout transforms needed between them, and converts the layouts with
+    ConvertLayout.
+
+    Parameters
+    ----------
+    fcost : Optional[Callable[[Call, str, str], float]]
+        The function that takes a conv2d call, a data layout and a kernel layout, and returns
+        the cost of the conv2d in these layouts in cycles, for example from measurements. A
+        layout transform costs one cycle per element. When not given, the cost is estimated
+        from the flops of the conv2d and the vector lanes it fills.
+
+    Returns
+    -------
+    ret : tvm.transform.Pass
+        The registered pass for layout selection.
+    """
+    return _ffi_api.SelectLayout(fcost)  # type: ignore
+
+
 def DeadCodeElimination(entry_functions: Optional[List[str]] = None) -> tvm.ir.transform.Pass:
     """Remove dead code in the IRModule.
     Currently it removes:
@@ -1582,6 +1716,8 @@ def RewriteCUDAGraph() -> tvm.ir.transform.Pass:
     """Rewrite a Relax module for executing with CUDA graph. This pass identifies the regions that
     can be executed with CUDA graph and lifts them into new functions for runtime graph capturing.
 
+    The pass is enabled by the PassContext config ``"relax.backend.use_cuda_graph"``.
+
     Returns
     -------
     ret: tvm.ir.transform.Pass
@@ -1590,6 +1726,23 @@ def RewriteCUDAGraph() -> tvm.ir.transform.Pass:
     return _ffi_api.RewriteCUDAGraph()  # type: ignore
 
 
+def RewriteCPUExecPlan() -> tvm.ir.transform.Pass:
+    """Rewrite a Relax module for executing with CPU execution plans. The regions found as in
+    :py:func:`RewriteCUDAGraph` are lifted into new functions, and the VM records the kernel calls
+    of each lifted region into an execution plan that later calls replay without interpreting the
+    bytecode.
+
+    The pass is enabled by the PassContext config ``"relax.backend.use_cpu_exec_plan"``, and
+    ignores ``"relax.backend.use_cuda_graph"``.
+
+    Returns
+    -------
+    ret: tvm.ir.transform.Pass
+        The registered pass for rewriting CPU execution plans
+    """
+    return _ffi_api.RewriteCPUExecPlan()  # type: ignore
+
+
 def AllocateWorkspace() -> tvm.ir.transform.Pass:
     """Allocate a workspace, represented by a tensor of size big enough for all external
     functions that require a temporary storage, and append it to the arguments of external
@@ -474,7 +474,13 @@ class TrackerSession(object):
 
 
 def connect(
-    url, port, key="", session_timeout=0, session_constructor_args=None, enable_logging=False
+    url,
+    port,
+    key="",
+    session_timeout=0,
+    session_constructor_args=None,
+    enable_logging=False,
+    num_streams=1,
 ):
     """Connect to RPC Server
 
@@ -502,6 +508,12 @@ def connect(
     enable_logging: boolean
         flag to enable/disable logging. Logging is disabled by default.
 
+    num_streams: int
+        Number of streams to multiplex over the connection. Calls from different
+        threads then run concurrently on the server, each client thread is bound
+        to one stream. Falls back to a single stream when the server does not
+        support multiplexing or a session constructor is given.
+
     Returns
     -------
     sess : RPCSession
@@ -530,6 +542,8 @@ def connect(
     try:
         if session_timeout:
             key += f" -timeout={session_timeout}"
+        if num_streams > 1 and not session_constructor_args:
+            key += f" -mux={num_streams}"
         session_constructor_args = session_constructor_args if session_constructor_args else []
         if not isinstance(session_constructor_args, (list, tuple)):
             raise TypeError("Expect the session constructor to be a list or tuple")
@@ -120,9 +120,16 @@ def _server_env(load_library, work_path=None):
     return temp
 
 
-def _serve_loop(sock, load_library, work_path):
+# Upper bound of the streams a client can multiplex over one connection.
+MAX_RPC_STREAMS = 64
+
+
+def _serve_loop(sock, load_library, work_path, num_streams=1):
     _server_env(load_library, work_path)
-    _ffi_api.ServerLoop(sock.fileno())
+    if num_streams > 1:
+        _ffi_api.MuxServerLoop(sock.fileno(), num_streams)
+    else:
+        _ffi_api.ServerLoop(sock.fileno())
 
 
 def _parse_server_opt(opts):
@@ -131,6 +138,8 @@ def _parse_server_opt(opts):
     for kv in opts:
         if kv.startswith("-timeout="):
             ret["timeout"] = float(kv[9:])
+        elif kv.startswith("-mux="):
+            ret["mux"] = min(int(kv[5:]), MAX_RPC_STREAMS)
     return ret
 
 
@@ -141,7 +150,9 @@ def _serving(sock, addr, opts, load_library):
     os.chdir(work_path.path)  # Avoiding file name conflict between sessions.
     logger.info(f"start serving at {work_path.path}")
 
-    server_proc = multiprocessing.Process(target=_serve_loop, args=(sock, load_library, work_path))
+    server_proc = multiprocessing.Process(
+        target=_serve_loop, args=(sock, load_library, work_path, opts.get("mux", 1))
+    )
     server_proc.start()
     server_proc.join(opts.get("timeout", None))  # Wait until finish or timeout.
 
@@ -243,10 +254,14 @@ def _listen_loop(sock, port, rpc_key, tracker_addr, load_library, custom_addr):
                 conn.close()
                 logger.warning("mismatch key from %s", addr)
                 continue
+            opts = _parse_server_opt(arr[1:])
+            if opts.get("mux", 1) > 1:
+                # Grant the streams, the client multiplexes only when it sees this.
+                server_key += f" -mux={opts['mux']}"
             conn.sendall(struct.pack("<i", base.RPC_CODE_SUCCESS))
             conn.sendall(struct.pack("<i", len(server_key)))
             conn.sendall(server_key.encode("utf-8"))
-            return conn, addr, _parse_server_opt(arr[1:])
+            return conn, addr, opts
 
     # Server logic
     tracker_conn = None
@@ -302,7 +317,10 @@ def _connect_proxy_loop(addr, key, load_library):
             keylen = struct.unpack("<i", base.recvall(sock, 4))[0]
             remote_key = py_str(base.recvall(sock, keylen))
 
-            _serving(sock, addr, _parse_server_opt(remote_key.split()[1:]), load_library)
+            opts = _parse_server_opt(remote_key.split()[1:])
+            # The proxy answers the client handshake, so no streams are granted.
+            opts.pop("mux", None)
+            _serving(sock, addr, opts, load_library)
             retry_count = 0
         except (socket.error, IOError) as err:
             retry_count += 1
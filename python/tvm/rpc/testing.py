@@ -17,6 +17,8 @@
 
 # pylint: disable=invalid-name,unnecessary-comprehension
 """ Testing functions for the RPC server."""
+import threading
+
 import numpy as np
 import tvm
 
@@ -27,6 +29,18 @@ def _addone(x):
     return x + 1
 
 
+_barriers = {}
+_barriers_lock = threading.Lock()
+
+
+@tvm.register_func("rpc.test.barrier")
+def _barrier(name, parties, timeout):
+    # Only returns once `parties` calls with the same name are in flight at the same time.
+    with _barriers_lock:
+        barrier = _barriers.setdefault(name, threading.Barrier(parties))
+    return barrier.wait(timeout) >= 0
+
+
 @tvm.register_func("rpc.test.strcat")
 def _strcat(name, x):
     return f"{name}:{x}"
@@ -32,6 +32,7 @@ from .executable import Executable
 from .ndarray import device, cpu, cuda, opencl, vulkan, metal
 from .ndarray import vpi, rocm, ext_dev
 from .module import load_module, enabled, system_lib, load_static_library, num_threads
+from .module import numa_nodes, bind_to_numa_node, WorkerPool
 from .container import String, ShapeTuple
 from .object_generic import const
 from .params import (
@@ -44,5 +44,17 @@ def LoadJSON(json_str):
     raise RuntimeError("Do not support object serialization in runtime only mode")
 
 
+def SaveBinary(obj):
+    raise RuntimeError("Do not support object serialization in runtime only mode")
+
+
+def LoadBinary(blob):
+    raise RuntimeError("Do not support object serialization in runtime only mode")
+
+
+def LoadBinaryFile(path):
+    raise RuntimeError("Do not support object serialization in runtime only mode")
+
+
 # Exports functions registered in node namespace.
 tvm.ffi._init_api("node", __name__)
@@ -18,6 +18,7 @@
 with the distributed runtime.
 """
 
+import contextlib
 import logging
 import os
 import pickle
@@ -246,6 +247,51 @@ class Session(Object):
         executing all the existing instructions."""
         return self._sync_worker(0)
 
+    def begin_batch(self) -> None:
+        """Start buffering the subsequent commands on the controller. Instead of being sent one
+        by one, the buffered commands are sent to each worker as a single message when the batch
+        ends, when the batch grows large, or when a reply from a worker is needed."""
+        _ffi_api.SessionBeginBatch(self)  # type: ignore # pylint: disable=no-member
+
+    def end_batch(self) -> int:
+        """Send the buffered commands and stop batching.
+
+        Returns
+        -------
+        fence : int
+            A fence that completes once worker-0 finishes all the commands submitted so far.
+        """
+        return _ffi_api.SessionEndBatch(self)  # type: ignore # pylint: disable=no-member
+
+    def wait_fence(self, fence: int) -> None:
+        """Wait until a fence returned by `end_batch` completes. A single round-trip to worker-0
+        completes all the fences issued before it.
+
+        Parameters
+        ----------
+        fence : int
+            The fence to wait for.
+        """
+        _ffi_api.SessionWaitFence(self, fence)  # type: ignore # pylint: disable=no-member
+
+    @contextlib.contextmanager
+    def batch(self):
+        """A scope in which the commands issued by the controller are batched.
+
+        Examples
+        --------
+        .. code-block:: python
+
+            with sess.batch():
+                for _ in range(num_steps):
+                    sess.call_packed(step_func, state)
+        """
+        self.begin_batch()
+        try:
+            yield
+        finally:
+            self.end_batch()
+
     def copy_from_worker_0(self, host_array: NDArray, remote_array: DRef) -> None:
         """Copy an NDArray from worker-0 to the controller-side NDArray.
 
@@ -319,11 +365,14 @@ class Session(Object):
             - nccl
             - rccl
             - mpi
+            - shm, which communicates through shared host memory and ignores `device_ids`
+            - socket, which connects workers directly over TCP, provides point-to-point
+              transfers only and ignores `device_ids`
 
         *device_ids : int
             The device IDs to be used by the underlying communication library.
         """
-        assert ccl in ("nccl", "rccl"), f"Unsupported CCL backend: {ccl}"
+        assert ccl in ("nccl", "rccl", "shm", "socket"), f"Unsupported CCL backend: {ccl}"
         _ffi_api.SessionInitCCL(self, ccl, ShapeTuple(device_ids))  # type: ignore # pylint: disable=no-member
         self._clear_ipc_memory_pool()
 
@@ -28,6 +28,7 @@ from tvm.base import _RUNTIME_ONLY
 from tvm.libinfo import find_include_path
 
 from . import _ffi_api
+from .object import Object
 
 
 class BenchmarkResult:
@@ -89,6 +90,53 @@ class BenchmarkResult:
         )
 
 
+class AdaptiveBenchmarkResult(BenchmarkResult):
+    """Runtimes from adaptive benchmarking, with the distribution of the samples"""
+
+    def __init__(self, results: Sequence[float], number: int, converged: bool, ci: float):
+        """Construct a new AdaptiveBenchmarkResult.
+
+        Parameters
+        ----------
+        results : Sequence[float]
+            Raw times from benchmarking, each the mean of `number` runs.
+
+        number : int
+            The number of runs averaged into each result.
+
+        converged : bool
+            Whether the target confidence interval was reached.
+
+        ci : float
+            Half-width in seconds of the 95% confidence interval of the mean.
+
+        Attributes
+        ----------
+        percentiles : Dict[int, float]
+            The 5th, 25th, 50th, 75th, 90th, 95th and 99th percentiles of the results.
+        num_outliers : int
+            Number of results outside of the Tukey fences, i.e. further than 1.5 times
+            the interquartile range from the first or third quartile.
+        """
+        super().__init__(results)
+        self.number = number
+        self.converged = converged
+        self.ci = ci
+        self.percentiles = {
+            q: float(np.percentile(self.results, q)) for q in (5, 25, 50, 75, 90, 95, 99)
+        }
+        q1, q3 = self.percentiles[25], self.percentiles[75]
+        lo, hi = q1 - 1.5 * (q3 - q1), q3 + 1.5 * (q3 - q1)
+        self.num_outliers = int(sum(1 for r in self.results if r < lo or r > hi))
+
+    def __repr__(self):
+        return (
+            f"AdaptiveBenchmarkResult(mean={self.mean}, ci={self.ci}, median={self.median}, "
+            f"std={self.std}, num_samples={len(self.results)}, number={self.number}, "
+            f"converged={self.converged}, num_outliers={self.num_outliers})"
+        )
+
+
 class ModulePropertyMask(object):
     """Runtime Module Property Mask."""
 
@@ -393,6 +441,98 @@ class Module(tvm.ffi.Object):
         except NameError:
             raise NameError("time_evaluator is only supported when RPC is enabled")
 
+    def adaptive_time_evaluator(
+        self,
+        func_names,
+        dev,
+        min_repeat=5,
+        max_repeat=100,
+        min_repeat_ms=1,
+        target_rel_ci=0.02,
+        cooldown_interval_ms=0,
+        cache_flush_bytes=0,
+        f_preproc="",
+    ):
+        """Get an evaluator that measures a batch of functions until their runtimes are stable.
+
+        All functions are measured in one call, which saves round trips over RPC.
+        Each round takes one sample of every function that has not converged yet,
+        and a function converges once the 95% confidence interval of its mean is
+        narrower than `target_rel_ci` relative to the mean. Stable kernels thus stop
+        after `min_repeat` samples while noisy ones get up to `max_repeat`.
+
+        Parameters
+        ----------
+        func_names: Union[str, Sequence[str]]
+            The names of the functions in the module, they must take the same arguments.
+
+        dev: Device
+            The device we should run the functions on.
+
+        min_repeat: int, optional
+            The minimum number of samples of each function, at least 2.
+
+        max_repeat: int, optional
+            The maximum number of samples of each function.
+
+        min_repeat_ms: int, optional
+            The minimum duration of one sample in milliseconds. The number of runs
+            averaged into one sample is increased until a sample lasts this long.
+
+        target_rel_ci: float, optional
+            The target half-width of the confidence interval relative to the mean.
+
+        cooldown_interval_ms: int, optional
+            The cooldown interval in milliseconds between rounds.
+
+        cache_flush_bytes: int, optional
+            The number of bytes to flush from the cache before each sample.
+
+        f_preproc: str, optional
+            The preprocess function name executed before each sample,
+            e.g. "cache_flush_cpu_non_first_arg".
+
+        Returns
+        -------
+        ftimer : function
+            The function that takes the arguments of the functions and returns
+            a list with one AdaptiveBenchmarkResult per function.
+        """
+        if isinstance(func_names, str):
+            func_names = [func_names]
+        try:
+            feval = _ffi_api.RPCAdaptiveTimeEvaluator(
+                self,
+                ",".join(func_names),
+                dev.device_type,
+                dev.device_id,
+                min_repeat,
+                max_repeat,
+                min_repeat_ms,
+                target_rel_ci,
+                cooldown_interval_ms,
+                cache_flush_bytes,
+                f_preproc,
+            )
+
+            def evaluator(*args):
+                """Internal wrapped evaluator."""
+                blob = feval(*args)
+                values = struct.unpack("@" + "d" * (len(blob) // 8), blob)
+                results, pos = [], 0
+                for _ in func_names:
+                    num_samples, number, converged, ci = values[pos : pos + 4]
+                    samples = values[pos + 4 : pos + 4 + int(num_samples)]
+                    pos += 4 + int(num_samples)
+                    results.append(
+                        AdaptiveBenchmarkResult(samples, int(number), bool(converged), ci)
+                    )
+                return results
+
+            return evaluator
+        except NameError:
+            raise NameError("adaptive_time_evaluator is only supported when RPC is enabled")
+
     def _collect_from_import_tree(self, filter_func):
         """Helper function to collect modules from the tree matching a filter_func, then return it.
 
@@ -714,3 +854,72 @@ def num_threads() -> int:
         Number of threads in use.
     """
     return _ffi_api.NumThreads()
+
+
+def numa_nodes() -> dict:
+    """Get the CPUs of every NUMA node this process may run on.
+
+    Returns
+    -------
+    dict of int to list of int
+        The CPU ids of each node keyed by node id. One hyper-thread of
+        every physical core comes first.
+    """
+    return {int(node): list(cpus) for node, cpus in _ffi_api.NumaNodes().items()}
+
+
+def bind_to_numa_node(node: int, nthreads: int = 0) -> int:
+    """Bind the thread pool of the calling thread to a NUMA node.
+
+    Parameters
+    ----------
+    node : int
+        The id of the NUMA node.
+
+    nthreads : int
+        The number of threads to use, 0 uses one thread per physical core of the node.
+
+    Returns
+    -------
+    int
+        The number of threads the pool uses.
+    """
+    return _ffi_api.BindToNumaNode(node, nthreads)
+
+
+@tvm.ffi.register_object("runtime.WorkerPool")
+class WorkerPool(Object):
+    """A thread pool that parallel regions can be directed to.
+
+    Models served side by side from one process can each get a pool sized
+    and pinned for them, so their parallel regions run concurrently without
+    oversubscribing the CPUs. See :py:meth:`VirtualMachine.set_worker_pool`.
+
+    Parameters
+    ----------
+    nthreads : int
+        The number of threads, 0 uses one per CPU in cpus, or the default
+        concurrency when cpus is empty.
+
+    cpus : Optional[Sequence[int]]
+        The CPUs the workers run on. When empty, the workers float over all CPUs.
+
+    share_cpus : bool
+        Whether the workers share all of cpus instead of getting one CPU each.
+    """
+
+    # The affinity modes of the pool, mirroring ThreadGroup::AffinityMode.
+    kSpecifyOneCorePerThread = -2
+    kSpecifyThreadShareAllCore = -3
+
+    def __init__(self, nthreads: int = 0, cpus: Sequence[int] = (), share_cpus: bool = False):
+        if share_cpus:
+            mode = WorkerPool.kSpecifyThreadShareAllCore
+        else:
+            mode = WorkerPool.kSpecifyOneCorePerThread
+        self.__init_handle_by_constructor__(_ffi_api.WorkerPool, nthreads, list(cpus), mode)
+
+    @property
+    def num_threads(self) -> int:
+        """The number of threads of the pool."""
+        return _ffi_api.WorkerPoolNumThreads(self)
@@ -88,6 +88,7 @@ class VirtualMachine(object):
         self._get_function_arity = self.module["get_function_arity"]
         self._get_function_param_name = self.module["get_function_param_name"]
         self._set_instrument = self.module["set_instrument"]
+        self._set_worker_pool = self.module["set_worker_pool"]
         self._setup_device(device, memory_cfg)
 
     def _setup_device(self, dev: Device, memory_cfg: Union[str, Dict[Device, str]]) -> None:
@@ -365,6 +366,16 @@ class VirtualMachine(object):
         """
         self._set_instrument(instrument)
 
+    def set_worker_pool(self, pool: Optional[tvm.runtime.WorkerPool]) -> None:
+        """Run the parallel regions of the functions invoked on this VM on a thread pool.
+
+        Parameters
+        ----------
+        pool: Optional[tvm.runtime.WorkerPool]
+            The pool, or None to use the default pool of the calling thread.
+        """
+        self._set_worker_pool(pool)
+
     def time_evaluator(
         self,
         func_name: str,
@@ -228,6 +228,26 @@ def llvm_get_vector_width(target=None):
     return _ffi_api.llvm_get_vector_width(target)
 
 
+def llvm_pgo_write_profile(module, path):
+    """Write the profile collected by a module built with ``-profile-generate``.
+
+    The written file is an indexed LLVM profile that can be passed back to the
+    target with ``-profile-use=<path>`` to rebuild the module with
+    profile-guided optimization.
+
+    Parameters
+    ----------
+    module : Union[tvm.runtime.Module, tvm.runtime.Executable]
+        The module, or an executable returned by ``tvm.compile``.
+
+    path : str
+        The path of the profile to write.
+    """
+    if hasattr(module, "jit"):
+        module = module.jit()
+    _ffi_api.llvm_pgo_write_profile(module, path)
+
+
 def llvm_version_major(allow_none=False):
     """Get the major LLVM version.
 
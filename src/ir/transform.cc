@@ -33,6 +33,7 @@
 
 #include <chrono>
 #include <iomanip>
+#include <optional>
 #include <stack>
 #include <unordered_set>
 
@@ -46,6 +47,7 @@ using tvm::ffi::Any;
 using tvm::ffi::PackedArgs;
 
 TVM_REGISTER_PASS_CONFIG_OPTION("testing.immutable_module", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("transform.use_object_arena", Bool);
 
 struct PassContextThreadLocalEntry {
   /*! \brief The default pass context. */
@@ -306,6 +308,16 @@ IRModule Pass::operator()(IRModule mod, const PassContext& pass_ctx) const {
     return mod;
   }
   IRModule ret;
+  // Allocate the nodes created by the pass from an arena. Nodes that
+  // survive the pass (e.g. the returned module) remain valid after the
+  // scope exits and keep their arena page alive. Only the outermost pass
+  // opens a scope: the passes nested in a Sequential share it, so nodes
+  // handed from one pass to the next do not pin a page per pass.
+  std::optional<ffi::ObjectArenaScope> arena_scope;
+  if (ffi::ObjectArena::Current() == nullptr &&
+      pass_ctx->GetConfig<Bool>("transform.use_object_arena", Bool(false)).value()) {
+    arena_scope.emplace();
+  }
   if (pass_ctx->GetConfig<Bool>("testing.immutable_module", Bool(false)).value()) {
     ret = Pass::AssertImmutableModule(mod, node, pass_ctx);
   } else {
@@ -30,9 +30,20 @@
 namespace tvm {
 namespace meta_schedule {
 
+/*! \brief Hash a module with a handler that reuses the hash values in the cache. */
+template <typename THandler>
+size_t HashWithCacheImpl(const IRModule& mod, SHashCache* cache) {
+  THandler handler;
+  handler.SetCache(cache);
+  return handler.Hash(mod, false);
+}
+
 class ModuleEqualityStructural : public ModuleEquality {
  public:
   size_t Hash(IRModule mod) const { return tvm::StructuralHash()(mod); }
+  size_t HashWithCache(IRModule mod, SHashCache* cache) const {
+    return HashWithCacheImpl<SHashHandlerDefault>(mod, cache);
+  }
   bool Equal(IRModule lhs, IRModule rhs) const { return tvm::StructuralEqual()(lhs, rhs); }
   String GetName() const { return "structural"; }
 };
@@ -57,6 +68,9 @@ class SEqualHandlerIgnoreNDArray : public SEqualHandlerDefault {
 class ModuleEqualityIgnoreNDArray : public ModuleEquality {
  public:
   size_t Hash(IRModule mod) const { return SHashHandlerIgnoreNDArray().Hash(mod, false); }
+  size_t HashWithCache(IRModule mod, SHashCache* cache) const {
+    return HashWithCacheImpl<SHashHandlerIgnoreNDArray>(mod, cache);
+  }
   bool Equal(IRModule lhs, IRModule rhs) const {
     return SEqualHandlerIgnoreNDArray().Equal(lhs, rhs, false);
   }
@@ -20,6 +20,7 @@
 #define TVM_META_SCHEDULE_MODULE_EQUALITY_H_
 
 #include <tvm/ir/module.h>
+#include <tvm/node/structural_hash.h>
 
 #include <memory>
 #include <string>
@@ -33,6 +34,14 @@ class ModuleEquality {
   virtual ~ModuleEquality() = default;
 
   virtual size_t Hash(IRModule mod) const = 0;
+  /*!
+   * \brief Hash a module, reusing and populating the hash values in the cache.
+   * \param mod The module.
+   * \param cache The cache, which keeps the hashed nodes alive. It should only live for one
+   *  batch of hashing, e.g. one round of a search, and only be used with one ModuleEquality.
+   * \return The same value as Hash(mod).
+   */
+  virtual size_t HashWithCache(IRModule mod, SHashCache* cache) const { return Hash(mod); }
   virtual bool Equal(IRModule lhs, IRModule rhs) const = 0;
   virtual String GetName() const = 0;
 
@@ -543,6 +543,9 @@ std::vector<Schedule> EvolutionarySearchNode::State::EvolveWithCostModel(
     exists = this->measured_workloads_;
   }
   SizedHeap heap(num);
+  // The schedules that are not mutated stay in the population across the iterations, so their
+  // hash values are cached for this round of evolution.
+  SHashCache hash_cache;
   for (int iter = 0;; ++iter) {
     // Predict normalized score with the cost model,
     std::vector<double> scores =
@@ -554,7 +557,7 @@ std::vector<Schedule> EvolutionarySearchNode::State::EvolveWithCostModel(
       for (int i = 0, n = population.size(); i < n; ++i) {
         Schedule sch = population.at(i);
         IRModule mod = sch->mod();
-        size_t shash = ModuleHash(mod);
+        size_t shash = database_->GetModuleEquality().HashWithCache(mod, &hash_cache);
         double score = scores.at(i);
         if (!exists.Has(mod, shash)) {
           exists.Add(mod, shash);
@@ -31,8 +31,19 @@
 #include <tvm/node/serialization.h>
 #include <tvm/runtime/ndarray.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
 #include <map>
+#include <memory>
 #include <string>
 
 #include "../support/base64.h"
@@ -645,6 +656,48 @@ class JSONAttrSetter {
   }
 };
 
+/*!
+ * \brief Sort the nodes of a serialized graph so that each node comes after
+ *  all the nodes it depends on through its data and fields.
+ * \param nodes The nodes, each of which provides `data` and `fields` index lists.
+ * \return The topological order.
+ */
+template <typename TNode>
+std::vector<size_t> TopoSortNodes(const std::vector<TNode>& nodes) {
+  size_t n_nodes = nodes.size();
+  std::vector<size_t> topo_order;
+  std::vector<size_t> in_degree(n_nodes, 0);
+  for (const TNode& node : nodes) {
+    for (size_t i : node.data) {
+      ++in_degree[i];
+    }
+    for (size_t i : node.fields) {
+      ++in_degree[i];
+    }
+  }
+  for (size_t i = 0; i < n_nodes; ++i) {
+    if (in_degree[i] == 0) {
+      topo_order.push_back(i);
+    }
+  }
+  for (size_t p = 0; p < topo_order.size(); ++p) {
+    const TNode& node = nodes[topo_order[p]];
+    for (size_t i : node.data) {
+      if (--in_degree[i] == 0) {
+        topo_order.push_back(i);
+      }
+    }
+    for (size_t i : node.fields) {
+      if (--in_degree[i] == 0) {
+        topo_order.push_back(i);
+      }
+    }
+  }
+  ICHECK_EQ(topo_order.size(), n_nodes) << "Cyclic reference detected in serialized graph";
+  std::reverse(std::begin(topo_order), std::end(topo_order));
+  return topo_order;
+}
+
 // json graph structure to store node
 struct JSONGraph {
   // the root of the graph
@@ -695,40 +748,7 @@ struct JSONGraph {
     return g;
   }
 
-  std::vector<size_t> TopoSort() const {
-    size_t n_nodes = nodes.size();
-    std::vector<size_t> topo_order;
-    std::vector<size_t> in_degree(n_nodes, 0);
-    for (const JSONNode& jnode : nodes) {
-      for (size_t i : jnode.data) {
-        ++in_degree[i];
-      }
-      for (size_t i : jnode.fields) {
-        ++in_degree[i];
-      }
-    }
-    for (size_t i = 0; i < n_nodes; ++i) {
-      if (in_degree[i] == 0) {
-        topo_order.push_back(i);
-      }
-    }
-    for (size_t p = 0; p < topo_order.size(); ++p) {
-      const JSONNode& jnode = nodes[topo_order[p]];
-      for (size_t i : jnode.data) {
-        if (--in_degree[i] == 0) {
-          topo_order.push_back(i);
-        }
-      }
-      for (size_t i : jnode.fields) {
-        if (--in_degree[i] == 0) {
-          topo_order.push_back(i);
-        }
-      }
-    }
-    ICHECK_EQ(topo_order.size(), n_nodes) << "Cyclic reference detected in JSON file";
-    std::reverse(std::begin(topo_order), std::end(topo_order));
-    return topo_order;
-  }
+  std::vector<size_t> TopoSort() const { return TopoSortNodes(nodes); }
 };
 
 std::string SaveJSON(Any n) {
@@ -786,8 +806,827 @@ Any LoadJSON(std::string json_str) {
   return nodes.at(jgraph.root);
 }
 
+/*! \brief Magic number of the binary node graph format. */
+constexpr uint64_t kTVMNodeBinaryMagic = 0x4E42534A4D56544BUL;
+/*! \brief Version of the binary node graph format. */
+constexpr uint64_t kTVMNodeBinaryVersion = 1;
+/*! \brief Alignment of NDArray blobs, relative to the beginning of the payload. */
+constexpr size_t kTVMNodeBinaryBlobAlign = 64;
+
+/*!
+ * \brief Tag of an object field value in the binary format.
+ * \note The tags mirror the field kinds handled by JSONAttrGetter.
+ */
+enum class BinaryFieldTag : uint8_t {
+  kNone = 0,
+  kInt = 1,
+  kFloat = 2,
+  kDataType = 3,
+  kRef = 4,
+};
+
+/*!
+ * \brief Buffered writer of the binary format.
+ *
+ *  Small records are batched into a local buffer before reaching the
+ *  stream, large blobs are written through. The writer tracks the number
+ *  of bytes emitted so that NDArray blobs can be aligned in the payload.
+ */
+class BinaryWriter {
+ public:
+  explicit BinaryWriter(dmlc::Stream* strm) : strm_(strm) { buffer_.reserve(kBufferSize); }
+
+  void WriteBytes(const void* data, size_t size) {
+    if (buffer_.size() + size > kBufferSize) {
+      this->Flush();
+      if (size >= kBufferSize) {
+        strm_->Write(data, size);
+        offset_ += size;
+        return;
+      }
+    }
+    buffer_.append(static_cast<const char*>(data), size);
+    offset_ += size;
+  }
+
+  void WriteByte(uint8_t value) { this->WriteBytes(&value, 1); }
+
+  void WriteVarint(uint64_t value) {
+    char buf[10];
+    size_t n = 0;
+    while (value >= 0x80) {
+      buf[n++] = static_cast<char>((value & 0x7F) | 0x80);
+      value >>= 7;
+    }
+    buf[n++] = static_cast<char>(value);
+    this->WriteBytes(buf, n);
+  }
+
+  // zigzag encoding so that small negative values stay small.
+  void WriteSVarint(int64_t value) {
+    this->WriteVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+  }
+
+  void WriteDouble(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    char buf[8];
+    for (int i = 0; i < 8; ++i) {
+      buf[i] = static_cast<char>((bits >> (i * 8)) & 0xFF);
+    }
+    this->WriteBytes(buf, 8);
+  }
+
+  void WriteString(const char* data, size_t size) {
+    this->WriteVarint(size);
+    this->WriteBytes(data, size);
+  }
+
+  void WriteString(const std::string& value) { this->WriteString(value.data(), value.size()); }
+
+  void WriteDataType(DLDataType dtype) {
+    this->WriteVarint(dtype.code);
+    this->WriteVarint(dtype.bits);
+    this->WriteVarint(dtype.lanes);
+  }
+
+  void WritePadding(size_t align) {
+    static const char zeros[kTVMNodeBinaryBlobAlign] = {0};
+    ICHECK_LE(align, kTVMNodeBinaryBlobAlign);
+    this->WriteBytes(zeros, (align - offset_ % align) % align);
+  }
+
+  void Flush() {
+    if (!buffer_.empty()) {
+      strm_->Write(buffer_.data(), buffer_.size());
+      buffer_.clear();
+    }
+  }
+
+ private:
+  static constexpr size_t kBufferSize = 1 << 16;
+  dmlc::Stream* strm_;
+  std::string buffer_;
+  size_t offset_{0};
+};
+
+/*! \brief Bounds-checked reader of the binary format. */
+class BinaryReader {
+ public:
+  BinaryReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+  const char* ReadBytes(size_t size) {
+    ICHECK_LE(size, size_ - offset_) << "LoadBinary: unexpected end of input";
+    const char* ptr = data_ + offset_;
+    offset_ += size;
+    return ptr;
+  }
+
+  uint8_t ReadByte() { return static_cast<uint8_t>(*this->ReadBytes(1)); }
+
+  uint64_t ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+      ICHECK_LT(shift, 64) << "LoadBinary: malformed varint";
+      uint8_t byte = this->ReadByte();
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) break;
+    }
+    return value;
+  }
+
+  int64_t ReadSVarint() {
+    uint64_t value = this->ReadVarint();
+    return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+  }
+
+  double ReadDouble() {
+    const char* buf = this->ReadBytes(8);
+    uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) {
+      bits |= static_cast<uint64_t>(static_cast<uint8_t>(buf[i])) << (i * 8);
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  std::string ReadString() {
+    size_t size = this->ReadVarint();
+    return std::string(this->ReadBytes(size), size);
+  }
+
+  DLDataType ReadDataType() {
+    DLDataType dtype;
+    dtype.code = static_cast<uint8_t>(this->ReadVarint());
+    dtype.bits = static_cast<uint8_t>(this->ReadVarint());
+    dtype.lanes = static_cast<uint16_t>(this->ReadVarint());
+    return dtype;
+  }
+
+  size_t ReadIndex(size_t num_nodes) {
+    uint64_t index = this->ReadVarint();
+    ICHECK_LT(index, num_nodes) << "LoadBinary: node index out of range";
+    return index;
+  }
+
+  void SkipPadding(size_t align) { this->ReadBytes((align - offset_ % align) % align); }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t offset_{0};
+};
+
+/*!
+ * \brief Writes an object graph in the binary format.
+ *
+ *  Layout of the payload:
+ *  - header: magic, format version, tvm version.
+ *  - type table: type key of every distinct type in the graph, whether it
+ *    uses repr bytes, and the names of its reflected fields.
+ *  - nodes: for each node in the NodeIndexer order, a varint type id
+ *    followed by a type dependent record. References to other nodes are
+ *    varint indices into the node list.
+ *  - blobs: the raw data of each NDArray, aligned to kTVMNodeBinaryBlobAlign.
+ */
+class BinaryGraphWriter {
+ public:
+  explicit BinaryGraphWriter(dmlc::Stream* strm) : writer_(strm) {}
+
+  void Save(const Any& root) {
+    NodeIndexer indexer;
+    indexer.MakeIndex(root);
+    node_index_ = &indexer.node_index_;
+    const std::vector<Any>& node_list = indexer.node_list_;
+
+    std::vector<uint64_t> node_type_ids;
+    node_type_ids.reserve(node_list.size());
+    for (const Any& node : node_list) {
+      node_type_ids.push_back(this->GetTypeId(node));
+    }
+
+    writer_.WriteBytes(&kTVMNodeBinaryMagic, sizeof(kTVMNodeBinaryMagic));
+    writer_.WriteVarint(kTVMNodeBinaryVersion);
+    writer_.WriteString(std::string(TVM_VERSION));
+    // type table, the None type (id 0) is implicit.
+    writer_.WriteVarint(types_.size());
+    for (const TypeEntry& entry : types_) {
+      writer_.WriteString(entry.type_key);
+      writer_.WriteByte(entry.has_repr_bytes);
+      writer_.WriteVarint(entry.field_names.size());
+      for (const std::string& name : entry.field_names) {
+        writer_.WriteString(name);
+      }
+    }
+    // nodes
+    writer_.WriteVarint(node_list.size());
+    writer_.WriteVarint(node_index_->at(root));
+    for (size_t i = 0; i < node_list.size(); ++i) {
+      writer_.WriteVarint(node_type_ids[i]);
+      if (node_type_ids[i] != 0) {
+        this->WriteNode(node_list[i], types_[node_type_ids[i] - 1]);
+      }
+    }
+    // blobs
+    writer_.WriteVarint(blobs_.size());
+    for (const runtime::NDArray& arr : blobs_) {
+      this->WriteBlob(arr);
+    }
+    writer_.Flush();
+  }
+
+ private:
+  struct TypeEntry {
+    std::string type_key;
+    uint8_t has_repr_bytes{0};
+    std::vector<std::string> field_names;
+  };
+
+  uint64_t GetTypeId(const Any& node) {
+    if (node == nullptr) return 0;
+    int32_t type_index = node.type_index();
+    auto it = type_ids_.find(type_index);
+    if (it != type_ids_.end()) return it->second;
+
+    TypeEntry entry;
+    entry.type_key = node.GetTypeKey();
+    if (auto opt_object = node.as<const Object*>()) {
+      const Object* obj = opt_object.value();
+      if (type_index != ffi::TypeIndex::kTVMFFIArray && type_index != ffi::TypeIndex::kTVMFFIMap &&
+          type_index != ffi::TypeIndex::kTVMFFINDArray) {
+        if (reflection_->GetReprBytes(obj, nullptr)) {
+          entry.has_repr_bytes = 1;
+        } else {
+          const TVMFFITypeInfo* tinfo = TVMFFIGetTypeInfo(type_index);
+          ICHECK(tinfo->extra_info != nullptr)
+              << "Object `" << obj->GetTypeKey()
+              << "` misses reflection registration and do not support serialization";
+          ffi::reflection::ForEachFieldInfo(tinfo, [&](const TVMFFIFieldInfo* field_info) {
+            entry.field_names.emplace_back(field_info->name.data, field_info->name.size);
+          });
+        }
+      }
+    }
+    types_.emplace_back(std::move(entry));
+    type_ids_[type_index] = types_.size();
+    return types_.size();
+  }
+
+  void WriteNode(const Any& node, const TypeEntry& entry) {
+    switch (node.type_index()) {
+      case ffi::TypeIndex::kTVMFFIBool:
+      case ffi::TypeIndex::kTVMFFIInt: {
+        writer_.WriteSVarint(node.cast<int64_t>());
+        break;
+      }
+      case ffi::TypeIndex::kTVMFFIFloat: {
+        writer_.WriteDouble(node.cast<double>());
+        break;
+      }
+      case ffi::TypeIndex::kTVMFFIDataType: {
+        writer_.WriteDataType(node.cast<DLDataType>());
+        break;
+      }
+      case ffi::TypeIndex::kTVMFFIDevice: {
+        DLDevice dev = node.cast<DLDevice>();
+        writer_.WriteVarint(dev.device_type);
+        writer_.WriteSVarint(dev.device_id);
+        break;
+      }
+      case ffi::TypeIndex::kTVMFFIArray: {
+        const ffi::ArrayObj* n = node.as<const ffi::ArrayObj*>().value();
+        writer_.WriteVarint(n->size());
+        for (const Any& elem : *n) {
+          writer_.WriteVarint(node_index_->at(elem));
+        }
+        break;
+      }
+      case ffi::TypeIndex::kTVMFFIMap: {
+        const ffi::MapObj* n = node.as<const ffi::MapObj*>().value();
+        bool is_str_map = std::all_of(n->begin(), n->end(), [](const auto& v) {
+          return v.first.template as<const ffi::StringObj*>();
+        });
+        writer_.WriteByte(is_str_map);
+        writer_.WriteVarint(n->size());
+        for (const auto& kv : *n) {
+          if (is_str_map) {
+            const ffi::StringObj* key = kv.first.template as<const ffi::StringObj*>().value();
+            writer_.WriteString(key->data, key->size);
+          } else {
+            writer_.WriteVarint(node_index_->at(kv.first));
+          }
+          writer_.WriteVarint(node_index_->at(kv.second));
+        }
+        break;
+      }
+      case ffi::TypeIndex::kTVMFFINDArray: {
+        runtime::NDArray arr = node.cast<runtime::NDArray>();
+        writer_.WriteDataType(arr->dtype);
+        writer_.WriteVarint(arr->ndim);
+        for (int i = 0; i < arr->ndim; ++i) {
+          writer_.WriteSVarint(arr->shape[i]);
+        }
+        writer_.WriteVarint(blobs_.size());
+        blobs_.push_back(arr);
+        break;
+      }
+      default: {
+        const Object* obj = node.as<const Object*>().value();
+        if (entry.has_repr_bytes) {
+          std::string repr_bytes;
+          reflection_->GetReprBytes(obj, &repr_bytes);
+          writer_.WriteString(repr_bytes);
+        } else {
+          this->WriteObjectFields(obj);
+        }
+      }
+    }
+  }
+
+  void WriteObjectFields(const Object* obj) {
+    const TVMFFITypeInfo* tinfo = TVMFFIGetTypeInfo(obj->type_index());
+    ffi::reflection::ForEachFieldInfo(tinfo, [&](const TVMFFIFieldInfo* field_info) {
+      Any field_value = ffi::reflection::FieldGetter(field_info)(obj);
+      switch (field_value.type_index()) {
+        case ffi::TypeIndex::kTVMFFINone: {
+          writer_.WriteByte(static_cast<uint8_t>(BinaryFieldTag::kNone));
+          break;
+        }
+        case ffi::TypeIndex::kTVMFFIBool:
+        case ffi::TypeIndex::kTVMFFIInt: {
+          writer_.WriteByte(static_cast<uint8_t>(BinaryFieldTag::kInt));
+          writer_.WriteSVarint(field_value.cast<int64_t>());
+          break;
+        }
+        case ffi::TypeIndex::kTVMFFIFloat: {
+          writer_.WriteByte(static_cast<uint8_t>(BinaryFieldTag::kFloat));
+          writer_.WriteDouble(field_value.cast<double>());
+          break;
+        }
+        case ffi::TypeIndex::kTVMFFIDataType: {
+          writer_.WriteByte(static_cast<uint8_t>(BinaryFieldTag::kDataType));
+          writer_.WriteDataType(field_value.cast<DLDataType>());
+          break;
+        }
+        default: {
+          if (field_value.type_index() >= ffi::TypeIndex::kTVMFFIStaticObjectBegin) {
+            writer_.WriteByte(static_cast<uint8_t>(BinaryFieldTag::kRef));
+            writer_.WriteVarint(node_index_->at(field_value));
+          } else {
+            LOG(FATAL) << "Unsupported type: " << field_value.GetTypeKey();
+          }
+        }
+      }
+    });
+  }
+
+  void WriteBlob(const runtime::NDArray& arr) {
+    size_t nbytes = runtime::GetDataSize(*arr.operator->());
+    writer_.WriteVarint(nbytes);
+    writer_.WritePadding(kTVMNodeBinaryBlobAlign);
+    if (DMLC_IO_NO_ENDIAN_SWAP && arr->device.device_type == kDLCPU && arr.IsContiguous()) {
+      // quick path, stream directly from the tensor buffer
+      writer_.WriteBytes(static_cast<const char*>(arr->data) + arr->byte_offset, nbytes);
+    } else {
+      std::vector<uint8_t> bytes(nbytes);
+      runtime::NDArray::CopyToBytes(arr.operator->(), dmlc::BeginPtr(bytes), nbytes);
+      if (!DMLC_IO_NO_ENDIAN_SWAP) {
+        size_t elem_bytes = (arr->dtype.bits * arr->dtype.lanes + 7) / 8;
+        dmlc::ByteSwap(dmlc::BeginPtr(bytes), elem_bytes, nbytes / elem_bytes);
+      }
+      writer_.WriteBytes(dmlc::BeginPtr(bytes), nbytes);
+    }
+  }
+
+  BinaryWriter writer_;
+  const std::unordered_map<Any, size_t, ffi::AnyHash, ffi::AnyEqual>* node_index_{nullptr};
+  std::unordered_map<int32_t, uint64_t> type_ids_;
+  std::vector<TypeEntry> types_;
+  std::vector<runtime::NDArray> blobs_;
+  ReflectionVTable* reflection_ = ReflectionVTable::Global();
+};
+
+/*! \brief Loads an object graph saved by BinaryGraphWriter. */
+class BinaryGraphReader {
+ public:
+  BinaryGraphReader(const char* data, size_t size) : reader_(data, size) {}
+  /*!
+   * \brief Load from a payload owned by backing, to which the loaded tensors refer instead of
+   *  copying their data.
+   */
+  BinaryGraphReader(const char* data, size_t size, std::shared_ptr<const void> backing)
+      : reader_(data, size), backing_(std::move(backing)) {}
+
+  Any Load() {
+    uint64_t magic;
+    std::memcpy(&magic, reader_.ReadBytes(sizeof(magic)), sizeof(magic));
+    ICHECK_EQ(magic, kTVMNodeBinaryMagic) << "LoadBinary: invalid magic number";
+    uint64_t version = reader_.ReadVarint();
+    ICHECK_EQ(version, kTVMNodeBinaryVersion) << "LoadBinary: unsupported format version";
+    // tvm version, kept for diagnostics
+    reader_.ReadString();
+    this->ReadTypeTable();
+
+    size_t n_nodes = reader_.ReadVarint();
+    size_t root = reader_.ReadIndex(n_nodes);
+    nodes_.resize(n_nodes);
+    // Pass 1: decode the records and create all non-container objects
+    for (size_t i = 0; i < n_nodes; ++i) {
+      this->ReadNode(&nodes_[i], n_nodes);
+    }
+    // Pass 2: fill in the tensors
+    this->ReadBlobs();
+    // Pass 3: topo sort
+    std::vector<size_t> topo_order = TopoSortNodes(nodes_);
+    // Pass 4: set all values
+    for (size_t i : topo_order) {
+      this->SetAttrs(&nodes_[i]);
+    }
+    return nodes_[root].value;
+  }
+
+ private:
+  enum class Kind : uint8_t {
+    kNone,
+    kBool,
+    kInt,
+    kFloat,
+    kDataType,
+    kDevice,
+    kArray,
+    kMap,
+    kNDArray,
+    kReprBytes,
+    kObject,
+  };
+
+  struct TypeEntry {
+    std::string type_key;
+    Kind kind{Kind::kNone};
+    /*! \brief Field info of each saved field, in saved order. */
+    std::vector<const TVMFFIFieldInfo*> fields;
+  };
+
+  struct FieldValue {
+    const TVMFFIFieldInfo* field_info;
+    Any value;
+    /*! \brief Index of the referenced node if the field is a reference. */
+    int64_t ref_index{-1};
+  };
+
+  struct Node {
+    /*! \brief The decoded value, containers are filled in by SetAttrs. */
+    Any value;
+    const TypeEntry* type{nullptr};
+    /*! \brief Keys of a string map. */
+    std::vector<std::string> keys;
+    /*! \brief Elements of an array or map. */
+    std::vector<size_t> data;
+    /*! \brief Field dependencies. */
+    std::vector<size_t> fields;
+    /*! \brief Decoded field values. */
+    std::vector<FieldValue> field_values;
+  };
+
+  /*! \brief An NDArray record whose data is in the blob section. */
+  struct TensorEntry {
+    Node* node;
+    ffi::Shape shape;
+    DLDataType dtype;
+  };
+
+  /*! \brief Gives an NDArray the data of a blob, keeping the payload alive. */
+  class BackedBlobAlloc {
+   public:
+    BackedBlobAlloc(std::shared_ptr<const void> backing, const char* data)
+        : backing_(std::move(backing)), data_(data) {}
+    void AllocData(DLTensor* tensor) { tensor->data = const_cast<char*>(data_); }
+    void FreeData(DLTensor* tensor) {}
+
+   private:
+    std::shared_ptr<const void> backing_;
+    const char* data_;
+  };
+
+  void ReadTypeTable() {
+    size_t n_types = reader_.ReadVarint();
+    types_.resize(n_types);
+    for (TypeEntry& entry : types_) {
+      entry.type_key = reader_.ReadString();
+      bool has_repr_bytes = reader_.ReadByte() != 0;
+      size_t n_fields = reader_.ReadVarint();
+      std::vector<std::string> field_names;
+      for (size_t i = 0; i < n_fields; ++i) {
+        field_names.push_back(reader_.ReadString());
+      }
+      const std::string& key = entry.type_key;
+      if (key == ffi::StaticTypeKey::kTVMFFINone) {
+        entry.kind = Kind::kNone;
+      } else if (key == ffi::StaticTypeKey::kTVMFFIBool) {
+        entry.kind = Kind::kBool;
+      } else if (key == ffi::StaticTypeKey::kTVMFFIInt) {
+        entry.kind = Kind::kInt;
+      } else if (key == ffi::StaticTypeKey::kTVMFFIFloat) {
+        entry.kind = Kind::kFloat;
+      } else if (key == ffi::StaticTypeKey::kTVMFFIDataType) {
+        entry.kind = Kind::kDataType;
+      } else if (key == ffi::StaticTypeKey::kTVMFFIDevice) {
+        entry.kind = Kind::kDevice;
+      } else if (key == ffi::ArrayObj::_type_key) {
+        entry.kind = Kind::kArray;
+      } else if (key == ffi::MapObj::_type_key) {
+        entry.kind = Kind::kMap;
+      } else if (key == ffi::NDArrayObj::_type_key) {
+        entry.kind = Kind::kNDArray;
+      } else if (has_repr_bytes) {
+        entry.kind = Kind::kReprBytes;
+      } else {
+        entry.kind = Kind::kObject;
+        entry.fields = this->ResolveFields(key, field_names);
+      }
+    }
+  }
+
+  static std::vector<const TVMFFIFieldInfo*> ResolveFields(
+      const std::string& type_key, const std::vector<std::string>& field_names) {
+    const TVMFFITypeInfo* tinfo = TVMFFIGetTypeInfo(ffi::TypeKeyToIndex(type_key));
+    ICHECK(tinfo->extra_info != nullptr)
+        << "Object `" << type_key
+        << "` misses reflection registration and do not support serialization";
+    std::unordered_map<std::string, const TVMFFIFieldInfo*> field_map;
+    ffi::reflection::ForEachFieldInfo(tinfo, [&](const TVMFFIFieldInfo* field_info) {
+      field_map[std::string(field_info->name.data, field_info->name.size)] = field_info;
+    });
+    ICHECK_EQ(field_map.size(), field_names.size())
+        << "LoadBinary: field mismatch for type `" << type_key << "`";
+    std::vector<const TVMFFIFieldInfo*> fields;
+    for (const std::string& name : field_names) {
+      auto it = field_map.find(name);
+      if (it == field_map.end()) {
+        LOG(FATAL) << "LoadBinary: type `" << type_key << "` does not have field " << name;
+      }
+      fields.push_back(it->second);
+    }
+    return fields;
+  }
+
+  void ReadNode(Node* node, size_t n_nodes) {
+    uint64_t type_id = reader_.ReadVarint();
+    if (type_id == 0) return;
+    ICHECK_LE(type_id, types_.size()) << "LoadBinary: type id out of range";
+    node->type = &types_[type_id - 1];
+    switch (node->type->kind) {
+      case Kind::kNone: {
+        break;
+      }
+      case Kind::kBool: {
+        node->value = static_cast<bool>(reader_.ReadSVarint());
+        break;
+      }
+      case Kind::kInt: {
+        node->value = reader_.ReadSVarint();
+        break;
+      }
+      case Kind::kFloat: {
+        node->value = reader_.ReadDouble();
+        break;
+      }
+      case Kind::kDataType: {
+        node->value = reader_.ReadDataType();
+        break;
+      }
+      case Kind::kDevice: {
+        DLDevice dev;
+        dev.device_type = static_cast<DLDeviceType>(reader_.ReadVarint());
+        dev.device_id = static_cast<int32_t>(reader_.ReadSVarint());
+        node->value = dev;
+        break;
+      }
+      case Kind::kArray: {
+        size_t size = reader_.ReadVarint();
+        node->data.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+          node->data.push_back(reader_.ReadIndex(n_nodes));
+        }
+        break;
+      }
+      case Kind::kMap: {
+        bool is_str_map = reader_.ReadByte() != 0;
+        size_t size = reader_.ReadVarint();
+        for (size_t i = 0; i < size; ++i) {
+          if (is_str_map) {
+            node->keys.push_back(reader_.ReadString());
+          } else {
+            node->data.push_back(reader_.ReadIndex(n_nodes));
+          }
+          node->data.push_back(reader_.ReadIndex(n_nodes));
+        }
+        break;
+      }
+      case Kind::kNDArray: {
+        DLDataType dtype = reader_.ReadDataType();
+        std::vector<int64_t> shape(reader_.ReadVarint());
+        for (int64_t& dim : shape) {
+          dim = reader_.ReadSVarint();
+        }
+        size_t blob_index = reader_.ReadVarint();
+        ICHECK_EQ(blob_index, tensors_.size()) << "LoadBinary: NDArray blobs out of order";
+        // the tensor is created when its blob is reached
+        tensors_.push_back(TensorEntry{node, ffi::Shape(std::move(shape)), dtype});
+        break;
+      }
+      case Kind::kReprBytes: {
+        node->value = ObjectRef(reflection_->CreateInitObject(node->type->type_key,
+                                                              reader_.ReadString()));
+        break;
+      }
+      case Kind::kObject: {
+        node->value = ObjectRef(reflection_->CreateInitObject(node->type->type_key));
+        for (const TVMFFIFieldInfo* field_info : node->type->fields) {
+          FieldValue field{field_info, Any(), -1};
+          switch (static_cast<BinaryFieldTag>(reader_.ReadByte())) {
+            case BinaryFieldTag::kNone: {
+              break;
+            }
+            case BinaryFieldTag::kInt: {
+              field.value = reader_.ReadSVarint();
+              break;
+            }
+            case BinaryFieldTag::kFloat: {
+              field.value = reader_.ReadDouble();
+              break;
+            }
+            case BinaryFieldTag::kDataType: {
+              field.value = reader_.ReadDataType();
+              break;
+            }
+            case BinaryFieldTag::kRef: {
+              field.ref_index = reader_.ReadIndex(n_nodes);
+              node->fields.push_back(field.ref_index);
+              break;
+            }
+            default: {
+              LOG(FATAL) << "LoadBinary: unknown field tag";
+            }
+          }
+          node->field_values.emplace_back(std::move(field));
+        }
+        break;
+      }
+    }
+  }
+
+  void ReadBlobs() {
+    size_t n_blobs = reader_.ReadVarint();
+    ICHECK_EQ(n_blobs, tensors_.size()) << "LoadBinary: NDArray blob count mismatch";
+    for (const TensorEntry& entry : tensors_) {
+      size_t nbytes = reader_.ReadVarint();
+      DLTensor spec{nullptr,
+                    {kDLCPU, 0},
+                    static_cast<int32_t>(entry.shape.size()),
+                    entry.dtype,
+                    const_cast<int64_t*>(entry.shape.data()),
+                    nullptr,
+                    0};
+      ICHECK_EQ(nbytes, runtime::GetDataSize(spec)) << "LoadBinary: NDArray blob size mismatch";
+      reader_.SkipPadding(kTVMNodeBinaryBlobAlign);
+      const char* data = reader_.ReadBytes(nbytes);
+      if (backing_ != nullptr && DMLC_IO_NO_ENDIAN_SWAP) {
+        // lazy path, the tensor refers to the blob in the mapped file
+        entry.node->value = runtime::NDArray::FromNDAlloc(BackedBlobAlloc(backing_, data),
+                                                          entry.shape, entry.dtype, {kDLCPU, 0});
+        continue;
+      }
+      runtime::NDArray arr = runtime::NDArray::Empty(entry.shape, entry.dtype, {kDLCPU, 0});
+      arr.CopyFromBytes(data, nbytes);
+      if (!DMLC_IO_NO_ENDIAN_SWAP) {
+        size_t elem_bytes = (arr->dtype.bits * arr->dtype.lanes + 7) / 8;
+        dmlc::ByteSwap(arr->data, elem_bytes, nbytes / elem_bytes);
+      }
+      entry.node->value = arr;
+    }
+  }
+
+  void SetAttrs(Node* node) {
+    if (node->type == nullptr) return;
+    switch (node->type->kind) {
+      case Kind::kArray: {
+        Array<Any> result;
+        result.reserve(node->data.size());
+        for (size_t index : node->data) {
+          result.push_back(nodes_[index].value);
+        }
+        node->value = result;
+        break;
+      }
+      case Kind::kMap: {
+        Map<Any, Any> result;
+        if (node->keys.empty()) {
+          for (size_t i = 0; i < node->data.size(); i += 2) {
+            result.Set(nodes_[node->data[i]].value, nodes_[node->data[i + 1]].value);
+          }
+        } else {
+          for (size_t i = 0; i < node->data.size(); ++i) {
+            result.Set(String(node->keys[i]), nodes_[node->data[i]].value);
+          }
+        }
+        node->value = result;
+        break;
+      }
+      case Kind::kObject: {
+        Object* obj = const_cast<Object*>(node->value.as<const Object*>().value());
+        for (const FieldValue& field : node->field_values) {
+          ffi::reflection::FieldSetter setter(field.field_info);
+          if (field.ref_index >= 0) {
+            setter(obj, nodes_[field.ref_index].value);
+          } else {
+            setter(obj, field.value);
+          }
+        }
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  BinaryReader reader_;
+  /*! \brief The owner of the payload if the tensors may refer to it, or nullptr. */
+  std::shared_ptr<const void> backing_;
+  std::vector<TypeEntry> types_;
+  std::vector<Node> nodes_;
+  std::vector<TensorEntry> tensors_;
+  ReflectionVTable* reflection_ = ReflectionVTable::Global();
+};
+
+void SaveBinary(Any node, dmlc::Stream* strm) { BinaryGraphWriter(strm).Save(node); }
+
+std::string SaveBinary(Any node) {
+  std::string blob;
+  dmlc::MemoryStringStream strm(&blob);
+  SaveBinary(node, &strm);
+  return blob;
+}
+
+Any LoadBinary(const char* data, size_t size) { return BinaryGraphReader(data, size).Load(); }
+
+Any LoadBinary(const std::string& blob) { return LoadBinary(blob.data(), blob.size()); }
+
+#ifndef _WIN32
+/*! \brief A private read-write mapping of a whole file. */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    CHECK_NE(fd, -1) << "LoadBinaryFile: cannot open " << path << ": " << std::strerror(errno);
+    struct stat st;
+    int ret = fstat(fd, &st);
+    if (ret == 0 && st.st_size > 0) {
+      size_ = static_cast<size_t>(st.st_size);
+      // Writes to the tensors stay private to the process.
+      data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    int err = errno;
+    close(fd);
+    CHECK_EQ(ret, 0) << "LoadBinaryFile: cannot stat " << path << ": " << std::strerror(err);
+    CHECK_GT(size_, 0) << "LoadBinaryFile: " << path << " is empty";
+    CHECK(data_ != MAP_FAILED) << "LoadBinaryFile: cannot map " << path << ": "
+                               << std::strerror(err);
+  }
+
+  ~MappedFile() {
+    if (data_ != MAP_FAILED) munmap(data_, size_);
+  }
+
+  const char* data() const { return static_cast<const char*>(data_); }
+  size_t size() const { return size_; }
+
+ private:
+  void* data_{MAP_FAILED};
+  size_t size_{0};
+};
+
+Any LoadBinaryFile(const std::string& path) {
+  auto file = std::make_shared<MappedFile>(path);
+  return BinaryGraphReader(file->data(), file->size(), file).Load();
+}
+#else
+Any LoadBinaryFile(const std::string& path) {
+  std::ifstream fs(path, std::ios::in | std::ios::binary);
+  CHECK(!fs.fail()) << "LoadBinaryFile: cannot open " << path;
+  std::string blob((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+  return LoadBinary(blob);
+}
+#endif
+
 TVM_FFI_STATIC_INIT_BLOCK({
   namespace refl = tvm::ffi::reflection;
-  refl::GlobalDef().def("node.SaveJSON", SaveJSON).def("node.LoadJSON", LoadJSON);
+  refl::GlobalDef()
+      .def("node.SaveJSON", SaveJSON)
+      .def("node.LoadJSON", LoadJSON)
+      .def("node.SaveBinary", [](Any node) { return ffi::Bytes(SaveBinary(node)); })
+      .def("node.LoadBinary", [](ffi::Bytes blob) { return LoadBinary(blob.data(), blob.size()); })
+      .def("node.LoadBinaryFile", [](String path) { return LoadBinaryFile(path); });
 });
 }  // namespace tvm
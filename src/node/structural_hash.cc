@@ -22,6 +22,7 @@
 #include <dmlc/memory_io.h>
 #include <tvm/ffi/function.h>
 #include <tvm/ffi/reflection/registry.h>
+#include <tvm/ir/module.h>
 #include <tvm/node/functor.h>
 #include <tvm/node/node.h>
 #include <tvm/node/object_path.h>
@@ -31,7 +32,11 @@
 #include <tvm/target/codegen.h>
 
 #include <algorithm>
+#include <optional>
+#include <typeindex>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "../support/base64.h"
 #include "../support/str_escape.h"
@@ -50,6 +55,72 @@ void ReflectionVTable::SHashReduce(const Object* self, SHashReducer reducer) con
   fshash_reduce_[tindex](self, reducer);
 }
 
+/*!
+ * \brief Entry of the persistent hash cache.
+ *
+ *  The hash of a subtree is context free unless the subtree contains free
+ *  variables or graph nodes, whose hash depends on the counters and on the
+ *  hashes assigned earlier in the traversal. For such subtrees we record the
+ *  context: the counters before and after the subtree, the memoized values it
+ *  read from outside (inputs), and the values it memoized itself (outputs).
+ */
+struct SHashCacheEntry {
+  /*! \brief The hash value of the subtree. */
+  uint64_t hash;
+  /*! \brief Whether the hash depends on the traversal context. */
+  bool context_dependent{false};
+  /*! \brief The map_free_vars flag the subtree was hashed with. */
+  bool map_free_vars{false};
+  /*! \brief Counter values before and after the subtree. */
+  uint32_t free_var_counter_begin{0};
+  uint32_t free_var_counter_end{0};
+  uint32_t graph_node_counter_begin{0};
+  uint32_t graph_node_counter_end{0};
+  /*! \brief Memoized values read from outside of the subtree. */
+  std::vector<std::pair<ObjectRef, uint64_t>> inputs;
+  /*! \brief Free variables and graph nodes memoized inside the subtree. */
+  std::vector<std::pair<ObjectRef, uint64_t>> outputs;
+};
+
+class SHashCache::Impl {
+ public:
+  explicit Impl(size_t max_entries) : max_entries_(max_entries) {}
+
+  const SHashCacheEntry* Find(const ObjectRef& object) const {
+    auto it = entries_.find(object);
+    return it != entries_.end() ? &it->second : nullptr;
+  }
+
+  void Insert(const ObjectRef& object, SHashCacheEntry entry) {
+    // Keep the entries cached so far once the limit is reached.
+    if (entries_.size() >= max_entries_) return;
+    entries_.emplace(object, std::move(entry));
+  }
+
+  void CheckHandlerType(const std::type_index& handler_type) {
+    if (!handler_type_.has_value()) {
+      handler_type_ = handler_type;
+    }
+    ICHECK(handler_type_.value() == handler_type)
+        << "SHashCache cannot be shared between handlers of different types";
+  }
+
+  /*!
+   * \brief Maximum number of inputs and outputs of a cached entry.
+   *  Bounds the memory spent on recording contexts of large subtrees.
+   */
+  static constexpr size_t kMaxContextSize = 1024;
+
+  std::unordered_map<ObjectRef, SHashCacheEntry, ObjectPtrHash, ObjectPtrEqual> entries_;
+  size_t max_entries_;
+  std::optional<std::type_index> handler_type_;
+};
+
+SHashCache::SHashCache(size_t max_entries) : impl(new Impl(max_entries)) {}
+SHashCache::~SHashCache() { delete impl; }
+void SHashCache::Clear() { impl->entries_.clear(); }
+size_t SHashCache::size() const { return impl->entries_.size(); }
+
 // Hash handler that handles free vars
 // by assigning an unique counter in the order of their occurrence.
 //
@@ -77,14 +148,51 @@ class SHashHandlerDefault::Impl {
     bool children_expanded{false};
     /*! \brief Whether the node is graph node. */
     bool graph_node_hash{false};
+    /*! \brief Whether the node is hashed as a free variable. */
+    bool free_var_hash{false};
     /*! \brief whether to map the free variables. */
     bool map_free_vars;
+    /*! \brief The journal size and memo sequence number when the children were expanded. */
+    size_t journal_begin{0};
+    uint64_t memo_seq_begin{0};
+    /*! \brief The counter values when the children were expanded. */
+    uint32_t free_var_counter_begin{0};
+    uint32_t graph_node_counter_begin{0};
 
     Task() = default;
     explicit Task(ObjectRef object, uint64_t reduced_hash, bool map_free_vars)
         : object(object), reduced_hash(reduced_hash), map_free_vars(map_free_vars) {}
   };
 
+  /*! \brief Memoized hash value of an object in the current traversal. */
+  struct MemoEntry {
+    uint64_t hash;
+    /*! \brief Whether the value depends on the traversal context. */
+    bool context_dependent;
+    /*! \brief Order in which the entry was created. */
+    uint64_t seq;
+  };
+
+  /*!
+   * \brief Use of a context dependent memoized value (input),
+   *  or creation of a free variable or graph node entry (output).
+   *  Only recorded when a cache is attached.
+   */
+  struct JournalEvent {
+    ObjectRef object;
+    uint64_t hash;
+    uint64_t seq;
+    bool is_input;
+  };
+
+  void SetCache(SHashCache* cache) {
+    ICHECK(hash_memo_.empty()) << "SetCache must be called before hashing";
+    if (cache != nullptr) {
+      cache->impl->CheckHandlerType(std::type_index(typeid(*parent_)));
+    }
+    cache_ = cache;
+  }
+
   void MarkGraphNode() {
     // need to push to pending tasks in this case
     ICHECK(!allow_push_to_stack_ && !task_stack_.empty());
@@ -94,7 +202,7 @@ class SHashHandlerDefault::Impl {
   bool LookupHashedValue(const ObjectRef& key, uint64_t* hash_value) {
     auto it = hash_memo_.find(key);
     if (it != hash_memo_.end()) {
-      hash_value[0] = it->second;
+      hash_value[0] = UseMemo(it->first, it->second);
       return true;
     }
     return false;
@@ -106,6 +214,9 @@ class SHashHandlerDefault::Impl {
 
   void SHashReduceFreeVar(const runtime::Object* var, bool map_free_vars) {
     ICHECK(!hash_memo_.count(GetRef<ObjectRef>(var)));
+    if (!allow_push_to_stack_ && !task_stack_.empty() && task_stack_.back().object.get() == var) {
+      task_stack_.back().free_var_hash = true;
+    }
     if (map_free_vars) {
       // use counter value.
       uint64_t value = std::hash<uint64_t>()(free_var_counter_++);
@@ -127,7 +238,7 @@ class SHashHandlerDefault::Impl {
     }
     auto it = hash_memo_.find(object);
     if (it != hash_memo_.end()) {
-      pending_tasks_.emplace_back(Task(ObjectRef(nullptr), it->second, false));
+      pending_tasks_.emplace_back(Task(ObjectRef(nullptr), UseMemo(it->first, it->second), false));
     } else {
       // Push a pending task with initial value.
       pending_tasks_.emplace_back(Task(object, object->GetTypeKeyHash(), map_free_vars));
@@ -154,6 +265,7 @@ class SHashHandlerDefault::Impl {
     ICHECK_EQ(result_stack_.size(), 1U);
     uint64_t ret = result_stack_.back();
     result_stack_.pop_back();
+    journal_.clear();
     return ret;
   }
 
@@ -187,6 +299,92 @@ class SHashHandlerDefault::Impl {
     result_stack_.resize(stack_begin);
     return reduced_hash;
   }
+  /*!
+   * \brief Get a memoized value, recording the use if the value is context dependent.
+   */
+  uint64_t UseMemo(const ObjectRef& object, const MemoEntry& memo) {
+    if (cache_ != nullptr && memo.context_dependent) {
+      journal_.push_back(JournalEvent{object, memo.hash, memo.seq, true});
+    }
+    return memo.hash;
+  }
+  /*!
+   * \brief Memoize the hash of a task whose children have all been reduced.
+   * \param task The task.
+   */
+  void Memoize(const Task& task) {
+    bool is_context_leaf = task.graph_node_hash || task.free_var_hash;
+    bool context_dependent = is_context_leaf || journal_.size() > task.journal_begin;
+    uint64_t seq = memo_seq_++;
+    hash_memo_[task.object] = MemoEntry{task.reduced_hash, context_dependent, seq};
+    if (cache_ == nullptr) return;
+    if (is_context_leaf) {
+      journal_.push_back(JournalEvent{task.object, task.reduced_hash, seq, false});
+    }
+    // IRModuleNode is updated in place, so its identity does not determine its content.
+    if (task.object->IsInstance<IRModuleNode>()) return;
+
+    SHashCacheEntry entry;
+    entry.hash = task.reduced_hash;
+    entry.context_dependent = context_dependent;
+    if (context_dependent) {
+      entry.map_free_vars = task.map_free_vars;
+      entry.free_var_counter_begin = task.free_var_counter_begin;
+      entry.free_var_counter_end = free_var_counter_;
+      entry.graph_node_counter_begin = task.graph_node_counter_begin;
+      entry.graph_node_counter_end = graph_node_counter_;
+      if (journal_.size() - task.journal_begin > SHashCache::Impl::kMaxContextSize) return;
+      for (size_t i = task.journal_begin; i < journal_.size(); ++i) {
+        const JournalEvent& event = journal_[i];
+        if (!event.is_input) {
+          entry.outputs.emplace_back(event.object, event.hash);
+        } else if (event.seq < task.memo_seq_begin) {
+          entry.inputs.emplace_back(event.object, event.hash);
+        }
+      }
+    }
+    cache_->impl->Insert(task.object, std::move(entry));
+  }
+  /*!
+   * \brief Try to reuse the cached hash of the object of a task.
+   * \param task The task, its reduced hash is set on success.
+   * \return Whether the cached value is valid in the current context.
+   */
+  bool TryReuseCache(Task* task) {
+    const SHashCacheEntry* entry = cache_->impl->Find(task->object);
+    if (entry == nullptr) return false;
+    if (entry->context_dependent) {
+      if (entry->map_free_vars != task->map_free_vars ||
+          entry->free_var_counter_begin != free_var_counter_ ||
+          entry->graph_node_counter_begin != graph_node_counter_) {
+        return false;
+      }
+      for (const auto& kv : entry->inputs) {
+        auto it = hash_memo_.find(kv.first);
+        if (it == hash_memo_.end() || it->second.hash != kv.second) return false;
+      }
+      for (const auto& kv : entry->outputs) {
+        if (hash_memo_.count(kv.first)) return false;
+      }
+      // replay the effects of hashing the subtree.
+      for (const auto& kv : entry->inputs) {
+        const MemoEntry& memo = hash_memo_.at(kv.first);
+        journal_.push_back(JournalEvent{kv.first, memo.hash, memo.seq, true});
+      }
+      for (const auto& kv : entry->outputs) {
+        uint64_t seq = memo_seq_++;
+        hash_memo_[kv.first] = MemoEntry{kv.second, true, seq};
+        journal_.push_back(JournalEvent{kv.first, kv.second, seq, false});
+      }
+      free_var_counter_ = entry->free_var_counter_end;
+      graph_node_counter_ = entry->graph_node_counter_end;
+    }
+    task->reduced_hash = entry->hash;
+    if (!hash_memo_.count(task->object)) {
+      hash_memo_[task->object] = MemoEntry{entry->hash, entry->context_dependent, memo_seq_++};
+    }
+    return true;
+  }
   // run the tasks.
   void RunTasks() {
     while (task_stack_.size() != 0) {
@@ -200,7 +398,7 @@ class SHashHandlerDefault::Impl {
         auto it = hash_memo_.find(entry.object);
         if (it != hash_memo_.end()) {
           // use the pre-computed hash for the object.
-          entry.reduced_hash = it->second;
+          entry.reduced_hash = UseMemo(it->first, it->second);
         } else {
           // Append the graph node counter to the hash
           // so that we can distinguish DAG from trees.
@@ -208,7 +406,7 @@ class SHashHandlerDefault::Impl {
             entry.reduced_hash = support::HashCombine(entry.reduced_hash,
                                                       std::hash<uint64_t>()(graph_node_counter_++));
           }
-          hash_memo_[entry.object] = entry.reduced_hash;
+          this->Memoize(entry);
         }
         // send value to parent.
         this->PopTaskStack();
@@ -219,13 +417,19 @@ class SHashHandlerDefault::Impl {
         // check if there are already hash for object.
         auto it = hash_memo_.find(entry.object);
         if (it != hash_memo_.end()) {
-          entry.reduced_hash = it->second;
+          entry.reduced_hash = UseMemo(it->first, it->second);
+          this->PopTaskStack();
+        } else if (cache_ != nullptr && this->TryReuseCache(&entry)) {
           this->PopTaskStack();
         } else {
           // NOTE: important to modify entry before visit.
           // as entry becomes invalid after we change the stack.
           entry.children_expanded = true;
           entry.result_stack_index = result_stack_.size();
+          entry.journal_begin = journal_.size();
+          entry.memo_seq_begin = memo_seq_;
+          entry.free_var_counter_begin = free_var_counter_;
+          entry.graph_node_counter_begin = graph_node_counter_;
 
           ICHECK_EQ(pending_tasks_.size(), 0U);
           allow_push_to_stack_ = false;
@@ -260,12 +464,20 @@ class SHashHandlerDefault::Impl {
   // reflection vtable
   ReflectionVTable* vtable_ = ReflectionVTable::Global();
   // map from lhs to rhs
-  std::unordered_map<ObjectRef, uint64_t, ObjectPtrHash, ObjectPtrEqual> hash_memo_;
+  std::unordered_map<ObjectRef, MemoEntry, ObjectPtrHash, ObjectPtrEqual> hash_memo_;
+  // number of memo entries created so far.
+  uint64_t memo_seq_{0};
+  // the persistent cache, can be nullptr.
+  SHashCache* cache_{nullptr};
+  // journal of the context dependent values, only used with cache.
+  std::vector<JournalEvent> journal_;
 };
 
 SHashHandlerDefault::SHashHandlerDefault() { impl = new Impl(this); }
 SHashHandlerDefault::~SHashHandlerDefault() { delete impl; }
 
+void SHashHandlerDefault::SetCache(SHashCache* cache) { impl->SetCache(cache); }
+
 void SHashHandlerDefault::SHashReduceHashedValue(uint64_t hashed_value) {
   return impl->SHashReduceHashedValue(hashed_value);
 }
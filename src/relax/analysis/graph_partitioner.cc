@@ -19,6 +19,7 @@
 
 #include "./graph_partitioner.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace tvm {
@@ -170,6 +171,7 @@ void GraphPartitioner::MergeFromTo(Group* child, Group* parent) {
   // update the number of nodes of the parent group
   parent->num_nodes += child->num_nodes;
   parent->args_num += child->args_num;
+  parent->flops += child->flops;
   child->parent = parent;
   // update anchor ref and pattern
   if (child->anchor_ref != nullptr) {
@@ -225,6 +227,43 @@ size_t GraphPartitioner::CountFusedNodesWithNewChild(IndexedForwardGraph::Node*
   return target->FindRoot()->num_nodes + CountNodesUptoSink_(child, dom_parent);
 }
 
+double GraphPartitioner::SumFlopsUptoSink_(IndexedForwardGraph::Node* src,
+                                           IndexedForwardGraph::Node* sink,
+                                           std::unordered_set<Group*>* counted_groups) {
+  if (src == sink || visited_.count(src)) return 0;
+  visited_.insert(src);
+  Group* gnode = groups_[src->index];
+  ICHECK(gnode != nullptr);
+  // The whole group of the node is merged, so count the flops of each group once.
+  double sum = counted_groups->insert(gnode->FindRoot()).second ? gnode->FindRoot()->flops : 0;
+  for (auto link = src->outputs.head; link != nullptr; link = link->next) {
+    sum += SumFlopsUptoSink_(link->value.node, sink, counted_groups);
+  }
+  return sum;
+}
+
+bool GraphPartitioner::IsFusionProfitable(IndexedForwardGraph::Node* child,
+                                          IndexedForwardGraph::Node* dom_parent) {
+  if (cost_->max_fused_flops > 0) {
+    Group* target = groups_[dom_parent->index]->FindRoot();
+    std::unordered_set<Group*> counted_groups{target};
+    visited_.clear();
+    double fused_flops = target->flops + SumFlopsUptoSink_(child, dom_parent, &counted_groups);
+    if (fused_flops > cost_->max_fused_flops) {
+      return false;
+    }
+  }
+  double flops = cost_->flops[child->index];
+  double output_bytes = cost_->output_bytes[child->index];
+  double reads_per_element = cost_->reads_per_element[child->index];
+  if (flops < 0 || output_bytes < 0 || reads_per_element < 0) return true;
+  // Once inlined, the child is computed again for every extra read of its output, in exchange of
+  // not writing the output to memory and reading it back.
+  double recompute_flops = (reads_per_element - 1) * flops;
+  double materialize_flops = 2 * output_bytes * cost_->flops_per_byte;
+  return recompute_flops <= materialize_flops;
+}
+
 size_t GraphPartitioner::CountArgs_(IndexedForwardGraph::Node* src,
                                     const IndexedForwardGraph& graph, bool update_postpone) {
   std::unordered_set<Group*> visited_groups;
@@ -317,6 +356,9 @@ void GraphPartitioner::InitGroups(const IndexedForwardGraph& graph) {
       group_node->anchor_ref = graph_node->ref;
     }
     group_node->args_num = args_counter(graph_node->ref);
+    if (cost_ != nullptr) {
+      group_node->flops = std::max(cost_->flops[nid], 0.0);
+    }
     groups_[nid] = group_node;
   }
 }
@@ -355,6 +397,8 @@ void GraphPartitioner::RunFuse(const IndexedForwardGraph& graph,    //
     // refuse the fusion if too many ops are going to be fused together
     if (CountFusedNodesWithNewChild(graph_node, dom_node->parent->gnode) > max_fuse_depth_)
       continue;
+    // Refuse the fusion if the cost estimates tell it does not pay off
+    if (cost_ != nullptr && !IsFusionProfitable(graph_node, dom_node->parent->gnode)) continue;
     // Refuse the fusion if too many arguments are going to be in the fused function
     if (max_function_args_ > 0) {
       auto limit = CountArgsLimit_(graph_node);
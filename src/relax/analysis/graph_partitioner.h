@@ -158,17 +158,40 @@ class DominatorTree {
   Node* GetNode(support::Arena* arena, IndexedForwardGraph::Node* gnode);
 };
 
+/*!
+ * \brief The cost estimates that guide the fusion decisions of GraphPartitioner.
+ *
+ * The estimates are indexed by IndexedForwardGraph::Node::index. A negative estimate means
+ * that the cost is unknown, and the fusion of the node is then decided by the op patterns only.
+ */
+struct FusionCostEstimate {
+  /*! \brief The floating point operations of each node. */
+  std::vector<double> flops;
+  /*! \brief The number of bytes of the output of each node. */
+  std::vector<double> output_bytes;
+  /*!
+   * \brief The number of times each element of the output of a node is read by its consumers,
+   * i.e. how many times the node is computed once it is inlined into the consumers.
+   */
+  std::vector<double> reads_per_element;
+  /*! \brief The maximum floating point operations of a fused group, 0 for no limit. */
+  double max_fused_flops{0};
+  /*! \brief The floating point operations that writing or reading one byte is worth. */
+  double flops_per_byte{0};
+};
+
 /*!
  * \brief A partition of the graph marked by union find data structure.
  */
 class GraphPartitioner {
  public:
   explicit GraphPartitioner(support::Arena* arena, int opt_level, size_t max_fuse_depth,
-                            size_t max_function_args)
+                            size_t max_function_args, const FusionCostEstimate* cost = nullptr)
       : arena_(arena),
         opt_level_(opt_level),
         max_fuse_depth_(max_fuse_depth),
-        max_function_args_(max_function_args) {}
+        max_function_args_(max_function_args),
+        cost_(cost) {}
   /*!
    * \brief Group as a union find data structure.
    */
@@ -192,6 +215,8 @@ class GraphPartitioner {
      * \brief The number of function arguments belonging to this group
      */
     size_t args_num{0};
+    /*! \brief The estimated floating point operations of the nodes in this group */
+    double flops{0};
 
     /*! \brief Optional attributes to annotate the grouped function. */
     Map<String, Any> attrs;
@@ -216,6 +241,8 @@ class GraphPartitioner {
   size_t max_fuse_depth_;
   /*! \brief The maximum number of arguments in one fused function */
   size_t max_function_args_;
+  /*! \brief The cost estimates of the nodes, nullptr if fusion is not guided by costs */
+  const FusionCostEstimate* cost_;
   /*! \brief The internal groups. */
   std::vector<Group*> groups_;
   /*! \brief internal field used for deduplication */
@@ -293,6 +320,14 @@ class GraphPartitioner {
   // limit will be exceeded.
   size_t CountFusedArgs(const IndexedForwardGraph& graph, IndexedForwardGraph::Node* child);
 
+  // Sum the estimated flops of the groups between src and sink, skipping the counted groups.
+  double SumFlopsUptoSink_(IndexedForwardGraph::Node* src, IndexedForwardGraph::Node* sink,
+                           std::unordered_set<Group*>* counted_groups);
+  // Check whether fusing child into the group of dom_parent pays off according to the cost
+  // estimates. The fused group must stay within the flops limit, and inlining the child must not
+  // recompute more than it saves in memory traffic.
+  bool IsFusionProfitable(IndexedForwardGraph::Node* child, IndexedForwardGraph::Node* dom_parent);
+
   // Initialize the groups.
   void InitGroups(const IndexedForwardGraph& graph);
 
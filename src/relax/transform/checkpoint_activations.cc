@@ -0,0 +1,293 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file src/relax/transform/checkpoint_activations.cc
+ * \brief Choose the activations of a function to recompute in its backward pass under a memory
+ * budget, and mark them with start_checkpoint and end_checkpoint for the Gradient pass.
+ *
+ * The backward pass generated by Gradient keeps every checkpointed activation alive from its
+ * computation to its use in the backward pass, and recomputes the other activations from the
+ * checkpoints when the backward pass needs them. The activations between two checkpoints form a
+ * segment, and the activations of a segment are recomputed together. So the activation memory
+ * of the backward pass is estimated as the size of the checkpoints plus the size of the largest
+ * segment, following the sqrt decomposition of gradient checkpointing.
+ *
+ * The activations are split into segments by a size limit. The pass tries a range of limits,
+ * and takes the segmentation that fits in the memory budget with the least recomputation, where
+ * the cost of recomputing an activation is estimated by the bytes that its op reads and writes.
+ */
+
+#include <tvm/ffi/reflection/registry.h>
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/transform.h>
+#include <tvm/relax/utils.h>
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tvm {
+namespace relax {
+
+namespace {
+
+/*! \brief The bytes of a tensor of static shape, or 0 if the size is not static. */
+int64_t StaticTensorBytes(const StructInfo& sinfo) {
+  const auto* tensor_sinfo = sinfo.as<TensorStructInfoNode>();
+  if (tensor_sinfo == nullptr || tensor_sinfo->IsUnknownDtype()) return 0;
+  Optional<Array<PrimExpr>> shape = tensor_sinfo->GetShape();
+  if (!shape.defined()) return 0;
+  int64_t bytes = tensor_sinfo->dtype.bytes() * tensor_sinfo->dtype.lanes();
+  for (const PrimExpr& dim : shape.value()) {
+    const auto* int_dim = dim.as<IntImmNode>();
+    if (int_dim == nullptr) return 0;
+    bytes *= int_dim->value;
+  }
+  return bytes;
+}
+
+/*! \brief An activation of the function. */
+struct Activation {
+  Var var;
+  int64_t bytes{0};
+  /*! \brief The estimated cost of recomputing the activation, or -1 if it cannot be. */
+  double recompute_cost{-1};
+};
+
+/*! \brief The checkpoints picked for a segment size limit. */
+struct Segmentation {
+  std::vector<bool> recompute;
+  double memory{0};
+  double recompute_cost{0};
+};
+
+class ActivationCheckpointer {
+ public:
+  static Function Transform(const Function& func, int64_t memory_budget) {
+    const auto* seq_expr = func->body.as<SeqExprNode>();
+    CHECK(seq_expr && seq_expr->blocks.size() == 1 &&
+          seq_expr->blocks[0]->IsInstance<DataflowBlockNode>())
+        << "CheckpointActivations only supports functions of one dataflow block";
+    DataflowBlock block = Downcast<DataflowBlock>(seq_expr->blocks[0]);
+
+    std::vector<Activation> activations;
+    for (const Binding& binding : block->bindings) {
+      const auto* var_binding = binding.as<VarBindingNode>();
+      CHECK(var_binding) << "CheckpointActivations only supports VarBinding";
+      const auto* call = var_binding->value.as<CallNode>();
+      if (call && (call->op.same_as(Op::Get("relax.grad.start_checkpoint")) ||
+                   call->op.same_as(Op::Get("relax.grad.end_checkpoint")))) {
+        // Keep the checkpoints marked by the user.
+        return func;
+      }
+      Activation activation;
+      activation.var = binding->var;
+      activation.bytes = StaticTensorBytes(GetStructInfo(binding->var));
+      activation.recompute_cost = RecomputeCost(var_binding);
+      activations.push_back(activation);
+    }
+
+    Segmentation best = SelectSegmentation(activations, memory_budget);
+    std::unordered_set<const VarNode*> recompute_vars;
+    for (size_t i = 0; i < activations.size(); ++i) {
+      if (best.recompute[i]) recompute_vars.insert(activations[i].var.get());
+    }
+    if (recompute_vars.empty()) return func;
+    DataflowBlock new_block = ActivationCheckpointer(recompute_vars).MarkCheckpoints(block);
+    Function new_func = func;
+    new_func.CopyOnWrite()->body = SeqExpr({new_block}, seq_expr->body);
+    return new_func;
+  }
+
+ private:
+  explicit ActivationCheckpointer(std::unordered_set<const VarNode*> recompute_vars)
+      : recompute_vars_(std::move(recompute_vars)) {}
+
+  /*!
+   * \brief The cost of recomputing the binding, or -1 if it is not recomputed. Only the pure op
+   * calls computing a tensor from other variables are recomputed, and the function outputs are
+   * always kept.
+   */
+  static double RecomputeCost(const VarBindingNode* binding) {
+    static const auto& purity_map = Op::GetAttrMap<Bool>("FPurity");
+    const auto* call = binding->value.as<CallNode>();
+    const auto* op = call ? call->op.as<OpNode>() : nullptr;
+    if (op == nullptr || !binding->var->IsInstance<DataflowVarNode>() ||
+        !purity_map.get(GetRef<Op>(op), Bool(false))->value) {
+      return -1;
+    }
+    double cost = StaticTensorBytes(GetStructInfo(binding->var));
+    if (cost <= 0) return -1;
+    bool uses_var = false;
+    PostOrderVisit(binding->value, [&](const Expr& expr) {
+      if (expr->IsInstance<VarNode>()) {
+        uses_var = true;
+        cost += StaticTensorBytes(GetStructInfo(expr));
+      }
+    });
+    return uses_var ? cost : -1;
+  }
+
+  /*!
+   * \brief Split the activations into segments no larger than the limit, starting a new segment
+   * with a checkpoint whenever the next activation does not fit.
+   */
+  static Segmentation Segment(const std::vector<Activation>& activations, double limit) {
+    Segmentation result;
+    result.recompute.resize(activations.size(), false);
+    double checkpoint_bytes = 0;
+    double segment_bytes = 0;
+    double max_segment_bytes = 0;
+    for (size_t i = 0; i < activations.size(); ++i) {
+      const Activation& activation = activations[i];
+      if (activation.recompute_cost < 0 && activation.bytes == 0) continue;
+      if (activation.recompute_cost >= 0 && segment_bytes + activation.bytes <= limit) {
+        result.recompute[i] = true;
+        result.recompute_cost += activation.recompute_cost;
+        segment_bytes += activation.bytes;
+      } else {
+        checkpoint_bytes += activation.bytes;
+        max_segment_bytes = std::max(max_segment_bytes, segment_bytes);
+        segment_bytes = 0;
+      }
+    }
+    max_segment_bytes = std::max(max_segment_bytes, segment_bytes);
+    result.memory = checkpoint_bytes + max_segment_bytes;
+    return result;
+  }
+
+  static Segmentation SelectSegmentation(const std::vector<Activation>& activations,
+                                         int64_t memory_budget) {
+    double total_bytes = 0;
+    double min_bytes = std::numeric_limits<double>::infinity();
+    for (const Activation& activation : activations) {
+      total_bytes += activation.bytes;
+      if (activation.recompute_cost >= 0) {
+        min_bytes = std::min(min_bytes, static_cast<double>(activation.bytes));
+      }
+    }
+    // Keeping all the activations costs nothing if it fits.
+    Segmentation best = Segment(activations, 0);
+    if (best.memory <= memory_budget) return best;
+    bool found = false;
+    for (double limit = total_bytes; limit >= min_bytes; limit *= 0.8) {
+      Segmentation candidate = Segment(activations, limit);
+      bool fits = candidate.memory <= memory_budget;
+      if (fits && (!found || candidate.recompute_cost < best.recompute_cost)) {
+        best = candidate;
+        found = true;
+      } else if (!found && candidate.memory < best.memory) {
+        best = candidate;
+      }
+    }
+    if (!found) {
+      LOG(WARNING) << "CheckpointActivations cannot fit the activations in the memory budget of "
+                   << memory_budget << " bytes, the least estimated memory is " << best.memory
+                   << " bytes";
+    }
+    return best;
+  }
+
+  /*!
+   * \brief Mark the recomputed activations for the Gradient pass. A recomputed activation whose
+   * inputs are all checkpoints reads them through start_checkpoint, and a checkpoint reads the
+   * recomputed activations through end_checkpoint.
+   */
+  DataflowBlock MarkCheckpoints(const DataflowBlock& block) {
+    for (const Binding& binding : block->bindings) {
+      const auto* var_binding = binding.as<VarBindingNode>();
+      bool recompute = recompute_vars_.count(binding->var.get());
+      bool reads_recomputed = false;
+      PostOrderVisit(var_binding->value, [&](const Expr& expr) {
+        if (recompute_vars_.count(expr.as<VarNode>())) reads_recomputed = true;
+      });
+      Map<Var, Expr> binds;
+      if (recompute && !reads_recomputed) {
+        PostOrderVisit(var_binding->value, [&](const Expr& expr) {
+          if (const auto* var = expr.as<VarNode>()) {
+            binds.Set(GetRef<Var>(var), GetMarker(GetRef<Var>(var), &start_vars_, true));
+          }
+        });
+      } else if (!recompute && reads_recomputed) {
+        PostOrderVisit(var_binding->value, [&](const Expr& expr) {
+          if (const auto* var = expr.as<VarNode>(); var && recompute_vars_.count(var)) {
+            binds.Set(GetRef<Var>(var), GetMarker(GetRef<Var>(var), &end_vars_, false));
+          }
+        });
+      }
+      if (binds.empty()) {
+        bindings_.push_back(binding);
+      } else {
+        bindings_.push_back(VarBinding(binding->var, Bind(var_binding->value, binds)));
+      }
+    }
+    return DataflowBlock(bindings_, block->span);
+  }
+
+  /*! \brief Get the marker variable of the variable, emitting its binding when first used. */
+  Var GetMarker(const Var& var, std::unordered_map<const VarNode*, Var>* markers, bool start) {
+    auto it = markers->find(var.get());
+    if (it != markers->end()) return it->second;
+    static const Op& start_op = Op::Get("relax.grad.start_checkpoint");
+    static const Op& end_op = Op::Get("relax.grad.end_checkpoint");
+    Call value(start ? start_op : end_op, {var});
+    UpdateStructInfo(value, GetStructInfo(var));
+    Var marker = DataflowVar(var->name_hint() + (start ? "_start_cp" : "_end_cp"),
+                             GetStructInfo(var));
+    bindings_.push_back(VarBinding(marker, value));
+    markers->emplace(var.get(), marker);
+    return marker;
+  }
+
+  std::unordered_set<const VarNode*> recompute_vars_;
+  std::unordered_map<const VarNode*, Var> start_vars_;
+  std::unordered_map<const VarNode*, Var> end_vars_;
+  Array<Binding> bindings_;
+};
+
+}  // namespace
+
+namespace transform {
+
+Pass CheckpointActivations(String func_name, int64_t memory_budget) {
+  auto pass_func = [=](IRModule mod, PassContext pc) {
+    auto func = mod->Lookup(func_name).as<Function>();
+    CHECK(func) << func_name << " is not a Relax Function";
+    Function new_func = ActivationCheckpointer::Transform(func.value(), memory_budget);
+    if (new_func.same_as(func.value())) return mod;
+    mod.CopyOnWrite()->Update(mod->GetGlobalVar(func_name), new_func);
+    return mod;
+  };
+  return CreateModulePass(/*pass_function=*/pass_func,
+                          /*opt_level=*/0,
+                          /*pass_name=*/"CheckpointActivations",
+                          /*required=*/{});
+}
+
+TVM_FFI_STATIC_INIT_BLOCK({
+  namespace refl = tvm::ffi::reflection;
+  refl::GlobalDef().def("relax.transform.CheckpointActivations", CheckpointActivations);
+});
+
+}  // namespace transform
+}  // namespace relax
+}  // namespace tvm
@@ -78,8 +78,9 @@ using tir::Layout;
  */
 class LayoutConvertMutator : public ExprMutator {
  public:
-  explicit LayoutConvertMutator(const Map<String, Array<String>>& desired_layouts)
-      : desired_layouts_(desired_layouts) {}
+  explicit LayoutConvertMutator(const Map<String, Array<String>>& desired_layouts,
+                                const Map<Var, Map<String, Array<String>>>& binding_layouts = {})
+      : desired_layouts_(desired_layouts), binding_layouts_(binding_layouts) {}
 
  private:
   Array<Integer> LayoutToIntegers(const Layout& layout) {
@@ -215,8 +216,8 @@ class LayoutConvertMutator : public ExprMutator {
   }
 
   void VisitBinding_(const VarBindingNode* binding, const CallNode* call_node) final {
-    Optional<InferLayoutOutput> res =
-        GetInferLayoutInfo(call_node, desired_layouts_, var_layout_map_);
+    Optional<InferLayoutOutput> res = GetInferLayoutInfo(
+        call_node, binding_layouts_.Get(binding->var).value_or(desired_layouts_), var_layout_map_);
     ObjectPtr<CallNode> new_call = make_object<CallNode>(*call_node);
     new_call->struct_info_ = std::nullopt;
     if (!res.defined() ||
@@ -333,11 +334,14 @@ class LayoutConvertMutator : public ExprMutator {
 
   std::unordered_map<Var, NLayout> var_layout_map_;
   Map<String, Array<String>> desired_layouts_;
+  // The desired layouts of specific bindings, which take precedence over desired_layouts_.
+  Map<Var, Map<String, Array<String>>> binding_layouts_;
 };  // namespace relax
 
 DataflowBlock ConvertLayoutPass(const DataflowBlock& df_block,
-                                Map<String, Array<String>> desired_layouts) {
-  LayoutConvertMutator mutator(desired_layouts);
+                                Map<String, Array<String>> desired_layouts,
+                                Map<Var, Map<String, Array<String>>> binding_layouts) {
+  LayoutConvertMutator mutator(desired_layouts, binding_layouts);
   return Downcast<DataflowBlock>(mutator.VisitBindingBlock(df_block));
 }
 
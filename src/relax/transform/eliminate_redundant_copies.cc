@@ -0,0 +1,330 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file src/relax/transform/eliminate_redundant_copies.cc
+ * \brief Remove the copies of tensors that are not needed.
+ *
+ * The pass rewrites the following bindings of a function, looking through the bindings of all
+ * its blocks:
+ *
+ * - Ops that return their input unchanged, such as a permute_dims to the same axes, a reshape,
+ *   broadcast_to or view to the same shape, or an astype to the same dtype, and call_tir of
+ *   PrimFuncs that copy their input to their output element by element, are replaced by their
+ *   input.
+ * - Chains of permute_dims, of reshape and of view are folded into one op, which is removed
+ *   too if the chain is a round trip.
+ *
+ * Replacing a tensor by its input makes both names refer to the same memory. This is safe in
+ * the pure dataflow of Relax, but not when an in-place call or an impure call, such as a packed
+ * function that writes its arguments, may write either of them, so the replacement is skipped in
+ * the functions that contain call_tir_inplace or any impure call. The bindings left unused by the
+ * rewrite are removed.
+ */
+
+#include <tvm/arith/analyzer.h>
+#include <tvm/ffi/reflection/registry.h>
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/attrs/datatype.h>
+#include <tvm/relax/attrs/manipulate.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/transform.h>
+#include <tvm/tir/stmt_functor.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../op/memory/view.h"
+#include "../op/tensor/manipulate.h"
+
+namespace tvm {
+namespace relax {
+
+namespace {
+
+/*! \brief Check whether the PrimFunc copies its only input to its output element by element. */
+bool IsIdentityCopy(const tir::PrimFunc& func) {
+  if (func->params.size() != 2) return false;
+  Optional<tir::Buffer> input = func->buffer_map.Get(func->params[0]);
+  Optional<tir::Buffer> output = func->buffer_map.Get(func->params[1]);
+  if (!input || !output || input.value()->dtype != output.value()->dtype ||
+      output.value()->shape.empty()) {
+    return false;
+  }
+  std::vector<const tir::BlockRealizeNode*> realizes;
+  int num_stores = 0;
+  tir::PostOrderVisit(func->body, [&](const ObjectRef& obj) {
+    if (const auto* realize = obj.as<tir::BlockRealizeNode>()) {
+      if (!realize->block->iter_vars.empty()) realizes.push_back(realize);
+    } else if (obj->IsInstance<tir::BufferStoreNode>()) {
+      ++num_stores;
+    }
+  });
+  if (realizes.size() != 1 || num_stores != 1) return false;
+  const tir::BlockRealizeNode* realize = realizes[0];
+  const tir::BlockNode* block = realize->block.get();
+  const auto* store = block->body.as<tir::BufferStoreNode>();
+  if (store == nullptr || block->init.defined() || !tir::is_one(realize->predicate) ||
+      !store->buffer.same_as(output.value()) ||
+      block->iter_vars.size() != output.value()->shape.size()) {
+    return false;
+  }
+  PrimExpr value = store->value;
+  if (const auto* cast = value.as<tir::CastNode>()) {
+    if (cast->value->dtype != cast->dtype) return false;
+    value = cast->value;
+  }
+  const auto* load = value.as<tir::BufferLoadNode>();
+  if (load == nullptr || !load->buffer.same_as(input.value())) return false;
+
+  arith::Analyzer analyzer;
+  std::unordered_set<const tir::VarNode*> loop_vars;
+  for (size_t i = 0; i < block->iter_vars.size(); ++i) {
+    const tir::IterVar& iter = block->iter_vars[i];
+    const auto* binding = realize->iter_values[i].as<tir::VarNode>();
+    // Every element of the output is written once from the same element of the input.
+    if (iter->iter_type != tir::kDataPar || binding == nullptr ||
+        !loop_vars.insert(binding).second || !tir::is_zero(iter->dom->min) ||
+        !analyzer.CanProveEqual(iter->dom->extent, output.value()->shape[i]) ||
+        !analyzer.CanProveEqual(iter->dom->extent, input.value()->shape[i]) ||
+        !store->indices[i].same_as(iter->var) || !load->indices[i].same_as(iter->var)) {
+      return false;
+    }
+  }
+  return load->indices.size() == block->iter_vars.size();
+}
+
+/*! \brief Check whether the function writes any tensor in place. */
+bool HasInplaceCall(const Expr& func) {
+  static const Op& call_tir_inplace_op = Op::Get("relax.call_tir_inplace");
+  bool found = false;
+  PostOrderVisit(func, [&](const Expr& expr) {
+    if (const auto* call = expr.as<CallNode>()) {
+      found = found || call->op.same_as(call_tir_inplace_op);
+    }
+  });
+  return found;
+}
+
+class RedundantCopyEliminator : public ExprMutator {
+ public:
+  explicit RedundantCopyEliminator(const IRModule& mod) : ExprMutator(mod), mod_(mod) {}
+
+  Function Transform(const Function& func) {
+    allow_alias_ = !HasInplaceCall(func) && !ContainsImpureCall(func);
+    changed_ = false;
+    Function new_func = Downcast<Function>(VisitExpr(func));
+    if (!changed_) return func;
+    return Downcast<Function>(RemoveAllUnused(new_func));
+  }
+
+ private:
+  using ExprMutator::VisitBinding_;
+
+  BindingBlock VisitBindingBlock_(const DataflowBlockNode* block) final {
+    ++block_index_;
+    return ExprMutator::VisitBindingBlock_(block);
+  }
+
+  void VisitBinding_(const VarBindingNode* binding, const CallNode* call_node) final {
+    Call call = Downcast<Call>(VisitExpr(GetRef<Call>(call_node)));
+    Expr value = call;
+    if (Optional<Expr> simplified = Simplify(call)) {
+      changed_ = true;
+      value = simplified.value();
+      if (value->IsInstance<VarNode>() && binding->var->IsInstance<DataflowVarNode>()) {
+        var_remap_[binding->var->vid] = Downcast<Var>(value);
+        return;
+      }
+      value = builder_->Normalize(value);
+    }
+    ReEmitBinding(binding, value);
+    Var new_var = Downcast<Var>(VisitExpr(binding->var));
+    if (new_var->IsInstance<DataflowVarNode>()) {
+      dataflow_var_blocks_[new_var.get()] = block_index_;
+    }
+    if (const auto* new_call = value.as<CallNode>()) {
+      producers_[new_var.get()] = GetRef<Call>(new_call);
+    }
+  }
+
+  /*! \brief Simplify the call, or return std::nullopt if it cannot be simplified. */
+  Optional<Expr> Simplify(const Call& call) {
+    static const Op& permute_dims_op = Op::Get("relax.permute_dims");
+    static const Op& reshape_op = Op::Get("relax.reshape");
+    static const Op& view_op = Op::Get("relax.memory.view");
+    static const Op& broadcast_to_op = Op::Get("relax.broadcast_to");
+    static const Op& astype_op = Op::Get("relax.astype");
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+
+    if (call->op.same_as(permute_dims_op)) {
+      return SimplifyPermuteDims(call);
+    } else if (call->op.same_as(reshape_op)) {
+      Expr data = call->args[0];
+      bool folded = false;
+      if (Optional<Call> producer = GetProducer(data, reshape_op)) {
+        data = producer.value()->args[0];
+        folded = true;
+      }
+      if (AliasOf(data, call)) return data;
+      if (folded) return reshape(data, call->args[1]);
+    } else if (call->op.same_as(view_op)) {
+      if (!IsShapeOnlyView(call)) return std::nullopt;
+      Expr data = call->args[0];
+      bool folded = false;
+      if (Optional<Call> producer = GetProducer(data, view_op)) {
+        if (IsShapeOnlyView(producer.value())) {
+          data = producer.value()->args[0];
+          folded = true;
+        }
+      }
+      if (AliasOf(data, call)) return data;
+      if (folded) return view(data, call->args[1], std::nullopt, std::nullopt);
+    } else if (call->op.same_as(broadcast_to_op) || call->op.same_as(astype_op)) {
+      if (AliasOf(call->args[0], call)) return call->args[0];
+    } else if (call->op.same_as(call_tir_op)) {
+      const auto* args = call->args[1].as<TupleNode>();
+      const auto* gvar = call->args[0].as<GlobalVarNode>();
+      if (args == nullptr || args->fields.size() != 1 || gvar == nullptr) return std::nullopt;
+      auto func = mod_->functions.Get(GetRef<GlobalVar>(gvar));
+      if (func && func.value()->IsInstance<tir::PrimFuncNode>() &&
+          IsIdentityCopy(Downcast<tir::PrimFunc>(func.value())) &&
+          AliasOf(args->fields[0], call)) {
+        return args->fields[0];
+      }
+    }
+    return std::nullopt;
+  }
+
+  Optional<Expr> SimplifyPermuteDims(const Call& call) {
+    static const Op& permute_dims_op = Op::Get("relax.permute_dims");
+    Expr data = call->args[0];
+    const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(data);
+    if (sinfo == nullptr || sinfo->IsUnknownNdim()) return std::nullopt;
+    std::vector<int64_t> axes = GetAxes(call, sinfo->ndim);
+    bool folded = false;
+    if (Optional<Call> producer = GetProducer(data, permute_dims_op)) {
+      const auto* producer_sinfo = GetStructInfoAs<TensorStructInfoNode>(producer.value()->args[0]);
+      if (producer_sinfo && !producer_sinfo->IsUnknownNdim()) {
+        // The i-th axis of the result is the axes[i]-th axis of the producer, which is the
+        // inner_axes[axes[i]]-th axis of the producer input.
+        std::vector<int64_t> inner_axes = GetAxes(producer.value(), producer_sinfo->ndim);
+        for (int64_t& axis : axes) axis = inner_axes[axis];
+        data = producer.value()->args[0];
+        folded = true;
+      }
+    }
+    bool identity = true;
+    for (size_t i = 0; i < axes.size(); ++i) {
+      identity = identity && axes[i] == static_cast<int64_t>(i);
+    }
+    if (identity && AliasOf(data, call)) return data;
+    if (!folded) return std::nullopt;
+    Array<Integer> new_axes;
+    for (int64_t axis : axes) new_axes.push_back(Integer(axis));
+    return permute_dims(data, new_axes);
+  }
+
+  static std::vector<int64_t> GetAxes(const Call& call, int ndim) {
+    const auto* attrs = call->attrs.as<PermuteDimsAttrs>();
+    std::vector<int64_t> axes;
+    if (attrs->axes.defined()) {
+      for (const Integer& axis : attrs->axes.value()) {
+        axes.push_back(axis->value < 0 ? axis->value + ndim : axis->value);
+      }
+    } else {
+      for (int i = ndim - 1; i >= 0; --i) axes.push_back(i);
+    }
+    return axes;
+  }
+
+  static bool IsShapeOnlyView(const Call& call) {
+    auto is_void = [](const Expr& expr) {
+      const auto* tuple = expr.as<TupleNode>();
+      return tuple && tuple->fields.empty();
+    };
+    return !is_void(call->args[1]) && is_void(call->args[2]) && is_void(call->args[3]);
+  }
+
+  /*!
+   * \brief Get the call of the op that produced the expression, if the input of the call can be
+   * used in the current block.
+   */
+  Optional<Call> GetProducer(const Expr& expr, const Op& op) {
+    auto it = producers_.find(expr.get());
+    if (it == producers_.end() || !it->second->op.same_as(op)) return std::nullopt;
+    const Expr& input = it->second->args[0];
+    if (input->IsInstance<DataflowVarNode>() &&
+        dataflow_var_blocks_[input.get()] != block_index_) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  /*! \brief Check whether the data can stand for the result of the call. */
+  bool AliasOf(const Expr& data, const Call& call) {
+    if (!allow_alias_ || !data->IsInstance<VarNode>()) return false;
+    const auto* data_sinfo = GetStructInfoAs<TensorStructInfoNode>(data);
+    const auto* call_sinfo = GetStructInfoAs<TensorStructInfoNode>(call);
+    if (data_sinfo == nullptr || call_sinfo == nullptr || data_sinfo->dtype != call_sinfo->dtype ||
+        data_sinfo->IsUnknownDtype()) {
+      return false;
+    }
+    Optional<Array<PrimExpr>> data_shape = data_sinfo->GetShape();
+    Optional<Array<PrimExpr>> call_shape = call_sinfo->GetShape();
+    if (!data_shape || !call_shape || data_shape.value().size() != call_shape.value().size()) {
+      return false;
+    }
+    for (size_t i = 0; i < data_shape.value().size(); ++i) {
+      if (!analyzer_.CanProveEqual(data_shape.value()[i], call_shape.value()[i])) return false;
+    }
+    return true;
+  }
+
+  IRModule mod_;
+  arith::Analyzer analyzer_;
+  bool allow_alias_{true};
+  bool changed_{false};
+  /*! \brief The op calls that produced the variables of the function. */
+  std::unordered_map<const Object*, Call> producers_;
+  /*! \brief The index of the current dataflow block. */
+  int block_index_{0};
+  /*! \brief The index of the dataflow block defining each dataflow variable. */
+  std::unordered_map<const Object*, int> dataflow_var_blocks_;
+};
+
+}  // namespace
+
+namespace transform {
+
+Pass EliminateRedundantCopies() {
+  auto pass_func = [=](Function func, IRModule mod, PassContext pc) {
+    return RedundantCopyEliminator(mod).Transform(func);
+  };
+  return CreateFunctionPass(pass_func, 1, "EliminateRedundantCopies", {});
+}
+
+TVM_FFI_STATIC_INIT_BLOCK({
+  namespace refl = tvm::ffi::reflection;
+  refl::GlobalDef().def("relax.transform.EliminateRedundantCopies", EliminateRedundantCopies);
+});
+
+}  // namespace transform
+}  // namespace relax
+}  // namespace tvm
@@ -25,22 +25,142 @@
 #include <tvm/relax/transform.h>
 #include <tvm/relax/type.h>
 #include <tvm/runtime/module.h>
+#include <tvm/runtime/threading_backend.h>
 #include <tvm/tir/function.h>
 #include <tvm/tir/op.h>
+#include <tvm/tir/stmt_functor.h>
+
+#include <exception>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace tvm {
 namespace relax {
 
+/*!
+ * \brief The PrimFuncs built for constant evaluation, looked up via structural equality.
+ * \details One cache is shared by all the functions folded in one run of the FoldConstant
+ * pass, so that a PrimFunc that appears in many functions, or is created again by
+ * legalization, is only built once. The cache, and the modules it built, are released at the
+ * end of the run.
+ */
+class ConstEvalBuildCache {
+ public:
+  /*!
+   * \brief Get the built version of func, building it if it is not built yet.
+   * \return The built func, nullopt if func cannot be built.
+   */
+  Optional<ffi::Function> Get(const tir::PrimFunc& func) {
+    auto it = cache_.find(func);
+    if (it != cache_.end()) {
+      return it->second;
+    }
+    Optional<ffi::Function> build_func = std::nullopt;
+    try {
+      // Not all the primfunc can be directly built via llvm, for example, if a function is
+      // already scheduled to only work on GPU, we will need to skip this in the const folder for
+      // now
+      // TODO(Hongyi): further check and narrow the scope of foldable function
+      runtime::Module rt_module =
+          Build(WithAttr(func, tvm::attr::kGlobalSymbol, String("tir_function")));
+      build_func = rt_module.GetFunction("tir_function");
+    } catch (const tvm::Error& err) {
+      // build failure may happen in which case we skip
+      DLOG(WARNING) << "Build failure for function " << func << ", Error message: " << err.what();
+    }
+    cache_[func] = build_func;
+    return build_func;
+  }
+
+  /*!
+   * \brief Build the funcs that are not built yet together in one module, which pays the
+   * fixed cost of a build once rather than once per func.
+   * \note If the module fails to build, the funcs are left to be built one by one by Get, so
+   * that a func that cannot be built does not prevent the others from being folded.
+   */
+  void BuildAll(const std::vector<tir::PrimFunc>& funcs) {
+    IRModule mod;
+    std::vector<std::pair<tir::PrimFunc, std::string>> to_build;
+    for (const tir::PrimFunc& func : funcs) {
+      if (cache_.count(func) ||
+          std::any_of(to_build.begin(), to_build.end(),
+                      [&](const auto& item) { return StructuralEqual()(item.first, func); })) {
+        continue;
+      }
+      std::string symbol = "tir_function_" + std::to_string(to_build.size());
+      mod->Add(GlobalVar(symbol), WithAttr(func, tvm::attr::kGlobalSymbol, String(symbol)));
+      to_build.emplace_back(func, symbol);
+    }
+    if (to_build.size() < 2) {
+      return;
+    }
+    try {
+      runtime::Module rt_module = Build(mod);
+      for (const auto& [func, symbol] : to_build) {
+        cache_[func] = rt_module.GetFunction(symbol);
+      }
+    } catch (const tvm::Error& err) {
+      DLOG(WARNING) << "Batched build failure, Error message: " << err.what();
+    }
+  }
+
+ private:
+  /*! \brief Build a PrimFunc or an IRModule of PrimFuncs for the host. */
+  static runtime::Module Build(ObjectRef mod) {
+    Target eval_cpu_target{"llvm"};
+    const auto pf = tvm::ffi::Function::GetGlobalRequired("tir.build");
+    return pf(mod, eval_cpu_target).cast<runtime::Module>();
+  }
+
+  // cache for function build, via structural equality
+  std::unordered_map<tir::PrimFunc, Optional<ffi::Function>, StructuralHash, StructuralEqual>
+      cache_;
+};
+
 class ConstantFolder : public ExprMutator {
  public:
-  static Function Fold(Function func, IRModule ctx_module) {
-    ConstantFolder folder(std::move(ctx_module));
-    func = Downcast<Function>(RemoveAllUnused(folder(func)));
+  static Function Fold(Function func, IRModule ctx_module, ConstEvalBuildCache* build_cache) {
+    // Find the PrimFuncs the folding evaluates, without evaluating them, and build them at once.
+    ConstantFolder discovery(ctx_module, build_cache, /*discover_only=*/true);
+    discovery(func);
+    build_cache->BuildAll(discovery.discovered_funcs_);
+
+    ConstantFolder folder(std::move(ctx_module), build_cache, /*discover_only=*/false);
+    func = Downcast<Function>(folder(func));
+    folder.EvaluatePendingCalls();
+    func = Downcast<Function>(RemoveAllUnused(func));
     return func;
   }
 
  private:
-  explicit ConstantFolder(IRModule ctx_module) : ExprMutator(ctx_module) {}
+  explicit ConstantFolder(IRModule ctx_module, ConstEvalBuildCache* build_cache,
+                          bool discover_only)
+      : ExprMutator(ctx_module), build_cache_(build_cache), discover_only_(discover_only) {}
+
+  /*!
+   * \brief A call_tir whose output constant is created when the call is visited, and whose
+   * output data is computed when the pending calls are evaluated.
+   */
+  struct PendingCall {
+    /*! \brief The built PrimFunc. */
+    ffi::Function func;
+    /*! \brief The arguments, with the output at the end. */
+    std::vector<runtime::NDArray> args;
+    /*! \brief The evaluation wave. A call only depends on the calls of earlier waves. */
+    int wave;
+    /*!
+     * \brief Whether the PrimFunc has parallel loops. Such a call launches its own parallel job,
+     * which cannot be nested in the parallel evaluation of the other calls.
+     */
+    bool has_parallel_loop;
+  };
+
+  /*! \brief Allocator of the placeholder arrays of the discovery, which own no data. */
+  struct PlaceholderAlloc {
+    void AllocData(DLTensor* tensor) { tensor->data = nullptr; }
+    void FreeData(DLTensor* tensor) {}
+  };
 
   /*!
    * \brief Pattern match the shape inside the given struct info to a
@@ -97,38 +217,6 @@ class ConstantFolder : public ExprMutator {
     return std::nullopt;
   }
 
-  /*!
-   * \brief Get a cached build version of func
-   * \return The cached func, nullopt if func cannot be built.
-   */
-  Optional<ffi::Function> GetCachedBuild(tir::PrimFunc func) {
-    // TODO(tvm-team): consider another way of bulk extract and build PrimFunc once
-    // would be helpful for future cases where PrimFunc recursively call into each other
-    Target eval_cpu_target{"llvm"};
-
-    auto it = func_build_cache_.find(func);
-    if (it != func_build_cache_.end()) {
-      return it->second;
-    }
-    Optional<ffi::Function> build_func = std::nullopt;
-
-    try {
-      // Not all the primfunc can be directly built via llvm, for example, if a function is
-      // already scheduled to only work on GPU, we will need to skip this in the const folder for
-      // now
-      // TODO(Hongyi): further check and narrow the scope of foldable function
-      const auto pf = tvm::ffi::Function::GetGlobalRequired("tir.build");
-      func = WithAttr(func, tvm::attr::kGlobalSymbol, String("tir_function"));
-      runtime::Module rt_module = pf(func, eval_cpu_target).cast<runtime::Module>();
-      build_func = rt_module.GetFunction("tir_function");
-    } catch (const tvm::Error& err) {
-      // build failure may happen in which case we skip
-      DLOG(WARNING) << "Build failure for function " << func << ", Error message: " << err.what();
-    }
-    func_build_cache_[func] = build_func;
-    return build_func;
-  }
-
   /*!
    * \brief Checks if it is useful to fold \p expr.
    * \details Folding an expr is a trade-off - we are materializing a constant in the IRModule and
@@ -146,31 +234,96 @@ class ConstantFolder : public ExprMutator {
   // if failed return std::nullopt
   Optional<Expr> ConstEvaluateCallTIR(tir::PrimFunc tir_func, Array<runtime::NDArray> arr_args,
                                       ffi::Shape shape, DataType ret_type) {
+    DLDevice cpu_dev = {DLDeviceType::kDLCPU, 0};
+    if (discover_only_) {
+      // Assume the func can be built, and let the later calls see a constant output. Scalars
+      // get real storage, as legalization may read their value.
+      discovered_funcs_.push_back(tir_func);
+      if (shape.empty()) {
+        return Constant(runtime::NDArray::Empty(shape, ret_type, cpu_dev));
+      }
+      return Constant(runtime::NDArray::FromNDAlloc(PlaceholderAlloc(), shape, ret_type, cpu_dev));
+    }
+
     // obtain function from the cache.
-    Optional<ffi::Function> func = GetCachedBuild(tir_func);
+    Optional<ffi::Function> func = build_cache_->Get(tir_func);
     if (!func) return std::nullopt;
 
-    // here the vector size has an additional + 1 because we need to put ret_tensor at the end
-    std::vector<AnyView> packed_args(arr_args.size() + 1);
-
-    DLDevice cpu_dev = {DLDeviceType::kDLCPU, 0};
     runtime::NDArray ret_tensor = runtime::NDArray::Empty(shape, ret_type, cpu_dev);
 
-    // avoid set rvalue ref which get de-allocated later, store args in a vector
-    // where temp_args[i] are lvalue ref that is stable
-    std::vector<runtime::NDArray> temp_args(arr_args.begin(), arr_args.end());
-
-    size_t arg_offset = 0;
-    for (; arg_offset < arr_args.size(); ++arg_offset) {
-      packed_args[arg_offset] = temp_args[arg_offset];
+    // The call is evaluated later, after the calls computing its arguments.
+    PendingCall call{func.value(), std::vector<runtime::NDArray>(arr_args.begin(), arr_args.end()),
+                     0, HasParallelLoop(tir_func)};
+    for (const runtime::NDArray& arg : call.args) {
+      auto it = pending_output_wave_.find(arg.get());
+      if (it != pending_output_wave_.end()) {
+        call.wave = std::max(call.wave, it->second + 1);
+      }
     }
-    // set return value
-    packed_args[arg_offset++] = ret_tensor;
+    call.args.push_back(ret_tensor);
+    pending_output_wave_[ret_tensor.get()] = call.wave;
+    pending_calls_.push_back(std::move(call));
+    return Constant(ret_tensor);
+  }
 
+  /*! \brief Check whether the PrimFunc has a parallel loop. */
+  static bool HasParallelLoop(const tir::PrimFunc& func) {
+    bool found = false;
+    tir::PostOrderVisit(func->body, [&](const ObjectRef& obj) {
+      if (const auto* loop = obj.as<tir::ForNode>()) {
+        found = found || loop->kind == tir::ForKind::kParallel;
+      }
+    });
+    return found;
+  }
+
+  static void RunPendingCall(const PendingCall& call) {
+    std::vector<AnyView> packed_args(call.args.begin(), call.args.end());
     ffi::Any ret;
-    // invoke
-    func.value().CallPacked(ffi::PackedArgs(packed_args.data(), packed_args.size()), &ret);
-    return Constant(ret_tensor);
+    call.func.CallPacked(ffi::PackedArgs(packed_args.data(), packed_args.size()), &ret);
+  }
+
+  /*!
+   * \brief Evaluate the pending calls, so that the data of all the folded constants is
+   * computed. The calls of a wave are independent of each other. The calls without parallel
+   * loops run in parallel, and the calls with parallel loops run one after another, each using
+   * the thread pool by itself.
+   */
+  void EvaluatePendingCalls() {
+    std::vector<std::vector<const PendingCall*>> waves;
+    for (const PendingCall& call : pending_calls_) {
+      if (static_cast<int>(waves.size()) <= call.wave) {
+        waves.resize(call.wave + 1);
+      }
+      waves[call.wave].push_back(&call);
+    }
+    for (const std::vector<const PendingCall*>& wave : waves) {
+      std::vector<const PendingCall*> serial_calls;
+      std::vector<const PendingCall*> parallel_calls;
+      for (const PendingCall* call : wave) {
+        (call->has_parallel_loop ? serial_calls : parallel_calls).push_back(call);
+      }
+      std::vector<std::exception_ptr> errors(parallel_calls.size());
+      if (!parallel_calls.empty()) {
+        runtime::parallel_for_with_threading_backend(
+            [&](int64_t i) {
+              try {
+                RunPendingCall(*parallel_calls[i]);
+              } catch (...) {
+                errors[i] = std::current_exception();
+              }
+            },
+            0, parallel_calls.size());
+      }
+      for (const std::exception_ptr& error : errors) {
+        if (error) std::rethrow_exception(error);
+      }
+      for (const PendingCall* call : serial_calls) {
+        RunPendingCall(*call);
+      }
+    }
+    pending_calls_.clear();
+    pending_output_wave_.clear();
   }
 
   // Returns the folded expr if the call is successfully folded to constant, otherwise null.
@@ -248,6 +401,15 @@ class ConstantFolder : public ExprMutator {
     if (builder_->CurrentBlockIsDataFlow()) {
       // Check if we can them to call_tir
       if (legalize_map.count(op)) {
+        // Legalization may read the value of scalar constants, which has to be computed first.
+        for (const Expr& arg : post_call->args) {
+          const auto* constant = arg.as<ConstantNode>();
+          if (constant && constant->data->ndim == 0 &&
+              pending_output_wave_.count(constant->data.get())) {
+            EvaluatePendingCalls();
+            break;
+          }
+        }
         // Get the legalized expression
         Call post_call_normalized = Downcast<Call>(builder_->Normalize(post_call));
         Expr legalized_expr = builder_->Normalize(legalize_map[op](builder_, post_call_normalized));
@@ -266,7 +428,9 @@ class ConstantFolder : public ExprMutator {
         //   decomposition map for each op in a similar way we do for legalization.
         ICHECK_EQ(post_call->args.size(), 1);
         Expr arg = post_call->args[0];
-        if (arg->IsInstance<ConstantNode>()) {
+        if (arg->IsInstance<ConstantNode>() && !discover_only_) {
+          // The shape is read from the data of the constant, which has to be computed first.
+          EvaluatePendingCalls();
           Constant constant = Downcast<Constant>(arg);
           runtime::NDArray ndarray = constant->data;
           ICHECK_EQ(ndarray->device.device_type, kDLCPU);
@@ -314,18 +478,38 @@ class ConstantFolder : public ExprMutator {
     return ExprMutator::VisitExpr_(op);
   }
 
-  // cache for function build, via structural equality
-  std::unordered_map<tir::PrimFunc, Optional<ffi::Function>, StructuralHash, StructuralEqual>
-      func_build_cache_;
+  /*! \brief The cache of the built PrimFuncs. */
+  ConstEvalBuildCache* build_cache_;
+  /*! \brief Whether to only collect the PrimFuncs to be evaluated, without evaluating them. */
+  bool discover_only_;
+  /*! \brief The PrimFuncs to be evaluated, collected by the discovery. */
+  std::vector<tir::PrimFunc> discovered_funcs_;
+  /*! \brief The calls whose output data is not computed yet. */
+  std::vector<PendingCall> pending_calls_;
+  /*! \brief The evaluation wave of the output of each pending call. */
+  std::unordered_map<const Object*, int> pending_output_wave_;
 };
 
 namespace transform {
 
 Pass FoldConstant() {
-  auto pass_func = [=](Function f, IRModule m, PassContext pc) {
-    return ConstantFolder::Fold(f, m);
+  auto pass_func = [](IRModule mod, PassContext pc) {
+    ConstEvalBuildCache build_cache;
+    IRModule updates;
+    for (const auto& [gvar, func] : mod->functions) {
+      if (auto opt = func.as<Function>()) {
+        Function new_func = ConstantFolder::Fold(opt.value(), mod, &build_cache);
+        if (!new_func.same_as(func)) {
+          updates->Add(gvar, new_func);
+        }
+      }
+    }
+    if (updates->functions.size()) {
+      mod.CopyOnWrite()->Update(updates);
+    }
+    return mod;
   };
-  return CreateFunctionPass(pass_func, 0, "FoldConstant", {});
+  return CreateModulePass(pass_func, 0, "FoldConstant", {});
 }
 
 TVM_FFI_STATIC_INIT_BLOCK({
@@ -37,8 +37,12 @@
 #include <tvm/tir/analysis.h>
 #include <tvm/tir/expr_functor.h>
 #include <tvm/tir/function.h>
+#include <tvm/tir/stmt_functor.h>
 
+#include <algorithm>
 #include <optional>
+#include <utility>
+#include <vector>
 
 #include "../../support/arena.h"
 #include "../analysis/graph_partitioner.h"
@@ -96,8 +100,16 @@ TVM_FFI_STATIC_INIT_BLOCK({
 using support::LinkNode;
 
 constexpr uint32_t kMaxFusedOps = 256;
+/*!
+ * \brief The default flops that moving one byte through memory is worth, when fusion is guided by
+ * the cost estimates. It is roughly the compute to memory bandwidth ratio of a CPU.
+ */
+constexpr int64_t kDefaultFlopsPerByte = 8;
 
 TVM_REGISTER_PASS_CONFIG_OPTION("relax.FuseOps.max_depth", Integer);
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.FuseOps.cost_model", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.FuseOps.max_fused_flops", Integer);
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.FuseOps.flops_per_byte", Integer);
 
 class GraphCreator : public ExprVisitor {
  public:
@@ -1030,15 +1042,161 @@ class OperatorFusor : public ExprMutator {
   bool lift_constants_{true};
 };
 
-IRModule FuseOps(IRModule mod, int opt_level, size_t max_fuse_depth) {
+/*!
+ * \brief Estimate the cost of the nodes of the indexed-forward graph from the PrimFuncs they call.
+ * \details For each binding that calls a PrimFunc, the estimate contains
+ *  - the floating point operations of the PrimFunc, from tir::EstimateTIRFlops,
+ *  - the bytes of its output, when the output shape is static,
+ *  - how many times each element of its output is loaded by the PrimFuncs that consume it, counted
+ *  from the loop nests around the loads, when the loop extents are static.
+ */
+class FusionCostEstimator : public ExprVisitor {
+ public:
+  static FusionCostEstimate Estimate(const IRModule& mod, const IndexedForwardGraph& graph) {
+    FusionCostEstimator estimator(mod);
+    for (const auto& [gv, base_func] : mod->functions) {
+      const auto* func = base_func.as<FunctionNode>();
+      if (func == nullptr || func->HasNonzeroAttr(attr::kPrimitive) ||
+          func->GetAttr<String>(attr::kCodegen).defined()) {
+        continue;
+      }
+      estimator(GetRef<Function>(func));
+    }
+
+    size_t num_nodes = graph.post_dfs_order.size();
+    FusionCostEstimate cost;
+    cost.flops.assign(num_nodes, -1);
+    cost.output_bytes.assign(num_nodes, -1);
+    cost.reads_per_element.assign(num_nodes, 1);
+    for (const auto& [var, call] : estimator.var2call_) {
+      auto it = graph.node_map.find(var);
+      if (it == graph.node_map.end()) continue;
+      size_t index = it->second->index;
+      tir::PrimFunc func = estimator.GetPrimFunc(call);
+      cost.flops[index] = tir::EstimateTIRFlops(func->body);
+      cost.output_bytes[index] = StaticTensorBytes(GetStructInfo(GetRef<Var>(var)));
+    }
+    for (const auto& [var, call] : estimator.var2call_) {
+      tir::PrimFunc func = estimator.GetPrimFunc(call);
+      const Array<Expr>& args = Downcast<Tuple>(call->args[1])->fields;
+      for (size_t i = 0; i < args.size() && i < func->params.size(); ++i) {
+        auto it = graph.node_map.find(args[i].get());
+        Optional<tir::Buffer> buffer = func->buffer_map.Get(func->params[i]);
+        if (it == graph.node_map.end() || !buffer.defined()) continue;
+        double& reads_per_element = cost.reads_per_element[it->second->index];
+        double num_bytes = StaticTensorBytes(GetStructInfo(args[i]));
+        double num_loads = BufferLoadCounter::Count(func, buffer.value());
+        if (reads_per_element < 0 || num_bytes <= 0 || num_loads < 0) {
+          reads_per_element = -1;
+        } else {
+          DataType dtype = buffer.value()->dtype;
+          double num_elements = num_bytes / (dtype.bytes() * dtype.lanes());
+          reads_per_element = std::max(reads_per_element, num_loads / num_elements);
+        }
+      }
+    }
+    return cost;
+  }
+
+ private:
+  /*! \brief Count the loads of a buffer, weighted by the extents of the loops around them. */
+  class BufferLoadCounter : public tir::StmtExprVisitor {
+   public:
+    /*! \return The number of loads, or -1 if a loop extent is not static. */
+    static double Count(const tir::PrimFunc& func, const tir::Buffer& buffer) {
+      BufferLoadCounter counter(buffer);
+      counter(func->body);
+      return counter.has_static_extents_ ? counter.num_loads_ : -1;
+    }
+
+   private:
+    explicit BufferLoadCounter(const tir::Buffer& buffer) : buffer_(buffer) {}
+
+    void VisitStmt_(const tir::ForNode* loop) final {
+      const auto* extent = loop->extent.as<IntImmNode>();
+      if (extent == nullptr) {
+        has_static_extents_ = false;
+        return;
+      }
+      double scale = scale_;
+      scale_ *= extent->value;
+      tir::StmtExprVisitor::VisitStmt_(loop);
+      scale_ = scale;
+    }
+
+    void VisitExpr_(const tir::BufferLoadNode* load) final {
+      if (load->buffer->data.same_as(buffer_->data)) {
+        num_loads_ += scale_;
+      }
+      tir::StmtExprVisitor::VisitExpr_(load);
+    }
+
+    tir::Buffer buffer_;
+    double scale_{1};
+    double num_loads_{0};
+    bool has_static_extents_{true};
+  };
+
+  explicit FusionCostEstimator(const IRModule& mod) : mod_(mod) {}
+
+  void VisitBinding_(const VarBindingNode* binding, const CallNode* call) final {
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    static const Op& call_tir_inplace_op = Op::Get("relax.call_tir_inplace");
+    if ((call->op.same_as(call_tir_op) || call->op.same_as(call_tir_inplace_op)) &&
+        call->args[1]->IsInstance<TupleNode>()) {
+      if (auto gv = call->args[0].as<GlobalVar>()) {
+        if (mod_->Lookup(gv.value())->IsInstance<tir::PrimFuncNode>()) {
+          var2call_.emplace_back(binding->var.get(), call);
+        }
+      }
+    }
+    ExprVisitor::VisitBinding_(binding, call);
+  }
+
+  tir::PrimFunc GetPrimFunc(const CallNode* call) const {
+    return Downcast<tir::PrimFunc>(mod_->Lookup(Downcast<GlobalVar>(call->args[0])));
+  }
+
+  /*! \return The number of bytes of a tensor of static shape, or -1 otherwise. */
+  static double StaticTensorBytes(const StructInfo& sinfo) {
+    const auto* tensor_sinfo = sinfo.as<TensorStructInfoNode>();
+    if (tensor_sinfo == nullptr || tensor_sinfo->IsUnknownDtype()) return -1;
+    const auto* shape = tensor_sinfo->shape.as<ShapeExprNode>();
+    if (shape == nullptr) return -1;
+    double bytes = tensor_sinfo->dtype.bytes() * tensor_sinfo->dtype.lanes();
+    for (const PrimExpr& dim : shape->values) {
+      const auto* int_dim = dim.as<IntImmNode>();
+      if (int_dim == nullptr) return -1;
+      bytes *= int_dim->value;
+    }
+    return bytes;
+  }
+
+  /*! \brief The IRModule that contains the called PrimFuncs. */
+  IRModule mod_;
+  /*! \brief The bindings that call a PrimFunc, in the order of visit. */
+  std::vector<std::pair<const VarNode*, const CallNode*>> var2call_;
+};
+
+IRModule FuseOps(IRModule mod, int opt_level, size_t max_fuse_depth, bool use_cost_model,
+                 double max_fused_flops, double flops_per_byte) {
   support::Arena arena;
 
   // Step 1. Create the indexed-forward graph according to the input IRModule.
   IndexedForwardGraph graph = GraphCreator::Create(mod, &arena);
 
-  // Step 2. Partition the graph by applying the fusion algorithm.
+  // Step 2. Partition the graph by applying the fusion algorithm, guided by the cost estimates of
+  // the nodes if requested.
+  std::optional<FusionCostEstimate> cost;
+  if (use_cost_model) {
+    cost = FusionCostEstimator::Estimate(mod, graph);
+    cost->max_fused_flops = max_fused_flops;
+    cost->flops_per_byte = flops_per_byte;
+  }
   std::vector<GraphPartitioner::Group*> groups =
-      GraphPartitioner(&arena, opt_level, max_fuse_depth, /*max_function_args=*/0).Partition(graph);
+      GraphPartitioner(&arena, opt_level, max_fuse_depth, /*max_function_args=*/0,
+                       cost.has_value() ? &cost.value() : nullptr)
+          .Partition(graph);
 
   // Step 3. Transform the IRModule by fusing the operators in accordance with the graph partition
   // results.
@@ -1431,7 +1589,14 @@ Pass FuseOps(int fuse_opt_level) {
       [=](IRModule m, PassContext pc) {
         int opt_level = fuse_opt_level == -1 ? pc->opt_level : fuse_opt_level;
         auto max_fuse_depth = pc->GetConfig("relax.FuseOps.max_depth", Integer(kMaxFusedOps));
-        return relax::FuseOps(m, opt_level, max_fuse_depth.value().IntValue());
+        bool use_cost_model =
+            pc->GetConfig<Bool>("relax.FuseOps.cost_model").value_or(Bool(false))->value;
+        auto max_fused_flops = pc->GetConfig("relax.FuseOps.max_fused_flops", Integer(0));
+        auto flops_per_byte =
+            pc->GetConfig("relax.FuseOps.flops_per_byte", Integer(kDefaultFlopsPerByte));
+        return relax::FuseOps(m, opt_level, max_fuse_depth.value().IntValue(), use_cost_model,
+                              max_fused_flops.value().IntValue(),
+                              flops_per_byte.value().IntValue());
       };
   return CreateModulePass(/*pass_function=*/pass_func,  //
                           /*opt_level=*/0,              //
@@ -0,0 +1,357 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/relax/transform/horizontal_fuse_ops.cc
+ * \brief Fuse independent kernels of a dataflow block into one PrimFunc.
+ *
+ * FuseOps only groups bindings along producer-consumer edges, so independent kernels that
+ * could run together are still launched one by one. This pass groups the `call_tir` bindings
+ * of a dataflow block that
+ *  - call an elementwise, broadcast, injective or reduction PrimFunc,
+ *  - are at the same depth of the dataflow graph, which means none of them depends on another,
+ *  - produce outputs of the same shape.
+ *
+ * Each group becomes a primitive Relax function, which FuseTIR turns into a single PrimFunc.
+ * The adjacent loop nests of the fused PrimFunc that iterate over the same space and touch
+ * disjoint buffers are then merged, so the kernels of a group share their outer loops.
+ */
+
+#include <tvm/arith/analyzer.h>
+#include <tvm/ffi/reflection/registry.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/op_attr_types.h>
+#include <tvm/relax/struct_info.h>
+#include <tvm/relax/transform.h>
+#include <tvm/relax/utils.h>
+#include <tvm/tir/analysis.h>
+#include <tvm/tir/function.h>
+#include <tvm/tir/stmt_functor.h>
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+#include "../../support/arena.h"
+#include "../analysis/graph_partitioner.h"
+#include "utils.h"
+
+namespace tvm {
+namespace relax {
+
+/*!
+ * \brief Partition the call_tir bindings of the dataflow blocks into horizontal groups. The result
+ * can be passed to MakeGroupedFunctions to create a grouped function for each group.
+ */
+class HorizontalPartitioner : public ExprVisitor {
+ public:
+  using Group = GraphPartitioner::Group;
+  using GroupMap = std::unordered_map<const Object*, Group*>;
+
+  static GroupMap Run(const IRModule& mod, const Function& func, int max_group_size,
+                      support::Arena* arena) {
+    HorizontalPartitioner partitioner(mod, max_group_size, arena);
+    partitioner.VisitExpr(func);
+    return partitioner.group_map_;
+  }
+
+ private:
+  HorizontalPartitioner(const IRModule& mod, int max_group_size, support::Arena* arena)
+      : mod_(mod), max_group_size_(max_group_size), arena_(arena) {}
+
+  void VisitVarDef(const Var& var) final { group_map_[var.get()] = arena_->make<Group>(); }
+
+  void VisitBindingBlock_(const DataflowBlockNode* block) final {
+    ExprVisitor::VisitBindingBlock_(block);
+
+    /*! \brief The candidates at the same depth and with the same output shape. */
+    struct Bucket {
+      int depth;
+      Array<PrimExpr> shape;
+      std::vector<Var> vars;
+    };
+    std::vector<Bucket> buckets;
+    // The depth of a binding is the length of the longest path from the inputs of the block.
+    // There is no path between two bindings of the same depth, and each group only contains
+    // bindings of the same depth, so the grouping cannot introduce a cyclic dependency.
+    std::unordered_map<const VarNode*, int> depth;
+    for (const Binding& binding : block->bindings) {
+      int binding_depth = 0;
+      PostOrderVisit(GetBoundValue(binding), [&](const ObjectRef& obj) {
+        if (const auto* var = obj.as<VarNode>()) {
+          if (auto it = depth.find(var); it != depth.end()) {
+            binding_depth = std::max(binding_depth, it->second + 1);
+          }
+        }
+      });
+      depth[binding->var.get()] = binding_depth;
+
+      Optional<Array<PrimExpr>> shape = GetFusibleOutputShape(binding);
+      if (!shape.defined()) {
+        continue;
+      }
+      auto it = std::find_if(buckets.begin(), buckets.end(), [&](const Bucket& bucket) {
+        return bucket.depth == binding_depth &&
+               static_cast<int>(bucket.vars.size()) < max_group_size_ &&
+               StructuralEqual()(bucket.shape, shape.value());
+      });
+      if (it == buckets.end()) {
+        buckets.push_back(Bucket{binding_depth, shape.value(), {}});
+        it = buckets.end() - 1;
+      }
+      it->vars.push_back(binding->var);
+    }
+
+    for (const Bucket& bucket : buckets) {
+      Group* root = group_map_[bucket.vars[0].get()];
+      for (size_t i = 1; i < bucket.vars.size(); ++i) {
+        Group* group = group_map_[bucket.vars[i].get()];
+        group->parent = root;
+        root->num_nodes += group->num_nodes;
+      }
+    }
+  }
+
+  /*!
+   * \brief Get the output shape of a binding that can be fused horizontally.
+   * \return The output shape, or std::nullopt if the binding cannot be fused.
+   */
+  Optional<Array<PrimExpr>> GetFusibleOutputShape(const Binding& binding) const {
+    static const Op& call_tir_op = Op::Get("relax.call_tir");
+    const auto* var_binding = binding.as<VarBindingNode>();
+    if (var_binding == nullptr) {
+      return std::nullopt;
+    }
+    const auto* call = var_binding->value.as<CallNode>();
+    if (call == nullptr || !call->op.same_as(call_tir_op) || call->args.size() != 2) {
+      return std::nullopt;
+    }
+    const auto* gv = call->args[0].as<GlobalVarNode>();
+    if (gv == nullptr) {
+      return std::nullopt;
+    }
+    const auto* prim_func = mod_->Lookup(GetRef<GlobalVar>(gv)).as<tir::PrimFuncNode>();
+    if (prim_func == nullptr) {
+      return std::nullopt;
+    }
+    Optional<Integer> pattern = prim_func->GetAttr<Integer>("op_pattern");
+    if (!pattern.defined() || pattern.value()->value > static_cast<int>(kCommReduce)) {
+      return std::nullopt;
+    }
+    const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(var_binding->var);
+    if (sinfo == nullptr) {
+      return std::nullopt;
+    }
+    const auto* shape = sinfo->shape.as<ShapeExprNode>();
+    if (shape == nullptr) {
+      return std::nullopt;
+    }
+    return shape->values;
+  }
+
+  /*! \brief The IRModule that contains the called PrimFuncs. */
+  IRModule mod_;
+  /*! \brief The maximum number of bindings in a group. */
+  int max_group_size_;
+  /*! \brief The arena to allocate the groups. */
+  support::Arena* arena_;
+  /*! \brief The group of each variable. */
+  GroupMap group_map_;
+};
+
+/*!
+ * \brief Merge the adjacent loop nests in the root block of a PrimFunc that iterate over the
+ * same space and touch disjoint buffers.
+ */
+class LoopNestMerger {
+ public:
+  static tir::PrimFunc Run(tir::PrimFunc func) {
+    const auto* realize = func->body.as<tir::BlockRealizeNode>();
+    if (realize == nullptr) {
+      return func;
+    }
+    const auto* seq = realize->block->body.as<tir::SeqStmtNode>();
+    if (seq == nullptr) {
+      return func;
+    }
+
+    LoopNestMerger merger;
+    Array<tir::Stmt> nests;
+    for (const tir::Stmt& nest : seq->seq) {
+      if (!nests.empty() && merger.IsIndependent(nests.back(), nest)) {
+        if (Optional<tir::Stmt> merged = merger.MergeLoops(nests.back(), nest)) {
+          nests.Set(nests.size() - 1, merged.value());
+          continue;
+        }
+      }
+      nests.push_back(nest);
+    }
+    if (nests.size() == seq->seq.size()) {
+      return func;
+    }
+
+    tir::Block root = realize->block;
+    root.CopyOnWrite()->body = tir::SeqStmt::Flatten(nests);
+    tir::BlockRealize new_realize = GetRef<tir::BlockRealize>(realize);
+    new_realize.CopyOnWrite()->block = root;
+    func.CopyOnWrite()->body = new_realize;
+    return func;
+  }
+
+ private:
+  /*! \brief Check whether the two statements can run in any interleaving. */
+  static bool IsIndependent(const tir::Stmt& a, const tir::Stmt& b) {
+    std::unordered_set<const tir::BufferNode*> reads_a, writes_a, reads_b, writes_b;
+    CollectAccessedBuffers(a, &reads_a, &writes_a);
+    CollectAccessedBuffers(b, &reads_b, &writes_b);
+    for (const tir::BufferNode* buffer : writes_a) {
+      if (reads_b.count(buffer) || writes_b.count(buffer)) return false;
+    }
+    for (const tir::BufferNode* buffer : writes_b) {
+      if (reads_a.count(buffer)) return false;
+    }
+    return true;
+  }
+
+  static void CollectAccessedBuffers(const tir::Stmt& stmt,
+                                     std::unordered_set<const tir::BufferNode*>* reads,
+                                     std::unordered_set<const tir::BufferNode*>* writes) {
+    tir::PostOrderVisit(stmt, [&](const ObjectRef& obj) {
+      if (const auto* block = obj.as<tir::BlockNode>()) {
+        for (const tir::BufferRegion& region : block->reads) {
+          reads->insert(region->buffer.get());
+        }
+        for (const tir::BufferRegion& region : block->writes) {
+          writes->insert(region->buffer.get());
+        }
+      }
+    });
+  }
+
+  /*!
+   * \brief Whether the loop can be merged with another loop. Only the serial loops that are bound
+   * to data parallel block iterators are merged, so the merged loop can still be parallelized.
+   */
+  static bool IsMergeableLoop(const tir::ForNode* loop) {
+    if (loop->kind != tir::ForKind::kSerial || loop->thread_binding.defined() ||
+        !loop->annotations.empty()) {
+      return false;
+    }
+    bool is_spatial = true;
+    tir::PostOrderVisit(loop->body, [&](const ObjectRef& obj) {
+      const auto* realize = obj.as<tir::BlockRealizeNode>();
+      if (realize == nullptr) return;
+      const Array<tir::IterVar>& iter_vars = realize->block->iter_vars;
+      for (size_t i = 0; i < iter_vars.size(); ++i) {
+        if (iter_vars[i]->iter_type != tir::IterVarType::kDataPar &&
+            tir::UsesVar(realize->iter_values[i],
+                         [&](const tir::VarNode* var) { return var == loop->loop_var.get(); })) {
+          is_spatial = false;
+        }
+      }
+    });
+    return is_spatial;
+  }
+
+  /*!
+   * \brief Merge the outer loops of two loop nests, as long as their iteration spaces are the same.
+   * \return The merged loop nest, or std::nullopt if the outermost loops differ.
+   */
+  Optional<tir::Stmt> MergeLoops(const tir::Stmt& a, const tir::Stmt& b) {
+    const auto* loop_a = a.as<tir::ForNode>();
+    const auto* loop_b = b.as<tir::ForNode>();
+    if (loop_a == nullptr || loop_b == nullptr || !IsMergeableLoop(loop_a) ||
+        !IsMergeableLoop(loop_b) || loop_a->loop_var.dtype() != loop_b->loop_var.dtype() ||
+        !analyzer_.CanProveEqual(loop_a->min, loop_b->min) ||
+        !analyzer_.CanProveEqual(loop_a->extent, loop_b->extent)) {
+      return std::nullopt;
+    }
+    tir::Stmt body_b = tir::Substitute(loop_b->body, {{loop_b->loop_var, loop_a->loop_var}});
+    tir::Stmt body =
+        MergeLoops(loop_a->body, body_b).value_or(tir::SeqStmt::Flatten(loop_a->body, body_b));
+    tir::For merged = GetRef<tir::For>(loop_a);
+    merged.CopyOnWrite()->body = body;
+    return merged;
+  }
+
+  arith::Analyzer analyzer_;
+};
+
+IRModule HorizontalFuseOps(IRModule mod, int max_group_size) {
+  support::Arena arena;
+  HorizontalPartitioner::GroupMap group_map;
+  std::unordered_set<std::string> existing_names;
+  for (const auto& [gv, base_func] : mod->functions) {
+    existing_names.insert(gv->name_hint);
+    const auto* func = base_func.as<FunctionNode>();
+    if (func == nullptr || func->HasNonzeroAttr(attr::kPrimitive) ||
+        func->GetAttr<String>(attr::kCodegen).defined()) {
+      continue;
+    }
+    auto func_group_map =
+        HorizontalPartitioner::Run(mod, GetRef<Function>(func), max_group_size, &arena);
+    group_map.insert(func_group_map.begin(), func_group_map.end());
+  }
+  bool has_group = std::any_of(group_map.begin(), group_map.end(),
+                               [](const auto& kv) { return kv.second->FindRoot()->num_nodes > 1; });
+  if (!has_group) {
+    return mod;
+  }
+
+  // Step 1. Create a primitive function for each group, and fuse it into a PrimFunc.
+  mod = MakeGroupedFunctions(mod, group_map, /*lift_constants=*/true);
+  mod = transform::FuseTIR()(mod);
+
+  // Step 2. Merge the loop nests of the kernels in the fused PrimFuncs.
+  IRModule updates;
+  for (const auto& [gv, base_func] : mod->functions) {
+    if (existing_names.count(gv->name_hint)) {
+      continue;
+    }
+    if (const auto* prim_func = base_func.as<tir::PrimFuncNode>()) {
+      tir::PrimFunc merged = LoopNestMerger::Run(GetRef<tir::PrimFunc>(prim_func));
+      if (!merged.same_as(base_func)) {
+        updates->Add(gv, merged);
+      }
+    }
+  }
+  mod.CopyOnWrite()->Update(updates);
+  return mod;
+}
+
+namespace transform {
+
+Pass HorizontalFuseOps(int max_group_size) {
+  auto pass_func = [=](IRModule mod, PassContext pc) {
+    return relax::HorizontalFuseOps(mod, max_group_size);
+  };
+  return CreateModulePass(/*pass_function=*/pass_func,        //
+                          /*opt_level=*/3,                    //
+                          /*pass_name=*/"HorizontalFuseOps",  //
+                          /*required=*/{});
+}
+
+TVM_FFI_STATIC_INIT_BLOCK({
+  namespace refl = tvm::ffi::reflection;
+  refl::GlobalDef().def("relax.transform.HorizontalFuseOps", HorizontalFuseOps);
+});
+
+}  // namespace transform
+}  // namespace relax
+}  // namespace tvm
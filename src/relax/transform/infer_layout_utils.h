@@ -268,6 +268,18 @@ bool NoDesiredLayout(const Call& call, const Map<String, Array<String>>& desired
  */
 LayoutDecision FollowDecision(const LayoutDecision& src, int dst_ndim);
 
+/*!
+ * \brief Convert the layouts of the ops in a dataflow block, see ConvertLayout.
+ * \param df_block The dataflow block.
+ * \param desired_layouts The desired layouts of the ops, keyed by op name.
+ * \param binding_layouts The desired layouts for the op call of specific bindings, which take
+ * precedence over desired_layouts.
+ * \return The converted dataflow block.
+ */
+DataflowBlock ConvertLayoutPass(const DataflowBlock& df_block,
+                                Map<String, Array<String>> desired_layouts,
+                                Map<Var, Map<String, Array<String>>> binding_layouts = {});
+
 }  // namespace relax
 }  // namespace tvm
 
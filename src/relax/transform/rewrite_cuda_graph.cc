@@ -48,6 +48,12 @@
  *
  * 2. Lift the regions identified in step 1 to a separate function and rewrite the original function
  * with `CUDAGraphRewriter`.
+ *
+ * The same rewriting serves CPU targets in `RewriteCPUExecPlan`, enabled by
+ * `relax.backend.use_cpu_exec_plan`. The lifted regions are then launched with the
+ * `vm.builtin.cpu_exec_plan` builtins, which record the kernel calls of
+ * the first run into a flat execution plan and replay it afterwards without interpreting the
+ * bytecode.
  */
 #include <tvm/ffi/reflection/registry.h>
 #include <tvm/relax/analysis.h>
@@ -67,6 +73,7 @@ namespace tvm {
 namespace relax {
 
 TVM_REGISTER_PASS_CONFIG_OPTION("relax.backend.use_cuda_graph", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.backend.use_cpu_exec_plan", Bool);
 
 /*! \brief The rewriting plan of lifting a region for either allocation or capturing for cuda graph
  * execution
@@ -734,7 +741,13 @@ Function MergeAllocationPlans(const std::vector<LiftedFunctionRewritePlan*>& all
 /*! \brief The rewriter for CUDA graph */
 class CUDAGraphRewriter : public ExprMutator {
  public:
-  explicit CUDAGraphRewriter(const IRModule& mod) : ExprMutator(mod) {}
+  /*!
+   * \param mod The module to be rewritten.
+   * \param kind The kind of the capture, "cuda_graph" or "cpu_exec_plan", which names the
+   * builtins launching the lifted functions.
+   */
+  explicit CUDAGraphRewriter(const IRModule& mod, String kind = "cuda_graph")
+      : ExprMutator(mod), kind_(kind) {}
 
   IRModule Rewrite() {
     CUDAGraphRewritePlanner planner(builder_->GetContextIRModule(), &arena_);
@@ -750,7 +763,7 @@ class CUDAGraphRewriter : public ExprMutator {
     auto [alloc_plans, capture_plans] = planner.Plan();
     if (alloc_plans.size()) {
       auto global_alloc_func = MergeAllocationPlans(alloc_plans);
-      gv_global_alloc_ = builder_->AddFunction(global_alloc_func, "cuda_graph_alloc");
+      gv_global_alloc_ = builder_->AddFunction(global_alloc_func, kind_ + "_alloc");
     }
     for (const auto* plan : alloc_plans) {
       subgraph_launches_[plan->launch_point] = plan;
@@ -771,9 +784,8 @@ class CUDAGraphRewriter : public ExprMutator {
 
   void LaunchSubgraph(const VarBindingNode* op, const LiftedFunctionRewritePlan* plan) {
     static const auto& call_builtin_with_ctx_op = Op::Get("relax.call_builtin_with_ctx");
-    static const auto& builtin_run_or_capture = ExternFunc("vm.builtin.cuda_graph.run_or_capture");
-    static const auto& builtin_get_cached_alloc =
-        ExternFunc("vm.builtin.cuda_graph.get_cached_alloc");
+    ExternFunc builtin_run_or_capture("vm.builtin." + kind_ + ".run_or_capture");
+    ExternFunc builtin_get_cached_alloc("vm.builtin." + kind_ + ".get_cached_alloc");
 
     Expr launch_subgraph;
     if (plan->is_alloc) {
@@ -788,7 +800,7 @@ class CUDAGraphRewriter : public ExprMutator {
           Attrs(), {ret_struct_info});
     } else {
       auto gv_func = builder_->AddFunction(
-          plan->func, current_func_.value()->name_hint + "_cuda_graph_capture");
+          plan->func, current_func_.value()->name_hint + "_" + kind_ + "_capture");
       StructInfo call_sinfo = plan->func->ret_struct_info;
       // Arguments of the lifted function
       Array<Expr> args;
@@ -874,10 +886,11 @@ class CUDAGraphRewriter : public ExprMutator {
   support::Arena arena_;
   Optional<GlobalVar> gv_global_alloc_ = std::nullopt;
   Optional<GlobalVar> current_func_ = std::nullopt;
+  String kind_;
 };
 
-IRModule RewriteCUDAGraph(IRModule mod) {
-  CUDAGraphRewriter rewriter(mod);
+IRModule RewriteCUDAGraph(IRModule mod, String kind) {
+  CUDAGraphRewriter rewriter(mod, kind);
   mod = rewriter.Rewrite();
   return mod;
 }
@@ -890,7 +903,7 @@ Pass RewriteCUDAGraph() {
         bool use_cuda_graph =
             pc->GetConfig<Bool>("relax.backend.use_cuda_graph").value_or(Bool(false))->value;
         if (use_cuda_graph) {
-          mod = ::tvm::relax::RewriteCUDAGraph(std::move(mod));
+          mod = ::tvm::relax::RewriteCUDAGraph(std::move(mod), "cuda_graph");
         }
 
         return mod;
@@ -898,9 +911,25 @@ Pass RewriteCUDAGraph() {
   return CreateModulePass(pass_func, 0, "RewriteCUDAGraph", {});
 }
 
+Pass RewriteCPUExecPlan() {
+  auto pass_func =  //
+      [=](IRModule mod, PassContext pc) {
+        bool use_cpu_exec_plan =
+            pc->GetConfig<Bool>("relax.backend.use_cpu_exec_plan").value_or(Bool(false))->value;
+        if (use_cpu_exec_plan) {
+          mod = ::tvm::relax::RewriteCUDAGraph(std::move(mod), "cpu_exec_plan");
+        }
+
+        return mod;
+      };
+  return CreateModulePass(pass_func, 0, "RewriteCPUExecPlan", {});
+}
+
 TVM_FFI_STATIC_INIT_BLOCK({
   namespace refl = tvm::ffi::reflection;
-  refl::GlobalDef().def("relax.transform.RewriteCUDAGraph", RewriteCUDAGraph);
+  refl::GlobalDef()
+      .def("relax.transform.RewriteCUDAGraph", RewriteCUDAGraph)
+      .def("relax.transform.RewriteCPUExecPlan", RewriteCPUExecPlan);
 });
 
 }  // namespace transform
@@ -0,0 +1,367 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file src/relax/transform/select_layout.cc
+ * \brief Select the layouts of conv2d ops by the estimated cost of the whole dataflow block.
+ *
+ * Every conv2d in the NCHW layout has a few candidate layouts: NCHW itself, NHWC and the
+ * NCHW[x]c layouts blocked by the vector width of the target. The blocked layouts are only
+ * legalized under an llvm target, so they are not candidates when no such target is in scope.
+ * The cost of a candidate is the
+ * cost of the conv2d in that layout, plus the layout transforms needed to and from the
+ * neighbouring conv2d ops. The layout-following ops between two conv2d ops, such as the
+ * elementwise ops, take the layout of their input, so the transforms only occur at the inputs
+ * of the conv2d ops and at the outputs of the block.
+ *
+ * The layouts are selected by dynamic programming over the conv2d ops in binding order, which
+ * is exact when the conv2d ops form chains or trees. The selected layouts are then applied by
+ * ConvertLayout.
+ */
+
+#include <tvm/ffi/reflection/registry.h>
+#include <tvm/relax/analysis.h>
+#include <tvm/relax/attrs/nn.h>
+#include <tvm/relax/expr_functor.h>
+#include <tvm/relax/op_attr_types.h>
+#include <tvm/relax/transform.h>
+#include <tvm/target/target.h>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "infer_layout_utils.h"
+
+namespace tvm {
+namespace relax {
+
+namespace {
+
+/*! \brief The vector width in bits assumed when the target does not tell it. */
+constexpr int kDefaultVectorBits = 128;
+
+/*! \brief A candidate layout of conv2d. */
+struct ConvLayout {
+  String data_layout;
+  String kernel_layout;
+};
+
+/*! \brief A conv2d whose layout is selected. */
+struct ConvNode {
+  Var var;
+  Call call;
+  /*! \brief The candidate layouts, the first one is the original layout. */
+  std::vector<ConvLayout> layouts;
+  /*! \brief The cost of the conv2d and of the transforms at the boundary for each candidate. */
+  std::vector<double> cost;
+  /*! \brief The conv2d ops producing the data input. */
+  std::vector<int> producers;
+  /*! \brief The conv2d ops consuming the output. */
+  std::vector<int> consumers;
+  /*! \brief The number of elements of the data input. */
+  double data_elems{0};
+  /*! \brief The number of elements of the output. */
+  double out_elems{0};
+  /*! \brief Whether the data input is not produced by a conv2d. */
+  bool input_from_outside{false};
+  /*! \brief Whether the output is used in the original layout. */
+  bool output_escapes{false};
+};
+
+int64_t NumElements(const Array<PrimExpr>& shape) {
+  int64_t num = 1;
+  for (const PrimExpr& dim : shape) {
+    const auto* int_dim = dim.as<IntImmNode>();
+    if (int_dim == nullptr) return -1;
+    num *= int_dim->value;
+  }
+  return num;
+}
+
+Optional<Array<PrimExpr>> StaticShape(const Expr& expr, int ndim) {
+  const auto* sinfo = GetStructInfoAs<TensorStructInfoNode>(expr);
+  if (sinfo == nullptr || sinfo->ndim != ndim || !sinfo->GetShape().defined()) {
+    return std::nullopt;
+  }
+  Array<PrimExpr> shape = sinfo->GetShape().value();
+  if (NumElements(shape) < 0) return std::nullopt;
+  return shape;
+}
+
+/*! \brief The current llvm target, the only kind under which NCHW[x]c conv2d is legalized. */
+Optional<Target> CurrentLLVMTarget() {
+  Optional<Target> target = Target::Current(/*allow_not_defined=*/true);
+  if (target.defined() && target.value()->kind->name == "llvm") {
+    return target;
+  }
+  return std::nullopt;
+}
+
+int GetVectorBits() {
+  if (Optional<Target> target = CurrentLLVMTarget()) {
+    if (auto f = tvm::ffi::Function::GetGlobal("target.llvm_get_vector_width")) {
+      int bits = (*f)(target.value()).cast<int>();
+      if (bits > 0) return bits;
+    }
+  }
+  return kDefaultVectorBits;
+}
+
+class LayoutSelector {
+ public:
+  LayoutSelector(int vector_bits, bool allow_blocked, Optional<ffi::Function> fcost)
+      : vector_bits_(vector_bits), allow_blocked_(allow_blocked), fcost_(fcost) {}
+
+  DataflowBlock Select(const DataflowBlock& block) {
+    static const Op& conv2d_op = Op::Get("relax.nn.conv2d");
+    nodes_.clear();
+    sources_.clear();
+    Map<Var, Map<String, Array<String>>> pinned_layouts;
+    for (const Binding& binding : block->bindings) {
+      const auto* var_binding = binding.as<VarBindingNode>();
+      const auto* call = var_binding ? var_binding->value.as<CallNode>() : nullptr;
+      if (call != nullptr && call->op.same_as(conv2d_op)) {
+        const auto* attrs = call->attrs.as<Conv2DAttrs>();
+        if (attrs->data_layout.size() != 4 || attrs->kernel_layout.size() != 4 ||
+            attrs->out_layout.size() != 4) {
+          // The layouts of the block are already blocked by hand.
+          return block;
+        }
+        if (!AddConv(var_binding->var, GetRef<Call>(call))) {
+          // Keep the conv2d in its layout instead of following the layout of its input.
+          Array<String> layouts{attrs->data_layout, attrs->kernel_layout, attrs->out_layout};
+          pinned_layouts.Set(var_binding->var, {{"relax.nn.conv2d", layouts}});
+          MarkEscape(var_binding->value);
+        }
+      } else if (call != nullptr && IsLayoutFollowing(var_binding->var, call)) {
+        std::vector<int> sources;
+        for (const Expr& arg : call->args) {
+          for (int src : GetSources(arg)) {
+            if (std::find(sources.begin(), sources.end(), src) == sources.end()) {
+              sources.push_back(src);
+            }
+          }
+        }
+        sources_[var_binding->var.get()] = std::move(sources);
+      } else {
+        MarkEscape(var_binding ? var_binding->value : binding.as<MatchCastNode>()->value);
+      }
+      if (!binding->var->IsInstance<DataflowVarNode>()) {
+        // ConvertLayout restores the original layout of the variables used after the block.
+        MarkEscape(binding->var);
+      }
+    }
+
+    std::vector<int> choice = SelectLayouts();
+    if (std::all_of(choice.begin(), choice.end(), [](int c) { return c == 0; })) {
+      return block;
+    }
+    Map<Var, Map<String, Array<String>>> binding_layouts = pinned_layouts;
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      const ConvLayout& layout = nodes_[i].layouts[choice[i]];
+      Array<String> layouts{layout.data_layout, layout.kernel_layout};
+      binding_layouts.Set(nodes_[i].var, {{"relax.nn.conv2d", layouts}});
+    }
+    return ConvertLayoutPass(block, {}, binding_layouts);
+  }
+
+ private:
+  /*! \brief Add a conv2d to the graph, return false if its layout cannot be selected. */
+  bool AddConv(const Var& var, const Call& call) {
+    const auto* attrs = call->attrs.as<Conv2DAttrs>();
+    if (attrs->data_layout != "NCHW" || attrs->kernel_layout != "OIHW" ||
+        attrs->out_layout != "NCHW" || attrs->groups != 1) {
+      return false;
+    }
+    Optional<Array<PrimExpr>> data_shape = StaticShape(call->args[0], 4);
+    Optional<Array<PrimExpr>> kernel_shape = StaticShape(call->args[1], 4);
+    Optional<Array<PrimExpr>> out_shape = StaticShape(var, 4);
+    if (!data_shape || !kernel_shape || !out_shape) return false;
+
+    ConvNode node;
+    node.var = var;
+    node.call = call;
+    node.data_elems = static_cast<double>(NumElements(data_shape.value()));
+    node.out_elems = static_cast<double>(NumElements(out_shape.value()));
+    node.layouts.push_back({"NCHW", "OIHW"});
+    int64_t in_channels = Downcast<IntImm>(data_shape.value()[1])->value;
+    int64_t out_channels = Downcast<IntImm>(out_shape.value()[1])->value;
+    DataType dtype = GetStructInfoAs<TensorStructInfoNode>(call->args[0])->dtype;
+    int lanes = std::max(1, vector_bits_ / dtype.bits());
+    for (int block = 4; allow_blocked_ && block <= lanes; block *= 2) {
+      if (in_channels % block == 0 && out_channels % block == 0) {
+        std::string b = std::to_string(block);
+        node.layouts.push_back({"NCHW" + b + "c", "OIHW" + b + "i" + b + "o"});
+      }
+    }
+    node.layouts.push_back({"NHWC", "OHWI"});
+
+    int index = static_cast<int>(nodes_.size());
+    node.producers = GetSources(call->args[0]);
+    node.input_from_outside = node.producers.empty();
+    for (int producer : node.producers) {
+      nodes_[producer].consumers.push_back(index);
+    }
+    MarkEscape(call->args[1]);
+    for (size_t i = 0; i < node.layouts.size(); ++i) {
+      double cost = EstimateCost(node, node.layouts[i], lanes);
+      if (i != 0) {
+        cost += (node.input_from_outside ? node.data_elems : 0);
+      }
+      node.cost.push_back(cost);
+    }
+    nodes_.push_back(std::move(node));
+    sources_[var.get()] = {index};
+    return true;
+  }
+
+  /*!
+   * \brief Estimate the cost of a conv2d in cycles. The conv2d is vectorized along the
+   * innermost axis of its output, and the cost is inversely proportional to how much of the
+   * vector lanes it fills.
+   */
+  double EstimateCost(const ConvNode& node, const ConvLayout& layout, int lanes) {
+    if (fcost_) {
+      return fcost_.value()(node.call, layout.data_layout, layout.kernel_layout).cast<double>();
+    }
+    const auto* attrs = node.call->attrs.as<Conv2DAttrs>();
+    Array<PrimExpr> kernel_shape = StaticShape(node.call->args[1], 4).value();
+    Array<PrimExpr> out_shape = StaticShape(node.var, 4).value();
+    double flops = 2 * node.out_elems * static_cast<double>(NumElements(kernel_shape)) /
+                   Downcast<IntImm>(kernel_shape[0])->value;
+    auto lane_usage = [lanes](int64_t extent) {
+      return static_cast<double>(extent) / ((extent + lanes - 1) / lanes * lanes);
+    };
+    double usage;
+    if (layout.data_layout == "NCHW") {
+      // Vectorized along the output width, the input is strided when the stride is not 1.
+      usage = lane_usage(Downcast<IntImm>(out_shape[3])->value) / attrs->strides[1]->value;
+    } else if (layout.data_layout == "NHWC") {
+      // Vectorized along the output channels, which are not contiguous in the OHWI kernel.
+      usage = lane_usage(Downcast<IntImm>(out_shape[1])->value) / 2;
+    } else {
+      // Vectorized along the channel block, contiguous in both the input and the kernel.
+      tir::Layout data_layout(layout.data_layout);
+      usage = lane_usage(data_layout.FactorOf(tir::LayoutAxis::Get('C')));
+    }
+    return flops / (2 * lanes * usage);
+  }
+
+  /*! \brief The cost of the layout transform between a conv2d and its consumer. */
+  double TransformCost(int producer, int producer_choice, int consumer, int consumer_choice) {
+    const String& from = nodes_[producer].layouts[producer_choice].data_layout;
+    const String& to = nodes_[consumer].layouts[consumer_choice].data_layout;
+    return from == to ? 0 : nodes_[consumer].data_elems;
+  }
+
+  std::vector<int> SelectLayouts() {
+    int num_nodes = static_cast<int>(nodes_.size());
+    for (ConvNode& node : nodes_) {
+      if (node.output_escapes) {
+        for (size_t i = 1; i < node.cost.size(); ++i) node.cost[i] += node.out_elems;
+      }
+    }
+    // The least cost of the conv2d ops up to each node, in each candidate layout of the node.
+    std::vector<std::vector<double>> total(num_nodes);
+    for (int i = 0; i < num_nodes; ++i) {
+      total[i] = nodes_[i].cost;
+      for (size_t s = 0; s < total[i].size(); ++s) {
+        for (int producer : nodes_[i].producers) {
+          double best = std::numeric_limits<double>::infinity();
+          for (size_t t = 0; t < total[producer].size(); ++t) {
+            best = std::min(best, total[producer][t] + TransformCost(producer, t, i, s));
+          }
+          total[i][s] += best;
+        }
+      }
+    }
+    // Pick the layouts backwards, each node knowing the layouts of its consumers.
+    std::vector<int> choice(num_nodes, 0);
+    for (int i = num_nodes - 1; i >= 0; --i) {
+      double best = std::numeric_limits<double>::infinity();
+      for (size_t s = 0; s < total[i].size(); ++s) {
+        double cost = total[i][s];
+        for (int consumer : nodes_[i].consumers) {
+          cost += TransformCost(i, s, consumer, choice[consumer]);
+        }
+        if (cost < best) {
+          best = cost;
+          choice[i] = static_cast<int>(s);
+        }
+      }
+    }
+    return choice;
+  }
+
+  /*! \brief Whether the op of the call takes the layout of its inputs in ConvertLayout. */
+  bool IsLayoutFollowing(const Var& var, const CallNode* call) {
+    static const auto& infer_layout_map = Op::GetAttrMap<FRelaxInferLayout>("FRelaxInferLayout");
+    const auto* op = call->op.as<OpNode>();
+    if (op == nullptr || !infer_layout_map.count(GetRef<Op>(op))) return false;
+    // Ops changing the rank, such as reshape and reduction, may restore the original layout.
+    if (!StaticShape(var, 4).defined()) return false;
+    for (const Expr& arg : call->args) {
+      if (!GetSources(arg).empty() && !StaticShape(arg, 4).defined()) return false;
+    }
+    return true;
+  }
+
+  std::vector<int> GetSources(const Expr& expr) {
+    auto it = sources_.find(expr.get());
+    return it == sources_.end() ? std::vector<int>() : it->second;
+  }
+
+  /*! \brief Mark the conv2d ops flowing into the expression as used in the original layout. */
+  void MarkEscape(const Expr& expr) {
+    PostOrderVisit(expr, [this](const Expr& e) {
+      for (int src : GetSources(e)) nodes_[src].output_escapes = true;
+    });
+  }
+
+  int vector_bits_;
+  /*! \brief Whether the NCHW[x]c layouts are candidates. */
+  bool allow_blocked_;
+  Optional<ffi::Function> fcost_;
+  std::vector<ConvNode> nodes_;
+  /*! \brief The conv2d ops whose output flows into each variable in the layout of the conv2d. */
+  std::unordered_map<const Object*, std::vector<int>> sources_;
+};
+
+}  // namespace
+
+namespace transform {
+
+Pass SelectLayout(Optional<ffi::Function> fcost) {
+  auto pass_func = [=](DataflowBlock block, IRModule m, PassContext pc) {
+    bool allow_blocked = CurrentLLVMTarget().defined();
+    return LayoutSelector(GetVectorBits(), allow_blocked, fcost).Select(block);
+  };
+  return CreateDataflowBlockPass(pass_func, 0, "SelectLayout", {});
+}
+
+TVM_FFI_STATIC_INIT_BLOCK({
+  namespace refl = tvm::ffi::reflection;
+  refl::GlobalDef().def("relax.transform.SelectLayout", SelectLayout);
+});
+
+}  // namespace transform
+}  // namespace relax
+}  // namespace tvm
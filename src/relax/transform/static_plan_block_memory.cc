@@ -64,6 +64,13 @@
  * It means the maximum value of variable that names "n" in the function
  * signature will have upper bound 1024. And we will use 1024 as its value
  * during memory planning.
+ *
+ * When offset packing is enabled, the tensors of a block are placed into one
+ * arena per device. The tensors whose size is constant, including the ones
+ * made constant by the upper bounds above, are packed at constant offsets.
+ * The tensors whose size stays symbolic in the function signature variables
+ * are laid out after them at symbolic offsets, so that the arena is still a
+ * single allocation whose size is computed from the actual shapes at runtime.
  */
 #include <tvm/arith/analyzer.h>
 #include <tvm/ffi/reflection/registry.h>
@@ -71,10 +78,15 @@
 #include <tvm/relax/expr_functor.h>
 #include <tvm/relax/nested_msg.h>
 #include <tvm/relax/transform.h>
+#include <tvm/runtime/device_api.h>
+#include <tvm/tir/analysis.h>
 #include <tvm/tir/stmt_functor.h>
 
+#include <algorithm>
+#include <limits>
 #include <map>
 #include <set>
+#include <tuple>
 #include <vector>
 
 namespace tvm {
@@ -288,6 +300,156 @@ class TokenAllocator1D {
   std::vector<StorageToken> full_pool_;
 };
 
+/*!
+ * \brief Packer that places tensors with known lifetimes into one arena by offset.
+ * \details Unlike TokenAllocator1D, which hands out whole storage tokens, the packer
+ * can place several small tensors inside the space of a large tensor that is dead.
+ * Every tensor gets an offset so that no two tensors that are alive at the same
+ * time overlap, and the arena size is the largest end offset.
+ *
+ * The placement first runs the greedy best-fit heuristic over the tensors ordered
+ * by size and by size times lifetime, and keeps the smaller arena. Arenas of at
+ * most `exact_limit` tensors are then solved exactly: placing the tensors at their
+ * lowest free offset in the order of their offsets in an optimal packing reproduces
+ * that packing, so it suffices to search over the placement orders.
+ */
+class ArenaPacker {
+ public:
+  /*! \brief A tensor to be placed. */
+  struct Item {
+    /*! \brief The time of the allocation. */
+    int64_t begin;
+    /*! \brief The time of the last use, inclusive. */
+    int64_t end;
+    /*! \brief The number of bytes, a multiple of the alignment. */
+    int64_t bytes;
+    /*! \brief The planned offset in the arena. */
+    int64_t offset{-1};
+  };
+
+  /*!
+   * \brief Assign the offsets of the items.
+   * \param items The items to be placed. Their offsets are set on return.
+   * \param exact_limit The largest number of items that is solved exactly.
+   * \return The size of the arena.
+   */
+  static int64_t Pack(std::vector<Item>* items, int exact_limit) {
+    int n = items->size();
+    const std::vector<Item>& its = *items;
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i) order[i] = i;
+    auto lifetime = [&its](int i) { return its[i].end - its[i].begin + 1; };
+
+    // Greedy by size: large tensors are the hardest to place, so they go first.
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return std::make_tuple(-its[a].bytes, -lifetime(a), its[a].begin) <
+             std::make_tuple(-its[b].bytes, -lifetime(b), its[b].begin);
+    });
+    std::vector<int64_t> best_offsets;
+    int64_t best = PlaceInOrder(its, order, &best_offsets);
+    // Greedy by the area each tensor takes in the time-offset plane.
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return its[a].bytes * lifetime(a) > its[b].bytes * lifetime(b);
+    });
+    std::vector<int64_t> offsets;
+    int64_t peak = PlaceInOrder(its, order, &offsets);
+    if (peak < best) {
+      best = peak;
+      best_offsets = offsets;
+    }
+
+    int64_t lower_bound = LiveBytesBound(its);
+    if (n <= exact_limit && best > lower_bound) {
+      offsets.assign(n, -1);
+      SearchExact(its, lower_bound, 0, 0, &offsets, &best, &best_offsets);
+    }
+    for (int i = 0; i < n; ++i) {
+      (*items)[i].offset = best_offsets[i];
+    }
+    return best;
+  }
+
+ private:
+  static bool Overlap(const Item& a, const Item& b) {
+    return a.begin <= b.end && b.begin <= a.end;
+  }
+
+  /*!
+   * \brief Find a free offset for item i among the placed items alive at the same time.
+   * \param best_fit Whether to take the smallest gap that fits rather than the lowest one.
+   */
+  static int64_t FindOffset(const std::vector<Item>& items, const std::vector<int64_t>& offsets,
+                            int i, bool best_fit) {
+    std::vector<std::pair<int64_t, int64_t>> busy;
+    for (size_t j = 0; j < items.size(); ++j) {
+      if (offsets[j] >= 0 && Overlap(items[i], items[j])) {
+        busy.emplace_back(offsets[j], offsets[j] + items[j].bytes);
+      }
+    }
+    std::sort(busy.begin(), busy.end());
+    int64_t cur = 0;
+    int64_t best_offset = -1;
+    int64_t best_gap = std::numeric_limits<int64_t>::max();
+    for (const auto& [lo, hi] : busy) {
+      int64_t gap = lo - cur;
+      if (gap >= items[i].bytes) {
+        if (!best_fit) return cur;
+        if (gap < best_gap) {
+          best_gap = gap;
+          best_offset = cur;
+        }
+      }
+      cur = std::max(cur, hi);
+    }
+    return best_offset >= 0 ? best_offset : cur;
+  }
+
+  /*! \brief Place the items greedily in the given order, returning the arena size. */
+  static int64_t PlaceInOrder(const std::vector<Item>& items, const std::vector<int>& order,
+                              std::vector<int64_t>* offsets) {
+    offsets->assign(items.size(), -1);
+    int64_t peak = 0;
+    for (int i : order) {
+      (*offsets)[i] = FindOffset(items, *offsets, i, /*best_fit=*/true);
+      peak = std::max(peak, (*offsets)[i] + items[i].bytes);
+    }
+    return peak;
+  }
+
+  /*! \brief The largest number of bytes alive at once, which no packing can go below. */
+  static int64_t LiveBytesBound(const std::vector<Item>& items) {
+    int64_t bound = 0;
+    for (const Item& at : items) {
+      int64_t live = 0;
+      for (const Item& item : items) {
+        if (item.begin <= at.begin && at.begin <= item.end) live += item.bytes;
+      }
+      bound = std::max(bound, live);
+    }
+    return bound;
+  }
+
+  /*! \brief Branch and bound over the placement orders. */
+  static void SearchExact(const std::vector<Item>& items, int64_t lower_bound, size_t depth,
+                          int64_t peak, std::vector<int64_t>* offsets, int64_t* best,
+                          std::vector<int64_t>* best_offsets) {
+    if (depth == items.size()) {
+      *best = peak;
+      *best_offsets = *offsets;
+      return;
+    }
+    for (size_t i = 0; i < items.size() && *best > lower_bound; ++i) {
+      if ((*offsets)[i] >= 0) continue;
+      int64_t offset = FindOffset(items, *offsets, i, /*best_fit=*/false);
+      int64_t new_peak = std::max(peak, offset + items[i].bytes);
+      if (new_peak >= *best) continue;
+      (*offsets)[i] = offset;
+      SearchExact(items, lower_bound, depth + 1, new_peak, offsets, best, best_offsets);
+      (*offsets)[i] = -1;
+    }
+  }
+};
+
 /*! \brief Check if the input op is a memory op that may return the same buffer. */
 bool IsInplaceMemoryOp(const Expr& op) {
   static const Op& reshape_op = Op::Get("relax.reshape");
@@ -702,8 +864,12 @@ class StorageAllocatorInit : public StorageAllocatorBaseVisitor {
 class StorageAllocator : public StorageAllocatorBaseVisitor {
  public:
   explicit StorageAllocator(std::unordered_map<const ExprNode*, Tokens> token_map,
-                            arith::Analyzer* analyzer)
-      : allocator_(analyzer) {
+                            arith::Analyzer* analyzer, bool offset_packing = false,
+                            int exact_packing_limit = 0)
+      : allocator_(analyzer),
+        analyzer_(analyzer),
+        offset_packing_(offset_packing),
+        exact_packing_limit_(exact_packing_limit) {
     this->token_map_ = std::move(token_map);
   }
 
@@ -724,6 +890,11 @@ class StorageAllocator : public StorageAllocatorBaseVisitor {
    * underlying storage token that it is using.
    */
   std::unordered_map<const ExprNode*, StorageToken> alloc_tensor2token;
+  /*!
+   * \brief The offset of each `builtin.alloc_tensor` in its storage, for the ones placed
+   * into an arena by offset packing.
+   */
+  std::unordered_map<const ExprNode*, PrimExpr> alloc_tensor2offset;
   /*! \brief The mapping from each binding block to the storage tokens that are create inside. */
   std::unordered_map<const BindingBlockNode*, std::vector<const StorageTokenNode*>> block2tokens;
 
@@ -731,6 +902,27 @@ class StorageAllocator : public StorageAllocatorBaseVisitor {
   using ExprVisitor::VisitBinding_;
   using ExprVisitor::VisitExpr_;
 
+  /*! \brief A tensor that is placed into an arena by offset packing. */
+  struct PackedTensor {
+    /*! \brief The `builtin.alloc_tensor` of the tensor. */
+    const CallNode* alloc;
+    /*! \brief The token of the tensor. */
+    StorageToken token;
+    /*! \brief The runtime device index of the tensor. */
+    int64_t device_index;
+    /*! \brief The time of the allocation. */
+    int64_t begin;
+    /*! \brief The time of the last use. */
+    int64_t end;
+  };
+
+  void VisitExpr_(const FunctionNode* func) final {
+    // The arena of a block is allocated before its first tensor, so a symbolic arena
+    // size may only use the TIR variables that are defined on function entry.
+    signature_vars_ = TIRVarsInStructInfo(GetStructInfo(GetRef<Function>(func)));
+    ExprVisitor::VisitExpr_(func);
+  }
+
   void VisitBindingBlock_(const BindingBlockNode* block) final {
     StorageAllocatorBaseVisitor::VisitBindingBlock_(block);
     // Sanity check: each token allocated inside the block should not be
@@ -738,10 +930,17 @@ class StorageAllocator : public StorageAllocatorBaseVisitor {
     for (const StorageTokenNode* token : block2tokens[block]) {
       ICHECK_EQ(token->ref_counter, 0);
     }
+    PackBlock(block);
+  }
+
+  void VisitBindingBlock_(const DataflowBlockNode* block) final {
+    StorageAllocatorBaseVisitor::VisitBindingBlock_(block);
+    PackBlock(block);
   }
 
   void VisitBinding_(const VarBindingNode* binding, const CallNode* call) final {
     static const Op& alloc_tensor_op = Op::Get("relax.builtin.alloc_tensor");
+    ++time_;
     if (call->op == alloc_tensor_op) {
       auto it = token_map_.find(call);
       ICHECK(it != token_map_.end());
@@ -752,7 +951,7 @@ class StorageAllocator : public StorageAllocatorBaseVisitor {
         return;
       }
       ICHECK(it->second.IsLeaf());
-      StorageToken new_token = this->RequestReuseOrAlloc(it->second.LeafValue());
+      StorageToken new_token = this->RequestPackingOrReuseOrAlloc(call, it->second.LeafValue());
 
       // Record that this alloc_tensor is using the token.
       alloc_tensor2token.insert({call, new_token});
@@ -792,6 +991,116 @@ class StorageAllocator : public StorageAllocatorBaseVisitor {
     }
   }
 
+  /*!
+   * \brief Record the token for offset packing when it is eligible, or otherwise request
+   * a storage reuse or allocate storage.
+   */
+  StorageToken RequestPackingOrReuseOrAlloc(const CallNode* alloc, StorageToken prototype) {
+    // Only tensors in plain global memory whose size is known on function entry can share
+    // an arena by offset.
+    const int64_t* device_index = tir::as_const_int(Downcast<PrimValue>(alloc->args[2])->value);
+    bool size_known_on_entry = prototype->const_bytes() >= 0 ||
+                               tir::UndefinedVars(prototype->bytes, signature_vars_).empty();
+    if (!offset_packing_ || !size_known_on_entry || prototype->storage_scope != "global" ||
+        device_index == nullptr) {
+      return RequestReuseOrAlloc(prototype);
+    }
+    ICHECK(!block_stack_.empty());
+    std::vector<PackedTensor>& packed = block2packed_[block_stack_.back()];
+    token2packed_[prototype.get()] = {block_stack_.back(), packed.size()};
+    packed.push_back({alloc, prototype, *device_index, time_, time_});
+    prototype->storage_id = this->n_storage_++;
+    return prototype;
+  }
+
+  /*!
+   * \brief Pack the tensors recorded in the block into one arena per device and storage
+   * scope, and point their `builtin.alloc_tensor` at the arena.
+   */
+  void PackBlock(const BindingBlockNode* block) {
+    auto it = block2packed_.find(block);
+    if (it == block2packed_.end()) return;
+    std::map<std::pair<std::string, int64_t>, std::vector<const PackedTensor*>> groups;
+    for (const PackedTensor& tensor : it->second) {
+      groups[{tensor.token->storage_scope, tensor.device_index}].push_back(&tensor);
+    }
+    for (const auto& [key, tensors] : groups) {
+      if (tensors.size() == 1) {
+        // A single tensor is its own arena.
+        continue;
+      }
+      std::vector<const PackedTensor*> const_tensors;
+      std::vector<const PackedTensor*> symbolic_tensors;
+      std::vector<ArenaPacker::Item> items;
+      DataType dtype = tensors[0]->token->dtype;
+      for (const PackedTensor* tensor : tensors) {
+        if (tensor->token->dtype != dtype) {
+          dtype = DataType::UInt(8);
+        }
+        int64_t bytes = tensor->token->const_bytes();
+        if (bytes < 0) {
+          symbolic_tensors.push_back(tensor);
+          continue;
+        }
+        bytes = (bytes + runtime::kAllocAlignment - 1) / runtime::kAllocAlignment *
+                runtime::kAllocAlignment;
+        items.push_back({tensor->begin, tensor->end, bytes});
+        const_tensors.push_back(tensor);
+      }
+      int64_t const_bytes = ArenaPacker::Pack(&items, exact_packing_limit_);
+
+      StorageToken arena(/*shape=*/Array<PrimExpr>(), dtype, key.first);
+      arena->storage_id = this->n_storage_++;
+      for (size_t i = 0; i < const_tensors.size(); ++i) {
+        alloc_tensor2token.insert_or_assign(const_tensors[i]->alloc, arena);
+        alloc_tensor2offset[const_tensors[i]->alloc] = IntImm(DataType::Int(64), items[i].offset);
+      }
+      arena->bytes = PackSymbolic(symbolic_tensors, arena, const_bytes);
+    }
+    for (const PackedTensor& tensor : it->second) {
+      token2packed_.erase(tensor.token.get());
+    }
+    block2packed_.erase(it);
+  }
+
+  /*!
+   * \brief Lay out the symbolic-size tensors of an arena after its constant part.
+   * \details The tensors are assigned to slots in the order of allocation. A tensor takes
+   * the slot of a dead tensor when it provably fits in it, and a new slot at the end of the
+   * arena otherwise, so the offsets are sums of the slot sizes before it.
+   * \param tensors The symbolic-size tensors, in the order of allocation.
+   * \param arena The arena token.
+   * \param const_bytes The size of the constant part of the arena.
+   * \return The size of the arena.
+   */
+  PrimExpr PackSymbolic(const std::vector<const PackedTensor*>& tensors, StorageToken arena,
+                        int64_t const_bytes) {
+    struct Slot {
+      PrimExpr offset;
+      PrimExpr bytes;
+      int64_t end;
+    };
+    std::vector<Slot> slots;
+    PrimExpr arena_bytes = IntImm(DataType::Int(64), const_bytes);
+    IntImm align(DataType::Int(64), runtime::kAllocAlignment);
+    for (const PackedTensor* tensor : tensors) {
+      PrimExpr bytes = tensor->token->bytes;
+      auto it = std::find_if(slots.begin(), slots.end(), [&](const Slot& slot) {
+        return slot.end < tensor->begin && analyzer_->CanProve(bytes <= slot.bytes);
+      });
+      if (it == slots.end()) {
+        PrimExpr aligned = analyzer_->Simplify(floordiv(bytes + align - 1, align) * align);
+        slots.push_back({arena_bytes, bytes, tensor->end});
+        arena_bytes = analyzer_->Simplify(arena_bytes + aligned);
+        it = slots.end() - 1;
+      }
+      it->end = tensor->end;
+      alloc_tensor2token.insert_or_assign(tensor->alloc, arena);
+      alloc_tensor2offset[tensor->alloc] = it->offset;
+    }
+    return arena_bytes;
+  }
+
   /*! \brief Request a storage reuse, or allocate storage if no appropriate storage is reusable. */
   StorageToken RequestReuseOrAlloc(StorageToken prototype) {
     Optional<StorageToken> token = allocator_.RequestReuse(prototype);
@@ -812,7 +1121,14 @@ class StorageAllocator : public StorageAllocatorBaseVisitor {
     ICHECK_GE(token->ref_counter, 0);
 
     if (token->ref_counter == 0) {
-      allocator_.Release(token);
+      auto it_packed = token2packed_.find(token.get());
+      if (it_packed != token2packed_.end()) {
+        // A packed tensor is not reused as a whole, its lifetime ends here.
+        const auto& [block, index] = it_packed->second;
+        block2packed_[block][index].end = time_;
+      } else {
+        allocator_.Release(token);
+      }
       auto it = token2cur_tensor_.find(token.get());
       ICHECK(it != token2cur_tensor_.end());
       token2cur_tensor_.erase(it);
@@ -823,8 +1139,26 @@ class StorageAllocator : public StorageAllocatorBaseVisitor {
   int n_storage_{0};
   /*! \brief The 1D memory allocator. */
   TokenAllocator1D allocator_;
+  /*! \brief The arithmetic analyzer, which knows the upper bounds of the TIR variables. */
+  arith::Analyzer* analyzer_;
   /*! \brief The mapping from each token to the tensors that are currently using it. */
   std::unordered_map<const StorageTokenNode*, std::vector<Var>> token2cur_tensor_;
+  /*!
+   * \brief Whether to pack the tensors of a block whose size is known on function entry into
+   * arenas by offset, the symbolic-size ones at symbolic offsets after the constant-size ones.
+   */
+  bool offset_packing_;
+  /*! \brief The largest arena, in number of tensors, whose packing is solved exactly. */
+  int exact_packing_limit_;
+  /*! \brief The logical time, counting the call bindings visited so far. */
+  int64_t time_{0};
+  /*! \brief The tensors to be packed in each binding block. */
+  std::unordered_map<const BindingBlockNode*, std::vector<PackedTensor>> block2packed_;
+  /*! \brief The block and the index in it of each token to be packed. */
+  std::unordered_map<const StorageTokenNode*, std::pair<const BindingBlockNode*, size_t>>
+      token2packed_;
+  /*! \brief The TIR variables in the signature of the function being planned. */
+  Array<tir::Var> signature_vars_;
 };
 
 /*!
@@ -837,10 +1171,12 @@ class StorageAllocationRewriter : public ExprMutator {
  public:
   explicit StorageAllocationRewriter(
       IRModule mod, std::unordered_map<const ExprNode*, StorageToken> alloc_tensor2token,
+      std::unordered_map<const ExprNode*, PrimExpr> alloc_tensor2offset,
       std::unordered_map<const BindingBlockNode*, std::vector<const StorageTokenNode*>>
           block2tokens)
       : ExprMutator(std::move(mod)),
         alloc_tensor2token_(std::move(alloc_tensor2token)),
+        alloc_tensor2offset_(std::move(alloc_tensor2offset)),
         block2tokens_(std::move(block2tokens)) {}
 
   IRModule Rewrite() {
@@ -902,7 +1238,9 @@ class StorageAllocationRewriter : public ExprMutator {
       }
 
       // And always create a `memory.alloc_tensor` for the old `builtin.alloc_tensor`.
-      PrimValue offset = PrimValue::Int64(0);
+      auto it_offset = alloc_tensor2offset_.find(call);
+      PrimValue offset = it_offset != alloc_tensor2offset_.end() ? PrimValue(it_offset->second)
+                                                                 : PrimValue::Int64(0);
       DataType dtype = sinfo->dtype;
       return Call(mem_alloc_tensor, {storage_var, offset, sinfo->shape.value(), DataTypeImm(dtype)},
                   Attrs());
@@ -953,33 +1291,46 @@ class StorageAllocationRewriter : public ExprMutator {
    its corresponding underlying storage token that it is using.
    */
   std::unordered_map<const ExprNode*, StorageToken> alloc_tensor2token_;
+  /*! \brief The offset of each `builtin.alloc_tensor` placed into an arena. */
+  std::unordered_map<const ExprNode*, PrimExpr> alloc_tensor2offset_;
   /*! \brief The mapping from each binding block to the storage tokens that are create inside. */
   std::unordered_map<const BindingBlockNode*, std::vector<const StorageTokenNode*>> block2tokens_;
   /*! \brief The mapping from each token to its corresponding storage var in each function. */
   std::unordered_map<const StorageTokenNode*, Var> token2storage_var_;
 };
 
-IRModule StaticPlanBlockMemory(IRModule mod) {
+IRModule StaticPlanBlockMemory(IRModule mod, bool offset_packing, int exact_packing_limit) {
   arith::Analyzer ana;
 
   // Step 1. Initialize.
   std::unordered_map<const ExprNode*, Tokens> token_map =
       StorageAllocatorInit::Initialize(mod, &ana);
   // Step 2. Collect the memory allocation info.
-  StorageAllocator allocator(std::move(token_map), &ana);
+  StorageAllocator allocator(std::move(token_map), &ana, offset_packing, exact_packing_limit);
   allocator.Allocate(mod);
   // Step 3. Rewrite the function.
   StorageAllocationRewriter rewriter(std::move(mod),  //
                                      std::move(allocator.alloc_tensor2token),
+                                     std::move(allocator.alloc_tensor2offset),
                                      std::move(allocator.block2tokens));
   return rewriter.Rewrite();
 }
 
 namespace transform {
 
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.StaticPlanBlockMemory.offset_packing", Bool);
+TVM_REGISTER_PASS_CONFIG_OPTION("relax.StaticPlanBlockMemory.exact_packing_limit", Integer);
+
 Pass StaticPlanBlockMemory() {
   auto pass_func = [=](IRModule m, PassContext pc) {
-    return relax::StaticPlanBlockMemory(std::move(m));
+    bool offset_packing = pc->GetConfig<Bool>("relax.StaticPlanBlockMemory.offset_packing")
+                              .value_or(Bool(false))
+                              ->value;
+    int exact_packing_limit =
+        pc->GetConfig<Integer>("relax.StaticPlanBlockMemory.exact_packing_limit")
+            .value_or(Integer(8))
+            ->value;
+    return relax::StaticPlanBlockMemory(std::move(m), offset_packing, exact_packing_limit);
   };
   return CreateModulePass(pass_func, /*opt_level=*/0, "StaticPlanBlockMemory", {});
 }
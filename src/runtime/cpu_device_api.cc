@@ -25,9 +25,12 @@
 #include <tvm/ffi/reflection/registry.h>
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/logging.h>
+#include <tvm/runtime/threading_backend.h>
 
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
 #include "workspace_pool.h"
 
@@ -39,6 +42,11 @@
 #include <sys/sysinfo.h>
 #endif
 
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -50,6 +58,31 @@
 
 namespace tvm {
 namespace runtime {
+
+/*!
+ * \brief Ask the kernel to place the pages of a large allocation on the NUMA node the
+ *  thread pool of the calling thread is bound to. This is only a hint, so failures
+ *  and kernels without NUMA support are ignored.
+ */
+static void PreferCurrentNumaNode(void* ptr, size_t nbytes) {
+#if defined(__linux__) && !defined(__ANDROID__) && defined(SYS_mbind)
+  constexpr size_t kMinBytes = 1 << 20;
+  constexpr int kMPolPreferred = 1;
+  int node = threading::CurrentNumaNode();
+  if (node < 0 || nbytes < kMinBytes) return;
+  // Only the whole pages inside the allocation are ours to re-bind.
+  uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = (reinterpret_cast<uintptr_t>(ptr) + page - 1) / page * page;
+  uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + nbytes) / page * page;
+  if (end <= begin) return;
+  constexpr int kBitsPerWord = sizeof(unsigned long) * 8;  // NOLINT(*)
+  std::vector<unsigned long> mask(node / kBitsPerWord + 1, 0);  // NOLINT(*)
+  mask[node / kBitsPerWord] = 1UL << (node % kBitsPerWord);
+  syscall(SYS_mbind, begin, end - begin, kMPolPreferred, mask.data(),
+          mask.size() * kBitsPerWord + 1, 0);
+#endif
+}
+
 class CPUDeviceAPI final : public DeviceAPI {
  public:
   void SetDevice(Device dev) final {}
@@ -105,6 +138,7 @@ class CPUDeviceAPI final : public DeviceAPI {
     // posix_memalign is available in android ndk since __ANDROID_API__ >= 17
     int ret = posix_memalign(&ptr, alignment, nbytes);
     if (ret != 0) throw std::bad_alloc();
+    PreferCurrentNumaNode(ptr, nbytes);
 #endif
     return ptr;
   }
@@ -21,6 +21,7 @@
 #include <tvm/ffi/function.h>
 #include <tvm/runtime/disco/session.h>
 
+#include <algorithm>
 #include <sstream>
 
 namespace tvm {
@@ -34,7 +35,7 @@ struct BcastSessionObj::Internal {
     ffi::AnyView packed_args[kNumArgs];
     ffi::PackedArgs::Fill(packed_args, static_cast<int>(action), reg_id,
                           std::forward<Args>(args)...);
-    self->BroadcastPacked(ffi::PackedArgs(packed_args, kNumArgs));
+    self->SubmitPacked(ffi::PackedArgs(packed_args, kNumArgs));
   }
 
   static DRef MakeDRef(int reg_id, Session session) {
@@ -65,6 +66,8 @@ void BcastSessionObj::CopyToWorker0(const NDArray& host_array, const DRef& remot
 
 void BcastSessionObj::Shutdown() {
   BcastSessionObj::Internal::BroadcastUnpacked(this, DiscoAction::kShutDown, 0);
+  batching_ = false;
+  this->FlushBatch();
 }
 
 void BcastSessionObj::InitCCL(String ccl, ffi::Shape device_ids) {
@@ -75,13 +78,69 @@ void BcastSessionObj::InitCCL(String ccl, ffi::Shape device_ids) {
 }
 
 void BcastSessionObj::SyncWorker(int worker_id) {
+  int64_t fence = issued_fence_;
   BcastSessionObj::Internal::BroadcastUnpacked(this, DiscoAction::kSyncWorker, worker_id);
+  this->FlushBatch();
   ffi::PackedArgs args = this->RecvReplyPacked(worker_id);
   ICHECK_EQ(args.size(), 2);
   DiscoAction action = static_cast<DiscoAction>(args[0].cast<int>());
   int ret_worker_id = args[1].cast<int>();
   ICHECK(action == DiscoAction::kSyncWorker);
   ICHECK_EQ(ret_worker_id, worker_id);
+  if (worker_id == 0) {
+    completed_fence_ = std::max(completed_fence_, fence);
+  }
+}
+
+void BcastSessionObj::BeginBatch() {
+  CHECK(!batching_) << "ValueError: A batch is already in progress on this session";
+  batching_ = true;
+}
+
+int64_t BcastSessionObj::EndBatch() {
+  CHECK(batching_) << "ValueError: `EndBatch` is called without a matching `BeginBatch`";
+  // Stop batching first, so that the registers released while sending are killed immediately.
+  batching_ = false;
+  this->FlushBatch();
+  return ++issued_fence_;
+}
+
+void BcastSessionObj::WaitFence(int64_t fence) {
+  CHECK_LE(fence, issued_fence_) << "ValueError: Fence " << fence << " has not been issued";
+  if (fence > completed_fence_) {
+    this->SyncWorker(0);
+  }
+}
+
+void BcastSessionObj::SubmitPacked(const ffi::PackedArgs& args) {
+  if (!batching_) {
+    this->BroadcastPacked(args);
+    return;
+  }
+  constexpr int kMaxBatchCommands = 256;
+  batch_.emplace_back(args.size());
+  batch_.insert(batch_.end(), args.data(), args.data() + args.size());
+  if (++batch_num_commands_ >= kMaxBatchCommands) {
+    this->FlushBatch();
+  }
+}
+
+void BcastSessionObj::FlushBatch() {
+  if (batch_num_commands_ == 0) {
+    return;
+  }
+  // `batch` may hold the last references to some DRefs, whose deallocation submits new
+  // commands when it is destructed, so the pending state is reset before sending.
+  std::vector<ffi::Any> batch = std::move(batch_);
+  int num_commands = batch_num_commands_;
+  batch_.clear();
+  batch_num_commands_ = 0;
+  std::vector<ffi::AnyView> packed_args;
+  packed_args.reserve(batch.size() + 2);
+  packed_args.emplace_back(static_cast<int>(DiscoAction::kBatch));
+  packed_args.emplace_back(num_commands);
+  packed_args.insert(packed_args.end(), batch.begin(), batch.end());
+  this->BroadcastPacked(ffi::PackedArgs(packed_args.data(), packed_args.size()));
 }
 
 DRef BcastSessionObj::CallWithPacked(const ffi::PackedArgs& args) {
@@ -96,7 +155,7 @@ DRef BcastSessionObj::CallWithPacked(const ffi::PackedArgs& args) {
     args_vec[1] = reg_id;
     args_vec[2] = func->reg_id;
   }
-  this->BroadcastPacked(ffi::PackedArgs(args_vec, args.size()));
+  this->SubmitPacked(ffi::PackedArgs(args_vec, args.size()));
   return BcastSessionObj::Internal::MakeDRef(reg_id, GetRef<Session>(this));
 }
 
@@ -42,6 +42,9 @@ class BcastSessionObj : public SessionObj {
   void SyncWorker(int worker_id) override;
   void Shutdown() override;
   void InitCCL(String ccl, IntTuple device_ids) override;
+  void BeginBatch() override;
+  int64_t EndBatch() override;
+  void WaitFence(int64_t fence) override;
   ffi::Any DebugGetFromRemote(int64_t reg_id, int worker_id) override = 0;
   void DebugSetRegister(int64_t reg_id, ffi::AnyView value, int worker_id) override = 0;
 
@@ -58,6 +61,13 @@ class BcastSessionObj : public SessionObj {
    * \param host_array The array to be appended to worker-0
    */
   virtual void AppendHostNDArray(const NDArray& host_array);
+  /*!
+   * \brief Broadcast a command to all workers, or append it to the pending batch when batching.
+   * \param args The command in TVM's ffi::Function calling convention.
+   */
+  void SubmitPacked(const ffi::PackedArgs& args);
+  /*! \brief Send the pending batch, if any, to all workers as one message. */
+  void FlushBatch();
   /*!
    * \brief Broadcast a command to all workers via TVM's ffi::Function calling convention.
    * As part of the calling convention, The first argument in the packed sequence must be
@@ -90,6 +100,19 @@ class BcastSessionObj : public SessionObj {
   int reg_count_ = 1;
   /*! \brief The regsiter ids that have been deallocated */
   std::vector<int64_t> free_regs_;
+  /*! \brief Whether commands are being buffered into `batch_`. */
+  bool batching_ = false;
+  /*!
+   * \brief The pending batch, encoded as `[num_args_0, args_0..., num_args_1, args_1..., ...]`.
+   * It owns the arguments so that they stay alive until the batch is sent.
+   */
+  std::vector<ffi::Any> batch_;
+  /*! \brief The number of commands in `batch_`. */
+  int batch_num_commands_ = 0;
+  /*! \brief The latest fence handed out by `EndBatch`. */
+  int64_t issued_fence_ = 0;
+  /*! \brief The latest fence known to be completed by worker-0. */
+  int64_t completed_fence_ = 0;
 
   struct Internal;
   friend struct Internal;
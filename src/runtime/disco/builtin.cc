@@ -23,6 +23,7 @@
 #include <tvm/runtime/disco/builtin.h>
 #include <tvm/runtime/disco/disco_worker.h>
 #include <tvm/runtime/disco/session.h>
+#include <tvm/runtime/threading_backend.h>
 #include <tvm/runtime/vm/vm.h>
 
 #include <sstream>
@@ -165,6 +166,11 @@ TVM_FFI_STATIC_INIT_BLOCK({
         const auto f_set_thread_affinity = tvm::ffi::Function::GetGlobalRequired(
             "tvm.runtime.threading.set_current_thread_affinity");
         f_set_thread_affinity(ffi::Shape{cpu_ids[worker_id]});
+      })
+      .def("runtime.disco.bind_worker_to_numa_node", [](ffi::Shape node_ids, int nthreads) {
+        int worker_id = WorkerId();
+        ICHECK_LT(worker_id, static_cast<int>(node_ids.size()));
+        threading::BindToNumaNode(node_ids[worker_id], nthreads);
       });
 });
 
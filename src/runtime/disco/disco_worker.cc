@@ -49,57 +49,82 @@ void DiscoWorker::SetRegister(int reg_id, ffi::AnyView value) {
 struct DiscoWorker::Impl {
   static void MainLoop(DiscoWorker* self) {
     ThreadLocalDiscoWorker::Get()->worker = self;
-    using namespace tvm;
     while (true) {
       ffi::PackedArgs args = self->channel->Recv();
-      DiscoAction action = static_cast<DiscoAction>(args[0].cast<int>());
-      int64_t reg_id = args[1].cast<int64_t>();
-      switch (action) {
-        case DiscoAction::kShutDown: {
-          Shutdown(self);
-          return;
-        }
-        case DiscoAction::kKillReg: {
-          GetReg(self, reg_id) = nullptr;
-          break;
-        }
-        case DiscoAction::kGetGlobalFunc: {
-          GetGlobalFunc(self, reg_id, args[2].cast<std::string>());
-          break;
-        }
-        case DiscoAction::kCallPacked: {
-          int func_reg_id = args[2].cast<int>();
-          CHECK_LT(func_reg_id, self->register_file.size());
-          ffi::Function func = GetReg(self, func_reg_id).cast<ffi::Function>();
-          CHECK(func.defined());
-          CallPacked(self, reg_id, func, args.Slice(3));
-          break;
-        }
-        case DiscoAction::kCopyFromWorker0: {
-          CopyFromWorker0(self, reg_id);
-          break;
-        }
-        case DiscoAction::kCopyToWorker0: {
-          CopyToWorker0(self, reg_id);
-          break;
-        }
-        case DiscoAction::kSyncWorker: {
-          SyncWorker(self, reg_id);
-          break;
-        }
-        case DiscoAction::kDebugGetFromRemote: {
-          int worker_id = args[2].cast<int>();
-          DebugGetFromRemote(self, reg_id, worker_id);
-          break;
-        }
-        case DiscoAction::kDebugSetRegister: {
-          int worker_id = args[2].cast<int>();
-          ffi::AnyView value = args[3];
-          DebugSetRegister(self, reg_id, worker_id, value);
-          break;
+      if (!ExecuteCommand(self, args)) {
+        return;
+      }
+    }
+  }
+
+  /*!
+   * \brief Execute a single command received from the controler.
+   * \return Whether the worker should keep running, i.e. false after a shutdown command.
+   */
+  static bool ExecuteCommand(DiscoWorker* self, ffi::PackedArgs args) {
+    using namespace tvm;
+    DiscoAction action = static_cast<DiscoAction>(args[0].cast<int>());
+    int64_t reg_id = args[1].cast<int64_t>();
+    switch (action) {
+      case DiscoAction::kShutDown: {
+        Shutdown(self);
+        return false;
+      }
+      case DiscoAction::kKillReg: {
+        GetReg(self, reg_id) = nullptr;
+        break;
+      }
+      case DiscoAction::kGetGlobalFunc: {
+        GetGlobalFunc(self, reg_id, args[2].cast<std::string>());
+        break;
+      }
+      case DiscoAction::kCallPacked: {
+        int func_reg_id = args[2].cast<int>();
+        CHECK_LT(func_reg_id, self->register_file.size());
+        ffi::Function func = GetReg(self, func_reg_id).cast<ffi::Function>();
+        CHECK(func.defined());
+        CallPacked(self, reg_id, func, args.Slice(3));
+        break;
+      }
+      case DiscoAction::kCopyFromWorker0: {
+        CopyFromWorker0(self, reg_id);
+        break;
+      }
+      case DiscoAction::kCopyToWorker0: {
+        CopyToWorker0(self, reg_id);
+        break;
+      }
+      case DiscoAction::kSyncWorker: {
+        SyncWorker(self, reg_id);
+        break;
+      }
+      case DiscoAction::kDebugGetFromRemote: {
+        int worker_id = args[2].cast<int>();
+        DebugGetFromRemote(self, reg_id, worker_id);
+        break;
+      }
+      case DiscoAction::kDebugSetRegister: {
+        int worker_id = args[2].cast<int>();
+        ffi::AnyView value = args[3];
+        DebugSetRegister(self, reg_id, worker_id, value);
+        break;
+      }
+      case DiscoAction::kBatch: {
+        // The batch is laid out as `[num_args_0, args_0..., num_args_1, args_1..., ...]`, and the
+        // register slot holds the number of commands.
+        int offset = 2;
+        for (int64_t i = 0; i < reg_id; ++i) {
+          int num_args = args[offset].cast<int>();
+          if (!ExecuteCommand(self, args.Slice(offset + 1, offset + 1 + num_args))) {
+            return false;
+          }
+          offset += 1 + num_args;
         }
+        ICHECK_EQ(offset, args.size());
+        break;
       }
     }
+    return true;
   }
 
   static void Shutdown(DiscoWorker* self) {}
@@ -0,0 +1,556 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file socket_ccl.cc
+ * \brief A point-to-point communication backend over direct TCP connections between workers.
+ *
+ * Every worker listens on an ephemeral port. After `init_ccl("socket")` the controller collects
+ * the ports, pairs them with the host of the node each worker runs on and hands the full address
+ * table to all workers. A worker opens one outgoing connection per receiver on first use, and
+ * eagerly to its peer in the next group, so that pipeline stages exchange activations directly
+ * instead of relaying them through the controller.
+ *
+ * Each worker runs an event loop on a background thread which polls the non-blocking sockets.
+ * Sends stage the buffer and return immediately, so a stage can move on to its next micro batch
+ * while the previous activation is still on the wire; `sync_worker` waits for the outgoing
+ * queues to drain. Receives wait until the message of the given sender has fully arrived.
+ * Collectives are not provided by this backend.
+ */
+#include <tvm/ffi/reflection/registry.h>
+#include <tvm/runtime/disco/builtin.h>
+#include <tvm/runtime/disco/session.h>
+
+#ifndef _WIN32
+#include <netinet/tcp.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../../../support/socket.h"
+#include "../utils.h"
+
+namespace tvm {
+namespace runtime {
+namespace socket_ccl {
+
+#define TVM_DISCO_SOCKET_CCL_NAME "socket"
+
+using support::PollHelper;
+using support::SockAddr;
+using support::Socket;
+using support::TCPSocket;
+
+inline void SetNoDelay(TCPSocket* socket) {
+  int opt = 1;
+  if (setsockopt(socket->sockfd, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<char*>(&opt),
+                 sizeof(opt)) != 0) {
+    Socket::Error("SetNoDelay");
+  }
+}
+
+inline int64_t NumBytes(const NDArray& array) {
+  return array.Shape()->Product() * DataType(array->dtype).bytes();
+}
+
+/*!
+ * \brief One direction of a connection between two workers.
+ *
+ *  Outgoing connections start with the id of the sender, then both directions carry frames of
+ *  an int64 payload size followed by the payload.
+ */
+struct PeerConnection {
+  TCPSocket socket;
+  /*! \brief The worker on the other end, -1 for an incoming connection that has not said hello. */
+  int peer = -1;
+  /*! \brief The size header or hello being read. */
+  int64_t header = 0;
+  /*! \brief The number of bytes of `header` read so far. */
+  size_t header_received = 0;
+  /*! \brief Whether `header` holds the size of the payload being read. */
+  bool in_payload = false;
+  /*! \brief The payload being read. */
+  std::string payload;
+  /*! \brief The number of bytes of `payload` read so far. */
+  size_t payload_received = 0;
+  /*! \brief The frames waiting to be sent. */
+  std::deque<std::string> outbox;
+  /*! \brief The number of bytes of the first frame in `outbox` sent so far. */
+  size_t head_sent = 0;
+};
+
+class SocketCCLContext {
+ public:
+  /*! \brief The worker this context belongs to. */
+  DiscoWorker* worker = nullptr;
+
+  ~SocketCCLContext() { Clear(); }
+
+  static SocketCCLContext* Get() {
+    thread_local static SocketCCLContext ctx;
+    return &ctx;
+  }
+
+  bool initialized() const { return io_thread_.joinable(); }
+
+  /*! \brief Start listening for peers, return the port. */
+  int Listen() {
+    Socket::Startup();
+    listener_.Create();
+    listener_.Bind(SockAddr("0.0.0.0", 0));
+    listener_.Listen(256);
+    SockAddr addr;
+    socklen_t addrlen = sizeof(addr.addr);
+    if (getsockname(listener_.sockfd, reinterpret_cast<sockaddr*>(&addr.addr), &addrlen) != 0) {
+      Socket::Error("getsockname");
+    }
+    // The loop is woken up through a connection to itself, which is accepted before the port
+    // is published so that it cannot be confused with a peer.
+    wake_send_.Create();
+    CHECK(wake_send_.Connect(SockAddr("127.0.0.1", addr.port())))
+        << "Cannot connect the socket CCL to itself, errno = " << Socket::GetLastErrorCode();
+    SetNoDelay(&wake_send_);
+    wake_recv_ = listener_.Accept();
+    wake_recv_.SetNonBlock(true);
+    return addr.port();
+  }
+
+  /*! \brief Record the addresses of all workers and start the event loop. */
+  void Start(std::vector<std::string> peer_addrs) {
+    CHECK_EQ(static_cast<int>(peer_addrs.size()), worker->num_workers)
+        << "ValueError: Expect one address per worker";
+    peer_addrs_ = std::move(peer_addrs);
+    outbound_.resize(worker->num_workers);
+    inbox_.resize(worker->num_workers);
+    listener_.SetNonBlock(true);
+    io_thread_ = std::thread([this]() { this->Loop(); });
+  }
+
+  /*! \brief Stage `buffer` for sending to `receiver`. */
+  void Send(int receiver, const NDArray& buffer) {
+    int64_t num_bytes = NumBytes(buffer);
+    std::string frame(sizeof(int64_t) + num_bytes, '\0');
+    std::memcpy(&frame[0], &num_bytes, sizeof(int64_t));
+    buffer.CopyToBytes(&frame[sizeof(int64_t)], num_bytes);
+    PeerConnection* conn = GetOutbound(receiver);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      CheckError();
+      conn->outbox.push_back(std::move(frame));
+    }
+    Wake();
+  }
+
+  /*! \brief Wait for the next message from `sender` and copy it into `buffer`. */
+  void Recv(int sender, NDArray buffer) {
+    std::string payload;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [&]() { return !inbox_[sender].empty() || !error_.empty(); });
+      CheckError();
+      payload = std::move(inbox_[sender].front());
+      inbox_[sender].pop_front();
+    }
+    CHECK_EQ(static_cast<int64_t>(payload.size()), NumBytes(buffer))
+        << "ValueError: Worker " << sender << " sent " << payload.size()
+        << " bytes, but the receiving buffer has " << NumBytes(buffer) << " bytes";
+    buffer.CopyFromBytes(payload.data(), payload.size());
+  }
+
+  /*! \brief Connect to `receiver` ahead of the first send. */
+  void Preconnect(int receiver) { GetOutbound(receiver); }
+
+  /*! \brief Wait until all staged messages are sent. */
+  void Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&]() {
+      if (!error_.empty()) return true;
+      for (const auto& conn : outbound_) {
+        if (conn != nullptr && !conn->outbox.empty()) return false;
+      }
+      return true;
+    });
+    CheckError();
+  }
+
+  void Clear() {
+    if (io_thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      Wake();
+      io_thread_.join();
+    }
+    for (auto& conn : outbound_) {
+      if (conn != nullptr) conn->socket.Close();
+    }
+    for (auto& conn : inbound_) {
+      conn->socket.Close();
+    }
+    for (TCPSocket* socket : {&listener_, &wake_send_, &wake_recv_}) {
+      if (!socket->IsClosed()) socket->Close();
+    }
+    outbound_.clear();
+    inbound_.clear();
+    inbox_.clear();
+    peer_addrs_.clear();
+    error_.clear();
+    stop_ = false;
+    worker = nullptr;
+  }
+
+ private:
+  void CheckError() const { CHECK(error_.empty()) << "The socket CCL failed: " << error_; }
+
+  void Wake() {
+    char byte = 0;
+    wake_send_.SendAll(&byte, 1);
+  }
+
+  PeerConnection* GetOutbound(int receiver) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (outbound_[receiver] != nullptr) return outbound_[receiver].get();
+    }
+    // Only the worker thread creates outgoing connections, so connecting outside of the lock
+    // cannot race with another connection attempt.
+    const std::string& url = peer_addrs_[receiver];
+    size_t sep = url.rfind(':');
+    SockAddr addr(url.substr(0, sep).c_str(), std::stoi(url.substr(sep + 1)));
+    auto conn = std::make_unique<PeerConnection>();
+    conn->peer = receiver;
+    conn->socket.Create(addr.ss_family());
+    CHECK(conn->socket.Connect(addr)) << "Cannot connect to worker " << receiver << " at " << url
+                                      << ", errno = " << Socket::GetLastErrorCode();
+    SetNoDelay(&conn->socket);
+    int64_t hello = worker->worker_id;
+    conn->socket.SendAll(&hello, sizeof(hello));
+    conn->socket.SetNonBlock(true);
+    std::lock_guard<std::mutex> lock(mutex_);
+    outbound_[receiver] = std::move(conn);
+    return outbound_[receiver].get();
+  }
+
+  void Loop() {
+    try {
+      while (true) {
+        PollHelper poll;
+        poll.WatchRead(wake_recv_.sockfd);
+        poll.WatchRead(listener_.sockfd);
+        for (const auto& conn : inbound_) {
+          poll.WatchRead(conn->socket.sockfd);
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (stop_) return;
+          for (const auto& conn : outbound_) {
+            if (conn != nullptr && !conn->outbox.empty()) poll.WatchWrite(conn->socket.sockfd);
+          }
+        }
+        poll.Poll();
+        if (poll.CheckRead(wake_recv_.sockfd)) {
+          char bytes[256];
+          while (wake_recv_.Recv(bytes, sizeof(bytes)) > 0) {
+          }
+        }
+        if (poll.CheckRead(listener_.sockfd)) {
+          Accept();
+        }
+        for (size_t i = 0; i < inbound_.size();) {
+          if (poll.CheckRead(inbound_[i]->socket.sockfd) && !ReadInbound(inbound_[i].get())) {
+            // The sender finished, e.g. at shutdown.
+            inbound_[i]->socket.Close();
+            inbound_.erase(inbound_.begin() + i);
+          } else {
+            ++i;
+          }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& conn : outbound_) {
+          if (conn != nullptr && poll.CheckWrite(conn->socket.sockfd)) {
+            WriteOutbound(conn.get());
+          }
+        }
+      }
+    } catch (const std::exception& e) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = e.what();
+      cv_.notify_all();
+    }
+  }
+
+  void Accept() {
+    while (true) {
+      auto conn = std::make_unique<PeerConnection>();
+      conn->socket = TCPSocket(accept(listener_.sockfd, nullptr, nullptr));
+      if (conn->socket.IsClosed()) {
+        if (Socket::LastErrorWouldBlock()) return;
+        Socket::Error("Accept");
+      }
+      conn->socket.SetNonBlock(true);
+      SetNoDelay(&conn->socket);
+      inbound_.push_back(std::move(conn));
+    }
+  }
+
+  /*! \brief Read what is available on an incoming connection, return false at end of stream. */
+  bool ReadInbound(PeerConnection* conn) {
+    while (true) {
+      char* dst;
+      size_t num_bytes;
+      if (!conn->in_payload) {
+        dst = reinterpret_cast<char*>(&conn->header) + conn->header_received;
+        num_bytes = sizeof(int64_t) - conn->header_received;
+      } else {
+        dst = &conn->payload[conn->payload_received];
+        num_bytes = conn->payload.size() - conn->payload_received;
+      }
+      ssize_t ret = num_bytes == 0 ? 0 : conn->socket.Recv(dst, num_bytes);
+      if (ret == -1) {
+        if (Socket::LastErrorWouldBlock()) return true;
+        Socket::Error("Recv");
+      }
+      if (ret == 0 && num_bytes != 0) return false;
+      if (!conn->in_payload) {
+        conn->header_received += ret;
+        if (conn->header_received < sizeof(int64_t)) continue;
+        conn->header_received = 0;
+        if (conn->peer == -1) {
+          CHECK(conn->header >= 0 && conn->header < worker->num_workers)
+              << "Invalid worker id " << conn->header << " in the hello of a peer";
+          conn->peer = static_cast<int>(conn->header);
+          continue;
+        }
+        conn->payload.assign(conn->header, '\0');
+        conn->payload_received = 0;
+        conn->in_payload = true;
+      } else {
+        conn->payload_received += ret;
+      }
+      if (conn->in_payload && conn->payload_received == conn->payload.size()) {
+        conn->in_payload = false;
+        std::lock_guard<std::mutex> lock(mutex_);
+        inbox_[conn->peer].push_back(std::move(conn->payload));
+        conn->payload.clear();
+        cv_.notify_all();
+      }
+    }
+  }
+
+  /*! \brief Send what the socket accepts from the outbox, requires `mutex_`. */
+  void WriteOutbound(PeerConnection* conn) {
+#ifdef MSG_NOSIGNAL
+    constexpr int kFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kFlags = 0;
+#endif
+    while (!conn->outbox.empty()) {
+      const std::string& frame = conn->outbox.front();
+      ssize_t ret = conn->socket.Send(frame.data() + conn->head_sent,
+                                      frame.size() - conn->head_sent, kFlags);
+      if (ret == -1) {
+        if (Socket::LastErrorWouldBlock()) return;
+        Socket::Error("Send");
+      }
+      conn->head_sent += ret;
+      if (conn->head_sent == frame.size()) {
+        conn->outbox.pop_front();
+        conn->head_sent = 0;
+      }
+    }
+    cv_.notify_all();
+  }
+
+  TCPSocket listener_;
+  /*! \brief The two ends of the connection used to wake up the event loop. */
+  TCPSocket wake_send_, wake_recv_;
+  /*! \brief The address of each worker as host:port. */
+  std::vector<std::string> peer_addrs_;
+  /*! \brief The outgoing connection to each worker, created on first use. */
+  std::vector<std::unique_ptr<PeerConnection>> outbound_;
+  /*! \brief The incoming connections, only accessed by the event loop. */
+  std::vector<std::unique_ptr<PeerConnection>> inbound_;
+  /*! \brief The messages received from each worker. */
+  std::vector<std::deque<std::string>> inbox_;
+  /*! \brief The error which stopped the event loop, if any. */
+  std::string error_;
+  bool stop_ = false;
+  /*! \brief Guards `outbound_`, `inbox_`, `error_` and `stop_`. */
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread io_thread_;
+};
+
+inline SocketCCLContext* GetInitializedContext() {
+  SocketCCLContext* ctx = SocketCCLContext::Get();
+  CHECK(ctx->initialized()) << "ValueError: The socket CCL has not been initialized on this "
+                               "worker, please call `init_ccl(\"socket\")` first.";
+  return ctx;
+}
+
+void InitCCL(Session sess, ffi::Shape device_ids) {
+  DRef f_listen = sess->GetGlobalFunc("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME
+                                      ".init_ccl_per_worker");
+  DLOG(INFO) << "Initializing " TVM_DISCO_SOCKET_CCL_NAME " with devices: " << device_ids;
+  DRef ports = sess->CallPacked(f_listen, device_ids);
+  // Workers of a socket session are reached through the host of their node, all other sessions
+  // run on the local host.
+  const auto f_worker_host = tvm::ffi::Function::GetGlobal("runtime.disco.socket_session_host");
+  std::string addrs;
+  for (int64_t i = 0; i < sess->GetNumWorkers(); ++i) {
+    std::string host = "127.0.0.1";
+    if (f_worker_host.has_value()) {
+      String node_host = (*f_worker_host)(sess, i).cast<String>();
+      if (!node_host.empty()) host = node_host;
+    }
+    int port = ports->DebugGetFromRemote(i).cast<int>();
+    addrs += (i == 0 ? "" : ",") + host + ":" + std::to_string(port);
+  }
+  DRef f_start = sess->GetGlobalFunc("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".start_workers");
+  sess->CallPacked(f_start, addrs);
+  sess->SyncWorker(0);
+}
+
+int InitCCLPerWorker(ffi::Shape device_ids) {
+  SocketCCLContext* ctx = SocketCCLContext::Get();
+  DiscoWorker* worker = DiscoWorker::ThreadLocal();
+  ICHECK(worker != nullptr);
+  // Messages are staged in host memory, so `device_ids` only exist for API compatibility.
+  ctx->Clear();
+  ctx->worker = worker;
+  worker->ccl = TVM_DISCO_SOCKET_CCL_NAME;
+  return ctx->Listen();
+}
+
+void StartWorkers(String addrs) {
+  SocketCCLContext* ctx = SocketCCLContext::Get();
+  ICHECK(ctx->worker != nullptr);
+  std::vector<std::string> peer_addrs;
+  std::string all = addrs;
+  for (size_t begin = 0; begin <= all.size();) {
+    size_t end = std::min(all.find(',', begin), all.size());
+    peer_addrs.push_back(all.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  ctx->Start(std::move(peer_addrs));
+  // Pipeline stages talk to the same worker of the next group over and over again.
+  DiscoWorker* worker = ctx->worker;
+  int group_size = worker->num_workers / worker->num_groups;
+  if (worker->worker_id + group_size < worker->num_workers) {
+    ctx->Preconnect(worker->worker_id + group_size);
+  }
+}
+
+/********** Point-to-point **********/
+
+void SendToWorker(NDArray buffer, int receiver_id) {
+  SocketCCLContext* ctx = GetInitializedContext();
+  int worker_id = ctx->worker->worker_id;
+  CHECK(receiver_id >= 0 && receiver_id < ctx->worker->num_workers)
+      << "Invalid receiver id " << receiver_id << ". The world size is "
+      << ctx->worker->num_workers;
+  CHECK_NE(worker_id, receiver_id) << "Cannot send to worker itself.";
+  ctx->Send(receiver_id, buffer);
+}
+
+void RecvFromWorker(NDArray buffer, int sender_id) {
+  SocketCCLContext* ctx = GetInitializedContext();
+  int worker_id = ctx->worker->worker_id;
+  CHECK(sender_id >= 0 && sender_id < ctx->worker->num_workers)
+      << "Invalid sender id " << sender_id << ". The world size is " << ctx->worker->num_workers;
+  CHECK_NE(worker_id, sender_id) << "Cannot receive from the worker itself.";
+  ctx->Recv(sender_id, buffer);
+}
+
+void RecvFromWorker0(NDArray buffer) {
+  SocketCCLContext* ctx = GetInitializedContext();
+  CHECK_NE(ctx->worker->worker_id, 0)
+      << "ValueError: Worker 0 is not allowed to call RecvFromWorker0.";
+  socket_ccl::RecvFromWorker(buffer, 0);
+}
+
+void SendToNextGroup(NDArray buffer) {
+  SocketCCLContext* ctx = GetInitializedContext();
+  int group_size = ctx->worker->num_workers / ctx->worker->num_groups;
+  int receiver_id = ctx->worker->worker_id + group_size;
+  CHECK_LT(receiver_id, ctx->worker->num_workers)
+      << "The current group is already the last group and there is no such a next group.";
+  socket_ccl::SendToWorker(buffer, receiver_id);
+}
+
+void RecvFromPrevGroup(NDArray buffer) {
+  SocketCCLContext* ctx = GetInitializedContext();
+  int group_size = ctx->worker->num_workers / ctx->worker->num_groups;
+  int sender_id = ctx->worker->worker_id - group_size;
+  CHECK_GE(sender_id, 0)
+      << "The current group is already the first group and there is no such a previous group.";
+  socket_ccl::RecvFromWorker(buffer, sender_id);
+}
+
+void SyncWorker() { GetInitializedContext()->Flush(); }
+
+TVM_FFI_STATIC_INIT_BLOCK({
+  namespace refl = tvm::ffi::reflection;
+  refl::GlobalDef()
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".init_ccl", InitCCL)
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".init_ccl_per_worker", InitCCLPerWorker)
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".start_workers", StartWorkers)
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".recv_from_worker0", RecvFromWorker0)
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".send_to_next_group", SendToNextGroup)
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".recv_from_prev_group", RecvFromPrevGroup)
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".send_to_worker", SendToWorker)
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".recv_from_worker", RecvFromWorker)
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".sync_worker", SyncWorker)
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME
+           ".test_send_to_next_group_recv_from_prev_group",
+           [](NDArray buffer) {
+             SocketCCLContext* ctx = GetInitializedContext();
+             int group_size = ctx->worker->num_workers / ctx->worker->num_groups;
+             int group_id = ctx->worker->worker_id / group_size;
+             if (group_id + 1 < ctx->worker->num_groups) {
+               socket_ccl::SendToNextGroup(buffer);
+             }
+             if (group_id > 0) {
+               socket_ccl::RecvFromPrevGroup(buffer);
+             }
+           })
+      .def("runtime.disco." TVM_DISCO_SOCKET_CCL_NAME ".test_worker2_sends_to_worker0",
+           [](NDArray buffer) {
+             SocketCCLContext* ctx = GetInitializedContext();
+             if (ctx->worker->worker_id == 2) {
+               socket_ccl::SendToWorker(buffer, 0);
+             } else if (ctx->worker->worker_id == 0) {
+               socket_ccl::RecvFromWorker(buffer, 2);
+             }
+           });
+});
+
+}  // namespace socket_ccl
+}  // namespace runtime
+}  // namespace tvm
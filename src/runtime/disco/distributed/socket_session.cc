@@ -20,6 +20,8 @@
 #include <tvm/ffi/reflection/registry.h>
 
 #include <numeric>
+#include <string>
+#include <vector>
 
 #include "../../../support/socket.h"
 #include "../bcast_session.h"
@@ -53,6 +55,12 @@ class DiscoSocketChannel : public DiscoChannel {
   DiscoStreamMessageQueue message_queue_;
 };
 
+/*! \brief The host part of an address. */
+inline std::string HostOf(const SockAddr& addr) {
+  std::string url = addr.AsString();
+  return url.substr(0, url.rfind(':'));
+}
+
 class SocketSessionObj : public BcastSessionObj {
  public:
   explicit SocketSessionObj(int num_nodes, int num_workers_per_node, int num_groups,
@@ -91,13 +99,31 @@ class SocketSessionObj : public BcastSessionObj {
       //  - num_groups
       //  - node_id
       remote_channels_.back()->Send(ffi::PackedArgs(packed_args, 4));
+      node_hosts_.push_back(HostOf(addr));
       LOG(INFO) << "Remote node " << addr.AsString() << " connected";
     }
+    // Remote nodes reach the workers of the controller through the address they connected to.
+    std::string local_host = "127.0.0.1";
+    if (!remote_sockets_.empty()) {
+      SockAddr addr;
+      socklen_t addrlen = sizeof(addr.addr);
+      if (getsockname(remote_sockets_[0].sockfd, reinterpret_cast<sockaddr*>(&addr.addr),
+                      &addrlen) == 0) {
+        local_host = HostOf(addr);
+      }
+    }
+    node_hosts_.insert(node_hosts_.begin(), local_host);
+  }
+
+  /*! \brief The host through which the workers of other nodes reach the given worker. */
+  const std::string& WorkerHost(int worker_id) const {
+    return node_hosts_.at(worker_id / num_workers_per_node_);
   }
 
   int64_t GetNumWorkers() final { return num_nodes_ * num_workers_per_node_; }
 
   ffi::Any DebugGetFromRemote(int64_t reg_id, int worker_id) final {
+    this->FlushBatch();
     int node_id = worker_id / num_workers_per_node_;
     if (node_id == 0) {
       return local_session_->DebugGetFromRemote(reg_id, worker_id);
@@ -116,6 +142,7 @@ class SocketSessionObj : public BcastSessionObj {
   }
 
   void DebugSetRegister(int64_t reg_id, AnyView value, int worker_id) final {
+    this->FlushBatch();
     int node_id = worker_id / num_workers_per_node_;
     if (node_id == 0) {
       local_session_->DebugSetRegister(reg_id, value, worker_id);
@@ -178,6 +205,9 @@ class SocketSessionObj : public BcastSessionObj {
   }
 
   void Shutdown() final {
+    // Send the commands the controller still batches before the remote nodes go away.
+    batching_ = false;
+    this->FlushBatch();
     // local session will be implicitly shutdown by its destructor
     std::vector<AnyView> packed_args(2);
     ffi::PackedArgs::Fill(packed_args.data(), static_cast<int>(DiscoSocketAction::kShutdown), -1);
@@ -204,6 +234,8 @@ class SocketSessionObj : public BcastSessionObj {
   TCPSocket socket_;
   std::vector<TCPSocket> remote_sockets_;
   std::vector<std::unique_ptr<DiscoSocketChannel>> remote_channels_;
+  /*! \brief The host of each node, as reachable from the other nodes. */
+  std::vector<std::string> node_hosts_;
   BcastSession local_session_{nullptr};
 };
 
@@ -310,6 +342,14 @@ TVM_FFI_STATIC_INIT_BLOCK({
   namespace refl = tvm::ffi::reflection;
   refl::GlobalDef()
       .def("runtime.disco.SocketSession", SocketSession)
+      .def("runtime.disco.socket_session_host",
+           [](Session sess, int worker_id) -> String {
+             // Empty for other kinds of sessions, whose workers all live on the local host.
+             if (const auto* socket_sess = sess.as<SocketSessionObj>()) {
+               return socket_sess->WorkerHost(worker_id);
+             }
+             return "";
+           })
       .def("runtime.disco.socket_session_init_workers",
            [](int num_nodes, int node_id, int num_groups, int num_workers_per_node) {
              LOG(INFO) << "Initializing worker group with " << num_nodes << " nodes, "
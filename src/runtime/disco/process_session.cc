@@ -99,6 +99,7 @@ class ProcessSessionObj final : public BcastSessionObj {
       this->SyncWorker(worker_id);
       return worker_0_->worker->register_file.at(reg_id);
     }
+    this->FlushBatch();
     {
       ffi::AnyView packed_args[3];
       ffi::PackedArgs::Fill(packed_args, static_cast<int>(DiscoAction::kDebugGetFromRemote), reg_id,
@@ -119,6 +120,7 @@ class ProcessSessionObj final : public BcastSessionObj {
       worker_0_->worker->SetRegister(reg_id, value);
       return;
     }
+    this->FlushBatch();
     ObjectRef wrapped{nullptr};
     if (value.as<ObjectRef>()) {
       wrapped = DiscoDebugObject::Wrap(value);
@@ -44,6 +44,9 @@ TVM_FFI_STATIC_INIT_BLOCK({
       .def_method("runtime.disco.SessionCopyToWorker0", &SessionObj::CopyToWorker0)
       .def_method("runtime.disco.SessionSyncWorker", &SessionObj::SyncWorker)
       .def_method("runtime.disco.SessionInitCCL", &SessionObj::InitCCL)
+      .def_method("runtime.disco.SessionBeginBatch", &SessionObj::BeginBatch)
+      .def_method("runtime.disco.SessionEndBatch", &SessionObj::EndBatch)
+      .def_method("runtime.disco.SessionWaitFence", &SessionObj::WaitFence)
       .def_packed("runtime.disco.SessionCallPacked",
                   [](ffi::PackedArgs args, ffi::Any* rv) {
                     Session self = args[0].cast<Session>();
@@ -0,0 +1,690 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file shm_ccl.cc
+ * \brief A collective communication backend for CPU workers based on POSIX shared memory.
+ *
+ * All workers of a session, either threads of a ThreadedSession or processes of a ProcessSession
+ * on the same host, map one shared segment. The segment consists of a small header with barriers
+ * and point-to-point mailboxes, followed by one staging slot per worker. Each worker only writes to
+ * its own slot, and the slot is first touched by its owner so that, under the default first-touch
+ * policy, it is placed on the NUMA node the worker runs on. Binding workers to cores via
+ * `runtime.disco.bind_worker_to_cpu_core` before `init_ccl` makes the placement stable.
+ *
+ * Reductions are performed as a reduce-scatter followed by an allgather: every rank reduces one
+ * contiguous segment of the staged chunk across all peers, then every rank collects the reduced
+ * segments. The reduction kernels are plain contiguous loops which the compiler vectorizes;
+ * float16 and bfloat16 are accumulated in float32 blocks.
+ */
+#include <builtin_fp16.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tvm/ffi/reflection/registry.h>
+#include <tvm/runtime/disco/builtin.h>
+#include <tvm/runtime/disco/session.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../../support/process_id.h"
+#include "../utils.h"
+
+namespace tvm {
+namespace runtime {
+namespace shm {
+
+#define TVM_DISCO_SHM_CCL_NAME "shm"
+
+/*! \brief Alignment of the segment regions, which is also the page size assumed for slots. */
+constexpr int64_t kShmPageBytes = 4096;
+/*! \brief The default size of the staging slot of each worker. */
+constexpr int64_t kDefaultSlotBytes = 4 << 20;
+
+/*! \brief A sense-reversing barrier living in the shared segment. */
+struct alignas(64) ShmBarrier {
+  std::atomic<uint32_t> count;
+  std::atomic<uint32_t> generation;
+};
+
+/*! \brief The mailbox of a worker, used by point-to-point transfers out of its slot. */
+struct alignas(64) ShmMailbox {
+  /*! \brief The id of the receiver plus one of the message staged in the slot, 0 if empty. */
+  std::atomic<int32_t> receiver;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<int32_t>::is_always_lock_free,
+              "The shared-memory backend requires address-free atomics");
+
+inline int64_t RoundUp(int64_t value, int64_t align) { return (value + align - 1) / align * align; }
+
+/*!
+ * \brief The layout of the shared segment. Barrier 0 is the global barrier, and barrier `1 + g`
+ * belongs to group `g`. The number of groups never exceeds the number of workers.
+ */
+inline int64_t HeaderBytes(int num_workers) {
+  return RoundUp(static_cast<int64_t>(1 + num_workers) * sizeof(ShmBarrier) +
+                     static_cast<int64_t>(num_workers) * sizeof(ShmMailbox),
+                 kShmPageBytes);
+}
+
+inline int64_t SegmentBytes(int num_workers, int64_t slot_bytes) {
+  return HeaderBytes(num_workers) + num_workers * slot_bytes;
+}
+
+/*! \brief Spin on a condition, yielding the core once the wait becomes long. */
+template <typename FCond>
+inline void SpinUntil(FCond cond) {
+  for (int i = 0; !cond(); ++i) {
+    if (i >= 1024) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+struct ShmCCLContext {
+  /*! \brief The worker this context belongs to. */
+  DiscoWorker* worker = nullptr;
+  /*! \brief The start of the mapped segment. */
+  uint8_t* base = nullptr;
+  /*! \brief The number of bytes mapped. */
+  int64_t mapped_bytes = 0;
+  /*! \brief The size of the staging slot of each worker. */
+  int64_t slot_bytes = 0;
+
+  ~ShmCCLContext() { Clear(); }
+
+  void Clear() {
+    if (base != nullptr) {
+      munmap(base, mapped_bytes);
+    }
+    base = nullptr;
+    worker = nullptr;
+  }
+
+  ShmBarrier* Barrier(int index) const { return reinterpret_cast<ShmBarrier*>(base) + index; }
+
+  ShmMailbox* Mailbox(int worker_id) const {
+    return reinterpret_cast<ShmMailbox*>(base + (1 + worker->num_workers) * sizeof(ShmBarrier)) +
+           worker_id;
+  }
+
+  uint8_t* Slot(int worker_id) const {
+    return base + HeaderBytes(worker->num_workers) + worker_id * slot_bytes;
+  }
+
+  static ShmCCLContext* Get() {
+    thread_local static ShmCCLContext ctx;
+    return &ctx;
+  }
+};
+
+/*! \brief The set of workers taking part in a collective, either all workers or one group. */
+struct Communicator {
+  /*! \brief The rank of the current worker inside the communicator. */
+  int rank;
+  /*! \brief The number of workers in the communicator. */
+  int size;
+  /*! \brief The worker id of rank 0. */
+  int first_worker;
+  /*! \brief The barrier shared by the communicator. */
+  ShmBarrier* barrier;
+
+  void Sync() const {
+    uint32_t generation = barrier->generation.load(std::memory_order_acquire);
+    if (barrier->count.fetch_add(1, std::memory_order_acq_rel) + 1 ==
+        static_cast<uint32_t>(size)) {
+      barrier->count.store(0, std::memory_order_relaxed);
+      barrier->generation.fetch_add(1, std::memory_order_release);
+    } else {
+      SpinUntil([&]() {
+        return barrier->generation.load(std::memory_order_acquire) != generation;
+      });
+    }
+  }
+};
+
+inline ShmCCLContext* GetInitializedContext() {
+  ShmCCLContext* ctx = ShmCCLContext::Get();
+  CHECK(ctx->base != nullptr) << "ValueError: The shared-memory CCL has not been initialized on "
+                                 "this worker, please call `init_ccl(\"shm\")` first.";
+  return ctx;
+}
+
+inline Communicator GetCommunicator(const ShmCCLContext* ctx, bool in_group) {
+  int worker_id = ctx->worker->worker_id;
+  if (!in_group) {
+    return Communicator{worker_id, ctx->worker->num_workers, 0, ctx->Barrier(0)};
+  }
+  int group_size = ctx->worker->num_workers / ctx->worker->num_groups;
+  int group_id = worker_id / group_size;
+  return Communicator{worker_id % group_size, group_size, group_id * group_size,
+                      ctx->Barrier(1 + group_id)};
+}
+
+inline int64_t NumBytes(const NDArray& array) {
+  return array.Shape()->Product() * DataType(array->dtype).bytes();
+}
+
+/********** Reduction kernels **********/
+
+struct SumOp {
+  template <typename T>
+  T operator()(T a, T b) const {
+    return a + b;
+  }
+};
+
+struct ProdOp {
+  template <typename T>
+  T operator()(T a, T b) const {
+    return a * b;
+  }
+};
+
+struct MinOp {
+  template <typename T>
+  T operator()(T a, T b) const {
+    return b < a ? b : a;
+  }
+};
+
+struct MaxOp {
+  template <typename T>
+  T operator()(T a, T b) const {
+    return a < b ? b : a;
+  }
+};
+
+inline float BFloat16ToFloat(uint16_t value) {
+  uint32_t bits = static_cast<uint32_t>(value) << 16;
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+inline uint16_t FloatToBFloat16(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  if ((bits & 0x7FFFFFFFu) > 0x7F800000u) {
+    // Keep NaN a quiet NaN after truncation.
+    return static_cast<uint16_t>((bits >> 16) | 0x40u);
+  }
+  // Round to nearest even.
+  return static_cast<uint16_t>((bits + 0x7FFFu + ((bits >> 16) & 1u)) >> 16);
+}
+
+inline float HalfToFloat(uint16_t value) {
+  return __extendXfYf2__<uint16_t, uint16_t, 10, float, uint32_t, 23>(value);
+}
+
+inline uint16_t FloatToHalf(float value) {
+  return __truncXfYf2__<float, uint32_t, 23, uint16_t, uint16_t, 10>(value);
+}
+
+/*!
+ * \brief Reduce the peers into `dst` elementwise for natively supported element types.
+ * \param dst The segment of the current worker, which also serves as the first operand.
+ * \param peers The same segment in the slots of the other workers.
+ * \param numel The number of elements in the segment.
+ * \param divisor The divisor applied at the end for averaging, 1 otherwise.
+ */
+template <typename T, typename FOp>
+void ReduceNative(T* dst, const std::vector<const uint8_t*>& peers, int64_t numel, FOp op,
+                  int divisor) {
+  for (const uint8_t* peer : peers) {
+    const T* src = reinterpret_cast<const T*>(peer);
+    for (int64_t i = 0; i < numel; ++i) {
+      dst[i] = op(dst[i], src[i]);
+    }
+  }
+  if (divisor != 1) {
+    for (int64_t i = 0; i < numel; ++i) {
+      dst[i] = dst[i] / static_cast<T>(divisor);
+    }
+  }
+}
+
+/*!
+ * \brief Reduce 16-bit floating point segments by accumulating blocks in float32, so that
+ * the inner loops stay vectorizable and the intermediate results do not lose precision.
+ */
+template <float (*FLoad)(uint16_t), uint16_t (*FStore)(float), typename FOp>
+void ReduceLowPrecision(uint16_t* dst, const std::vector<const uint8_t*>& peers, int64_t numel,
+                        FOp op, int divisor) {
+  constexpr int64_t kBlock = 256;
+  float acc[kBlock];
+  float operand[kBlock];
+  for (int64_t begin = 0; begin < numel; begin += kBlock) {
+    int64_t n = std::min(kBlock, numel - begin);
+    for (int64_t i = 0; i < n; ++i) {
+      acc[i] = FLoad(dst[begin + i]);
+    }
+    for (const uint8_t* peer : peers) {
+      const uint16_t* src = reinterpret_cast<const uint16_t*>(peer) + begin;
+      for (int64_t i = 0; i < n; ++i) {
+        operand[i] = FLoad(src[i]);
+      }
+      for (int64_t i = 0; i < n; ++i) {
+        acc[i] = op(acc[i], operand[i]);
+      }
+    }
+    float scale = 1.0f / static_cast<float>(divisor);
+    for (int64_t i = 0; i < n; ++i) {
+      dst[begin + i] = FStore(divisor != 1 ? acc[i] * scale : acc[i]);
+    }
+  }
+}
+
+template <typename FOp>
+void ReduceWithOp(DataType dtype, uint8_t* dst, const std::vector<const uint8_t*>& peers,
+                  int64_t numel, FOp op, int divisor) {
+  if (dtype.is_float() && dtype.bits() == 32) {
+    ReduceNative(reinterpret_cast<float*>(dst), peers, numel, op, divisor);
+  } else if (dtype.is_float() && dtype.bits() == 64) {
+    ReduceNative(reinterpret_cast<double*>(dst), peers, numel, op, divisor);
+  } else if (dtype.is_float16()) {
+    ReduceLowPrecision<HalfToFloat, FloatToHalf>(reinterpret_cast<uint16_t*>(dst), peers, numel,
+                                                  op, divisor);
+  } else if (dtype.is_bfloat16()) {
+    ReduceLowPrecision<BFloat16ToFloat, FloatToBFloat16>(reinterpret_cast<uint16_t*>(dst), peers,
+                                                          numel, op, divisor);
+  } else if (dtype.is_int() && dtype.bits() == 32) {
+    ReduceNative(reinterpret_cast<int32_t*>(dst), peers, numel, op, divisor);
+  } else if (dtype.is_int() && dtype.bits() == 64) {
+    ReduceNative(reinterpret_cast<int64_t*>(dst), peers, numel, op, divisor);
+  } else if (dtype.is_int() && dtype.bits() == 8) {
+    ReduceNative(reinterpret_cast<int8_t*>(dst), peers, numel, op, divisor);
+  } else if (dtype.is_uint() && dtype.bits() == 32) {
+    ReduceNative(reinterpret_cast<uint32_t*>(dst), peers, numel, op, divisor);
+  } else if (dtype.is_uint() && dtype.bits() == 8) {
+    ReduceNative(reinterpret_cast<uint8_t*>(dst), peers, numel, op, divisor);
+  } else {
+    LOG(FATAL) << "ValueError: Data type " << dtype
+               << " is not supported by the shared-memory allreduce.";
+  }
+}
+
+void Reduce(DataType dtype, ReduceKind kind, uint8_t* dst, const std::vector<const uint8_t*>& peers,
+            int64_t numel, int num_ranks) {
+  switch (kind) {
+    case ReduceKind::kSum:
+      return ReduceWithOp(dtype, dst, peers, numel, SumOp(), 1);
+    case ReduceKind::kProd:
+      return ReduceWithOp(dtype, dst, peers, numel, ProdOp(), 1);
+    case ReduceKind::kMin:
+      return ReduceWithOp(dtype, dst, peers, numel, MinOp(), 1);
+    case ReduceKind::kMax:
+      return ReduceWithOp(dtype, dst, peers, numel, MaxOp(), 1);
+    case ReduceKind::kAvg:
+      return ReduceWithOp(dtype, dst, peers, numel, SumOp(), num_ranks);
+  }
+  LOG(FATAL) << "ValueError: Unknown ReduceKind: " << static_cast<int>(kind);
+}
+
+/********** Initialization **********/
+
+void InitCCL(Session sess, ffi::Shape device_ids) {
+  DRef func = sess->GetGlobalFunc("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".init_ccl_per_worker");
+  DLOG(INFO) << "Initializing " TVM_DISCO_SHM_CCL_NAME " with devices: " << device_ids;
+  static std::atomic<int> segment_counter{0};
+  int num_workers = static_cast<int>(sess->GetNumWorkers());
+  int64_t slot_bytes = kDefaultSlotBytes;
+  if (const char* env = std::getenv("TVM_DISCO_SHM_SLOT_BYTES")) {
+    slot_bytes = std::atoll(env);
+    CHECK_GT(slot_bytes, 0) << "ValueError: TVM_DISCO_SHM_SLOT_BYTES must be positive, but got "
+                            << env;
+  }
+  slot_bytes = RoundUp(slot_bytes, kShmPageBytes);
+  std::string name = "/tvm-disco-shm-" + std::to_string(support::GetProcessId()) + "-" +
+                     std::to_string(segment_counter.fetch_add(1));
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  CHECK_NE(fd, -1) << "Cannot create shared memory segment " << name << ": "
+                   << std::strerror(errno);
+  // The segment is zero-filled, which is the initial state of the barriers and mailboxes.
+  if (ftruncate(fd, SegmentBytes(num_workers, slot_bytes)) != 0) {
+    int err = errno;
+    close(fd);
+    shm_unlink(name.c_str());
+    LOG(FATAL) << "Cannot resize shared memory segment " << name << ": " << std::strerror(err);
+  }
+  close(fd);
+  sess->CallPacked(func, device_ids, name, slot_bytes);
+  // Worker 0 returns only after every worker has mapped the segment, so the name can be removed.
+  sess->SyncWorker(0);
+  shm_unlink(name.c_str());
+}
+
+void InitCCLPerWorker(ffi::Shape device_ids, std::string name, int64_t slot_bytes) {
+  ShmCCLContext* ctx = ShmCCLContext::Get();
+  DiscoWorker* worker = DiscoWorker::ThreadLocal();
+  ICHECK(worker != nullptr);
+  CHECK(ctx->base == nullptr) << "Cannot initialize CCL, "
+                              << "the previous shared-memory segment is still mapped";
+  // All workers operate on host memory, so `device_ids` only exist for API compatibility.
+  ICHECK(worker->default_device.device_type == DLDeviceType::kDLCPU)
+      << "The shared-memory CCL requires workers to use CPU as the default device, but got "
+      << worker->default_device;
+  int64_t mapped_bytes = SegmentBytes(worker->num_workers, slot_bytes);
+  int fd = shm_open(name.c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+  CHECK_NE(fd, -1) << "Cannot open shared memory segment " << name << ": "
+                   << std::strerror(errno);
+  void* base = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  CHECK(base != MAP_FAILED) << "Cannot map shared memory segment " << name << ": "
+                            << std::strerror(errno);
+  worker->ccl = TVM_DISCO_SHM_CCL_NAME;
+  ctx->worker = worker;
+  ctx->base = static_cast<uint8_t*>(base);
+  ctx->mapped_bytes = mapped_bytes;
+  ctx->slot_bytes = slot_bytes;
+  // First touch of the own slot places its pages on the NUMA node of this worker.
+  std::memset(ctx->Slot(worker->worker_id), 0, slot_bytes);
+  GetCommunicator(ctx, /*in_group=*/false).Sync();
+}
+
+/********** Collectives **********/
+
+void AllReduce(NDArray send, ReduceKind reduce_kind, bool in_group, NDArray recv) {
+  ShmCCLContext* ctx = GetInitializedContext();
+  Communicator comm = GetCommunicator(ctx, in_group);
+  DataType dtype(send->dtype);
+  CHECK_EQ(dtype.lanes(), 1) << "ValueError: Vector data type " << dtype
+                             << " cannot be allreduced.";
+  int64_t numel = send.Shape()->Product();
+  CHECK_EQ(numel, recv.Shape()->Product())
+      << "ValueError: The number of elements in `send` and `recv` must be the same";
+  int64_t elem_bytes = dtype.bytes();
+  int64_t chunk_numel = ctx->slot_bytes / elem_bytes;
+  const uint8_t* send_data = static_cast<const uint8_t*>(send->data);
+  uint8_t* recv_data = static_cast<uint8_t*>(recv->data);
+  uint8_t* own_slot = ctx->Slot(ctx->worker->worker_id);
+  std::vector<const uint8_t*> peers;
+  peers.reserve(comm.size - 1);
+  for (int64_t begin = 0; begin < numel; begin += chunk_numel) {
+    int64_t n = std::min(chunk_numel, numel - begin);
+    int64_t segment = (n + comm.size - 1) / comm.size;
+    std::memcpy(own_slot, send_data + begin * elem_bytes, n * elem_bytes);
+    comm.Sync();
+    // Reduce-scatter: each rank reduces its own segment across all peers in place.
+    int64_t seg_begin = std::min(n, segment * comm.rank);
+    int64_t seg_end = std::min(n, seg_begin + segment);
+    if (seg_end > seg_begin) {
+      peers.clear();
+      for (int r = 0; r < comm.size; ++r) {
+        if (r != comm.rank) {
+          peers.push_back(ctx->Slot(comm.first_worker + r) + seg_begin * elem_bytes);
+        }
+      }
+      Reduce(dtype, reduce_kind, own_slot + seg_begin * elem_bytes, peers, seg_end - seg_begin,
+             comm.size);
+    }
+    comm.Sync();
+    // Allgather: collect the reduced segments from their owners.
+    for (int r = 0; r < comm.size; ++r) {
+      int64_t r_begin = std::min(n, segment * r);
+      int64_t r_end = std::min(n, r_begin + segment);
+      if (r_end > r_begin) {
+        std::memcpy(recv_data + (begin + r_begin) * elem_bytes,
+                    ctx->Slot(comm.first_worker + r) + r_begin * elem_bytes,
+                    (r_end - r_begin) * elem_bytes);
+      }
+    }
+    comm.Sync();
+  }
+}
+
+void AllGather(NDArray send, bool in_group, NDArray recv) {
+  ShmCCLContext* ctx = GetInitializedContext();
+  Communicator comm = GetCommunicator(ctx, in_group);
+  int64_t send_bytes = NumBytes(send);
+  CHECK_EQ(send_bytes * comm.size, NumBytes(recv))
+      << "ValueError: The size of `recv` must be " << comm.size << " times the size of `send`";
+  const uint8_t* send_data = static_cast<const uint8_t*>(send->data);
+  uint8_t* recv_data = static_cast<uint8_t*>(recv->data);
+  uint8_t* own_slot = ctx->Slot(ctx->worker->worker_id);
+  for (int64_t begin = 0; begin < send_bytes; begin += ctx->slot_bytes) {
+    int64_t n = std::min(ctx->slot_bytes, send_bytes - begin);
+    std::memcpy(own_slot, send_data + begin, n);
+    comm.Sync();
+    for (int r = 0; r < comm.size; ++r) {
+      std::memcpy(recv_data + r * send_bytes + begin, ctx->Slot(comm.first_worker + r), n);
+    }
+    comm.Sync();
+  }
+}
+
+void BroadcastFromWorker0(Optional<NDArray> send, bool in_group, NDArray recv) {
+  ShmCCLContext* ctx = GetInitializedContext();
+  Communicator comm = GetCommunicator(ctx, in_group);
+  bool is_sender = comm.rank == 0;
+  int64_t num_bytes = NumBytes(recv);
+  const uint8_t* send_data = nullptr;
+  if (is_sender) {
+    CHECK(send.defined());
+    CHECK(send.value().Shape()->Product() == recv.Shape()->Product());
+    send_data = static_cast<const uint8_t*>(send.value()->data);
+  }
+  uint8_t* recv_data = static_cast<uint8_t*>(recv->data);
+  uint8_t* root_slot = ctx->Slot(comm.first_worker);
+  for (int64_t begin = 0; begin < num_bytes; begin += ctx->slot_bytes) {
+    int64_t n = std::min(ctx->slot_bytes, num_bytes - begin);
+    if (is_sender) {
+      std::memcpy(root_slot, send_data + begin, n);
+    }
+    comm.Sync();
+    if (!is_sender) {
+      std::memcpy(recv_data + begin, root_slot, n);
+    }
+    comm.Sync();
+  }
+  if (is_sender && send_data != recv_data) {
+    std::memcpy(recv_data, send_data, num_bytes);
+  }
+}
+
+void ScatterFromWorker0(Optional<NDArray> send, bool in_group, NDArray recv) {
+  CHECK(recv.defined()) << "ValueError: buffer `recv` must not be None";
+  ShmCCLContext* ctx = GetInitializedContext();
+  Communicator comm = GetCommunicator(ctx, in_group);
+  bool is_sender = comm.rank == 0;
+  int64_t shard_bytes = NumBytes(recv);
+  const uint8_t* send_data = nullptr;
+  if (is_sender) {
+    CHECK(send.defined()) << "ValueError: buffer `send` must be provided when worker_id == 0.";
+    NDArray buffer = send.value();
+    int64_t numel = buffer.Shape()->Product();
+    CHECK_EQ(numel % comm.size, 0) << "ValueError: Scattering evenly requires that the number "
+                                      "of elements in the buffer to be "
+                                      "divisible by the number of workers, but got numel = "
+                                   << numel << " and " << comm.size << " workers.";
+    CHECK_EQ(numel / comm.size, recv.Shape()->Product())
+        << "ValueError: The number of elements in buffer `recv` must be the same as each shard "
+           "of buffer `send`. `send.size` is "
+        << numel << ", but `recv.size` is " << recv.Shape()->Product() << ".";
+    send_data = static_cast<const uint8_t*>(buffer->data);
+  } else if (send.defined()) {
+    LOG(WARNING) << "ValueError: buffer `send` must be None when (worker_id != 0 && !in_group) "
+                    "or (worker_id % group_size != 0 && in_group). However, got send = "
+                 << send.get() << ". This will be ignored.";
+  }
+  uint8_t* recv_data = static_cast<uint8_t*>(recv->data);
+  uint8_t* root_slot = ctx->Slot(comm.first_worker);
+  // Each round stages one piece of every shard in the slot of the root.
+  int64_t piece_bytes = std::max<int64_t>(1, ctx->slot_bytes / comm.size);
+  for (int64_t begin = 0; begin < shard_bytes; begin += piece_bytes) {
+    int64_t n = std::min(piece_bytes, shard_bytes - begin);
+    if (is_sender) {
+      for (int r = 0; r < comm.size; ++r) {
+        std::memcpy(root_slot + r * n, send_data + r * shard_bytes + begin, n);
+      }
+    }
+    comm.Sync();
+    std::memcpy(recv_data + begin, root_slot + comm.rank * n, n);
+    comm.Sync();
+  }
+}
+
+void GatherToWorker0(NDArray send, bool in_group, Optional<NDArray> recv) {
+  CHECK(send.defined()) << "ValueError: buffer `send` must not be None";
+  ShmCCLContext* ctx = GetInitializedContext();
+  Communicator comm = GetCommunicator(ctx, in_group);
+  bool is_sender = comm.rank == 0;
+  int64_t shard_bytes = NumBytes(send);
+  uint8_t* recv_data = nullptr;
+  if (is_sender) {
+    CHECK(recv.defined()) << "ValueError: buffer `recv` must be provided when worker_id == 0.";
+    NDArray buffer = recv.value();
+    int64_t numel = buffer.Shape()->Product();
+    CHECK_EQ(numel % comm.size, 0) << "ValueError: Gathering evenly requires that the number "
+                                      "of elements in the buffer to be "
+                                      "divisible by the number of workers, but got numel = "
+                                   << numel << " and " << comm.size << " workers.";
+    CHECK_EQ(numel / comm.size, send.Shape()->Product())
+        << "ValueError: The number of elements in buffer `send` must be the same as each shard "
+           "of buffer `recv`. `recv.size` is "
+        << numel << ", but `send.size` is " << send.Shape()->Product() << ".";
+    recv_data = static_cast<uint8_t*>(buffer->data);
+  } else if (recv.defined()) {
+    LOG(WARNING) << "ValueError: buffer `recv` must be None when (worker_id != 0 && !in_group) "
+                    "or (worker_id % group_size != 0 && in_group). However, got recv = "
+                 << recv.get() << ". This will be ignored.";
+  }
+  const uint8_t* send_data = static_cast<const uint8_t*>(send->data);
+  uint8_t* own_slot = ctx->Slot(ctx->worker->worker_id);
+  for (int64_t begin = 0; begin < shard_bytes; begin += ctx->slot_bytes) {
+    int64_t n = std::min(ctx->slot_bytes, shard_bytes - begin);
+    std::memcpy(own_slot, send_data + begin, n);
+    comm.Sync();
+    if (is_sender) {
+      for (int r = 0; r < comm.size; ++r) {
+        std::memcpy(recv_data + r * shard_bytes + begin, ctx->Slot(comm.first_worker + r), n);
+      }
+    }
+    comm.Sync();
+  }
+}
+
+/********** Point-to-point **********/
+
+void SendToWorker(NDArray buffer, int receiver_id) {
+  ShmCCLContext* ctx = GetInitializedContext();
+  int worker_id = ctx->worker->worker_id;
+  CHECK(receiver_id >= 0 && receiver_id < ctx->worker->num_workers)
+      << "Invalid receiver id " << receiver_id << ". The world size is "
+      << ctx->worker->num_workers;
+  CHECK_NE(worker_id, receiver_id) << "Cannot send to worker itself.";
+  ShmMailbox* mailbox = ctx->Mailbox(worker_id);
+  uint8_t* own_slot = ctx->Slot(worker_id);
+  const uint8_t* data = static_cast<const uint8_t*>(buffer->data);
+  int64_t num_bytes = NumBytes(buffer);
+  for (int64_t begin = 0; begin < num_bytes; begin += ctx->slot_bytes) {
+    int64_t n = std::min(ctx->slot_bytes, num_bytes - begin);
+    std::memcpy(own_slot, data + begin, n);
+    mailbox->receiver.store(receiver_id + 1, std::memory_order_release);
+    // The slot is reusable once the receiver has drained it.
+    SpinUntil([&]() { return mailbox->receiver.load(std::memory_order_acquire) == 0; });
+  }
+}
+
+void RecvFromWorker(NDArray buffer, int sender_id) {
+  ShmCCLContext* ctx = GetInitializedContext();
+  int worker_id = ctx->worker->worker_id;
+  CHECK(sender_id >= 0 && sender_id < ctx->worker->num_workers)
+      << "Invalid sender id " << sender_id << ". The world size is " << ctx->worker->num_workers;
+  CHECK_NE(worker_id, sender_id) << "Cannot receive from the worker itself.";
+  ShmMailbox* mailbox = ctx->Mailbox(sender_id);
+  const uint8_t* sender_slot = ctx->Slot(sender_id);
+  uint8_t* data = static_cast<uint8_t*>(buffer->data);
+  int64_t num_bytes = NumBytes(buffer);
+  for (int64_t begin = 0; begin < num_bytes; begin += ctx->slot_bytes) {
+    int64_t n = std::min(ctx->slot_bytes, num_bytes - begin);
+    SpinUntil([&]() {
+      return mailbox->receiver.load(std::memory_order_acquire) == worker_id + 1;
+    });
+    std::memcpy(data + begin, sender_slot, n);
+    mailbox->receiver.store(0, std::memory_order_release);
+  }
+}
+
+void RecvFromWorker0(NDArray buffer) {
+  ShmCCLContext* ctx = GetInitializedContext();
+  CHECK_NE(ctx->worker->worker_id, 0)
+      << "ValueError: Worker 0 is not allowed to call RecvFromWorker0.";
+  shm::RecvFromWorker(buffer, 0);
+}
+
+void SendToNextGroup(NDArray buffer) {
+  ShmCCLContext* ctx = GetInitializedContext();
+  int group_size = ctx->worker->num_workers / ctx->worker->num_groups;
+  int receiver_id = ctx->worker->worker_id + group_size;
+  CHECK_LT(receiver_id, ctx->worker->num_workers)
+      << "The current group is already the last group and there is no such a next group.";
+  shm::SendToWorker(buffer, receiver_id);
+}
+
+void RecvFromPrevGroup(NDArray buffer) {
+  ShmCCLContext* ctx = GetInitializedContext();
+  int group_size = ctx->worker->num_workers / ctx->worker->num_groups;
+  int sender_id = ctx->worker->worker_id - group_size;
+  CHECK_GE(sender_id, 0)
+      << "The current group is already the first group and there is no such a previous group.";
+  shm::RecvFromWorker(buffer, sender_id);
+}
+
+void SyncWorker() {
+  // All the operations above complete synchronously on the calling worker.
+  ICHECK(ShmCCLContext::Get()->worker != nullptr);
+}
+
+TVM_FFI_STATIC_INIT_BLOCK({
+  namespace refl = tvm::ffi::reflection;
+  refl::GlobalDef()
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".init_ccl", InitCCL)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".init_ccl_per_worker", InitCCLPerWorker)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".allreduce",
+           [](NDArray send, int kind, bool in_group, NDArray recv) {
+             CHECK(0 <= kind && kind <= 4) << "ValueError: Unknown ReduceKind: " << kind;
+             shm::AllReduce(send, static_cast<ReduceKind>(kind), in_group, recv);
+           })
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".allgather", AllGather)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".broadcast_from_worker0",
+           BroadcastFromWorker0)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".scatter_from_worker0", ScatterFromWorker0)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".gather_to_worker0", GatherToWorker0)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".recv_from_worker0", RecvFromWorker0)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".send_to_next_group", SendToNextGroup)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".recv_from_prev_group", RecvFromPrevGroup)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".send_to_worker", SendToWorker)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".recv_from_worker", RecvFromWorker)
+      .def("runtime.disco." TVM_DISCO_SHM_CCL_NAME ".sync_worker", SyncWorker);
+});
+
+}  // namespace shm
+}  // namespace runtime
+}  // namespace tvm
@@ -20,15 +20,18 @@
 #include <tvm/runtime/base.h>
 #include <tvm/runtime/disco/disco_worker.h>
 #include <tvm/runtime/object.h>
+#include <tvm/runtime/threading_backend.h>
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <utility>
 
-#include "../../support/ring_buffer.h"
 #include "../minrpc/rpc_reference.h"
 #include "./bcast_session.h"
 #include "./disco_worker_thread.h"
@@ -37,13 +40,23 @@
 namespace tvm {
 namespace runtime {
 
+/*!
+ * \brief A single-producer single-consumer message queue between the controller and a worker.
+ *
+ * Messages are encoded directly into a lock-free byte ring by the producer and decoded directly
+ * out of it by the consumer, so a message is copied only once. Messages larger than the ring are
+ * streamed through it. Both sides spin for a while before parking on a condition variable, and
+ * the spin budget adapts to whether recent waits were short enough to be served by spinning.
+ */
 class DiscoThreadedMessageQueue : private dmlc::Stream,
                                   private DiscoProtocol<DiscoThreadedMessageQueue> {
  public:
+  DiscoThreadedMessageQueue() : ring_(new char[kRingBytes]) {}
+
   void Send(const ffi::PackedArgs& args) {
     RPCReference::ReturnPackedSeq(reinterpret_cast<const TVMFFIAny*>(args.data()), args.size(),
                                   this);
-    CommitSendAndNotifyEnqueue();
+    PublishWrite();
   }
 
   ffi::PackedArgs Recv() {
@@ -51,38 +64,23 @@ class DiscoThreadedMessageQueue : private dmlc::Stream,
     ffi::AnyView* packed_args = nullptr;
     int num_args = 0;
     RPCReference::RecvPackedSeq(reinterpret_cast<TVMFFIAny**>(&packed_args), &num_args, this);
+    ICHECK_EQ(read_packet_end_, read_pos_) << "InternalError: Message is not fully consumed";
+    PublishRead();
     return ffi::PackedArgs(packed_args, num_args);
   }
 
  protected:
-  void CommitSendAndNotifyEnqueue() {
-    bool need_notify = false;
-    {
-      std::lock_guard<std::mutex> lock{mutex_};
-      ++msg_cnt_;
-      ring_buffer_.Write(write_buffer_.data(), write_buffer_.size());
-      need_notify = dequeue_waiting_;
-    }
-    if (need_notify) {
-      condition_.notify_one();
-    }
-    write_buffer_.clear();
-  }
+  /*! \brief The capacity of the ring in bytes, must be a power of two. */
+  static constexpr uint64_t kRingBytes = 64 << 10;
+  /*! \brief The bounds of the adaptive spin budget before parking. */
+  static constexpr uint32_t kMinSpinCount = 16;
+  static constexpr uint32_t kMaxSpinCount = 1 << 14;
 
   void DequeueNextPacket() {
-    {
-      std::unique_lock<std::mutex> lock(mutex_);
-      dequeue_waiting_ = true;
-      condition_.wait(lock, [this] { return msg_cnt_.load() > 0; });
-      dequeue_waiting_ = false;
-      --msg_cnt_;
-      uint64_t packet_nbytes = 0;
-      ring_buffer_.Read(&packet_nbytes, sizeof(packet_nbytes));
-      read_buffer_.resize(packet_nbytes);
-      ring_buffer_.Read(read_buffer_.data(), packet_nbytes);
-      read_offset_ = 0;
-    }
     this->RecycleAll();
+    uint64_t packet_nbytes = 0;
+    this->Read(&packet_nbytes);
+    read_packet_end_ = read_pos_ + packet_nbytes;
     RPCCode code = RPCCode::kReturn;
     this->Read(&code);
   }
@@ -90,19 +88,83 @@ class DiscoThreadedMessageQueue : private dmlc::Stream,
   void MessageStart(uint64_t packet_nbytes) {}
 
   size_t Read(void* data, size_t size) final {
-    std::memcpy(data, read_buffer_.data() + read_offset_, size);
-    read_offset_ += size;
-    ICHECK_LE(read_offset_, read_buffer_.size());
+    char* dst = static_cast<char*>(data);
+    size_t remaining = size;
+    while (remaining != 0) {
+      if (read_pos_ == cached_head_) {
+        // Return the drained space to the producer before waiting for more data.
+        PublishRead();
+        WaitUntil([this] { return (cached_head_ = head_.load()) != read_pos_; },
+                  &consumer_parked_, &consumer_spin_count_);
+      }
+      size_t offset = read_pos_ & (kRingBytes - 1);
+      size_t n = std::min<uint64_t>({remaining, cached_head_ - read_pos_, kRingBytes - offset});
+      std::memcpy(dst, ring_.get() + offset, n);
+      dst += n;
+      remaining -= n;
+      read_pos_ += n;
+    }
     return size;
   }
 
   size_t Write(const void* data, size_t size) final {
-    size_t cur_size = write_buffer_.size();
-    write_buffer_.resize(cur_size + size);
-    std::memcpy(write_buffer_.data() + cur_size, data, size);
+    const char* src = static_cast<const char*>(data);
+    size_t remaining = size;
+    while (remaining != 0) {
+      if (write_pos_ - cached_tail_ == kRingBytes) {
+        // The ring is full: publish what is written so far so the consumer can drain it.
+        PublishWrite();
+        WaitUntil([this] { return write_pos_ - (cached_tail_ = tail_.load()) != kRingBytes; },
+                  &producer_parked_, &producer_spin_count_);
+      }
+      size_t offset = write_pos_ & (kRingBytes - 1);
+      size_t n = std::min<uint64_t>(
+          {remaining, kRingBytes - (write_pos_ - cached_tail_), kRingBytes - offset});
+      std::memcpy(ring_.get() + offset, src, n);
+      src += n;
+      remaining -= n;
+      write_pos_ += n;
+    }
     return size;
   }
 
+  /*! \brief Make the bytes written so far visible to the consumer. */
+  void PublishWrite() {
+    head_.store(write_pos_);
+    NotifyIfParked(&consumer_parked_);
+  }
+
+  /*! \brief Return the bytes read so far to the producer. */
+  void PublishRead() {
+    tail_.store(read_pos_);
+    NotifyIfParked(&producer_parked_);
+  }
+
+  void NotifyIfParked(std::atomic<bool>* parked) {
+    // Sequentially consistent accesses to the positions and the flags guarantee that either the
+    // parking side observes the new position, or this side observes the flag.
+    if (parked->load()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      condition_.notify_all();
+    }
+  }
+
+  template <typename FCond>
+  void WaitUntil(FCond cond, std::atomic<bool>* parked, uint32_t* spin_count) {
+    for (uint32_t i = 0; i < *spin_count; ++i) {
+      if (cond()) {
+        *spin_count = std::min(*spin_count * 2, kMaxSpinCount);
+        return;
+      }
+      tvm::runtime::threading::YieldThread();
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    parked->store(true);
+    condition_.wait(lock, cond);
+    parked->store(false);
+    *spin_count = std::max(*spin_count / 2, kMinSpinCount);
+  }
+
   using dmlc::Stream::Read;
   using dmlc::Stream::ReadArray;
   using dmlc::Stream::Write;
@@ -110,16 +172,26 @@ class DiscoThreadedMessageQueue : private dmlc::Stream,
   friend struct RPCReference;
   friend struct DiscoProtocol<DiscoThreadedMessageQueue>;
 
-  // The read/write buffer will only be accessed by the producer thread.
-  std::string write_buffer_;
-  std::string read_buffer_;
-  size_t read_offset_ = 0;
-  bool dequeue_waiting_ = false;
+  std::unique_ptr<char[]> ring_;
+  // the cache line paddings are used for avoid false sharing between the two sides
+  /*! \brief The position up to which the producer has published, written by the producer. */
+  alignas(64) std::atomic<uint64_t> head_{0};
+  /*! \brief The position up to which the consumer has drained, written by the consumer. */
+  alignas(64) std::atomic<uint64_t> tail_{0};
+  // States only accessed by the producer thread.
+  alignas(64) uint64_t write_pos_ = 0;
+  uint64_t cached_tail_ = 0;
+  uint32_t producer_spin_count_ = kMinSpinCount;
+  std::atomic<bool> producer_parked_{false};
+  // States only accessed by the consumer thread.
+  alignas(64) uint64_t read_pos_ = 0;
+  uint64_t cached_head_ = 0;
+  uint64_t read_packet_end_ = 0;
+  uint32_t consumer_spin_count_ = kMinSpinCount;
+  std::atomic<bool> consumer_parked_{false};
 
   std::mutex mutex_;
-  std::atomic<int> msg_cnt_{0};
   std::condition_variable condition_;
-  support::RingBuffer ring_buffer_;
 };
 
 class DiscoThreadChannel final : public DiscoChannel {
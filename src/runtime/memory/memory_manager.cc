@@ -23,6 +23,7 @@
  */
 #include <tvm/ffi/function.h>
 #include <tvm/ffi/reflection/registry.h>
+#include <tvm/runtime/device_api.h>
 #include <tvm/runtime/memory/memory_manager.h>
 
 #include <memory>
@@ -103,9 +104,14 @@ NDArray StorageObj::AllocNDArray(int64_t offset, ffi::Shape shape, DLDataType dt
     explicit StorageAlloc(Storage storage) : storage_(storage) {}
 
     void AllocData(DLTensor* tensor, int64_t offset) {
-      if (storage_->buffer.device.device_type == kDLHexagon) {
-        // For Hexagon, non-zero offset support simply requires adjusting the
-        // beginning of data pointer
+      const Device& device = storage_->buffer.device;
+      // For Hexagon, non-zero offset support simply requires adjusting the
+      // beginning of data pointer. Devices whose pointers can be offset on the
+      // host do the same for aligned offsets, so that tensors packed into one
+      // storage can be passed to kernels that expect a zero byte_offset.
+      if (device.device_type == kDLHexagon ||
+          (offset != 0 && offset % kAllocAlignment == 0 &&
+           DeviceAPI::Get(device)->SupportsDevicePointerArithmeticsOnHost())) {
         auto offset_ptr = reinterpret_cast<uint8_t*>(storage_->buffer.data) + offset;
         tensor->data = reinterpret_cast<void*>(offset_ptr);
         tensor->byte_offset = 0;
@@ -38,6 +38,15 @@ constexpr const char* kRPCProtocolVer = "0.8.0";
 // When tvm.rpc.server.GetCRTMaxPacketSize global function is not registered.
 const uint64_t kRPCMaxTransferSizeBytesDefault = UINT64_MAX;
 
+/*!
+ * \brief Transport feature bits reported by tvm.rpc.server.GetTransportFeatures.
+ *  Servers without the function support none of them.
+ */
+enum RPCTransportFeature : int64_t {
+  /*! \brief The server accepts kCopyToRemoteCompressed and kCopyFromRemoteCompressed. */
+  kRPCTransportCompressedCopy = 1,
+};
+
 /*! \brief The RPC code */
 enum class RPCCode : int {
   kNone,
@@ -64,6 +73,10 @@ enum class RPCCode : int {
   kDevFreeStream,
   kDevSetStream,
   kDevGetCurrentStream,
+  // Compressed copy packets, only sent to servers that report
+  // kRPCTransportCompressedCopy, appended so existing codes keep their values.
+  kCopyToRemoteCompressed,
+  kCopyFromRemoteCompressed,
 };
 
 /*!
@@ -128,6 +141,10 @@ inline const char* RPCCodeToString(RPCCode code) {
       return "kCopyAmongRemote";
     case RPCCode::kDevAllocDataWithScope:
       return "kDevAllocDataWithScope";
+    case RPCCode::kCopyToRemoteCompressed:
+      return "kCopyToRemoteCompressed";
+    case RPCCode::kCopyFromRemoteCompressed:
+      return "kCopyFromRemoteCompressed";
     default:
       return "";
   }
@@ -32,6 +32,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <map>
@@ -867,6 +868,57 @@ TVM_FFI_STATIC_INIT_BLOCK({
       });
 });
 
+namespace {
+
+/*!
+ * \brief Time one `repeat` of back to back calls, growing `number` until they last
+ *        at least `min_repeat_ms`.
+ * \return The average time of one call in seconds.
+ */
+double MeasureRepeat(const ffi::Function& pf, Device dev, const ffi::AnyView* args, int num_args,
+                     int* number, int min_repeat_ms, int limit_zero_time_iterations,
+                     NDArray* arr1, const NDArray& arr2) {
+  ffi::Any temp;
+  double duration_ms = 0.0;
+  int absolute_zero_times = 0;
+  do {
+    if (duration_ms > 0.0) {
+      const double golden_ratio = 1.618;
+      *number = static_cast<int>(
+          std::max((min_repeat_ms / (duration_ms / *number) + 1), *number * golden_ratio));
+    }
+    if (arr2.defined()) {
+      arr1->CopyFrom(arr2);
+    }
+    DeviceAPI::Get(dev)->StreamSync(dev, nullptr);
+    // start timing
+    Timer t = Timer::Start(dev);
+    for (int j = 0; j < *number; ++j) {
+      pf.CallPacked(args, num_args, &temp);
+    }
+    t->Stop();
+    int64_t t_nanos = t->SyncAndGetElapsedNanos();
+    if (t_nanos == 0) absolute_zero_times++;
+    duration_ms = t_nanos / 1e6;
+  } while (duration_ms < min_repeat_ms && absolute_zero_times < limit_zero_time_iterations);
+  return duration_ms / 1e3 / *number;
+}
+
+/*! \brief The 97.5% quantile of the Student t distribution with `dof` degrees of freedom. */
+double StudentT975(int dof) {
+  static const double kTable[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                                  2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                                  2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                                  2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+  constexpr int kTableSize = sizeof(kTable) / sizeof(kTable[0]);
+  if (dof <= kTableSize) return kTable[std::max(dof, 1) - 1];
+  // First order Cornish-Fisher expansion around the normal quantile.
+  const double z = 1.959964;
+  return z + (z * z * z + z) / (4.0 * dof);
+}
+
+}  // namespace
+
 ffi::Function WrapTimeEvaluator(ffi::Function pf, Device dev, int number, int repeat,
                                 int min_repeat_ms, int limit_zero_time_iterations,
                                 int cooldown_interval_ms, int repeats_to_cooldown,
@@ -894,30 +946,8 @@ ffi::Function WrapTimeEvaluator(ffi::Function pf, Device dev, int number, int re
       if (f_preproc != nullptr) {
         f_preproc.CallPacked(args, num_args, &temp);
       }
-      double duration_ms = 0.0;
-      int absolute_zero_times = 0;
-      do {
-        if (duration_ms > 0.0) {
-          const double golden_ratio = 1.618;
-          number = static_cast<int>(
-              std::max((min_repeat_ms / (duration_ms / number) + 1), number * golden_ratio));
-        }
-        if (cache_flush_bytes > 0) {
-          arr1.CopyFrom(arr2);
-        }
-        DeviceAPI::Get(dev)->StreamSync(dev, nullptr);
-        // start timing
-        Timer t = Timer::Start(dev);
-        for (int j = 0; j < number; ++j) {
-          pf.CallPacked(args, num_args, &temp);
-        }
-        t->Stop();
-        int64_t t_nanos = t->SyncAndGetElapsedNanos();
-        if (t_nanos == 0) absolute_zero_times++;
-        duration_ms = t_nanos / 1e6;
-      } while (duration_ms < min_repeat_ms && absolute_zero_times < limit_zero_time_iterations);
-
-      double speed = duration_ms / 1e3 / number;
+      double speed = MeasureRepeat(pf, dev, args, num_args, &number, min_repeat_ms,
+                                   limit_zero_time_iterations, &arr1, arr2);
       os.write(reinterpret_cast<char*>(&speed), sizeof(speed));
 
       if (cooldown_interval_ms > 0 && (i % repeats_to_cooldown) == 0) {
@@ -932,6 +962,85 @@ ffi::Function WrapTimeEvaluator(ffi::Function pf, Device dev, int number, int re
   return ffi::Function::FromPacked(ftimer);
 }
 
+ffi::Function WrapAdaptiveTimeEvaluator(std::vector<ffi::Function> fs, Device dev, int min_repeat,
+                                        int max_repeat, int min_repeat_ms, double target_rel_ci,
+                                        int cooldown_interval_ms, int cache_flush_bytes,
+                                        ffi::Function f_preproc) {
+  ICHECK(!fs.empty()) << "ValueError: need at least one function to measure";
+  for (const ffi::Function& f : fs) {
+    ICHECK(f != nullptr);
+  }
+  ICHECK_GE(min_repeat, 2) << "ValueError: need at least two samples for a confidence interval";
+  ICHECK_GE(max_repeat, min_repeat);
+  ICHECK_GT(target_rel_ci, 0.0);
+  // Same bound on zero time measurements as the default of the fixed time evaluator.
+  constexpr int kLimitZeroTimeIterations = 100;
+
+  auto ftimer = [fs, dev, min_repeat, max_repeat, min_repeat_ms, target_rel_ci,
+                 cooldown_interval_ms, cache_flush_bytes,
+                 f_preproc](const ffi::AnyView* args, int num_args, ffi::Any* rv) {
+    ffi::Any temp;
+    const size_t num_funcs = fs.size();
+    // skip first time call, to activate lazy compilation components.
+    for (const ffi::Function& f : fs) {
+      f.CallPacked(args, num_args, &temp);
+    }
+
+    // allocate two large arrays to flush L2 cache
+    NDArray arr1, arr2;
+    if (cache_flush_bytes > 0) {
+      arr1 = NDArray::Empty({cache_flush_bytes / 4}, {kDLInt, 32, 1}, dev);
+      arr2 = NDArray::Empty({cache_flush_bytes / 4}, {kDLInt, 32, 1}, dev);
+    }
+
+    DeviceAPI::Get(dev)->StreamSync(dev, nullptr);
+
+    std::vector<std::vector<double>> samples(num_funcs);
+    std::vector<int> number(num_funcs, 1);
+    std::vector<double> half_width(num_funcs, 0.0);
+    std::vector<bool> converged(num_funcs, false);
+    for (int round = 0; round < max_repeat; ++round) {
+      bool pending = false;
+      for (size_t k = 0; k < num_funcs; ++k) {
+        if (converged[k]) continue;
+        if (f_preproc != nullptr) {
+          f_preproc.CallPacked(args, num_args, &temp);
+        }
+        std::vector<double>& xs = samples[k];
+        xs.push_back(MeasureRepeat(fs[k], dev, args, num_args, &number[k], min_repeat_ms,
+                                   kLimitZeroTimeIterations, &arr1, arr2));
+        const int n = static_cast<int>(xs.size());
+        if (n < 2) {
+          pending = true;
+          continue;
+        }
+        double mean = std::accumulate(xs.begin(), xs.end(), 0.0) / n;
+        double sq_sum = 0.0;
+        for (double x : xs) sq_sum += (x - mean) * (x - mean);
+        half_width[k] = StudentT975(n - 1) * std::sqrt(sq_sum / (n - 1) / n);
+        converged[k] = n >= min_repeat && half_width[k] <= target_rel_ci * mean;
+        pending = pending || !converged[k];
+      }
+      if (!pending) break;
+      if (cooldown_interval_ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(cooldown_interval_ms));
+      }
+    }
+
+    std::ostringstream os;
+    auto write = [&os](double v) { os.write(reinterpret_cast<const char*>(&v), sizeof(v)); };
+    for (size_t k = 0; k < num_funcs; ++k) {
+      write(static_cast<double>(samples[k].size()));
+      write(static_cast<double>(number[k]));
+      write(converged[k] ? 1.0 : 0.0);
+      write(half_width[k]);
+      for (double x : samples[k]) write(x);
+    }
+    *rv = ffi::Bytes(os.str());
+  };
+  return ffi::Function::FromPacked(ftimer);
+}
+
 TVM_FFI_STATIC_INIT_BLOCK({
   namespace refl = tvm::ffi::reflection;
   refl::GlobalDef()
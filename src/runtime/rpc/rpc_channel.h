@@ -53,6 +53,23 @@ class RPCChannel {
    * \return The actual bytes received.
    */
   virtual size_t Recv(void* data, size_t size) = 0;
+  /*!
+   * \brief Send a header followed by a payload, as if they were one buffer.
+   *
+   *  Channels backed by a socket override this with a vectored write so that
+   *  bulk payloads go out straight from the caller's memory.
+   *
+   * \param header The header pointer.
+   * \param header_size The size of the header.
+   * \param payload The payload pointer.
+   * \param payload_size The size of the payload.
+   * \return The actual bytes sent, counted from the start of the header.
+   */
+  virtual size_t SendGather(const void* header, size_t header_size, const void* payload,
+                            size_t payload_size) {
+    if (header_size != 0) return Send(header, header_size);
+    return Send(payload, payload_size);
+  }
 };
 
 /*!
@@ -32,12 +32,21 @@
 #include <array>
 #include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "../../support/arena.h"
+#include "../../support/lz_block.h"
 #include "../../support/ring_buffer.h"
 #include "../../support/utils.h"
 #include "rpc_local_session.h"
@@ -45,6 +54,13 @@
 namespace tvm {
 namespace runtime {
 
+/*! \brief Copies at least this large bypass the ring buffers on the client. */
+constexpr uint64_t kRPCZeroCopyMinBytes = 64 << 10;
+/*! \brief Copies at least this large are compressed when compression is enabled. */
+constexpr uint64_t kRPCCompressMinBytes = 64 << 10;
+/*! \brief Frame size of compressed copies, each frame is one round trip. */
+constexpr uint64_t kRPCCompressedFrameBytes = 4 << 20;
+
 /*!
  * Event-driven state-machine based handlers for RPCEndpoint.
  *
@@ -100,6 +116,20 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   /*! \brief Finish the copy ack stage. */
   void FinishCopyAck() { this->SwitchToState(kRecvPacketNumBytes); }
 
+  /*!
+   * \brief Leave the payload of the next packet on the channel if it is a copy ack of nbytes.
+   *  The code of the next packet is read ahead of its payload to find out.
+   * \param nbytes The expected payload size.
+   */
+  void ExpectDirectCopyAck(uint64_t nbytes) { direct_copy_ack_nbytes_ = nbytes; }
+
+  /*!
+   * \brief Check whether the copy ack received last left its payload on the channel.
+   *  The caller then receives the payload itself before it calls FinishCopyAck.
+   * \return Whether the payload is on the channel.
+   */
+  bool TakeDirectCopyAck() { return std::exchange(direct_copy_ack_received_, false); }
+
   /*!
    * \brief Enter the io loop until the next event.
    * \param client_mode Whether we are in the client.
@@ -122,7 +152,11 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
         case kRecvPacketNumBytes: {
           uint64_t packet_nbytes;
           ICHECK(this->Read(&packet_nbytes));
-          if (packet_nbytes != 0) {
+          if (packet_nbytes > sizeof(int32_t) && direct_copy_ack_nbytes_ != 0) {
+            this->SwitchToState(kRecvPacketCode);
+            this->RequestBytes(sizeof(int32_t));
+            packet_remaining_bytes_ = packet_nbytes - sizeof(int32_t);
+          } else if (packet_nbytes != 0) {
             this->SwitchToState(kProcessPacket);
             this->RequestBytes(packet_nbytes);
           } else {
@@ -130,6 +164,19 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
           }
           break;
         }
+        case kRecvPacketCode: {
+          this->Read(&peeked_code_);
+          uint64_t expected_nbytes = std::exchange(direct_copy_ack_nbytes_, 0);
+          if (peeked_code_ == RPCCode::kCopyAck && packet_remaining_bytes_ == expected_nbytes) {
+            peeked_code_ = RPCCode::kNone;
+            direct_copy_ack_received_ = true;
+            this->SwitchToState(kCopyAckReceived);
+          } else {
+            this->SwitchToState(kProcessPacket);
+            this->RequestBytes(packet_remaining_bytes_);
+          }
+          break;
+        }
         case kProcessPacket: {
           this->HandleProcessPacket(setreturn);
           break;
@@ -289,6 +336,7 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   enum State {
     kInitHeader,
     kRecvPacketNumBytes,
+    kRecvPacketCode,
     kProcessPacket,
     kWaitForAsyncCallback,
     kReturnReceived,
@@ -303,6 +351,14 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
   bool client_mode_{false};
   // Whether current handler is in the async server mode.
   bool async_server_mode_{false};
+  // Payload size of a copy ack that may stay on the channel, 0 if none is expected.
+  uint64_t direct_copy_ack_nbytes_{0};
+  // Whether the copy ack received last left its payload on the channel.
+  bool direct_copy_ack_received_{false};
+  // Code of the packet being processed when it was read ahead, kNone otherwise.
+  RPCCode peeked_code_{RPCCode::kNone};
+  // Bytes of the packet that follow its code.
+  uint64_t packet_remaining_bytes_{0};
   // Internal arena
   support::Arena arena_;
   // internal arena for temp objects
@@ -346,9 +402,9 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
 
   // Handler for read code.
   void HandleProcessPacket(RPCSession::FEncodeReturn setreturn) {
-    RPCCode code = RPCCode::kNone;
-    this->Read(&code);
-    if (code >= RPCCode::kSyscallCodeStart) {
+    RPCCode code = std::exchange(peeked_code_, RPCCode::kNone);
+    if (code == RPCCode::kNone) this->Read(&code);
+    if (code >= RPCCode::kSyscallCodeStart && code < RPCCode::kCopyToRemoteCompressed) {
       this->HandleSyscall(code);
     } else {
       switch (code) {
@@ -360,12 +416,14 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
           this->HandleNormalCallFunc();
           break;
         }
-        case RPCCode::kCopyFromRemote: {
-          this->HandleCopyFromRemote();
+        case RPCCode::kCopyFromRemote:
+        case RPCCode::kCopyFromRemoteCompressed: {
+          this->HandleCopyFromRemote(code == RPCCode::kCopyFromRemoteCompressed);
           break;
         }
-        case RPCCode::kCopyToRemote: {
-          this->HandleCopyToRemote();
+        case RPCCode::kCopyToRemote:
+        case RPCCode::kCopyToRemoteCompressed: {
+          this->HandleCopyToRemote(code == RPCCode::kCopyToRemoteCompressed);
           break;
         }
         case RPCCode::kException:
@@ -445,20 +503,34 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
 
   void HandleSyscall(RPCCode code);
 
-  void HandleCopyFromRemote() {
+  void HandleCopyFromRemote(bool compressed) {
     DLTensor* arr = RPCReference::ReceiveDLTensor(this);
     uint64_t data_bytes;
     this->Read(&data_bytes);
     size_t elem_bytes = (arr->dtype.bits * arr->dtype.lanes + 7) / 8;
     auto* sess = GetServingSession();
     // Return Copy Ack with the given data
-    auto fcopyack = [this](char* dptr, size_t num_bytes) {
+    auto fcopyack = [this, compressed](char* dptr, size_t num_bytes) {
       RPCCode code = RPCCode::kCopyAck;
-      uint64_t packet_nbytes = sizeof(code) + num_bytes;
+      if (compressed) {
+        // The payload is prefixed by its encoded size, which equals num_bytes
+        // when the data did not compress and is sent as is.
+        std::string packed = support::LZBlockCompress(dptr, num_bytes);
+        uint64_t packed_nbytes = std::min<uint64_t>(packed.size(), num_bytes);
+        const char* payload = packed_nbytes < num_bytes ? packed.data() : dptr;
+        uint64_t packet_nbytes = sizeof(code) + sizeof(packed_nbytes) + packed_nbytes;
+
+        this->Write(packet_nbytes);
+        this->Write(code);
+        this->Write(packed_nbytes);
+        this->WriteArray(payload, packed_nbytes);
+      } else {
+        uint64_t packet_nbytes = sizeof(code) + num_bytes;
 
-      this->Write(packet_nbytes);
-      this->Write(code);
-      this->WriteArray(dptr, num_bytes);
+        this->Write(packet_nbytes);
+        this->Write(code);
+        this->WriteArray(dptr, num_bytes);
+      }
       this->SwitchToState(kRecvPacketNumBytes);
     };
 
@@ -488,18 +560,30 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
     }
   }
 
-  void HandleCopyToRemote() {
+  void HandleCopyToRemote(bool compressed) {
     DLTensor* arr = RPCReference::ReceiveDLTensor(this);
     uint64_t data_bytes;
     this->Read(&data_bytes);
     size_t elem_bytes = (arr->dtype.bits * arr->dtype.lanes + 7) / 8;
     auto* sess = GetServingSession();
+    // Read the payload, decoding it when it arrives compressed.
+    auto fread_payload = [this, compressed, data_bytes](char* dptr) {
+      uint64_t packed_nbytes = data_bytes;
+      if (compressed) this->Read(&packed_nbytes);
+      if (packed_nbytes == data_bytes) {
+        this->ReadArray(dptr, data_bytes);
+      } else {
+        char* packed = this->ArenaAlloc<char>(packed_nbytes);
+        this->ReadArray(packed, packed_nbytes);
+        support::LZBlockDecompress(packed, packed_nbytes, dptr, data_bytes);
+      }
+    };
 
     // When session is local, we can directly treat handle
     // as the cpu pointer without allocating a temp space.
     if (arr->device.device_type == kDLCPU && sess->IsLocalSession()) {
       char* dptr = reinterpret_cast<char*>(arr->data) + arr->byte_offset;
-      this->ReadArray(dptr, data_bytes);
+      fread_payload(dptr);
 
       if (!DMLC_IO_NO_ENDIAN_SWAP) {
         dmlc::ByteSwap(dptr, elem_bytes, data_bytes / elem_bytes);
@@ -508,7 +592,7 @@ class RPCEndpoint::EventHandler : public dmlc::Stream {
       this->SwitchToState(kRecvPacketNumBytes);
     } else {
       char* temp_data = this->ArenaAlloc<char>(data_bytes);
-      this->ReadArray(temp_data, data_bytes);
+      fread_payload(temp_data);
 
       if (!DMLC_IO_NO_ENDIAN_SWAP) {
         dmlc::ByteSwap(temp_data, elem_bytes, data_bytes / elem_bytes);
@@ -871,6 +955,36 @@ void RPCEndpoint::CallFunc(RPCSession::PackedFuncHandle h, ffi::PackedArgs args,
   ICHECK(code == RPCCode::kReturn) << "code=" << RPCCodeToString(code);
 }
 
+void RPCEndpoint::SendWithPayload(const void* payload, size_t size) {
+  CHECK(channel_) << "Expected connection to server " << name_
+                  << " to be active, but the connection was previously closed";
+  // The writer only holds the packet header at this point, since every
+  // request drains it before returning.
+  std::string header(writer_.bytes_available(), '\0');
+  writer_.Read(dmlc::BeginPtr(header), header.size());
+  const char* data = static_cast<const char*>(payload);
+  size_t sent = 0;
+  while (sent < header.size()) {
+    sent += channel_->SendGather(header.data() + sent, header.size() - sent, data, size);
+  }
+  sent -= header.size();
+  while (sent < size) {
+    sent += channel_->Send(data + sent, size - sent);
+  }
+}
+
+void RPCEndpoint::RecvAll(void* data, size_t size) {
+  char* ptr = static_cast<char*>(data);
+  while (size != 0) {
+    size_t n = channel_->Recv(ptr, size);
+    if (n == 0) {
+      LOG(FATAL) << "Channel closes before we get needed bytes";
+    }
+    ptr += n;
+    size -= n;
+  }
+}
+
 void RPCEndpoint::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes) {
   std::lock_guard<std::mutex> lock(mutex_);
   RPCCode code = RPCCode::kCopyToRemote;
@@ -887,7 +1001,35 @@ void RPCEndpoint::CopyToRemote(void* from_bytes, DLTensor* to, uint64_t nbytes)
   handler_->Write(code);
   RPCReference::SendDLTensor(handler_, to);
   handler_->Write(nbytes);
-  handler_->WriteArray(reinterpret_cast<char*>(from_bytes), nbytes);
+  if (nbytes >= kRPCZeroCopyMinBytes) {
+    // Large payloads skip the writer and go out directly from the source.
+    SendWithPayload(from_bytes, nbytes);
+  } else {
+    handler_->WriteArray(reinterpret_cast<char*>(from_bytes), nbytes);
+  }
+  ICHECK(HandleUntilReturnEvent(true, [](ffi::PackedArgs) {}) == RPCCode::kReturn);
+}
+
+void RPCEndpoint::CopyToRemoteCompressed(const std::string& packed, DLTensor* to,
+                                         uint64_t nbytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RPCCode code = RPCCode::kCopyToRemoteCompressed;
+
+  uint64_t tensor_total_size_bytes = static_cast<uint64_t>(GetDataSize(*to));
+  ICHECK_LE(to->byte_offset + nbytes, tensor_total_size_bytes)
+      << "CopyToRemote: overflow in tensor size: (byte_offset=" << to->byte_offset
+      << ", nbytes=" << nbytes << ", tensor_total_size=" << tensor_total_size_bytes << ")";
+
+  uint64_t packed_nbytes = packed.size();
+  uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(to, code, nbytes);
+  uint64_t packet_nbytes = overhead + sizeof(packed_nbytes) + packed_nbytes;
+
+  handler_->Write(packet_nbytes);
+  handler_->Write(code);
+  RPCReference::SendDLTensor(handler_, to);
+  handler_->Write(nbytes);
+  handler_->Write(packed_nbytes);
+  SendWithPayload(packed.data(), packed.size());
   ICHECK(HandleUntilReturnEvent(true, [](ffi::PackedArgs) {}) == RPCCode::kReturn);
 }
 
@@ -907,12 +1049,50 @@ void RPCEndpoint::CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes
   handler_->Write(code);
   RPCReference::SendDLTensor(handler_, from);
   handler_->Write(nbytes);
+
+  // Receive a large plain copy ack straight into the destination instead of
+  // buffering the whole packet in the reader.
+  handler_->ExpectDirectCopyAck(nbytes >= kRPCZeroCopyMinBytes ? nbytes : 0);
   ICHECK(HandleUntilReturnEvent(true, [](ffi::PackedArgs) {}) == RPCCode::kCopyAck);
 
-  handler_->ReadArray(reinterpret_cast<char*>(to_bytes), nbytes);
+  if (handler_->TakeDirectCopyAck()) {
+    // The reader stops at the code of the packet, the payload is still on the channel.
+    ICHECK_EQ(reader_.bytes_available(), 0U);
+    RecvAll(to_bytes, nbytes);
+  } else {
+    handler_->ReadArray(reinterpret_cast<char*>(to_bytes), nbytes);
+  }
   handler_->FinishCopyAck();
 }
 
+std::string RPCEndpoint::CopyFromRemoteCompressed(DLTensor* from, uint64_t nbytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  RPCCode code = RPCCode::kCopyFromRemoteCompressed;
+
+  uint64_t tensor_total_size_bytes = static_cast<uint64_t>(GetDataSize(*from));
+  ICHECK_LE(from->byte_offset + nbytes, tensor_total_size_bytes)
+      << "CopyFromRemote: overflow in tensor size: (byte_offset=" << from->byte_offset
+      << ", nbytes=" << nbytes << ", tensor_total_size=" << tensor_total_size_bytes << ")";
+
+  uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(from, code, nbytes);
+  uint64_t packet_nbytes = overhead;
+
+  handler_->Write(packet_nbytes);
+  handler_->Write(code);
+  RPCReference::SendDLTensor(handler_, from);
+  handler_->Write(nbytes);
+  handler_->ExpectDirectCopyAck(0);
+  ICHECK(HandleUntilReturnEvent(true, [](ffi::PackedArgs) {}) == RPCCode::kCopyAck);
+
+  uint64_t packed_nbytes;
+  handler_->Read(&packed_nbytes);
+  ICHECK_LE(packed_nbytes, nbytes) << "CopyFromRemote: invalid compressed block size";
+  std::string packed(packed_nbytes, '\0');
+  handler_->ReadArray(dmlc::BeginPtr(packed), packed_nbytes);
+  handler_->FinishCopyAck();
+  return packed;
+}
+
 // SysCallEventHandler functions
 void RPCGetGlobalFunc(RPCSession* handler, ffi::PackedArgs args, ffi::Any* rv) {
   auto name = args[0].cast<std::string>();
@@ -1060,6 +1240,69 @@ void RPCEndpoint::EventHandler::HandleSyscall(RPCCode code) {
   }
 }
 
+/*!
+ * \brief A single worker thread that runs the codec work of compressed copies.
+ *
+ *  A session owns one worker, so a copy overlaps at most one frame of codec
+ *  work with the transfer, whatever its size.
+ */
+class RPCCodecWorker {
+ public:
+  RPCCodecWorker() = default;
+  RPCCodecWorker(const RPCCodecWorker&) = delete;
+  RPCCodecWorker& operator=(const RPCCodecWorker&) = delete;
+
+  ~RPCCodecWorker() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+  }
+
+  /*!
+   * \brief Run a task on the worker, the thread starts with the first task.
+   * \param task The task.
+   * \return The future of the task, it holds the exception thrown by the task if any.
+   */
+  template <typename R>
+  std::future<R> Submit(std::function<R()> task) {
+    auto packaged = std::make_shared<std::packaged_task<R()>>(std::move(task));
+    std::future<R> result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!thread_.joinable()) {
+        thread_ = std::thread([this]() { this->Run(); });
+      }
+      tasks_.emplace_back([packaged]() { (*packaged)(); });
+    }
+    cv_.notify_one();
+    return result;
+  }
+
+ private:
+  void Run() {
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+        if (tasks_.empty()) return;
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  bool stop_{false};
+  std::thread thread_;
+};
+
 /*!
  * \brief RPC client session that proxies all calls to an endpoint.
  */
@@ -1081,6 +1324,10 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
   }
 
   void CopyToRemote(void* local_from_bytes, DLTensor* remote_to, uint64_t nbytes) final {
+    if (nbytes >= kRPCCompressMinBytes && UseCompressedCopy()) {
+      CopyToRemoteCompressed(static_cast<const char*>(local_from_bytes), remote_to, nbytes);
+      return;
+    }
     RPCCode code = RPCCode::kCopyToRemote;
     uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(remote_to, code, nbytes);
     uint64_t rpc_max_size = GetRPCMaxTransferSize();
@@ -1107,6 +1354,10 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
   }
 
   void CopyFromRemote(DLTensor* remote_from, void* local_to_bytes, uint64_t nbytes) final {
+    if (nbytes >= kRPCCompressMinBytes && UseCompressedCopy()) {
+      CopyFromRemoteCompressed(remote_from, static_cast<char*>(local_to_bytes), nbytes);
+      return;
+    }
     RPCCode code = RPCCode::kCopyFromRemote;
     uint64_t overhead = RemoteCopyCalculatePacketOverheadSize(remote_from, code, nbytes);
     uint64_t rpc_max_size = GetRPCMaxTransferSize();
@@ -1227,8 +1478,106 @@ class RPCClientSession : public RPCSession, public DeviceAPI {
     return (uint64_t)rpc_chunk_max_size_bytes_;
   }
 
+  /*!
+   * \brief Whether copies are sent compressed, which requires the client to
+   *  opt in through TVM_RPC_COMPRESSION and the server to support it.
+   */
+  bool UseCompressedCopy() {
+    if (compressed_copy_ >= 0) {
+      return compressed_copy_ != 0;
+    }
+    compressed_copy_ = 0;
+    const char* opt = std::getenv("TVM_RPC_COMPRESSION");
+    if (opt == nullptr || std::string(opt) == "0") {
+      return false;
+    }
+    PackedFuncHandle rpc_func = GetFunction("tvm.rpc.server.GetTransportFeatures");
+    if (rpc_func != nullptr) {
+      CallFunc(rpc_func, ffi::PackedArgs(nullptr, 0), [this](ffi::PackedArgs args) {
+        int64_t features = args[1].cast<int64_t>();
+        compressed_copy_ = (features & kRPCTransportCompressedCopy) != 0;
+      });
+      FreeHandle(rpc_func);
+    }
+    return compressed_copy_ != 0;
+  }
+
+  // Size of the frames a compressed copy is split into.
+  uint64_t GetCompressedFrameSize(DLTensor* tensor, RPCCode code, uint64_t nbytes) {
+    uint64_t overhead =
+        RemoteCopyCalculatePacketOverheadSize(tensor, code, nbytes) + sizeof(uint64_t);
+    uint64_t rpc_max_size = GetRPCMaxTransferSize();
+    ICHECK_GT(rpc_max_size, overhead) << "Compressed copy: Invalid block size!";
+    return std::min(rpc_max_size - overhead, kRPCCompressedFrameBytes);
+  }
+
+  // Upload frame by frame, compressing the next frame while the current one is sent.
+  void CopyToRemoteCompressed(const char* from_bytes, DLTensor* remote_to, uint64_t nbytes) {
+    const uint64_t frame_size =
+        GetCompressedFrameSize(remote_to, RPCCode::kCopyToRemoteCompressed, nbytes);
+    const uint64_t base_offset = remote_to->byte_offset;
+    auto fcompress = [from_bytes, frame_size, nbytes](uint64_t offset) {
+      return support::LZBlockCompress(from_bytes + offset, std::min(frame_size, nbytes - offset));
+    };
+    std::future<std::string> next =
+        codec_worker_.Submit<std::string>([fcompress]() { return fcompress(0); });
+    try {
+      for (uint64_t offset = 0; offset < nbytes; offset += frame_size) {
+        const uint64_t size = std::min(frame_size, nbytes - offset);
+        std::string packed = next.get();
+        if (offset + size < nbytes) {
+          next = codec_worker_.Submit<std::string>(
+              [fcompress, offset, size]() { return fcompress(offset + size); });
+        }
+        remote_to->byte_offset = base_offset + offset;
+        if (packed.size() < size) {
+          endpoint_->CopyToRemoteCompressed(packed, remote_to, size);
+        } else {
+          endpoint_->CopyToRemote(const_cast<char*>(from_bytes + offset), remote_to, size);
+        }
+      }
+    } catch (...) {
+      // The worker still reads from_bytes; do not hand it back to the caller before that ends.
+      if (next.valid()) next.wait();
+      throw;
+    }
+  }
+
+  // Download frame by frame, decompressing a frame while the next one is received.
+  void CopyFromRemoteCompressed(DLTensor* remote_from, char* to_bytes, uint64_t nbytes) {
+    const uint64_t frame_size =
+        GetCompressedFrameSize(remote_from, RPCCode::kCopyFromRemoteCompressed, nbytes);
+    const uint64_t base_offset = remote_from->byte_offset;
+    std::future<void> pending;
+    try {
+      for (uint64_t offset = 0; offset < nbytes; offset += frame_size) {
+        const uint64_t size = std::min(frame_size, nbytes - offset);
+        remote_from->byte_offset = base_offset + offset;
+        std::string packed = endpoint_->CopyFromRemoteCompressed(remote_from, size);
+        if (pending.valid()) pending.get();
+        char* dst = to_bytes + offset;
+        auto shared_packed = std::make_shared<std::string>(std::move(packed));
+        pending = codec_worker_.Submit<void>([dst, size, shared_packed]() {
+          if (shared_packed->size() == size) {
+            std::memcpy(dst, shared_packed->data(), size);
+          } else {
+            support::LZBlockDecompress(shared_packed->data(), shared_packed->size(), dst, size);
+          }
+        });
+      }
+    } catch (...) {
+      // The worker still writes to_bytes; do not hand it back to the caller before that ends.
+      if (pending.valid()) pending.wait();
+      throw;
+    }
+    if (pending.valid()) pending.get();
+  }
+
   std::shared_ptr<RPCEndpoint> endpoint_;
   int64_t rpc_chunk_max_size_bytes_ = -1;
+  int compressed_copy_ = -1;
+  // Runs the compression of compressed copies next to the transfer.
+  RPCCodecWorker codec_worker_;
 };
 
 std::shared_ptr<RPCSession> CreateClientSession(std::shared_ptr<RPCEndpoint> endpoint) {
@@ -45,6 +45,8 @@ const int kRPCMagic = 0xff271;
 const int kRPCTrackerMagic = 0x2f271;
 // sucess response
 const int kRPCSuccess = kRPCMagic + 0;
+// a connection with the same key is already waiting in the proxy
+const int kRPCDuplicate = kRPCMagic + 1;
 // cannot found matched key in server
 const int kRPCMismatch = kRPCMagic + 2;
 
@@ -159,6 +161,22 @@ class RPCEndpoint {
    * \param type_hint Hint of content data type.
    */
   void CopyFromRemote(DLTensor* from, void* to_bytes, uint64_t nbytes);
+  /*!
+   * \brief Copy a compressed block into remote array content.
+   * \param packed The block encoded by support::LZBlockCompress.
+   * \param to The target array.
+   * \param nbytes The size of the decoded block in bytes.
+   * \note Only valid when the remote reports kRPCTransportCompressedCopy.
+   */
+  void CopyToRemoteCompressed(const std::string& packed, DLTensor* to, uint64_t nbytes);
+  /*!
+   * \brief Copy remote array content, letting the remote compress it.
+   * \param from The source array.
+   * \param nbytes The size of the memory in bytes.
+   * \return The encoded block, or the raw bytes when its size equals nbytes.
+   * \note Only valid when the remote reports kRPCTransportCompressedCopy.
+   */
+  std::string CopyFromRemoteCompressed(DLTensor* from, uint64_t nbytes);
 
   /*!
    * \brief Call a remote defined system function with arguments.
@@ -188,6 +206,11 @@ class RPCEndpoint {
   RPCCode HandleUntilReturnEvent(bool client_mode, RPCSession::FEncodeReturn setreturn);
   // Initalization
   void Init();
+  // Send the pending header in the writer followed by the payload, without
+  // staging the payload in the writer.
+  void SendWithPayload(const void* payload, size_t size);
+  // Receive exactly size bytes from the channel.
+  void RecvAll(void* data, size_t size);
   // Internal channel.
   std::unique_ptr<RPCChannel> channel_;
 
@@ -27,10 +27,13 @@
 #include <tvm/runtime/device_api.h>
 #include <tvm/runtime/profiling.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <memory>
+#include <string>
 #include <thread>
+#include <vector>
 #if defined(_M_X64) || defined(__x86_64__)
 #include <immintrin.h>
 #endif
@@ -225,6 +228,23 @@ class RPCModuleNode final : public ModuleNode {
     }
   }
 
+  ffi::Function GetAdaptiveTimeEvaluator(const std::string& names, Device dev, int min_repeat,
+                                         int max_repeat, int min_repeat_ms, double target_rel_ci,
+                                         int cooldown_interval_ms, int cache_flush_bytes,
+                                         const std::string& f_preproc_name) {
+    InitRemoteFunc(&remote_get_adaptive_time_evaluator_, "runtime.RPCAdaptiveTimeEvaluator");
+    // Remove session mask because we pass dev by parts.
+    ICHECK_EQ(GetRPCSessionIndex(dev), sess_->table_index())
+        << "ValueError: Need to pass the matched remote device to "
+        << "RPCModule.GetAdaptiveTimeEvaluator";
+    dev = RemoveRPCSessionMask(dev);
+    Optional<Module> mod;
+    if (module_handle_ != nullptr) mod = GetRef<Module>(this);
+    return remote_get_adaptive_time_evaluator_(
+        mod, names, static_cast<int>(dev.device_type), dev.device_id, min_repeat, max_repeat,
+        min_repeat_ms, target_rel_ci, cooldown_interval_ms, cache_flush_bytes, f_preproc_name);
+  }
+
   Module LoadModule(std::string name) {
     InitRemoteFunc(&remote_load_module_, "tvm.rpc.server.load_module");
     return remote_load_module_(name);
@@ -263,6 +283,10 @@ class RPCModuleNode final : public ModuleNode {
   ffi::TypedFunction<ffi::Function(Optional<Module>, std::string, int, int, int, int, int, int, int,
                                    int, int, std::string)>
       remote_get_time_evaluator_;
+  // remote function to get adaptive time evaluator
+  ffi::TypedFunction<ffi::Function(Optional<Module>, std::string, int, int, int, int, int, double,
+                                   int, int, std::string)>
+      remote_get_adaptive_time_evaluator_;
   // remote function getter for modules.
   ffi::TypedFunction<ffi::Function(Module, std::string, bool)> remote_mod_get_function_;
   // remote function getter for load module
@@ -438,6 +462,46 @@ TVM_FFI_STATIC_INIT_BLOCK({
                    cooldown_interval_ms, repeats_to_cooldown, cache_flush_bytes, f_preproc);
              }
            })
+      .def("runtime.RPCAdaptiveTimeEvaluator",
+           [](Optional<Module> opt_mod, std::string names, int device_type, int device_id,
+              int min_repeat, int max_repeat, int min_repeat_ms, double target_rel_ci,
+              int cooldown_interval_ms, int cache_flush_bytes, std::string f_preproc_name) {
+             Device dev;
+             dev.device_type = static_cast<DLDeviceType>(device_type);
+             dev.device_id = device_id;
+             if (opt_mod.defined() && opt_mod.value()->type_key() == std::string("rpc")) {
+               return static_cast<RPCModuleNode*>(opt_mod.value().operator->())
+                   ->GetAdaptiveTimeEvaluator(names, dev, min_repeat, max_repeat, min_repeat_ms,
+                                              target_rel_ci, cooldown_interval_ms,
+                                              cache_flush_bytes, f_preproc_name);
+             }
+             // The names are comma separated so that the batch crosses RPC as one string.
+             std::vector<ffi::Function> fs;
+             for (size_t begin = 0; begin <= names.size();) {
+               size_t end = std::min(names.find(',', begin), names.size());
+               std::string name = names.substr(begin, end - begin);
+               begin = end + 1;
+               if (opt_mod.defined()) {
+                 ffi::Function pf = opt_mod.value().GetFunction(name, true);
+                 CHECK(pf != nullptr) << "Cannot find " << name << " in the module";
+                 fs.push_back(pf);
+               } else {
+                 auto pf = tvm::ffi::Function::GetGlobal(name);
+                 ICHECK(pf.has_value()) << "Cannot find " << name << " in the global function";
+                 fs.push_back(*pf);
+               }
+             }
+             ffi::Function f_preproc;
+             if (!f_preproc_name.empty()) {
+               auto pf_preproc = tvm::ffi::Function::GetGlobal(f_preproc_name);
+               ICHECK(pf_preproc.has_value())
+                   << "Cannot find " << f_preproc_name << " in the global function";
+               f_preproc = *pf_preproc;
+             }
+             return profiling::WrapAdaptiveTimeEvaluator(
+                 fs, dev, min_repeat, max_repeat, min_repeat_ms, target_rel_ci,
+                 cooldown_interval_ms, cache_flush_bytes, f_preproc);
+           })
       .def_packed("cache_flush_cpu_non_first_arg",
                   [](ffi::PackedArgs args, ffi::Any* rv) { CPUCacheFlush(1, args); });
 });
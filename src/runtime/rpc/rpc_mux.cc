@@ -0,0 +1,458 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rpc_mux.cc
+ * \brief Multiplex several RPC streams over a single channel.
+ */
+#include "rpc_mux.h"
+
+#include <dmlc/endian.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../support/ring_buffer.h"
+#include "rpc_endpoint.h"
+
+namespace tvm {
+namespace runtime {
+
+/*!
+ * \brief Inbound bytes of one stream, filled by the connection reader.
+ *
+ *  The inbox is bounded: the reader waits for the stream to drain it before
+ *  delivering more. While it waits, packets of the other streams queue up on
+ *  the physical channel, which pushes the backpressure back to the sender.
+ */
+struct RPCMuxStream {
+  /*! \brief The inbox size above which the reader stops delivering. */
+  static constexpr size_t kMaxInboxBytes = 4 << 20;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  support::RingBuffer inbox;
+  /*! \brief The physical channel is closed, no more bytes will arrive. */
+  bool closed{false};
+  /*! \brief The stream channel is gone, inbound bytes are dropped. */
+  bool abandoned{false};
+};
+
+/*!
+ * \brief A physical channel shared by several streams.
+ *
+ *  A reader thread demultiplexes inbound packets into per-stream inboxes.
+ *  Outbound packets are written whole under the send lock, each stream
+ *  channel tags the packet size with its id on the way out.
+ */
+class RPCMuxConnection : public std::enable_shared_from_this<RPCMuxConnection> {
+ public:
+  /*! \brief Called from the reader on the first packet of a stream that was not opened. */
+  using FNewStream = std::function<void(uint32_t stream_id)>;
+
+  RPCMuxConnection(std::unique_ptr<RPCChannel> channel, int max_streams)
+      : channel_(std::move(channel)), streams_(max_streams) {
+    ICHECK(DMLC_IO_NO_ENDIAN_SWAP) << "RPC multiplexing requires a little endian host";
+    ICHECK_GT(max_streams, 0);
+  }
+
+  /*!
+   * \brief Start the reader thread.
+   * \param fnew_stream Handler of streams opened by the remote, nullptr to reject them.
+   * \param fclose Called once the channel is closed.
+   */
+  void Start(FNewStream fnew_stream, std::function<void()> fclose) {
+    fnew_stream_ = std::move(fnew_stream);
+    fclose_ = std::move(fclose);
+    // The reader keeps the connection alive until the remote closes it.
+    std::thread([self = shared_from_this()]() { self->ReaderLoop(); }).detach();
+  }
+
+  /*!
+   * \brief Open a channel for one stream.
+   * \param stream_id The stream id.
+   * \return The channel.
+   */
+  std::unique_ptr<RPCChannel> OpenStream(uint32_t stream_id);
+
+  /*!
+   * \brief Send one whole packet, packets of concurrent callers never interleave.
+   * \param data The packet, starting with its tagged size.
+   * \param size The number of bytes in the packet.
+   */
+  void SendPacket(const void* data, size_t size) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    ICHECK(!send_failed_) << "RPC multiplexed connection is broken by an earlier send error";
+    const char* ptr = static_cast<const char*>(data);
+    try {
+      while (size != 0) {
+        size_t n = channel_->Send(ptr, size);
+        ptr += n;
+        size -= n;
+      }
+    } catch (...) {
+      // A partial packet desynchronizes the remote reader for every stream.
+      send_failed_ = true;
+      throw;
+    }
+  }
+
+ private:
+  std::shared_ptr<RPCMuxStream> GetStream(uint32_t stream_id) {
+    std::lock_guard<std::mutex> lock(streams_mutex_);
+    ICHECK_LT(stream_id, streams_.size()) << "RPC stream id " << stream_id << " out of range";
+    if (streams_[stream_id] == nullptr) {
+      streams_[stream_id] = std::make_shared<RPCMuxStream>();
+      streams_[stream_id]->closed = eof_;
+    }
+    return streams_[stream_id];
+  }
+
+  bool RecvAll(void* data, size_t size) {
+    char* ptr = static_cast<char*>(data);
+    while (size != 0) {
+      size_t n = channel_->Recv(ptr, size);
+      if (n == 0) return false;
+      ptr += n;
+      size -= n;
+    }
+    return true;
+  }
+
+  static void Deliver(RPCMuxStream* stream, const void* data, size_t size) {
+    {
+      std::unique_lock<std::mutex> lock(stream->mutex);
+      stream->cv.wait(lock, [stream] {
+        return stream->inbox.bytes_available() < RPCMuxStream::kMaxInboxBytes ||
+               stream->abandoned;
+      });
+      if (stream->abandoned) return;
+      stream->inbox.Write(data, size);
+    }
+    stream->cv.notify_all();
+  }
+
+  void ReaderLoop() {
+    constexpr size_t kChunkBytes = 256 << 10;
+    std::vector<char> chunk(kChunkBytes);
+    try {
+      uint64_t header;
+      while (RecvAll(&header, sizeof(header))) {
+        uint32_t stream_id = static_cast<uint32_t>(header >> kRPCStreamIdShift);
+        uint64_t packet_nbytes = header & kRPCPacketNumBytesMask;
+        bool is_new;
+        {
+          std::lock_guard<std::mutex> lock(streams_mutex_);
+          is_new = stream_id < streams_.size() && streams_[stream_id] == nullptr;
+        }
+        std::shared_ptr<RPCMuxStream> stream = GetStream(stream_id);
+        if (is_new) {
+          ICHECK(fnew_stream_ != nullptr)
+              << "Received a packet on unopened RPC stream " << stream_id;
+          fnew_stream_(stream_id);
+        }
+        Deliver(stream.get(), &packet_nbytes, sizeof(packet_nbytes));
+        while (packet_nbytes != 0) {
+          size_t n = static_cast<size_t>(std::min<uint64_t>(packet_nbytes, kChunkBytes));
+          ICHECK(RecvAll(chunk.data(), n)) << "Channel closes in the middle of an RPC packet";
+          Deliver(stream.get(), chunk.data(), n);
+          packet_nbytes -= n;
+        }
+      }
+    } catch (const std::exception& e) {
+      LOG(WARNING) << "RPC multiplexed connection terminated: " << e.what();
+    }
+    std::vector<std::shared_ptr<RPCMuxStream>> streams;
+    {
+      std::lock_guard<std::mutex> lock(streams_mutex_);
+      eof_ = true;
+      streams = streams_;
+    }
+    for (const auto& stream : streams) {
+      if (stream == nullptr) continue;
+      {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->closed = true;
+      }
+      stream->cv.notify_all();
+    }
+    if (fclose_ != nullptr) fclose_();
+  }
+
+  std::unique_ptr<RPCChannel> channel_;
+  std::mutex send_mutex_;
+  bool send_failed_{false};
+  std::mutex streams_mutex_;
+  std::vector<std::shared_ptr<RPCMuxStream>> streams_;
+  bool eof_{false};
+  FNewStream fnew_stream_;
+  std::function<void()> fclose_;
+};
+
+/*!
+ * \brief Channel of one stream.
+ *
+ *  The endpoint writes a packet through several Send calls. The channel
+ *  collects them and hands the complete packet to the connection, so the
+ *  send lock is never held between calls.
+ */
+class RPCMuxStreamChannel final : public RPCChannel {
+ public:
+  RPCMuxStreamChannel(std::shared_ptr<RPCMuxConnection> conn, uint32_t stream_id,
+                      std::shared_ptr<RPCMuxStream> stream)
+      : conn_(std::move(conn)), stream_id_(stream_id), stream_(std::move(stream)) {}
+
+  ~RPCMuxStreamChannel() {
+    // Unblock the reader if it waits for this stream to drain its inbox.
+    {
+      std::lock_guard<std::mutex> lock(stream_->mutex);
+      stream_->abandoned = true;
+      stream_->inbox = support::RingBuffer();
+    }
+    stream_->cv.notify_all();
+  }
+
+  size_t Send(const void* data, size_t size) final {
+    constexpr size_t kHeaderBytes = sizeof(uint64_t);
+    const char* ptr = static_cast<const char*>(data);
+    size_t n;
+    if (packet_.size() < kHeaderBytes) {
+      // Collect the packet size, then store it tagged with the stream id.
+      n = std::min(kHeaderBytes - packet_.size(), size);
+      packet_.insert(packet_.end(), ptr, ptr + n);
+      if (packet_.size() != kHeaderBytes) return n;
+      uint64_t nbytes;
+      std::memcpy(&nbytes, packet_.data(), sizeof(nbytes));
+      ICHECK_EQ(nbytes & ~kRPCPacketNumBytesMask, 0U) << "RPC packet too large to multiplex";
+      uint64_t tagged = nbytes | (static_cast<uint64_t>(stream_id_) << kRPCStreamIdShift);
+      std::memcpy(packet_.data(), &tagged, sizeof(tagged));
+      packet_.reserve(kHeaderBytes + nbytes);
+      body_remaining_ = nbytes;
+    } else {
+      n = static_cast<size_t>(std::min<uint64_t>(size, body_remaining_));
+      packet_.insert(packet_.end(), ptr, ptr + n);
+      body_remaining_ -= n;
+    }
+    if (body_remaining_ == 0) {
+      std::vector<char> packet;
+      packet.swap(packet_);
+      conn_->SendPacket(packet.data(), packet.size());
+    }
+    return n;
+  }
+
+  size_t Recv(void* data, size_t size) final {
+    size_t n;
+    {
+      std::unique_lock<std::mutex> lock(stream_->mutex);
+      stream_->cv.wait(
+          lock, [this] { return stream_->inbox.bytes_available() != 0 || stream_->closed; });
+      n = std::min(size, stream_->inbox.bytes_available());
+      stream_->inbox.Read(data, n);
+    }
+    // The reader may wait for room in the inbox.
+    stream_->cv.notify_all();
+    return n;
+  }
+
+ private:
+  std::shared_ptr<RPCMuxConnection> conn_;
+  uint32_t stream_id_;
+  std::shared_ptr<RPCMuxStream> stream_;
+  // The packet being collected, starting with its tagged size.
+  std::vector<char> packet_;
+  // Bytes of the current packet body that are yet to be collected.
+  uint64_t body_remaining_{0};
+};
+
+std::unique_ptr<RPCChannel> RPCMuxConnection::OpenStream(uint32_t stream_id) {
+  return std::make_unique<RPCMuxStreamChannel>(shared_from_this(), stream_id,
+                                               GetStream(stream_id));
+}
+
+/*!
+ * \brief Client session that pins each calling thread to one of several streams.
+ */
+class RPCMuxClientSession : public RPCSession, public DeviceAPI {
+ public:
+  explicit RPCMuxClientSession(std::vector<std::shared_ptr<RPCSession>> streams)
+      : streams_(std::move(streams)), session_id_(next_session_id_++) {}
+
+  PackedFuncHandle GetFunction(const std::string& name) final {
+    return Stream()->GetFunction(name);
+  }
+
+  void CallFunc(PackedFuncHandle func, ffi::PackedArgs args,
+                const FEncodeReturn& fencode_return) final {
+    Stream()->CallFunc(func, args, fencode_return);
+  }
+
+  void CopyToRemote(void* local_from_bytes, DLTensor* remote_to, uint64_t nbytes) final {
+    Stream()->CopyToRemote(local_from_bytes, remote_to, nbytes);
+  }
+
+  void CopyFromRemote(DLTensor* remote_from, void* local_to_bytes, uint64_t nbytes) final {
+    Stream()->CopyFromRemote(remote_from, local_to_bytes, nbytes);
+  }
+
+  void FreeHandle(void* handle) final { Stream()->FreeHandle(handle); }
+
+  void SetDevice(Device dev) final { StreamAPI(dev)->SetDevice(dev); }
+
+  void GetAttr(Device dev, DeviceAttrKind kind, ffi::Any* rv) final {
+    StreamAPI(dev)->GetAttr(dev, kind, rv);
+  }
+
+  void* AllocDataSpace(Device dev, size_t nbytes, size_t alignment, DLDataType type_hint) final {
+    return StreamAPI(dev)->AllocDataSpace(dev, nbytes, alignment, type_hint);
+  }
+
+  void* AllocDataSpace(Device dev, int ndim, const int64_t* shape, DLDataType dtype,
+                       Optional<String> mem_scope) final {
+    return StreamAPI(dev)->AllocDataSpace(dev, ndim, shape, dtype, mem_scope);
+  }
+
+  void FreeDataSpace(Device dev, void* ptr) final { StreamAPI(dev)->FreeDataSpace(dev, ptr); }
+
+  void CopyDataFromTo(DLTensor* from, DLTensor* to, TVMStreamHandle stream) final {
+    StreamAPI(from->device)->CopyDataFromTo(from, to, stream);
+  }
+
+  TVMStreamHandle CreateStream(Device dev) final { return StreamAPI(dev)->CreateStream(dev); }
+
+  void FreeStream(Device dev, TVMStreamHandle stream) final {
+    StreamAPI(dev)->FreeStream(dev, stream);
+  }
+
+  void StreamSync(Device dev, TVMStreamHandle stream) final {
+    StreamAPI(dev)->StreamSync(dev, stream);
+  }
+
+  void SetStream(Device dev, TVMStreamHandle stream) final {
+    StreamAPI(dev)->SetStream(dev, stream);
+  }
+
+  TVMStreamHandle GetCurrentStream(Device dev) final {
+    return StreamAPI(dev)->GetCurrentStream(dev);
+  }
+
+  DeviceAPI* GetDeviceAPI(Device dev, bool allow_missing) final { return this; }
+
+  bool IsLocalSession() const final { return false; }
+
+  void Shutdown() final {
+    for (const auto& stream : streams_) {
+      stream->Shutdown();
+    }
+  }
+
+ private:
+  // The stream of the calling thread, assigned round robin on first use. The slots live in
+  // the thread, so they go away with it, and are keyed by the session id, which unlike the
+  // address is not reused by a later session.
+  RPCSession* Stream() {
+    thread_local std::unordered_map<uint64_t, size_t> thread_stream;
+    auto it = thread_stream.find(session_id_);
+    if (it == thread_stream.end()) {
+      size_t index = next_stream_++ % streams_.size();
+      it = thread_stream.emplace(session_id_, index).first;
+    }
+    return streams_[it->second].get();
+  }
+
+  DeviceAPI* StreamAPI(Device dev) { return Stream()->GetDeviceAPI(dev); }
+
+  std::vector<std::shared_ptr<RPCSession>> streams_;
+  uint64_t session_id_;
+  std::atomic<size_t> next_stream_{0};
+  static inline std::atomic<uint64_t> next_session_id_{0};
+};
+
+std::shared_ptr<RPCSession> CreateMultiplexedClientSession(std::unique_ptr<RPCChannel> channel,
+                                                           std::string name,
+                                                           std::string remote_key,
+                                                           int num_streams) {
+  auto conn = std::make_shared<RPCMuxConnection>(std::move(channel), num_streams);
+  conn->Start(nullptr, nullptr);
+  std::vector<std::shared_ptr<RPCSession>> streams;
+  for (int i = 0; i < num_streams; ++i) {
+    auto endpt = RPCEndpoint::Create(conn->OpenStream(i), name, remote_key);
+    endpt->InitRemoteSession(ffi::PackedArgs(nullptr, 0));
+    streams.push_back(CreateClientSession(endpt));
+  }
+  return std::make_shared<RPCMuxClientSession>(std::move(streams));
+}
+
+void RPCMuxServerLoop(std::unique_ptr<RPCChannel> channel, int max_streams) {
+  struct ServerState {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int num_opened{0};
+    int num_active{0};
+    bool closed{false};
+  };
+  auto state = std::make_shared<ServerState>();
+  auto conn = std::make_shared<RPCMuxConnection>(std::move(channel), max_streams);
+  std::weak_ptr<RPCMuxConnection> weak_conn = conn;
+
+  auto fnew_stream = [state, weak_conn](uint32_t stream_id) {
+    std::shared_ptr<RPCMuxConnection> conn = weak_conn.lock();
+    if (conn == nullptr) return;
+    std::unique_ptr<RPCChannel> stream = conn->OpenStream(stream_id);
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      ++state->num_opened;
+      ++state->num_active;
+    }
+    // Worker threads finish on their own once their stream shuts down.
+    std::thread([state, stream = std::move(stream)]() mutable {
+      try {
+        RPCEndpoint::Create(std::move(stream), "MuxServerLoop", "")->ServerLoop();
+      } catch (const std::exception& e) {
+        LOG(WARNING) << "RPC stream terminated: " << e.what();
+      }
+      std::lock_guard<std::mutex> lock(state->mutex);
+      --state->num_active;
+      state->cv.notify_all();
+    }).detach();
+  };
+  auto fclose = [state]() {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->closed = true;
+    state->cv.notify_all();
+  };
+  conn->Start(fnew_stream, fclose);
+  conn.reset();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->cv.wait(lock, [&] {
+    return state->num_active == 0 && (state->num_opened != 0 || state->closed);
+  });
+}
+
+}  // namespace runtime
+}  // namespace tvm
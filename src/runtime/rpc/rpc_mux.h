@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file rpc_mux.h
+ * \brief Multiplex several RPC streams over a single channel.
+ *
+ *  Every RPC packet starts with its size as a uint64. A multiplexed
+ *  connection stores the stream id in the bits of that size above
+ *  kRPCStreamIdShift, so stream 0 is byte-for-byte the plain protocol and
+ *  a multiplexed server can talk to a client that never opens a second
+ *  stream. Each stream runs an unmodified RPCEndpoint.
+ */
+#ifndef TVM_RUNTIME_RPC_RPC_MUX_H_
+#define TVM_RUNTIME_RPC_RPC_MUX_H_
+
+#include <memory>
+#include <string>
+
+#include "rpc_channel.h"
+#include "rpc_session.h"
+
+namespace tvm {
+namespace runtime {
+
+/*! \brief Bit position of the stream id in the packet size of a multiplexed connection. */
+constexpr int kRPCStreamIdShift = 48;
+/*! \brief Mask of the actual packet size in a multiplexed connection. */
+constexpr uint64_t kRPCPacketNumBytesMask = (static_cast<uint64_t>(1) << kRPCStreamIdShift) - 1;
+
+/*!
+ * \brief Create a client session whose calls are spread over several streams.
+ *
+ *  Each calling thread is pinned to one stream, so calls from different
+ *  threads are in flight concurrently while per-thread device state such
+ *  as the current stream stays consistent on the remote.
+ *
+ * \param channel The connected channel, the remote must serve it with RPCMuxServerLoop.
+ * \param name The local name of the session.
+ * \param remote_key The remote key reported during the handshake.
+ * \param num_streams The number of streams to open.
+ * \return The created session.
+ */
+std::shared_ptr<RPCSession> CreateMultiplexedClientSession(std::unique_ptr<RPCChannel> channel,
+                                                           std::string name,
+                                                           std::string remote_key,
+                                                           int num_streams);
+
+/*!
+ * \brief Serve a multiplexed connection, running each stream on its own worker thread.
+ *
+ *  Returns once every opened stream has shut down, or the channel is closed.
+ *
+ * \param channel The connected channel.
+ * \param max_streams The maximum number of streams the client may open.
+ */
+void RPCMuxServerLoop(std::unique_ptr<RPCChannel> channel, int max_streams);
+
+}  // namespace runtime
+}  // namespace tvm
+#endif  // TVM_RUNTIME_RPC_RPC_MUX_H_
@@ -25,6 +25,7 @@
 #include <tvm/ffi/reflection/registry.h>
 
 #include "../file_utils.h"
+#include "../minrpc/rpc_reference.h"
 
 namespace tvm {
 namespace runtime {
@@ -53,10 +54,13 @@ TVM_FFI_STATIC_INIT_BLOCK({
                     LOG(INFO) << "Download " << file_name << "... nbytes=" << data.size();
                     *rv = ffi::Bytes(data);
                   })
-      .def_packed("tvm.rpc.server.remove", [](ffi::PackedArgs args, ffi::Any* rv) {
-        std::string file_name = RPCGetPath(args[0].cast<std::string>());
-        RemoveFile(file_name);
-      });
+      .def_packed("tvm.rpc.server.remove",
+                  [](ffi::PackedArgs args, ffi::Any* rv) {
+                    std::string file_name = RPCGetPath(args[0].cast<std::string>());
+                    RemoveFile(file_name);
+                  })
+      .def("tvm.rpc.server.GetTransportFeatures",
+           []() -> int64_t { return kRPCTransportCompressedCopy; });
 });
 
 }  // namespace runtime
@@ -24,11 +24,15 @@
 #include <tvm/ffi/function.h>
 #include <tvm/ffi/reflection/registry.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <memory>
+#include <string>
 
 #include "../../support/socket.h"
 #include "rpc_endpoint.h"
 #include "rpc_local_session.h"
+#include "rpc_mux.h"
 #include "rpc_session.h"
 
 namespace tvm {
@@ -60,43 +64,59 @@ class SockChannel final : public RPCChannel {
     }
     return static_cast<size_t>(n);
   }
+#if !defined(_WIN32)
+  size_t SendGather(const void* header, size_t header_size, const void* payload,
+                    size_t payload_size) final {
+    ssize_t n = sock_.SendGather(header, header_size, payload, payload_size);
+    if (n == -1) {
+      support::Socket::Error("SockChannel::SendGather");
+    }
+    return static_cast<size_t>(n);
+  }
+#endif  // !defined(_WIN32)
 
  private:
   support::TCPSocket sock_;
 };
 
-std::shared_ptr<RPCEndpoint> RPCConnect(std::string url, int port, std::string key,
-                                        bool enable_logging, ffi::PackedArgs init_seq) {
-  support::TCPSocket sock;
+// Connect to the server and run the key handshake, return the remote key.
+std::string RPCConnectSocket(const std::string& url, int port, const std::string& key,
+                             support::TCPSocket* sock) {
   support::SockAddr addr(url.c_str(), port);
-  sock.Create(addr.ss_family());
-  ICHECK(sock.Connect(addr)) << "Connect to " << addr.AsString() << " failed";
+  sock->Create(addr.ss_family());
+  ICHECK(sock->Connect(addr)) << "Connect to " << addr.AsString() << " failed";
   // hand shake
-  std::ostringstream os;
   int code = kRPCMagic;
   int keylen = static_cast<int>(key.length());
-  ICHECK_EQ(sock.SendAll(&code, sizeof(code)), sizeof(code));
-  ICHECK_EQ(sock.SendAll(&keylen, sizeof(keylen)), sizeof(keylen));
+  ICHECK_EQ(sock->SendAll(&code, sizeof(code)), sizeof(code));
+  ICHECK_EQ(sock->SendAll(&keylen, sizeof(keylen)), sizeof(keylen));
   if (keylen != 0) {
-    ICHECK_EQ(sock.SendAll(key.c_str(), keylen), keylen);
+    ICHECK_EQ(sock->SendAll(key.c_str(), keylen), keylen);
   }
-  ICHECK_EQ(sock.RecvAll(&code, sizeof(code)), sizeof(code));
+  ICHECK_EQ(sock->RecvAll(&code, sizeof(code)), sizeof(code));
   if (code == kRPCMagic + 2) {
-    sock.Close();
+    sock->Close();
     LOG(FATAL) << "URL " << url << ":" << port << " cannot find server that matches key=" << key;
   } else if (code == kRPCMagic + 1) {
-    sock.Close();
+    sock->Close();
     LOG(FATAL) << "URL " << url << ":" << port << " server already have key=" << key;
   } else if (code != kRPCMagic) {
-    sock.Close();
+    sock->Close();
     LOG(FATAL) << "URL " << url << ":" << port << " is not TVM RPC server";
   }
-  ICHECK_EQ(sock.RecvAll(&keylen, sizeof(keylen)), sizeof(keylen));
+  ICHECK_EQ(sock->RecvAll(&keylen, sizeof(keylen)), sizeof(keylen));
   std::string remote_key;
   if (keylen != 0) {
     remote_key.resize(keylen);
-    ICHECK_EQ(sock.RecvAll(&remote_key[0], keylen), keylen);
+    ICHECK_EQ(sock->RecvAll(&remote_key[0], keylen), keylen);
   }
+  return remote_key;
+}
+
+std::shared_ptr<RPCEndpoint> RPCConnect(std::string url, int port, std::string key,
+                                        bool enable_logging, ffi::PackedArgs init_seq) {
+  support::TCPSocket sock;
+  std::string remote_key = RPCConnectSocket(url, port, key, &sock);
 
   std::unique_ptr<RPCChannel> channel = std::make_unique<SockChannel>(sock);
   auto endpt = RPCEndpoint::Create(std::move(channel), key, remote_key);
@@ -105,9 +125,30 @@ std::shared_ptr<RPCEndpoint> RPCConnect(std::string url, int port, std::string k
   return endpt;
 }
 
+// Number of streams the server granted in its key, 1 when it does not multiplex.
+int RPCGrantedStreams(const std::string& remote_key) {
+  const std::string opt = " -mux=";
+  size_t pos = remote_key.find(opt);
+  if (pos == std::string::npos) return 1;
+  return std::max(1, std::atoi(remote_key.c_str() + pos + opt.length()));
+}
+
 Module RPCClientConnect(std::string url, int port, std::string key, bool enable_logging,
                         ffi::PackedArgs init_seq) {
-  auto endpt = RPCConnect(url, port, "client:" + key, enable_logging, init_seq);
+  key = "client:" + key;
+  support::TCPSocket sock;
+  std::string remote_key = RPCConnectSocket(url, port, key, &sock);
+  std::unique_ptr<RPCChannel> channel = std::make_unique<SockChannel>(sock);
+
+  // Streams share the handles of one serving process, which only holds for the
+  // default local session.
+  int num_streams = RPCGrantedStreams(remote_key);
+  if (num_streams > 1 && init_seq.size() == 0) {
+    return CreateRPCSessionModule(
+        CreateMultiplexedClientSession(std::move(channel), key, remote_key, num_streams));
+  }
+  auto endpt = RPCEndpoint::Create(std::move(channel), key, remote_key);
+  endpt->InitRemoteSession(init_seq);
   return CreateRPCSessionModule(CreateClientSession(endpt));
 }
 
@@ -117,6 +158,12 @@ TVM_DLL void RPCServerLoop(int sockfd) {
   RPCEndpoint::Create(std::make_unique<SockChannel>(sock), "SockServerLoop", "")->ServerLoop();
 }
 
+// TVM_DLL needed for MSVC
+TVM_DLL void RPCMuxServerLoop(int sockfd, int max_streams) {
+  support::TCPSocket sock(static_cast<support::TCPSocket::SockType>(sockfd));
+  RPCMuxServerLoop(std::make_unique<SockChannel>(sock), max_streams);
+}
+
 void RPCServerLoop(ffi::Function fsend, ffi::Function frecv) {
   RPCEndpoint::Create(std::make_unique<CallbackChannel>(fsend, frecv), "SockServerLoop", "")
       ->ServerLoop();
@@ -133,13 +180,17 @@ TVM_FFI_STATIC_INIT_BLOCK({
                     bool enable_logging = args[3].cast<bool>();
                     *rv = RPCClientConnect(url, port, key, enable_logging, args.Slice(4));
                   })
-      .def_packed("rpc.ServerLoop", [](ffi::PackedArgs args, ffi::Any* rv) {
-        if (auto opt_int = args[0].as<int64_t>()) {
-          RPCServerLoop(opt_int.value());
-        } else {
-          RPCServerLoop(args[0].cast<tvm::ffi::Function>(), args[1].cast<tvm::ffi::Function>());
-        }
-      });
+      .def_packed("rpc.ServerLoop",
+                  [](ffi::PackedArgs args, ffi::Any* rv) {
+                    if (auto opt_int = args[0].as<int64_t>()) {
+                      RPCServerLoop(opt_int.value());
+                    } else {
+                      RPCServerLoop(args[0].cast<tvm::ffi::Function>(),
+                                    args[1].cast<tvm::ffi::Function>());
+                    }
+                  })
+      .def("rpc.MuxServerLoop",
+           [](int sockfd, int max_streams) { RPCMuxServerLoop(sockfd, max_streams); });
 });
 
 class SimpleSockHandler : public dmlc::Stream {
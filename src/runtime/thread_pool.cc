@@ -269,6 +269,17 @@ class ThreadPool {
     Init();
   }
 
+  /*!
+   * \brief Create a pool whose tasks all run on its workers, so the thread launching on it
+   *  keeps its affinity and may differ from launch to launch.
+   */
+  ThreadPool(int num_workers, threading::ThreadGroup::AffinityMode mode,
+             const std::vector<unsigned int>& cpus)
+      : num_workers_(num_workers), exclude_worker0_(false) {
+    Init();
+    UpdateWorkerConfiguration(mode, num_workers, cpus);
+  }
+
   ~ThreadPool() {
     for (std::unique_ptr<SpscTaskQueue>& q : queues_) {
       q->SignalForKill();
@@ -290,6 +301,8 @@ class ThreadPool {
     ParallelLauncher* launcher = ParallelLauncher::ThreadLocal();
     ICHECK(!launcher->is_worker)
         << "Cannot launch parallel job inside worker, consider fuse then parallel";
+    // The workers take one job at a time, launches from different threads take turns.
+    std::lock_guard<std::mutex> lock(launch_mutex_);
     if (num_task == 0) {
       num_task = num_workers_used_;
     }
@@ -333,6 +346,12 @@ class ThreadPool {
 
   int32_t NumThreads() const { return num_workers_used_; }
 
+  /*! \brief Recreate the workers with a different worker count. */
+  void Resize(int num_workers) {
+    num_workers_ = num_workers;
+    Reset();
+  }
+
  private:
   // Shared initialization code
   void Init() {
@@ -373,8 +392,36 @@ class ThreadPool {
   bool exclude_worker0_{true};
   std::vector<std::unique_ptr<SpscTaskQueue>> queues_;
   std::unique_ptr<tvm::runtime::threading::ThreadGroup> threads_;
+  // serializes launches from different threads
+  std::mutex launch_mutex_;
 };
 
+// Run a parallel job as a single task on the calling thread.
+static int ParallelLaunchSerial(FTVMParallelLambda flambda, void* cdata) {
+  std::atomic<int32_t> sync_counter{0};
+  TVMParallelGroupEnv env;
+  env.num_task = 1;
+  env.sync_handle = &sync_counter;
+  (*flambda)(0, &env, cdata);
+  return 0;
+}
+
+#if TVM_THREADPOOL_USE_OPENMP
+// Run a parallel job on the OpenMP threads.
+static int ParallelLaunchOMP(FTVMParallelLambda flambda, void* cdata, int num_task,
+                             int num_workers) {
+  if (num_task == 0) num_task = num_workers;
+  omp_set_num_threads(num_task);
+#pragma omp parallel num_threads(num_task)
+  {
+    TVMParallelGroupEnv env;
+    env.num_task = num_task;
+    (*flambda)(omp_get_thread_num(), &env, cdata);
+  }
+  return 0;
+}
+#endif
+
 /*!
  * \brief args[0] is the AffinityMode, args[1] is the number of threads.
  *  args2 is a list of CPUs which is used to set the CPU affinity.
@@ -398,7 +445,17 @@ TVM_FFI_STATIC_INIT_BLOCK({
                     }
                     threading::Configure(mode, nthreads, cpus);
                   })
-      .def("runtime.NumThreads", []() -> int32_t { return threading::NumThreads(); });
+      .def("runtime.NumThreads", []() -> int32_t { return threading::NumThreads(); })
+      .def("runtime.BindToNumaNode", threading::BindToNumaNode)
+      .def("runtime.CurrentNumaNode", threading::CurrentNumaNode)
+      .def("runtime.WorkerPool",
+           [](int nthreads, ffi::Array<int64_t> cpus, int mode) {
+             return threading::WorkerPool(
+                 nthreads, std::vector<unsigned int>(cpus.begin(), cpus.end()),
+                 static_cast<threading::ThreadGroup::AffinityMode>(mode));
+           })
+      .def("runtime.WorkerPoolNumThreads",
+           [](threading::WorkerPool pool) { return pool->NumThreads(); });
 });
 
 namespace threading {
@@ -471,36 +528,112 @@ TVM_DLL void Configure(tvm::runtime::threading::ThreadGroup::AffinityMode mode,
   ConfigureOMP(mode, nthreads, cpus);
 #endif
 }
-int32_t NumThreads() { return tvm::runtime::ThreadPool::ThreadLocal()->NumThreads(); }
+int32_t NumThreads() {
+  if (WorkerPoolNode* pool = WorkerPoolScope::Current()) return pool->NumThreads();
+  return tvm::runtime::ThreadPool::ThreadLocal()->NumThreads();
+}
+
+// The NUMA node the thread pool of the calling thread is bound to.
+static thread_local int current_numa_node = -1;
+
+int BindToNumaNode(int node, int nthreads) {
+  const std::vector<NumaNode>& nodes = NumaNodes();
+  auto it = std::find_if(nodes.begin(), nodes.end(),
+                         [node](const NumaNode& n) { return n.id == node; });
+  ICHECK(it != nodes.end()) << "NUMA node " << node << " does not exist";
+  ICHECK(!it->cpus.empty()) << "NUMA node " << node << " has no CPU this process may run on";
+  ICHECK_GE(nthreads, 0) << "The number of threads cannot be negative";
+  if (nthreads == 0) nthreads = it->num_cores;
+  nthreads = std::min(nthreads, static_cast<int>(it->cpus.size()));
+  SetMaxConcurrency(nthreads);
+#if !TVM_THREADPOOL_USE_OPENMP
+  ThreadPool* pool = tvm::runtime::ThreadPool::ThreadLocal();
+  pool->Resize(nthreads);
+  pool->UpdateWorkerConfiguration(ThreadGroup::kSpecifyOneCorePerThread, nthreads, it->cpus);
+#else
+  ConfigureOMP(ThreadGroup::kSpecifyOneCorePerThread, nthreads, it->cpus);
+#endif
+  current_numa_node = node;
+  return nthreads;
+}
+
+int CurrentNumaNode() { return current_numa_node; }
+
+// A WorkerPool is a ThreadPool whose tasks all run on its own workers.
+class WorkerPoolNode::Impl : public ThreadPool {
+ public:
+  using ThreadPool::ThreadPool;
+};
+
+TVM_REGISTER_OBJECT_TYPE(WorkerPoolNode);
+
+WorkerPoolNode::~WorkerPoolNode() = default;
+
+WorkerPool::WorkerPool(int nthreads, std::vector<unsigned int> cpus,
+                       ThreadGroup::AffinityMode mode) {
+  ICHECK_GE(nthreads, 0) << "The number of threads cannot be negative";
+  ICHECK(mode == ThreadGroup::kSpecifyOneCorePerThread ||
+         mode == ThreadGroup::kSpecifyThreadShareAllCore)
+      << "A worker pool is placed with kSpecifyOneCorePerThread or kSpecifyThreadShareAllCore";
+  if (nthreads == 0) {
+    nthreads = cpus.empty() ? MaxConcurrency() : static_cast<int>(cpus.size());
+  }
+  if (cpus.empty()) {
+    // Let the workers float over every CPU the process may run on.
+    for (const NumaNode& node : NumaNodes()) {
+      cpus.insert(cpus.end(), node.cpus.begin(), node.cpus.end());
+    }
+    mode = ThreadGroup::kSpecifyThreadShareAllCore;
+  }
+  auto n = make_object<WorkerPoolNode>();
+  n->num_threads_ = nthreads;
+#if !TVM_THREADPOOL_USE_OPENMP
+  n->impl_ = std::make_unique<WorkerPoolNode::Impl>(nthreads, mode, cpus);
+#endif
+  data_ = std::move(n);
+}
+
+int WorkerPoolNode::Launch(FTVMParallelLambda flambda, void* cdata, int num_task) {
+  if (num_threads_ == 1) {
+    return ParallelLaunchSerial(flambda, cdata);
+  }
+#if !TVM_THREADPOOL_USE_OPENMP
+  return impl_->Launch(flambda, cdata, num_task, 1);
+#else
+  return ParallelLaunchOMP(flambda, cdata, num_task, num_threads_);
+#endif
+}
+
+// The pool the parallel launches of the calling thread go to.
+static thread_local WorkerPoolNode* current_worker_pool = nullptr;
+
+WorkerPoolScope::WorkerPoolScope(ffi::Optional<WorkerPool> pool)
+    : pool_(std::move(pool)), prev_(current_worker_pool) {
+  if (pool_.defined()) {
+    current_worker_pool = const_cast<WorkerPoolNode*>(pool_.value().get());
+  }
+}
+
+WorkerPoolScope::~WorkerPoolScope() { current_worker_pool = prev_; }
+
+WorkerPoolNode* WorkerPoolScope::Current() { return current_worker_pool; }
 }  // namespace threading
 }  // namespace runtime
 }  // namespace tvm
 
 int TVMBackendParallelLaunch(FTVMParallelLambda flambda, void* cdata, int num_task) {
+  if (auto* pool = tvm::runtime::threading::WorkerPoolScope::Current()) {
+    return pool->Launch(flambda, cdata, num_task);
+  }
   int num_workers = tvm::runtime::threading::MaxConcurrency();
   if (num_workers == 1) {
-    std::atomic<int32_t> sync_counter{0};
-    TVMParallelGroupEnv env;
-    env.num_task = 1;
-    env.sync_handle = &sync_counter;
-    (*flambda)(0, &env, cdata);
-    return 0;
-  } else {
+    return tvm::runtime::ParallelLaunchSerial(flambda, cdata);
+  }
 #if !TVM_THREADPOOL_USE_OPENMP
-    int res = tvm::runtime::ThreadPool::ThreadLocal()->Launch(flambda, cdata, num_task, 1);
-    return res;
+  return tvm::runtime::ThreadPool::ThreadLocal()->Launch(flambda, cdata, num_task, 1);
 #else
-    if (num_task == 0) num_task = num_workers;
-    omp_set_num_threads(num_task);
-#pragma omp parallel num_threads(num_task)
-    {
-      TVMParallelGroupEnv env;
-      env.num_task = num_task;
-      (*flambda)(omp_get_thread_num(), &env, cdata);
-    }
-    return 0;
+  return tvm::runtime::ParallelLaunchOMP(flambda, cdata, num_task, num_workers);
 #endif
-  }
 }
 
 int TVMBackendParallelBarrier(int task_id, TVMParallelGroupEnv* penv) {
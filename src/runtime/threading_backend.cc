@@ -21,12 +21,15 @@
  * \file threading_backend.cc
  * \brief Native threading backend
  */
+#include <tvm/ffi/container/map.h>
 #include <tvm/ffi/container/shape.h>
 #include <tvm/ffi/function.h>
 #include <tvm/ffi/reflection/registry.h>
 #include <tvm/runtime/logging.h>
 #include <tvm/runtime/threading_backend.h>
 
+#include "../support/utils.h"
+
 #if defined(__linux__) || defined(__ANDROID__)
 #if __ANDROID_API__ >= 21
 #include <pthread.h>
@@ -36,6 +39,7 @@
 #else
 #endif
 #if defined(__linux__)
+#include <dirent.h>
 #include <sched.h>
 #endif
 #if defined(__hexagon__)
@@ -49,7 +53,10 @@ extern "C" {
 #define HEXAGON_STACK_ALIGNMENT 32
 #endif
 #include <algorithm>
+#include <set>
+#include <string>
 #include <thread>
+#include <utility>
 #define CURRENT_THREAD_HANDLE (static_cast<std::thread::native_handle_type>(0))
 namespace tvm {
 namespace runtime {
@@ -436,6 +443,101 @@ int MaxConcurrency() {
   return std::max(max_concurrency, 1);
 }
 
+#if defined(__linux__) || defined(__ANDROID__)
+// Parse a sysfs CPU list such as "0-3,8,10-11".
+static std::vector<unsigned int> ParseCpuList(const std::string& list) {
+  std::vector<unsigned int> cpus;
+  std::istringstream is(list);
+  std::string range;
+  while (std::getline(is, range, ',')) {
+    size_t dash = range.find('-');
+    try {
+      unsigned int first = std::stoul(range.substr(0, dash));
+      unsigned int last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+      for (unsigned int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    } catch (const std::exception&) {
+      // Skip the trailing newline and anything else that is not a range.
+    }
+  }
+  return cpus;
+}
+
+static std::vector<unsigned int> ReadCpuList(const std::string& path) {
+  std::ifstream ifs(path);
+  std::string list;
+  if (ifs.fail() || !std::getline(ifs, list)) return {};
+  return ParseCpuList(list);
+}
+#endif
+
+static std::vector<NumaNode> DiscoverNumaNodes() {
+  std::vector<NumaNode> nodes;
+  std::set<unsigned int> allowed;
+#if defined(__linux__) || defined(__ANDROID__)
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+    for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &mask)) allowed.insert(cpu);
+    }
+  }
+#endif
+  if (allowed.empty()) {
+    for (unsigned int cpu = 0; cpu < std::thread::hardware_concurrency(); ++cpu) {
+      allowed.insert(cpu);
+    }
+  }
+#if defined(__linux__)
+  const std::string root = "/sys/devices/system/node/";
+  if (DIR* dir = opendir(root.c_str())) {
+    while (dirent* entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name.compare(0, 4, "node") != 0 || !support::IsNumber(name.substr(4))) continue;
+      NumaNode node;
+      node.id = std::stoi(name.substr(4));
+      for (unsigned int cpu : ReadCpuList(root + name + "/cpulist")) {
+        if (allowed.count(cpu)) node.cpus.push_back(cpu);
+      }
+      nodes.push_back(std::move(node));
+    }
+    closedir(dir);
+  }
+#endif
+  if (nodes.empty()) {
+    nodes.push_back(NumaNode{0, std::vector<unsigned int>(allowed.begin(), allowed.end()), 0});
+  }
+  std::sort(nodes.begin(), nodes.end(),
+            [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+  // Put one hyper-thread of every physical core first, so that a pool smaller than
+  // the node does not pin two workers onto the same core.
+  for (NumaNode& node : nodes) {
+    std::vector<unsigned int> cores, siblings;
+    for (unsigned int cpu : node.cpus) {
+      bool first_of_core = true;
+#if defined(__linux__) || defined(__ANDROID__)
+      std::vector<unsigned int> core = ReadCpuList("/sys/devices/system/cpu/cpu" +
+                                                   std::to_string(cpu) +
+                                                   "/topology/thread_siblings_list");
+      for (unsigned int sibling : core) {
+        if (sibling < cpu && std::count(node.cpus.begin(), node.cpus.end(), sibling)) {
+          first_of_core = false;
+        }
+      }
+#endif
+      (first_of_core ? cores : siblings).push_back(cpu);
+    }
+    node.num_cores = static_cast<int>(cores.size());
+    node.cpus = std::move(cores);
+    node.cpus.insert(node.cpus.end(), siblings.begin(), siblings.end());
+  }
+  return nodes;
+}
+
+const std::vector<NumaNode>& NumaNodes() {
+  static const std::vector<NumaNode> nodes = DiscoverNumaNodes();
+  return nodes;
+}
+
 // This global function can be used by disco runtime to bind processes
 // to CPUs.
 TVM_FFI_STATIC_INIT_BLOCK({
@@ -445,6 +547,13 @@ TVM_FFI_STATIC_INIT_BLOCK({
         SetThreadAffinity(CURRENT_THREAD_HANDLE,
                           std::vector<unsigned int>{cpu_ids.begin(), cpu_ids.end()});
       });
+  refl::GlobalDef().def("runtime.NumaNodes", []() {
+    ffi::Map<int64_t, ffi::Shape> res;
+    for (const NumaNode& node : NumaNodes()) {
+      res.Set(node.id, ffi::Shape(node.cpus.begin(), node.cpus.end()));
+    }
+    return res;
+  });
 });
 
 }  // namespace threading
@@ -0,0 +1,296 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file src/runtime/vm/cpu_exec_plan_builtin.cc
+ * \brief The CPU execution plan related builtin functions for Relax virtual machine.
+ *
+ * This is the CPU counterpart of CUDA graph. The static regions lifted by the
+ * RewriteCUDAGraph pass are run once by the VM while it records the packed function
+ * calls they make. The kernel calls are kept in a flat plan together with their
+ * arguments, and the later runs of the region call the kernels from the plan directly,
+ * without interpreting the bytecode, checking shapes or allocating tensors.
+ */
+
+#include <tvm/ffi/container/array.h>
+#include <tvm/ffi/function.h>
+#include <tvm/ffi/reflection/registry.h>
+#include <tvm/runtime/vm/vm.h>
+
+#include <string>
+#include <unordered_set>
+
+#include "../../support/utils.h"
+
+namespace tvm {
+namespace runtime {
+namespace vm {
+
+namespace {
+
+struct CPUExecPlanKey {
+  // The unique index of the capture function within the module
+  int64_t index;
+  // The symbolic variables the capture function depends on. A plan is captured for each
+  // value of them.
+  ffi::Shape shape_expr;
+
+  CPUExecPlanKey(int64_t index, const Optional<ffi::Shape>& shape_expr) : index(index) {
+    if (shape_expr) {
+      this->shape_expr = shape_expr.value();
+    }
+  }
+};
+
+struct CPUExecPlanKeyHash {
+  size_t operator()(const CPUExecPlanKey& key) const {
+    std::hash<int64_t> hash_fn;
+    size_t hash = hash_fn(key.index);
+    for (const auto& shape : key.shape_expr) {
+      support::HashCombine(hash, hash_fn(shape));
+    }
+    return hash;
+  }
+};
+
+struct CPUExecPlanKeyEqual {
+  bool operator()(const CPUExecPlanKey& lhs, const CPUExecPlanKey& rhs) const {
+    return lhs.index == rhs.index && std::equal(lhs.shape_expr.begin(), lhs.shape_expr.end(),
+                                                rhs.shape_expr.begin(), rhs.shape_expr.end());
+  }
+};
+
+/*! \brief A kernel call in the plan. */
+struct CPUExecPlanStep {
+  /*! \brief The kernel. */
+  ffi::Function func;
+  /*! \brief The arguments, which keep the tensors of the captured run alive. */
+  std::vector<ffi::Any> args;
+  /*! \brief The views of the arguments, ready to be passed to the kernel. */
+  std::vector<ffi::AnyView> arg_views;
+};
+
+/*! \brief The captured execution plan of a static region. */
+struct CPUExecPlan {
+  /*!
+   * \brief Tuple of intemediate tensors in the capture func that will be used outside the
+   * capture func
+   */
+  ObjectRef states;
+  /*! \brief The kernel calls, in the order of execution. */
+  std::vector<CPUExecPlanStep> steps;
+  /*!
+   * \brief Whether the calls were recorded. The functions compiled to TIR by the VM do not
+   * go through the bytecode interpreter, and are run without a plan.
+   */
+  bool recorded = false;
+};
+
+/*!
+ * \brief Check whether the VM builtin only allocates, views or checks the shape of tensors,
+ * so that its call is not kept in the plan. Other builtins, such as vm.builtin.call_tir_dyn
+ * that launches the kernels of call_tir with tir_vars, are replayed like the kernels.
+ */
+bool IsCapturedOnlyBuiltin(const std::string& func_symbol) {
+  static const std::unordered_set<std::string> builtins = {
+      "vm.builtin.alloc_shape_heap",
+      "vm.builtin.alloc_storage",
+      "vm.builtin.alloc_tensor",
+      "vm.builtin.check_func_info",
+      "vm.builtin.check_prim_value_info",
+      "vm.builtin.check_shape_info",
+      "vm.builtin.check_tensor_info",
+      "vm.builtin.check_tuple_info",
+      "vm.builtin.make_prim_value",
+      "vm.builtin.make_shape",
+      "vm.builtin.make_tuple",
+      "vm.builtin.match_prim_value",
+      "vm.builtin.match_shape",
+      "vm.builtin.null_value",
+      "vm.builtin.reshape",
+      "vm.builtin.shape_of",
+      "vm.builtin.tuple_getitem",
+  };
+  return builtins.count(func_symbol);
+}
+
+/*! \brief Record the packed function calls of the VM for the lifetime of the object. */
+class VMCallRecordScope {
+ public:
+  VMCallRecordScope(VirtualMachine* vm, std::vector<VMRecordedCall>* calls) : vm_(vm) {
+    vm_->SetCallRecorder(calls);
+  }
+  ~VMCallRecordScope() { vm_->SetCallRecorder(nullptr); }
+
+ private:
+  VirtualMachine* vm_;
+};
+
+}  // namespace
+
+/*! \brief The VM extension of CPU execution plans. */
+class CPUExecPlanExtensionNode : public VMExtensionNode {
+ public:
+  TVM_DECLARE_FINAL_OBJECT_INFO(CPUExecPlanExtensionNode, VMExtensionNode);
+
+  /*!
+   * \brief Replay the execution plan if it has been captured, otherwise run the capture
+   * function and capture the plan.
+   * \param vm The virtual machine.
+   * \param capture_func The function of type (args...) -> Tuple[ObjectRef], where 'args' are the
+   * static arguments that are the same for all invocations of the capture function, the returned
+   * tuple contains the intermediate tensors that will be used outside the capture function.
+   * \param args The static arguments of the capture function
+   * \param entry_index The unique index of the capture function used for lookup.
+   * \return The return value of the capture function.
+   */
+  ObjectRef RunOrCapture(VirtualMachine* vm, const ObjectRef& capture_func, ObjectRef args,
+                         int64_t entry_index, Optional<ffi::Shape> shape_expr) {
+    CPUExecPlanKey entry_key{entry_index, shape_expr};
+    auto it = capture_cache_.find(entry_key);
+    if (it != capture_cache_.end() && it->second.recorded) {
+      const CPUExecPlan& plan = it->second;
+      ffi::Any rv;
+      for (const CPUExecPlanStep& step : plan.steps) {
+        step.func.CallPacked(step.arg_views.data(), step.arg_views.size(), &rv);
+      }
+      return plan.states;
+    }
+
+    Array<ObjectRef> tuple_args = Downcast<Array<ObjectRef>>(args);
+    int nargs = static_cast<int>(tuple_args.size());
+    std::vector<AnyView> packed_args(nargs);
+    for (int i = 0; i < nargs; ++i) {
+      packed_args[i] = tuple_args[i];
+    }
+
+    if (it != capture_cache_.end()) {
+      ffi::Any rv;
+      vm->InvokeClosurePacked(capture_func, ffi::PackedArgs(packed_args.data(), nargs), &rv);
+      return rv.cast<ObjectRef>();
+    }
+
+    std::vector<VMRecordedCall> calls;
+    ffi::Any capture_func_rv;
+    {
+      VMCallRecordScope record_scope(vm, &calls);
+      vm->InvokeClosurePacked(capture_func, ffi::PackedArgs(packed_args.data(), nargs),
+                              &capture_func_rv);
+    }
+
+    CPUExecPlan plan;
+    plan.states = capture_func_rv.cast<ObjectRef>();
+    plan.recorded = !calls.empty();
+    for (VMRecordedCall& call : calls) {
+      // The allocation, view and shape builtins of the region give the same objects in every
+      // run of a plan. The objects of the captured run are held by the arguments of the kernels
+      // and by the states, so these builtins do not need to run again.
+      if (IsCapturedOnlyBuiltin(call.func_symbol)) {
+        continue;
+      }
+      CPUExecPlanStep step;
+      step.func = std::move(call.func);
+      step.args = std::move(call.args);
+      step.arg_views.assign(step.args.begin(), step.args.end());
+      plan.steps.push_back(std::move(step));
+    }
+
+    ObjectRef states = plan.states;
+    capture_cache_[entry_key] = std::move(plan);
+    return states;
+  }
+
+  /*!
+   * \brief Get the cached allocation from the cache or run the allocation function.
+   * \param vm The virtual machine.
+   * \param alloc_func The function of type () -> ObjectRef, where the returned object is the
+   * tuple of allocated storage objects.
+   * \param entry_index The unique index of the allocation function used for lookup.
+   */
+  ObjectRef GetCachedAllocation(VirtualMachine* vm, const ObjectRef& alloc_func,
+                                int64_t entry_index) {
+    if (auto it = alloc_cache_.find(entry_index); it != alloc_cache_.end()) {
+      return it->second;
+    }
+    ffi::Any alloc_func_rv;
+    vm->InvokeClosurePacked(alloc_func, ffi::PackedArgs(nullptr, 0), &alloc_func_rv);
+    ObjectRef alloc_result = alloc_func_rv.cast<ObjectRef>();
+    alloc_cache_[entry_index] = alloc_result;
+    return alloc_result;
+  }
+
+  static constexpr const char* _type_key = "vm.CPUExecPlanExtension";
+
+ private:
+  /*!
+   * \brief The cache of captured plans. The key is a unique index for the capture function.
+   * The value is the result of the capture.
+   */
+  std::unordered_map<CPUExecPlanKey, CPUExecPlan, CPUExecPlanKeyHash, CPUExecPlanKeyEqual>
+      capture_cache_;
+  /*!
+   * \brief The cache of allocations. The key is a unique index for the allocation function.
+   * The value is the cached allocations, which is a tuple of storages.
+   */
+  std::unordered_map<int64_t, ObjectRef> alloc_cache_;
+};
+
+/*! Managed reference to CPUExecPlanExtensionNode */
+class CPUExecPlanExtension : public VMExtension {
+ public:
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(CPUExecPlanExtension, VMExtension,
+                                        CPUExecPlanExtensionNode);
+  static CPUExecPlanExtension Create() {
+    auto data_ = make_object<CPUExecPlanExtensionNode>();
+    return CPUExecPlanExtension(std::move(data_));
+  }
+};
+
+TVM_FFI_STATIC_INIT_BLOCK({
+  namespace refl = tvm::ffi::reflection;
+  refl::GlobalDef()
+      .def_packed("vm.builtin.cpu_exec_plan.run_or_capture",
+                  [](ffi::PackedArgs args, ffi::Any* rv) {
+                    ICHECK(args.size() == 5 || args.size() == 4);
+                    VirtualMachine* vm = VirtualMachine::GetContextPtr(args[0]);
+                    auto extension = vm->GetOrCreateExtension<CPUExecPlanExtension>();
+                    auto capture_func = args[1].cast<ObjectRef>();
+                    auto func_args = args[2].cast<ObjectRef>();
+                    int64_t entry_index = args[3].cast<int64_t>();
+                    Optional<ffi::Shape> shape_expr = std::nullopt;
+                    if (args.size() == 5) {
+                      shape_expr = args[4].cast<ffi::Shape>();
+                    }
+                    *rv = extension->RunOrCapture(vm, capture_func, func_args, entry_index,
+                                                  shape_expr);
+                  })
+      .def_packed("vm.builtin.cpu_exec_plan.get_cached_alloc",
+                  [](ffi::PackedArgs args, ffi::Any* rv) {
+                    ICHECK_EQ(args.size(), 3);
+                    VirtualMachine* vm = VirtualMachine::GetContextPtr(args[0]);
+                    auto extension = vm->GetOrCreateExtension<CPUExecPlanExtension>();
+                    auto alloc_func = args[1].cast<ObjectRef>();
+                    int64_t entry_index = args[2].cast<int64_t>();
+                    *rv = extension->GetCachedAllocation(vm, alloc_func, entry_index);
+                  });
+});
+
+}  // namespace vm
+}  // namespace runtime
+}  // namespace tvm
@@ -44,7 +44,14 @@
 #include <tvm/runtime/ndarray.h>
 #include <tvm/runtime/vm/ndarray_cache_support.h>
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <list>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "../../support/utils.h"
@@ -300,6 +307,270 @@ TVM_FFI_STATIC_INIT_BLOCK({
       .def("vm.builtin.ndarray_cache.load", NDArrayCache::Load);
 });
 
+/*!
+ * \brief Stream the parameters of an NDArray cache shard by shard.
+ *
+ * Unlike NDArrayCache::Load, which keeps every parameter of the cache alive, the stream
+ * loads a parameter only when it is requested and does not keep a reference to it. Used
+ * as the `fget_param` of a lazy parameter transform (see `relax.transform.LazyGetInput`),
+ * each source weight is freed once the VM drops it, which KillAfterLastUse of the default
+ * pipeline makes happen right after its last use. The stream records the peak size of the
+ * parameters alive at the same time, so that the bound can be checked.
+ *
+ * Only the raw bytes of at most `max_resident_shards` shards are kept in memory. A shard
+ * is released as soon as all of its parameters have been read. The next unread shard of
+ * the cache is read in the background while the current one is consumed, and counts
+ * against the limit: with `max_resident_shards` of 1 the shards are read one at a time
+ * without overlap, so at least 2 are needed to overlap reading with the transform.
+ */
+class NDArrayCacheStreamObj : public Object {
+ public:
+  /*!
+   * \brief Load the parameter with the given name.
+   * \param name The name of the parameter in the cache.
+   */
+  NDArray Get(const std::string& name) {
+    auto it = param_location_.find(name);
+    CHECK(it != param_location_.end())
+        << "ValueError: Cannot find parameter in the NDArray cache: " << name;
+    return Load(it->second.first, it->second.second);
+  }
+
+  /*!
+   * \brief Load the parameter at the given position of the cache.
+   * \param index The index of the parameter, in the order of the records of the cache.
+   */
+  NDArray GetByIndex(int64_t index) {
+    CHECK(index >= 0 && index < static_cast<int64_t>(param_order_.size()))
+        << "IndexError: The parameter index " << index << " is out of range, the NDArray cache"
+        << " has " << param_order_.size() << " parameters";
+    return Load(param_order_[index].first, param_order_[index].second);
+  }
+
+  /*! \return The peak number of bytes of the loaded parameters alive at the same time. */
+  int64_t PeakLiveBytes() const { return live_bytes_->peak.load(); }
+
+  static constexpr const char* _type_key = "vm.NDArrayCacheStream";
+  TVM_DECLARE_FINAL_OBJECT_INFO(NDArrayCacheStreamObj, Object);
+
+ private:
+  using FileRecord = NDArrayCacheMetadata::FileRecord;
+
+  /*! \brief The loading state of a shard. */
+  struct ShardState {
+    /*! \brief The raw bytes of the shard, nullptr if the shard is not in memory. */
+    std::shared_ptr<std::string> raw_data;
+    /*! \brief The background read of the shard, if there is one. */
+    std::future<std::shared_ptr<std::string>> prefetch;
+    /*! \brief Whether each parameter of the shard has been read. */
+    std::vector<bool> consumed;
+    /*! \brief The number of parameters in the shard that have not been read. */
+    int num_unread = 0;
+  };
+
+  /*! \brief The number of bytes of the loaded parameters that are alive. */
+  struct LiveBytes {
+    std::atomic<int64_t> current{0};
+    std::atomic<int64_t> peak{0};
+  };
+
+  /*!
+   * \brief Allocator of the arrays returned by the stream, which are views of the loaded
+   * parameters that count the bytes alive.
+   */
+  struct TrackedParamAlloc {
+    NDArray param;
+    std::shared_ptr<LiveBytes> live_bytes;
+
+    void AllocData(DLTensor* tensor) {
+      tensor->data = param->data;
+      tensor->byte_offset = param->byte_offset;
+      int64_t current = live_bytes->current += ffi::GetDataSize(*tensor);
+      int64_t peak = live_bytes->peak.load();
+      while (current > peak && !live_bytes->peak.compare_exchange_weak(peak, current)) {
+      }
+    }
+    void FreeData(DLTensor* tensor) { live_bytes->current -= ffi::GetDataSize(*tensor); }
+  };
+
+  /*! \brief Read the raw bytes of a shard from the file. */
+  static std::shared_ptr<std::string> ReadShard(const std::string& path_prefix,
+                                                const FileRecord* file) {
+    auto raw_data = std::make_shared<std::string>();
+    LoadBinaryFromFile(path_prefix + "/" + file->data_path, raw_data.get());
+    CHECK_EQ(file->format, "raw-shard") << "ValueError: Only `raw-shard` format is supported";
+    CHECK_EQ(file->nbytes, raw_data->length())
+        << "ValueError: Encountered an corrupted parameter shard " << file->data_path;
+    return raw_data;
+  }
+
+  NDArray Load(int shard_index, int record_index) {
+    std::shared_ptr<std::string> raw_data = AcquireShard(shard_index);
+    // Start reading the next shard before decoding, so that the file I/O overlaps with the
+    // decoding and with the transform of this parameter.
+    Prefetch(shard_index);
+    const FileRecord& file = metadata_.records[shard_index];
+    NDArray param;
+    try {
+      param = file.records[record_index].Load(device_, raw_data.get(), &staging_buffer_);
+    } catch (const dmlc::Error& e) {
+      LOG(FATAL) << "ValueError: Error when loading parameters from " << file.data_path << ": "
+                 << e.what();
+    }
+    ShardState& shard = shards_[shard_index];
+    if (!shard.consumed[record_index]) {
+      shard.consumed[record_index] = true;
+      --shard.num_unread;
+    }
+    if (shard.num_unread == 0) {
+      ReleaseShard(shard_index);
+    }
+    return NDArray::FromNDAlloc(TrackedParamAlloc{param, live_bytes_}, param.Shape(),
+                                param->dtype, param->device);
+  }
+
+  /*! \brief Make the raw bytes of the shard resident, evicting the least recently used ones. */
+  std::shared_ptr<std::string> AcquireShard(int shard_index) {
+    auto it = std::find(resident_.begin(), resident_.end(), shard_index);
+    if (it != resident_.end()) {
+      resident_.erase(it);
+    } else {
+      while (static_cast<int>(resident_.size()) >= max_resident_shards_) {
+        ReleaseShard(resident_.front());
+      }
+    }
+    resident_.push_back(shard_index);
+    ShardState& shard = shards_[shard_index];
+    if (shard.raw_data == nullptr) {
+      if (shard.prefetch.valid()) {
+        shard.raw_data = shard.prefetch.get();
+      } else {
+        shard.raw_data = ReadShard(metadata_.path, &metadata_.records[shard_index]);
+      }
+    }
+    return shard.raw_data;
+  }
+
+  /*!
+   * \brief Drop the raw bytes of the shard. An evicted shard that still has unread
+   * parameters is read again when one of them is requested.
+   */
+  void ReleaseShard(int shard_index) {
+    resident_.remove(shard_index);
+    ShardState& shard = shards_[shard_index];
+    if (shard.prefetch.valid()) {
+      shard.prefetch.wait();
+      shard.prefetch = std::future<std::shared_ptr<std::string>>();
+    }
+    shard.raw_data.reset();
+  }
+
+  /*! \brief Start reading the first unread shard after the given one in the background. */
+  void Prefetch(int shard_index) {
+    if (static_cast<int>(resident_.size()) >= max_resident_shards_) {
+      return;
+    }
+    for (int i = shard_index + 1; i < static_cast<int>(shards_.size()); ++i) {
+      ShardState& shard = shards_[i];
+      if (shard.num_unread == 0 || shard.raw_data != nullptr) continue;
+      if (!shard.prefetch.valid()) {
+        shard.prefetch = std::async(std::launch::async, ReadShard, metadata_.path,
+                                    &metadata_.records[i]);
+        resident_.push_back(i);
+      }
+      return;
+    }
+  }
+
+  /*! \brief The metadata loaded from `ndarray-cache.json` */
+  NDArrayCacheMetadata metadata_;
+  /*! \brief The device to load the parameters onto */
+  Device device_;
+  /*! \brief The maximum number of shards whose raw bytes are kept in memory */
+  int max_resident_shards_;
+  /*! \brief The loading state of each shard */
+  std::vector<ShardState> shards_;
+  /*! \brief The shards in memory or being read, from the least to the most recently used */
+  std::list<int> resident_;
+  /*! \brief Maps the name of a parameter to its shard and its index in the shard */
+  std::unordered_map<std::string, std::pair<int, int>> param_location_;
+  /*! \brief The shard and the index in the shard of each parameter, in the cache order */
+  std::vector<std::pair<int, int>> param_order_;
+  /*! \brief The staging buffer for OpenCL copies */
+  Optional<NDArray> staging_buffer_;
+  /*! \brief The bytes of the loaded parameters that are alive */
+  std::shared_ptr<LiveBytes> live_bytes_ = std::make_shared<LiveBytes>();
+
+  friend class NDArrayCacheStream;
+};
+
+/*! \brief Managed reference to NDArrayCacheStreamObj */
+class NDArrayCacheStream : public ObjectRef {
+ public:
+  /*!
+   * \brief Open a stream over the NDArray cache.
+   * \param cache_path The path to the NDArray cache.
+   * \param device_type The type of device to be loaded.
+   * \param device_id The device id.
+   * \param max_resident_shards The maximum number of shards kept in memory at the same time,
+   *  including the shard read in the background.
+   */
+  static NDArrayCacheStream Create(const std::string& cache_path, int device_type, int device_id,
+                                   int max_resident_shards) {
+    CHECK_GE(max_resident_shards, 1) << "ValueError: At least one shard must be kept in memory";
+    ObjectPtr<NDArrayCacheStreamObj> n = make_object<NDArrayCacheStreamObj>();
+    n->metadata_ = NDArrayCacheMetadata::Load(cache_path);
+    n->device_ = DLDevice{static_cast<DLDeviceType>(device_type), device_id};
+    n->max_resident_shards_ = max_resident_shards;
+    n->shards_.resize(n->metadata_.records.size());
+    for (int i = 0; i < static_cast<int>(n->metadata_.records.size()); ++i) {
+      const auto& records = n->metadata_.records[i].records;
+      n->shards_[i].consumed.assign(records.size(), false);
+      n->shards_[i].num_unread = static_cast<int>(records.size());
+      for (int j = 0; j < static_cast<int>(records.size()); ++j) {
+        n->param_location_[records[j].name] = {i, j};
+        n->param_order_.emplace_back(i, j);
+      }
+    }
+    return NDArrayCacheStream(std::move(n));
+  }
+
+  /*!
+   * \brief Get a function that can be used as the `fget_param` of a lazy parameter transform.
+   * It is called with the index of the parameter and, optionally, its name. The parameter is
+   * looked up by name when the name is given, and by its position in the cache otherwise.
+   */
+  ffi::Function AsFGetParam() const {
+    NDArrayCacheStream self = *this;
+    return ffi::Function([self](ffi::PackedArgs args, ffi::Any* rv) {
+      CHECK(args.size() == 1 || args.size() == 2)
+          << "TypeError: fget_param expects the index and optionally the name of the parameter, "
+          << "but gets " << args.size() << " arguments";
+      if (args.size() == 2) {
+        *rv = self->Get(args[1].cast<String>());
+      } else {
+        *rv = self->GetByIndex(args[0].cast<int64_t>());
+      }
+    });
+  }
+
+  TVM_DEFINE_MUTABLE_OBJECT_REF_METHODS(NDArrayCacheStream, ObjectRef, NDArrayCacheStreamObj);
+};
+
+TVM_REGISTER_OBJECT_TYPE(NDArrayCacheStreamObj);
+
+TVM_FFI_STATIC_INIT_BLOCK({
+  namespace refl = tvm::ffi::reflection;
+  refl::GlobalDef()
+      .def("vm.builtin.ndarray_cache_stream.create", NDArrayCacheStream::Create)
+      .def("vm.builtin.ndarray_cache_stream.get",
+           [](NDArrayCacheStream stream, String name) { return stream->Get(name); })
+      .def("vm.builtin.ndarray_cache_stream.as_fget_param",
+           [](NDArrayCacheStream stream) { return stream.AsFGetParam(); })
+      .def("vm.builtin.ndarray_cache_stream.peak_live_bytes",
+           [](NDArrayCacheStream stream) { return stream->PeakLiveBytes(); });
+});
+
 // This param module node can be useful to get param dict in RPC mode
 // when the remote already have loaded parameters from file.
 class ParamModuleNode : public runtime::ModuleNode {
@@ -196,6 +196,8 @@ class VirtualMachineImpl : public VirtualMachine {
   void InvokeClosurePacked(const ObjectRef& closure_or_packedfunc, ffi::PackedArgs args,
                            ffi::Any* rv) final;
   void SetInstrument(ffi::Function instrument) final { this->instrument_ = instrument; }
+  void SetWorkerPool(Optional<threading::WorkerPool> pool) final { this->worker_pool_ = pool; }
+  void SetCallRecorder(std::vector<VMRecordedCall>* calls) final { this->call_recorder_ = calls; }
 
   //---------------------------------------------------
   // Functions in the vtable of Module
@@ -219,6 +221,7 @@ class VirtualMachineImpl : public VirtualMachine {
   TVM_MODULE_VTABLE_ENTRY_PACKED("invoke_closure", &VirtualMachineImpl::_InvokeClosure);
   TVM_MODULE_VTABLE_ENTRY("invoke_stateful", &VirtualMachineImpl::_InvokeClosureStateful);
   TVM_MODULE_VTABLE_ENTRY_PACKED("set_instrument", &VirtualMachineImpl::_SetInstrument);
+  TVM_MODULE_VTABLE_ENTRY("set_worker_pool", &VirtualMachineImpl::SetWorkerPool);
   TVM_MODULE_VTABLE_ENTRY_PACKED("get_output_arity", &VirtualMachineImpl::_GetOutputArity);
   TVM_MODULE_VTABLE_ENTRY_PACKED("get_output", &VirtualMachineImpl::_GetOutput);
   TVM_MODULE_VTABLE_ENTRY_PACKED("set_input", &VirtualMachineImpl::_SetInputWithoutParamModule);
@@ -449,6 +452,10 @@ class VirtualMachineImpl : public VirtualMachine {
   RegType return_value_;
   /*!\ brief instrument function. */
   ffi::Function instrument_ = nullptr;
+  /*! \brief The thread pool parallel launches of the VM go to. */
+  Optional<threading::WorkerPool> worker_pool_;
+  /*! \brief The recorder of the packed function calls, if recording. */
+  std::vector<VMRecordedCall>* call_recorder_ = nullptr;
 };
 
 void VirtualMachineImpl::LoadExecutable(ObjectPtr<VMExecutable> exec) {
@@ -542,6 +549,7 @@ void VirtualMachineImpl::InvokeClosurePacked(const ObjectRef& closure_or_packedf
   std::copy(args.data(), args.data() + args.size(), packed_args.begin() + 1);
   {
     NVTXScopedRange scope("RelaxVM: " + clo->func_name);
+    threading::WorkerPoolScope pool_scope(worker_pool_);
     clo->impl.CallPacked(ffi::PackedArgs(packed_args.data(), packed_args.size()), rv);
   }
 }
@@ -567,6 +575,7 @@ RegType VirtualMachineImpl::InvokeClosureInternal(const ObjectRef& closure_or_pa
     packed->CallPacked(packed_args.data(), packed_args.size(), &ret);
   } else {
     ICHECK(clo != nullptr);
+    threading::WorkerPoolScope pool_scope(worker_pool_);
     clo->impl.CallPacked(packed_args.data(), packed_args.size(), &ret);
   }
   return ret;
@@ -759,6 +768,17 @@ void VirtualMachineImpl::RunInstrCall(VMFrame* curr_frame, Instruction instr) {
 
   ICHECK_LT(static_cast<size_t>(instr.func_idx), this->func_pool_.size());
 
+  if (call_recorder_ != nullptr) {
+    if (auto func = func_pool_[instr.func_idx].try_cast<ffi::Function>()) {
+      std::vector<ffi::Any> recorded_args(args.size());
+      for (int i = 0; i < args.size(); ++i) {
+        recorded_args[i] = args[i];
+      }
+      call_recorder_->push_back(
+          {func.value(), GetFuncName(instr.func_idx), std::move(recorded_args)});
+    }
+  }
+
   if (instrument_ == nullptr) {
     this->InvokeClosurePacked(func_pool_[instr.func_idx].cast<ObjectRef>(), args, &ret);
   } else {
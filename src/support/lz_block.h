@@ -0,0 +1,202 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file lz_block.h
+ * \brief A small LZ77 block codec used to compress bulk transfers.
+ *
+ *  The format follows the LZ4 block layout: a sequence of
+ *  (token, literals, offset, match length) records where the token packs
+ *  the literal length in its high nibble and the match length minus four
+ *  in its low nibble, and lengths of 15 or more continue in 255-valued
+ *  bytes. The codec favours speed over ratio so that compressing a
+ *  buffer stays cheaper than sending it over a typical network link.
+ */
+#ifndef TVM_SUPPORT_LZ_BLOCK_H_
+#define TVM_SUPPORT_LZ_BLOCK_H_
+
+#include <tvm/runtime/logging.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace tvm {
+namespace support {
+namespace lz_block {
+
+/*! \brief Shortest match the codec encodes. */
+constexpr size_t kMinMatch = 4;
+/*! \brief Largest back reference distance. */
+constexpr size_t kMaxOffset = 65535;
+/*! \brief Number of trailing bytes that are always emitted as literals. */
+constexpr size_t kLastLiterals = 5;
+/*! \brief Matches cannot start within this many bytes of the end. */
+constexpr size_t kMatchFindLimit = 12;
+/*! \brief log2 of the number of hash table entries. */
+constexpr int kHashLog = 14;
+
+inline uint32_t Load32(const char* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t Hash(uint32_t seq) { return (seq * 2654435761U) >> (32 - kHashLog); }
+
+inline void WriteLength(std::string* out, size_t len) {
+  while (len >= 255) {
+    out->push_back(static_cast<char>(255));
+    len -= 255;
+  }
+  out->push_back(static_cast<char>(len));
+}
+
+inline size_t ReadLength(const uint8_t* in, size_t size, size_t* ip) {
+  size_t len = 0;
+  uint8_t b;
+  do {
+    ICHECK_LT(*ip, size) << "LZBlockDecompress: truncated length";
+    b = in[(*ip)++];
+    len += b;
+  } while (b == 255);
+  return len;
+}
+
+inline void EmitSequence(std::string* out, const char* literals, size_t lit_len, size_t offset,
+                         size_t match_len) {
+  size_t ml = match_len - kMinMatch;
+  uint8_t token = static_cast<uint8_t>((lit_len < 15 ? lit_len : 15) << 4);
+  token |= static_cast<uint8_t>(ml < 15 ? ml : 15);
+  out->push_back(static_cast<char>(token));
+  if (lit_len >= 15) WriteLength(out, lit_len - 15);
+  out->append(literals, lit_len);
+  out->push_back(static_cast<char>(offset & 0xFF));
+  out->push_back(static_cast<char>((offset >> 8) & 0xFF));
+  if (ml >= 15) WriteLength(out, ml - 15);
+}
+
+inline void EmitLastLiterals(std::string* out, const char* literals, size_t lit_len) {
+  out->push_back(static_cast<char>((lit_len < 15 ? lit_len : 15) << 4));
+  if (lit_len >= 15) WriteLength(out, lit_len - 15);
+  out->append(literals, lit_len);
+}
+
+}  // namespace lz_block
+
+/*!
+ * \brief Compress a block of bytes.
+ * \param data The input data.
+ * \param size The size of the input in bytes.
+ * \return The compressed block.
+ * \note Inputs are expected to stay below 4 GiB. Incompressible input grows
+ *  by at most size / 255 + 16 bytes, callers are expected to fall back to
+ *  the raw bytes in that case.
+ */
+inline std::string LZBlockCompress(const char* data, size_t size) {
+  using namespace lz_block;
+  std::string out;
+  out.reserve(size / 2 + 16);
+  size_t anchor = 0;
+  if (size > kMatchFindLimit) {
+    std::vector<uint32_t> table(size_t(1) << kHashLog, 0);
+    const size_t limit = size - kMatchFindLimit;
+    size_t i = 1;
+    while (i < limit) {
+      uint32_t seq = Load32(data + i);
+      uint32_t h = Hash(seq);
+      size_t ref = table[h];
+      table[h] = static_cast<uint32_t>(i);
+      if (i - ref > kMaxOffset || Load32(data + ref) != seq) {
+        // Skip faster through data that does not match so that
+        // incompressible payloads cost little more than a copy.
+        i += 1 + ((i - anchor) >> 6);
+        continue;
+      }
+      // Extend the match backwards over pending literals, then forwards.
+      while (i > anchor && ref > 0 && data[i - 1] == data[ref - 1]) {
+        --i;
+        --ref;
+      }
+      size_t match_len = kMinMatch;
+      const size_t match_end = size - kLastLiterals;
+      while (i + match_len < match_end && data[ref + match_len] == data[i + match_len]) {
+        ++match_len;
+      }
+      EmitSequence(&out, data + anchor, i - anchor, i - ref, match_len);
+      i += match_len;
+      anchor = i;
+      if (i < limit) {
+        table[Hash(Load32(data + i - 2))] = static_cast<uint32_t>(i - 2);
+      }
+    }
+  }
+  EmitLastLiterals(&out, data + anchor, size - anchor);
+  return out;
+}
+
+/*!
+ * \brief Decompress a block produced by LZBlockCompress.
+ * \param data The compressed data.
+ * \param size The size of the compressed data in bytes.
+ * \param out The output buffer.
+ * \param out_size The expected size of the decompressed data.
+ */
+inline void LZBlockDecompress(const char* data, size_t size, char* out, size_t out_size) {
+  using namespace lz_block;
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(data);
+  size_t ip = 0, op = 0;
+  while (true) {
+    ICHECK_LT(ip, size) << "LZBlockDecompress: truncated block";
+    uint8_t token = in[ip++];
+    size_t lit_len = token >> 4;
+    if (lit_len == 15) lit_len += ReadLength(in, size, &ip);
+    ICHECK(ip + lit_len <= size && op + lit_len <= out_size)
+        << "LZBlockDecompress: literal run out of bounds";
+    std::memcpy(out + op, data + ip, lit_len);
+    ip += lit_len;
+    op += lit_len;
+    if (ip == size) break;
+
+    ICHECK_LE(ip + 2, size) << "LZBlockDecompress: truncated offset";
+    size_t offset = static_cast<size_t>(in[ip]) | (static_cast<size_t>(in[ip + 1]) << 8);
+    ip += 2;
+    ICHECK(offset != 0 && offset <= op) << "LZBlockDecompress: invalid offset " << offset;
+    size_t match_len = token & 15;
+    if (match_len == 15) match_len += ReadLength(in, size, &ip);
+    match_len += kMinMatch;
+    ICHECK_LE(op + match_len, out_size) << "LZBlockDecompress: match out of bounds";
+    // Overlapping matches replicate the last `offset` bytes, copy them in
+    // growing multiples of the period so that each memcpy stays disjoint.
+    for (size_t done = 0; done < match_len;) {
+      size_t dist = (offset + done) / offset * offset;
+      size_t n = std::min(dist, match_len - done);
+      std::memcpy(out + op + done, out + op + done - dist, n);
+      done += n;
+    }
+    op += match_len;
+  }
+  ICHECK_EQ(op, out_size) << "LZBlockDecompress: size mismatch";
+}
+
+}  // namespace support
+}  // namespace tvm
+#endif  // TVM_SUPPORT_LZ_BLOCK_H_
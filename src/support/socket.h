@@ -45,6 +45,7 @@
 #include <sys/ioctl.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
@@ -469,6 +470,29 @@ class TCPSocket : public Socket, public dmlc::Stream {
     return RetryCallOnEINTR(
         [&]() { return send(sockfd, buf, static_cast<sock_size_t>(len), flag); }, GetLastErrorCode);
   }
+#if !defined(_WIN32)
+  /*!
+   * \brief send two buffers back to back with a single vectored write
+   * \param buf0 the pointer to the first buffer
+   * \param len0 the size of the first buffer
+   * \param buf1 the pointer to the second buffer
+   * \param len1 the size of the second buffer
+   * \return size of data actually sent
+   *         return -1 if error occurs
+   */
+  ssize_t SendGather(const void* buf0, size_t len0, const void* buf1, size_t len1) {
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<void*>(buf0);
+    iov[0].iov_len = len0;
+    iov[1].iov_base = const_cast<void*>(buf1);
+    iov[1].iov_len = len1;
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    return RetryCallOnEINTR([&]() { return sendmsg(sockfd, &msg, 0); }, GetLastErrorCode);
+  }
+#endif  // !defined(_WIN32)
   /*!
    * \brief receive data using the socket
    * \param buf_ the pointer to the buffer
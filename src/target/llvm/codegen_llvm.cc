@@ -71,10 +71,12 @@
 #include <llvm/IRReader/IRReader.h>
 #include <llvm/Linker/Linker.h>
 #include <llvm/Pass.h>
+#include <llvm/ProfileData/InstrProf.h>
 #if TVM_LLVM_VERSION >= 160
 #include <llvm/IR/Verifier.h>  // For VerifierPass
 #include <llvm/Passes/PassBuilder.h>
 #include <llvm/Passes/StandardInstrumentations.h>
+#include <llvm/Support/VirtualFileSystem.h>
 #include <llvm/TargetParser/Host.h>
 #else
 #include <llvm/IR/LegacyPassManager.h>
@@ -86,6 +88,7 @@
 #include <llvm/Support/TypeSize.h>
 #endif
 #include <llvm/Support/CodeGen.h>
+#include <llvm/Support/FileSystem.h>
 #include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Target/TargetMachine.h>
@@ -98,6 +101,7 @@
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -356,11 +360,113 @@ std::unique_ptr<llvm::Module> CodeGenLLVM::Finish() {
   }
   link_modules_.clear();
   this->Verify();
+  // The instrumented functions may be inlined away, collect their PGO names beforehand.
+  std::unordered_map<std::string, std::string> pgo_names;
+  if (llvm_target_->GetProfileGenerate()) {
+    pgo_names = this->GetPGOFuncNames();
+  }
   this->Optimize();
+  if (llvm_target_->GetProfileGenerate()) {
+    this->EmitPGOCounterTable(pgo_names);
+  }
   this->Verify();
   return std::move(module_);
 }
 
+std::unordered_map<std::string, std::string> CodeGenLLVM::GetPGOFuncNames() const {
+  std::unordered_map<std::string, std::string> pgo_names;
+  size_t prefix_size = llvm::getInstrProfNameVarPrefix().size();
+  for (const llvm::Function& f : module_->functions()) {
+    if (f.isDeclaration()) continue;
+#if TVM_LLVM_VERSION >= 180
+    std::string name = llvm::getIRPGOFuncName(f);
+#else
+    std::string name = llvm::getPGOFuncName(f);
+#endif
+    pgo_names[llvm::getPGOFuncNameVarName(name, f.getLinkage()).substr(prefix_size)] = name;
+  }
+  return pgo_names;
+}
+
+void CodeGenLLVM::EmitPGOCounterTable(
+    const std::unordered_map<std::string, std::string>& pgo_names) {
+  constexpr int kNumValueKinds = llvm::IPVK_Last + 1;
+  static_assert(kNumValueKinds <= 4, "LLVMPGOCounterEntry cannot hold all value kinds");
+  // There is no profiling runtime to record value profiles (indirect call targets and
+  // memop sizes), drop the calls into it and only keep the block counters. Without call
+  // target profiles, indirect calls such as those of tvm_call_packed are not promoted.
+  for (const char* name : {"__llvm_profile_instrument_target", "__llvm_profile_instrument_memop",
+                           "__llvm_profile_instrument_range"}) {
+    llvm::Function* f = module_->getFunction(name);
+    if (f == nullptr) continue;
+    for (llvm::User* user : llvm::make_early_inc_range(f->users())) {
+      if (auto* call = llvm::dyn_cast<llvm::CallInst>(user)) {
+        call->eraseFromParent();
+      }
+    }
+    if (f->use_empty()) f->eraseFromParent();
+  }
+  // Some object formats pull the profiling runtime in through a reference to this hook.
+  if (llvm::GlobalVariable* hook = module_->getGlobalVariable("__llvm_profile_runtime")) {
+    if (hook->isDeclaration()) {
+      hook->setInitializer(llvm::Constant::getNullValue(hook->getValueType()));
+      hook->setLinkage(llvm::GlobalValue::WeakAnyLinkage);
+    }
+  }
+
+  llvm::ArrayType* t_value_sites = llvm::ArrayType::get(t_int64_, 4);
+  llvm::StructType* t_entry = llvm::StructType::create(
+      {t_void_p_, t_void_p_, t_int64_, t_int64_, t_value_sites}, "tvm.pgo.entry");
+  std::string data_prefix = llvm::getInstrProfDataVarPrefix().str();
+  std::string counters_prefix = llvm::getInstrProfCountersVarPrefix().str();
+  std::vector<llvm::Constant*> entries;
+  for (const llvm::GlobalVariable& data : module_->globals()) {
+    std::string data_name = data.getName().str();
+    if (data_name.compare(0, data_prefix.size(), data_prefix) != 0 || !data.hasInitializer()) {
+      continue;
+    }
+    std::string suffix = data_name.substr(data_prefix.size());
+    llvm::GlobalVariable* counters =
+        module_->getGlobalVariable(counters_prefix + suffix, /*AllowInternal=*/true);
+    auto* t_counters = counters ? llvm::dyn_cast<llvm::ArrayType>(counters->getValueType())
+                                : nullptr;
+    auto* fields = llvm::dyn_cast<llvm::ConstantStruct>(data.getInitializer());
+    if (t_counters == nullptr || !t_counters->getElementType()->isIntegerTy(64) ||
+        fields == nullptr) {
+      continue;
+    }
+    // The profile data starts with the name reference and the CFG hash.
+    auto* hash = llvm::dyn_cast<llvm::ConstantInt>(fields->getOperand(1));
+    if (hash == nullptr) continue;
+    // The number of value sites is the only array of i16 in the profile data.
+    std::vector<llvm::Constant*> value_sites(4, llvm::ConstantInt::get(t_int64_, 0));
+    for (const llvm::Use& field : fields->operands()) {
+      auto* value = llvm::cast<llvm::Constant>(field.get());
+      auto* t_array = llvm::dyn_cast<llvm::ArrayType>(value->getType());
+      if (t_array == nullptr || !t_array->getElementType()->isIntegerTy(16)) continue;
+      for (uint64_t kind = 0; kind < kNumValueKinds && kind < t_array->getNumElements(); ++kind) {
+        if (auto* num = llvm::dyn_cast_or_null<llvm::ConstantInt>(
+                value->getAggregateElement(kind))) {
+          value_sites[kind] = llvm::ConstantInt::get(t_int64_, num->getZExtValue());
+        }
+      }
+    }
+    auto it = pgo_names.find(suffix);
+    llvm::Constant* name = GetConstString(it != pgo_names.end() ? it->second : suffix);
+    entries.push_back(llvm::ConstantStruct::get(
+        t_entry, {llvm::ConstantExpr::getPointerCast(name, t_void_p_),
+                  llvm::ConstantExpr::getPointerCast(counters, t_void_p_),
+                  llvm::ConstantInt::get(t_int64_, hash->getZExtValue()),
+                  llvm::ConstantInt::get(t_int64_, t_counters->getNumElements()),
+                  llvm::ConstantArray::get(t_value_sites, value_sites)}));
+  }
+  entries.push_back(llvm::Constant::getNullValue(t_entry));
+  llvm::ArrayType* t_table = llvm::ArrayType::get(t_entry, entries.size());
+  new llvm::GlobalVariable(*module_, t_table, /*isConstant=*/true,
+                           llvm::GlobalValue::ExternalLinkage,
+                           llvm::ConstantArray::get(t_table, entries), kPGOCounterTable);
+}
+
 void CodeGenLLVM::HandleImport(const std::string& code) {
   llvm::StringRef code_str(code);
   std::unique_ptr<llvm::Module> mlib;
@@ -411,7 +517,21 @@ void CodeGenLLVM::Optimize() {
 
   llvm::PipelineTuningOptions pto = llvm::PipelineTuningOptions();
   llvm::PassInstrumentationCallbacks pic;
-  llvm::PassBuilder builder(tm, pto, std::nullopt, &pic);
+
+  // Profile-guided optimization, the counters are collected without a profile file.
+  std::optional<llvm::PGOOptions> pgo_options;
+  const std::string& profile_use = llvm_target_->GetProfileUse();
+  if (llvm_target_->GetProfileGenerate() || !profile_use.empty()) {
+    ICHECK(profile_use.empty() || llvm::sys::fs::exists(profile_use))
+        << "Cannot find the profile " << profile_use;
+    auto action = profile_use.empty() ? llvm::PGOOptions::IRInstr : llvm::PGOOptions::IRUse;
+#if TVM_LLVM_VERSION >= 170
+    pgo_options = llvm::PGOOptions(profile_use, "", "", "", llvm::vfs::getRealFileSystem(), action);
+#else
+    pgo_options = llvm::PGOOptions(profile_use, "", "", action);
+#endif
+  }
+  llvm::PassBuilder builder(tm, pto, pgo_options, &pic);
 
   llvm::LoopAnalysisManager lam;
   llvm::FunctionAnalysisManager fam;
@@ -532,6 +652,14 @@ void CodeGenLLVM::Optimize() {
 #endif
   builder.LoopVectorize = true;
   builder.SLPVectorize = true;
+  // Instrument the kernels for -profile-generate, or feed the -profile-use file to the pipeline.
+  const std::string& profile_use = llvm_target_->GetProfileUse();
+  if (llvm_target_->GetProfileGenerate()) {
+    builder.EnablePGOInstrGen = true;
+  } else if (!profile_use.empty()) {
+    ICHECK(llvm::sys::fs::exists(profile_use)) << "Cannot find the profile " << profile_use;
+    builder.PGOInstrUse = profile_use;
+  }
   this->InitPassManagerBuilder(&builder);
 
 #if TVM_LLVM_VERSION >= 50
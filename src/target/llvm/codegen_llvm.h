@@ -97,6 +97,26 @@ namespace codegen {
 
 using namespace tir;
 
+/*!
+ * \brief Entry of the counter table exported by modules built with `-profile-generate`.
+ *
+ * The table is named CodeGenLLVM::kPGOCounterTable and terminated by an entry
+ * whose name is nullptr. It lets the runtime write an indexed profile without
+ * the LLVM profiling runtime.
+ */
+struct LLVMPGOCounterEntry {
+  /*! \brief The PGO name of the function. */
+  const char* name;
+  /*! \brief The block counters of the function. */
+  const uint64_t* counters;
+  /*! \brief The CFG hash of the function. */
+  uint64_t hash;
+  /*! \brief The number of block counters. */
+  uint64_t num_counters;
+  /*! \brief The number of value profiling sites per value kind, at most 4 kinds. */
+  uint64_t num_value_sites[4];
+};
+
 /*!
  * \brief A base class to generate a LLVM.
  */
@@ -112,6 +132,8 @@ class CodeGenLLVM : public ExprFunctor<llvm::Value*(const PrimExpr&)>,
    * \return The created llvm generator.
    */
   static std::unique_ptr<CodeGenLLVM> Create(LLVMTarget* llvm_target);
+  /*! \brief Name of the table of LLVMPGOCounterEntry in instrumented modules. */
+  static constexpr const char* kPGOCounterTable = "__tvm_pgo_counters";
   /*!
    * \brief Initialize the code generator with given context
    * \param module_name The name of the module.
@@ -369,6 +391,10 @@ class CodeGenLLVM : public ExprFunctor<llvm::Value*(const PrimExpr&)>,
   virtual void AddStartupFunction() {}
   // apply optimization on the module.
   virtual void Optimize();
+  // Get the PGO name of each function, keyed by the suffix of its profile variables.
+  std::unordered_map<std::string, std::string> GetPGOFuncNames() const;
+  // Export the counters of a module instrumented for PGO, see LLVMPGOCounterEntry.
+  void EmitPGOCounterTable(const std::unordered_map<std::string, std::string>& pgo_names);
   // Get the maximim storage align bits of buffer pointer given storage scope.
   virtual int NativeVectorBits(const runtime::StorageScope& storage_scope) const;
   // Get correct address space depending on the backend
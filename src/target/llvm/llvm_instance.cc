@@ -266,13 +266,24 @@ LLVMTargetInfo::LLVMTargetInfo(LLVMInstance& instance, const TargetJSON& target)
   // LLVM JIT engine options
   if (const auto& v = Downcast<Optional<String>>(target.Get("jit").value_or(nullptr))) {
     String value = v.value();
-    if ((value == "mcjit") || (value == "orcjit")) {
+    if ((value == "mcjit") || (value == "orcjit") || (value == "orcjit-lazy")) {
       jit_engine_ = value;
     } else {
-      LOG(FATAL) << "invalid jit option " << value << " (can be `orcjit` or `mcjit`).";
+      LOG(FATAL) << "invalid jit option " << value
+                 << " (can be `orcjit`, `orcjit-lazy` or `mcjit`).";
     }
   }
 
+  // Profile-guided optimization options
+  if (auto flag = target.Get("profile-generate")) {
+    profile_generate_ = flag.value().cast<bool>();
+  }
+  if (const auto& v = Downcast<Optional<String>>(target.Get("profile-use").value_or(nullptr))) {
+    profile_use_ = v.value();
+  }
+  ICHECK(!profile_generate_ || profile_use_.empty())
+      << "-profile-generate and -profile-use cannot be used together";
+
   // TVM & LLVM vector width options
   if (const auto& w = Downcast<Optional<int64_t>>(target.Get("vector-width").value_or(nullptr))) {
     vector_width_ = w.value();
@@ -563,6 +574,13 @@ std::string LLVMTargetInfo::str() const {
     os << " -jit=" << jit_engine_;
   }
 
+  if (profile_generate_) {
+    os << " -profile-generate";
+  }
+  if (!profile_use_.empty()) {
+    os << " -profile-use=" << profile_use_;
+  }
+
   return os.str();
 }
 
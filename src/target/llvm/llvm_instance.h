@@ -239,9 +239,19 @@ class LLVMTargetInfo {
   llvm::FastMathFlags GetFastMathFlags() const { return fast_math_flags_; }
   /*!
    * \brief Get the LLVM JIT engine type
-   * \return the type name of the JIT engine (default "orcjit" or "mcjit")
+   * \return the type name of the JIT engine (default "orcjit", "orcjit-lazy" or "mcjit")
    */
   const std::string GetJITEngine() const { return jit_engine_; }
+  /*!
+   * \brief Whether to instrument the generated code for profile-guided optimization
+   * \return true if the code collects PGO counters at runtime
+   */
+  bool GetProfileGenerate() const { return profile_generate_; }
+  /*!
+   * \brief Get the profile used for profile-guided optimization
+   * \return path of the indexed profile, or empty string if PGO is not used
+   */
+  const std::string& GetProfileUse() const { return profile_use_; }
   /*!
    * \brief Get the TVM & LLVM vector_width
    * \return number of bits for vector width
@@ -361,6 +371,8 @@ class LLVMTargetInfo {
   llvm::CodeModel::Model code_model_ = llvm::CodeModel::Small;
   std::shared_ptr<llvm::TargetMachine> target_machine_;
   std::string jit_engine_ = "orcjit";
+  bool profile_generate_{false};
+  std::string profile_use_;
   int vector_width_{0};
 };
 
@@ -29,8 +29,10 @@
 #include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/MCJIT.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
 #include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/Orc/Speculation.h>
 #include <tvm/ffi/reflection/registry.h>
 #if _WIN32
 #include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
@@ -45,7 +47,11 @@
 #include <llvm/IR/Metadata.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IRReader/IRReader.h>
+#include <llvm/ProfileData/InstrProf.h>
+#include <llvm/ProfileData/InstrProfWriter.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 #if TVM_LLVM_VERSION >= 180
 #include <llvm/TargetParser/Host.h>
 #else
@@ -53,6 +59,7 @@
 #endif
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/Transforms/Utils/Cloning.h>
@@ -68,11 +75,15 @@
 #include <tvm/target/target.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <system_error>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -90,6 +101,148 @@ using ffi::Any;
 using ffi::Function;
 using ffi::PackedArgs;
 
+/*!
+ * \brief Persistent on-disk cache of JIT compiled object files.
+ *
+ * Objects are keyed by a hash of the module bitcode together with the
+ * properties of the target machine that produced them, so a cache directory
+ * can be shared between different targets.  The cache directory is taken from
+ * the TVM_LLVM_JIT_CACHE_DIR environment variable.
+ */
+class LLVMJITObjectCache : public llvm::ObjectCache {
+ public:
+  LLVMJITObjectCache(std::string cache_dir, const std::string& target_key)
+      : cache_dir_(std::move(cache_dir)), target_hash_(llvm::xxHash64(target_key)) {}
+
+  /*! \brief Number of objects loaded from a cache, over all caches of the process. */
+  static inline std::atomic<int64_t> num_hits{0};
+  /*! \brief Number of compiled objects handed to a cache, over all caches of the process. */
+  static inline std::atomic<int64_t> num_compiled{0};
+
+  /*!
+   * \brief Create the object cache if it is enabled in the environment.
+   * \param target_key The string identifying the target machine configuration.
+   * \return The object cache, or nullptr if caching is disabled.
+   */
+  static std::unique_ptr<LLVMJITObjectCache> CreateFromEnv(const std::string& target_key) {
+    const char* dir = std::getenv("TVM_LLVM_JIT_CACHE_DIR");
+    if (dir == nullptr || dir[0] == '\0') return nullptr;
+    std::error_code ecode = llvm::sys::fs::create_directories(dir);
+    if (ecode) {
+      LOG(WARNING) << "Cannot create LLVM JIT cache directory " << dir << ": " << ecode.message();
+      return nullptr;
+    }
+    return std::make_unique<LLVMJITObjectCache>(dir, target_key);
+  }
+
+  void notifyObjectCompiled(const llvm::Module* mod, llvm::MemoryBufferRef obj) final {
+    ++num_compiled;
+    std::string path = TakeCachePath(mod);
+    // Write to a temporary file first so that concurrent readers never see partial objects.
+    std::string tmp_path = path + ".tmp" + std::to_string(std::hash<std::thread::id>()(
+                                               std::this_thread::get_id()));
+    std::error_code ecode;
+    {
+#if TVM_LLVM_VERSION <= 70
+      llvm::raw_fd_ostream os(tmp_path, ecode, llvm::sys::fs::F_None);
+#else
+      llvm::raw_fd_ostream os(tmp_path, ecode, llvm::sys::fs::OF_None);
+#endif
+      if (ecode) return;
+      os << obj.getBuffer();
+    }
+    if (llvm::sys::fs::rename(tmp_path, path)) {
+      llvm::sys::fs::remove(tmp_path);
+    }
+  }
+
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* mod) final {
+    std::string path = GetCachePath(mod);
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false);
+    if (!buffer) return nullptr;
+    // A hit means notifyObjectCompiled will not be called for this module.
+    TakeCachePath(mod);
+    ++num_hits;
+    VLOG(2) << "LLVM JIT object cache hit " << path;
+    return std::move(buffer.get());
+  }
+
+ private:
+  /*! \brief Compute (and remember) the cache file of a module. */
+  std::string GetCachePath(const llvm::Module* mod) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = pending_.find(mod);
+      if (it != pending_.end()) return it->second;
+    }
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream os(bitcode);
+    llvm::WriteBitcodeToFile(*mod, os);
+    uint64_t hash = llvm::xxHash64(llvm::StringRef(bitcode.data(), bitcode.size()));
+    std::ostringstream name;
+    name << std::hex << hash << "-" << target_hash_ << "-" << std::dec << bitcode.size() << ".o";
+    llvm::SmallString<256> path(cache_dir_);
+    llvm::sys::path::append(path, name.str());
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_[mod] = std::string(path.str());
+  }
+  /*! \brief Get the cache file of a module and forget the module pointer. */
+  std::string TakeCachePath(const llvm::Module* mod) {
+    std::string path = GetCachePath(mod);
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(mod);
+    return path;
+  }
+
+  std::string cache_dir_;
+  uint64_t target_hash_;
+  std::mutex mutex_;
+  // Paths computed in getObject for modules that are being compiled.
+  std::unordered_map<const llvm::Module*, std::string> pending_;
+};
+
+namespace {
+
+/*!
+ * \brief Write the counters of a module built with `-profile-generate` as an indexed profile.
+ * \param table The counter table exported by the module, see LLVMPGOCounterEntry.
+ * \param file_name The profile to write, it can be consumed with `-profile-use`.
+ */
+void WriteLLVMPGOProfile(const LLVMPGOCounterEntry* table, const std::string& file_name) {
+  llvm::InstrProfWriter writer;
+#if TVM_LLVM_VERSION >= 150
+  llvm::Error err = writer.mergeProfileKind(llvm::InstrProfKind::IRInstrumentation);
+#elif TVM_LLVM_VERSION >= 140
+  llvm::Error err = writer.mergeProfileKind(llvm::InstrProfKind::IR);
+#else
+  llvm::Error err = writer.setIsIRLevelProfile(true, false);
+#endif
+  ICHECK(!err) << llvm::toString(std::move(err));
+  for (const LLVMPGOCounterEntry* entry = table; entry->name != nullptr; ++entry) {
+    std::vector<uint64_t> counts(entry->counters, entry->counters + entry->num_counters);
+    llvm::NamedInstrProfRecord record(entry->name, entry->hash, std::move(counts));
+    // Value profiles are not collected, but the number of sites must match the module.
+    for (uint32_t kind = llvm::IPVK_First; kind <= llvm::IPVK_Last; ++kind) {
+      record.reserveSites(kind, entry->num_value_sites[kind]);
+    }
+    writer.addRecord(std::move(record), [&](llvm::Error err) {
+      LOG(WARNING) << "Cannot add the profile of " << entry->name << ": "
+                   << llvm::toString(std::move(err));
+    });
+  }
+  std::error_code ecode;
+#if TVM_LLVM_VERSION <= 70
+  llvm::raw_fd_ostream os(file_name, ecode, llvm::sys::fs::F_None);
+#else
+  llvm::raw_fd_ostream os(file_name, ecode, llvm::sys::fs::OF_None);
+#endif
+  ICHECK_EQ(ecode.value(), 0) << "Cannot open file: " << file_name << " " << ecode.message();
+  err = writer.write(os);
+  ICHECK(!err) << llvm::toString(std::move(err));
+}
+
+}  // namespace
+
 class LLVMModuleNode final : public runtime::ModuleNode {
  public:
   ~LLVMModuleNode();
@@ -119,6 +272,8 @@ class LLVMModuleNode final : public runtime::ModuleNode {
  private:
   void InitMCJIT();
   void InitORCJIT();
+  void StartBackgroundCompile();
+  bool IsORCJIT() const { return jit_engine_ == "orcjit" || jit_engine_ == "orcjit-lazy"; }
   bool IsCompatibleWithHost(const llvm::TargetMachine* tm) const;
   void* GetGlobalAddr(const std::string& name, const LLVMTarget& llvm_target) const;
   void* GetFunctionAddr(const std::string& name, const LLVMTarget& llvm_target) const;
@@ -127,9 +282,20 @@ class LLVMModuleNode final : public runtime::ModuleNode {
   std::unique_ptr<LLVMInstance> llvm_instance_;
   // JIT lock
   std::mutex mutex_;
+  // Optional persistent cache of compiled objects, shared by the compilers of the engine.
+  std::unique_ptr<LLVMJITObjectCache> object_cache_;
+#if TVM_LLVM_VERSION >= 130
+  // The implementation library of every lazy stub, recorded by the compile-on-demand layer
+  // when it creates the stub. Must outlive the engine.
+  std::unique_ptr<llvm::orc::ImplSymbolMap> lazy_impls_;
+#endif
   // jit execution engines
   llvm::ExecutionEngine* mcjit_ee_{nullptr};
   std::unique_ptr<llvm::orc::LLJIT> orcjit_ee_{nullptr};
+  // Thread that compiles the remaining functions ahead of their first call in lazy mode,
+  // enabled by TVM_LLVM_JIT_BACKGROUND_COMPILE.
+  std::thread background_compile_;
+  std::atomic<bool> stop_background_compile_{false};
   // The raw pointer to the module.
   llvm::Module* module_{nullptr};
   // The unique_ptr owning the module. This becomes empty once JIT has been initialized
@@ -141,6 +307,10 @@ class LLVMModuleNode final : public runtime::ModuleNode {
 };
 
 LLVMModuleNode::~LLVMModuleNode() {
+  if (background_compile_.joinable()) {
+    stop_background_compile_ = true;
+    background_compile_.join();
+  }
   if (mcjit_ee_ != nullptr) {
     mcjit_ee_->runStaticConstructorsDestructors(true);
     delete mcjit_ee_;
@@ -184,12 +354,20 @@ ffi::Function LLVMModuleNode::GetFunction(const String& name,
   }
   ICHECK(jit_engine_.size()) << "JIT engine type is missing";
   if ((jit_engine_ == "mcjit") && (mcjit_ee_ == nullptr)) InitMCJIT();
-  if ((jit_engine_ == "orcjit") && (orcjit_ee_ == nullptr)) InitORCJIT();
+  if (IsORCJIT() && (orcjit_ee_ == nullptr)) InitORCJIT();
 
   std::lock_guard<std::mutex> lock(mutex_);
 
   TVMFFISafeCallType faddr;
   With<LLVMTarget> llvm_target(*llvm_instance_, LLVMTarget::GetTargetMetadata(*module_));
+  if (name == "__tvm_llvm_pgo_write_profile") {
+    auto* table = reinterpret_cast<const LLVMPGOCounterEntry*>(
+        GetGlobalAddr(CodeGenLLVM::kPGOCounterTable, *llvm_target));
+    if (table == nullptr) return ffi::Function();
+    return ffi::Function([sptr_to_self, table](ffi::PackedArgs args, ffi::Any* rv) {
+      WriteLLVMPGOProfile(table, args[0].cast<std::string>());
+    });
+  }
   if (name == runtime::symbol::tvm_module_main) {
     const char* entry_name = reinterpret_cast<const char*>(
         GetGlobalAddr(runtime::symbol::tvm_module_main, *llvm_target));
@@ -430,6 +608,10 @@ void LLVMModuleNode::InitMCJIT() {
   mcjit_ee_ = builder.create(tm.release());
   ICHECK(mcjit_ee_ != nullptr) << "Failed to initialize LLVM MCJIT engine for "
                                << module_->getTargetTriple();
+  object_cache_ = LLVMJITObjectCache::CreateFromEnv(llvm_target->str());
+  if (object_cache_ != nullptr) {
+    mcjit_ee_->setObjectCache(object_cache_.get());
+  }
 
   VLOG(2) << "LLVM MCJIT execute " << module_->getModuleIdentifier() << " for triple `"
           << llvm_target->GetTargetTriple() << "`"
@@ -494,10 +676,20 @@ void LLVMModuleNode::InitORCJIT() {
       << module_->getDataLayout().getStringRepresentation() << ")"
       << " and ExecutionEngine (" << layout.getStringRepresentation() << ")";
 
+  // Lazy mode: every function is split into its own partition by the compile-on-demand
+  // layer and only compiled when its stub is first called.
+  bool lazy = jit_engine_ == "orcjit-lazy";
+  object_cache_ = LLVMJITObjectCache::CreateFromEnv(llvm_target->str());
+
   // compiler
-  const auto compilerBuilder = [&](const llvm::orc::JITTargetMachineBuilder&)
+  const auto compilerBuilder = [&](const llvm::orc::JITTargetMachineBuilder& jtmb)
       -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
-    return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(tm));
+    if (lazy) {
+      // Partitions may be compiled concurrently by the caller and the background thread.
+      return std::make_unique<llvm::orc::ConcurrentIRCompiler>(jtmb, object_cache_.get());
+    }
+    return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(tm),
+                                                              object_cache_.get());
   };
 
 #if TVM_LLVM_VERSION >= 130
@@ -518,18 +710,46 @@ void LLVMModuleNode::InitORCJIT() {
     }
     return ObjLinkingLayer;
   };
+
+  // create lazy LLJIT, the indirect stubs it relies on are not available on every target
+  llvm::orc::LLLazyJIT* lazy_jit = nullptr;
+  if (lazy) {
+    llvm::orc::LLLazyJITBuilder lazy_builder;
+    lazy_builder.setJITTargetMachineBuilder(tm_builder)
+        .setDataLayout(layout)
+        .setCompileFunctionCreator(compilerBuilder)
+        .setObjectLinkingLayerCreator(linkerBuilder);
+    auto lazy_ee = lazy_builder.create();
+    if (lazy_ee) {
+      lazy_jit = lazy_ee.get().get();
+      orcjit_ee_ = std::move(lazy_ee.get());
+      lazy_impls_ = std::make_unique<llvm::orc::ImplSymbolMap>();
+      lazy_jit->getCompileOnDemandLayer().setImplMap(lazy_impls_.get());
+    } else {
+      LOG(WARNING) << "Cannot create lazy ORCJIT for " << llvm_target->GetTargetTriple() << ": "
+                   << llvm::toString(lazy_ee.takeError()) << ", fall back to eager compilation";
+      lazy = false;
+    }
+  }
+#else
+  if (lazy) {
+    LOG(WARNING) << "Lazy ORCJIT requires LLVM 13 or newer, fall back to eager compilation";
+    lazy = false;
+  }
 #endif
 
   // create LLJIT
-  orcjit_ee_ = llvm::cantFail(llvm::orc::LLJITBuilder()
+  if (orcjit_ee_ == nullptr) {
+    orcjit_ee_ = llvm::cantFail(llvm::orc::LLJITBuilder()
 #if TVM_LLVM_VERSION >= 110
-                                  .setDataLayout(layout)
+                                    .setDataLayout(layout)
 #endif
-                                  .setCompileFunctionCreator(compilerBuilder)
+                                    .setCompileFunctionCreator(compilerBuilder)
 #if TVM_LLVM_VERSION >= 130
-                                  .setObjectLinkingLayerCreator(linkerBuilder)
+                                    .setObjectLinkingLayerCreator(linkerBuilder)
 #endif
-                                  .create());
+                                    .create());
+  }
 
   ICHECK(orcjit_ee_ != nullptr) << "Failed to initialize LLVM ORCJIT engine for "
                                 << module_->getTargetTriple();
@@ -551,11 +771,17 @@ void LLVMModuleNode::InitORCJIT() {
 
   // add the llvm module to run
   llvm::orc::ThreadSafeModule tsm(std::move(umod), std::move(uctx));
+#if TVM_LLVM_VERSION >= 130
+  auto err = lazy ? lazy_jit->addLazyIRModule(std::move(tsm))
+                  : orcjit_ee_->addIRModule(std::move(tsm));
+#else
   auto err = orcjit_ee_->addIRModule(std::move(tsm));
+#endif
   ICHECK(!err) << llvm::toString(std::move(err));
 
-  VLOG(2) << "LLVM ORCJIT execute " << module_->getModuleIdentifier() << " for triple `"
-          << llvm_target->GetTargetTriple() << "`"
+  VLOG(2) << "LLVM ORCJIT" << (lazy ? " (lazy)" : "") << " execute "
+          << module_->getModuleIdentifier() << " for triple `" << llvm_target->GetTargetTriple()
+          << "`"
           << " on cpu `" << llvm_target->GetCPU() << "`";
 
   // run ctors
@@ -568,6 +794,48 @@ void LLVMModuleNode::InitORCJIT() {
   }
   runtime::InitContextFunctions(
       [this, &llvm_target](const char* name) { return GetGlobalAddr(name, *llvm_target); });
+
+  const char* background = std::getenv("TVM_LLVM_JIT_BACKGROUND_COMPILE");
+  if (lazy && background != nullptr && std::string(background) != "0") {
+    StartBackgroundCompile();
+  }
+}
+
+void LLVMModuleNode::StartBackgroundCompile() {
+#if TVM_LLVM_VERSION >= 130
+  std::vector<std::string> names;
+  for (const llvm::Function& func : module_->functions()) {
+    if (!func.isDeclaration() && !func.hasLocalLinkage()) {
+      names.push_back(func.getName().str());
+    }
+  }
+  background_compile_ = std::thread([this, names = std::move(names)]() {
+    llvm::orc::JITDylib& main = orcjit_ee_->getMainJITDylib();
+    // The speculator compiles the body behind a stub in the implementation library that
+    // lazy_impls_ recorded for it.
+    llvm::orc::Speculator speculator(*lazy_impls_, orcjit_ee_->getExecutionSession());
+    for (const std::string& name : names) {
+      if (stop_background_compile_) return;
+      // Looking up a function in the main library only emits its stub.
+      auto stub = orcjit_ee_->lookup(name);
+      if (!stub) {
+        VLOG(2) << "LLVM ORCJIT background compile of " << name
+                << " failed: " << llvm::toString(stub.takeError());
+        continue;
+      }
+#if TVM_LLVM_VERSION >= 150
+      uint64_t stub_addr = stub->getValue();
+#else
+      uint64_t stub_addr = stub->getAddress();
+#endif
+      llvm::orc::SymbolStringPtr symbol = orcjit_ee_->mangleAndIntern(name);
+      llvm::orc::Speculator::FunctionCandidatesMap candidates;
+      candidates[symbol].insert(symbol);
+      speculator.registerSymbols(std::move(candidates), &main);
+      speculator.speculateFor(llvm::orc::Speculator::TargetFAddr(stub_addr));
+    }
+  });
+#endif
 }
 
 bool LLVMModuleNode::IsCompatibleWithHost(const llvm::TargetMachine* tm) const {
@@ -587,7 +855,7 @@ void* LLVMModuleNode::GetGlobalAddr(const std::string& name, const LLVMTarget& l
   if (module_->getGlobalVariable(name) != nullptr) {
     if (jit_engine_ == "mcjit") {
       return reinterpret_cast<void*>(mcjit_ee_->getGlobalValueAddress(name));
-    } else if (jit_engine_ == "orcjit") {
+    } else if (IsORCJIT()) {
 #if TVM_LLVM_VERSION >= 150
       auto addr = llvm::cantFail(orcjit_ee_->lookup(name)).getValue();
 #else
@@ -607,7 +875,7 @@ void* LLVMModuleNode::GetFunctionAddr(const std::string& name,
   if (module_->getFunction(name) != nullptr) {
     if (jit_engine_ == "mcjit") {
       return reinterpret_cast<void*>(mcjit_ee_->getFunctionAddress(name));
-    } else if (jit_engine_ == "orcjit") {
+    } else if (IsORCJIT()) {
 #if TVM_LLVM_VERSION >= 150
       auto addr = llvm::cantFail(orcjit_ee_->lookup(name)).getValue();
 #else
@@ -644,6 +912,18 @@ static void LLVMReflectionRegister() {
              n->SetJITEngine(llvm_target->GetJITEngine());
              return runtime::Module(n);
            })
+      .def("target.llvm_jit_object_cache_stats",
+           []() -> Array<int64_t> {
+             return {LLVMJITObjectCache::num_hits.load(),
+                     LLVMJITObjectCache::num_compiled.load()};
+           })
+      .def("target.llvm_pgo_write_profile",
+           [](runtime::Module mod, std::string file_name) {
+             ffi::Function fwrite = mod->GetFunction("__tvm_llvm_pgo_write_profile", true);
+             ICHECK(fwrite != nullptr)
+                 << "The module is not an LLVM module built with -profile-generate";
+             fwrite(file_name);
+           })
       .def("target.llvm_lookup_intrinsic_id",
            [](std::string name) -> int64_t {
 #if TVM_LLVM_VERSION >= 200
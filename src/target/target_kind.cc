@@ -285,8 +285,11 @@ TVM_REGISTER_TARGET_KIND("llvm", kDLCPU)
     .add_attr_option<int64_t>("opt-level")
     // LLVM command line flags, see below
     .add_attr_option<Array<String>>("cl-opt")
-    // LLVM JIT engine mcjit/orcjit
+    // LLVM JIT engine mcjit/orcjit/orcjit-lazy
     .add_attr_option<String>("jit")
+    // Profile-guided optimization: instrument the kernels, or use an indexed profile
+    .add_attr_option<bool>("profile-generate")
+    .add_attr_option<String>("profile-use")
     // TVM & LLVM custom vector bit width
     .add_attr_option<int64_t>("vector-width")
     .set_default_keys({"cpu"})
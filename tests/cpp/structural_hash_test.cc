@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <tvm/node/structural_hash.h>
+#include <tvm/tir/expr.h>
+#include <tvm/tir/op.h>
+#include <tvm/tir/stmt.h>
+
+namespace {
+
+using namespace tvm;
+using namespace tvm::tir;
+
+uint64_t HashWithCache(const ObjectRef& obj, SHashCache* cache, bool map_free_vars) {
+  SHashHandlerDefault handler;
+  handler.SetCache(cache);
+  return handler.Hash(obj, map_free_vars);
+}
+
+TEST(StructuralHash, CacheMatchesUncached) {
+  Var x("x"), y("y"), n("n");
+  PrimExpr shared = x * y + 1;
+  Stmt body = LetStmt(y, n + 2, Evaluate(shared + shared));
+  Stmt stmt = SeqStmt({LetStmt(x, n, body), Evaluate(n * 3)});
+
+  for (bool map_free_vars : {false, true}) {
+    SHashCache cache;
+    uint64_t expected = SHashHandlerDefault().Hash(stmt, map_free_vars);
+    EXPECT_EQ(HashWithCache(stmt, &cache, map_free_vars), expected);
+    EXPECT_GT(cache.size(), 0U);
+    // second pass is served from the cache
+    EXPECT_EQ(HashWithCache(stmt, &cache, map_free_vars), expected);
+    // subtrees hashed on their own have a different context
+    EXPECT_EQ(HashWithCache(body, &cache, map_free_vars),
+              SHashHandlerDefault().Hash(body, map_free_vars));
+  }
+}
+
+TEST(StructuralHash, CacheAfterLocalRewrite) {
+  Var x("x"), n("n");
+  Stmt unchanged = LetStmt(x, n * 4, Evaluate(x * x + n));
+  Stmt before = SeqStmt({unchanged, Evaluate(n + 1)});
+  Stmt after = SeqStmt({unchanged, Evaluate(n + 2)});
+
+  SHashCache cache;
+  EXPECT_EQ(HashWithCache(before, &cache, true), SHashHandlerDefault().Hash(before, true));
+  EXPECT_EQ(HashWithCache(after, &cache, true), SHashHandlerDefault().Hash(after, true));
+  EXPECT_NE(HashWithCache(before, &cache, true), HashWithCache(after, &cache, true));
+}
+
+TEST(StructuralHash, CacheRespectsFreeVarOrder) {
+  Var x("x"), y("y");
+  PrimExpr e = x + y;
+  SHashCache cache;
+  // hash e first, then a tree where y is seen before x.
+  EXPECT_EQ(HashWithCache(e, &cache, true), SHashHandlerDefault().Hash(e, true));
+  Array<PrimExpr> arr = {y, e};
+  EXPECT_EQ(HashWithCache(arr, &cache, true), SHashHandlerDefault().Hash(arr, true));
+}
+
+TEST(StructuralHash, CacheStopsGrowingAtLimit) {
+  Var x("x"), n("n");
+  Stmt stmt = SeqStmt({LetStmt(x, n * 4, Evaluate(x * x + n)), Evaluate(n + 1)});
+  SHashCache cache(4);
+  EXPECT_EQ(HashWithCache(stmt, &cache, true), SHashHandlerDefault().Hash(stmt, true));
+  EXPECT_EQ(cache.size(), 4U);
+  EXPECT_EQ(HashWithCache(stmt, &cache, true), SHashHandlerDefault().Hash(stmt, true));
+  EXPECT_EQ(cache.size(), 4U);
+}
+
+}  // namespace
@@ -0,0 +1,79 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "../../../src/support/lz_block.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace tvm {
+namespace support {
+namespace {
+
+std::string RoundTrip(const std::string& data) {
+  std::string packed = LZBlockCompress(data.data(), data.size());
+  std::string unpacked(data.size(), '\0');
+  LZBlockDecompress(packed.data(), packed.size(), &unpacked[0], unpacked.size());
+  return unpacked;
+}
+
+TEST(LZBlock, SmallInputs) {
+  for (size_t n = 0; n < 64; ++n) {
+    std::string data;
+    for (size_t i = 0; i < n; ++i) data.push_back(static_cast<char>('a' + i % 3));
+    ASSERT_EQ(RoundTrip(data), data) << "n=" << n;
+  }
+}
+
+TEST(LZBlock, Compressible) {
+  std::vector<float> values(1 << 16);
+  for (size_t i = 0; i < values.size(); ++i) values[i] = static_cast<float>(i % 97);
+  std::string data(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(float));
+  std::string packed = LZBlockCompress(data.data(), data.size());
+  ASSERT_LT(packed.size(), data.size() / 4);
+  ASSERT_EQ(RoundTrip(data), data);
+
+  std::string zeros(1 << 20, '\0');
+  ASSERT_LT(LZBlockCompress(zeros.data(), zeros.size()).size(), zeros.size() / 100);
+  ASSERT_EQ(RoundTrip(zeros), zeros);
+}
+
+TEST(LZBlock, Incompressible) {
+  std::mt19937 rng(0);
+  std::string data(100003, '\0');
+  for (char& c : data) c = static_cast<char>(rng());
+  std::string packed = LZBlockCompress(data.data(), data.size());
+  ASSERT_LE(packed.size(), data.size() + data.size() / 255 + 16);
+  ASSERT_EQ(RoundTrip(data), data);
+}
+
+TEST(LZBlock, RejectsCorruptInput) {
+  std::string data(4096, 'x');
+  std::string packed = LZBlockCompress(data.data(), data.size());
+  std::string out(data.size(), '\0');
+  ASSERT_ANY_THROW(LZBlockDecompress(packed.data(), packed.size() - 1, &out[0], out.size()));
+  ASSERT_ANY_THROW(LZBlockDecompress(packed.data(), packed.size(), &out[0], out.size() - 1));
+}
+
+}  // namespace
+}  // namespace support
+}  // namespace tvm
@@ -22,6 +22,7 @@
 #include <tvm/runtime/logging.h>
 #include <tvm/runtime/threading_backend.h>
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <sstream>
@@ -184,6 +185,92 @@ TEST(ThreadingBackend, TVMBackendAffinityConfigure) {
   }
 }
 
+TEST(ThreadingBackend, NumaNodes) {
+  const auto& nodes = tvm::runtime::threading::NumaNodes();
+  ASSERT_FALSE(nodes.empty());
+  std::unordered_set<unsigned int> seen;
+  for (const auto& node : nodes) {
+    EXPECT_LE(node.num_cores, static_cast<int>(node.cpus.size()));
+    for (unsigned int cpu : node.cpus) {
+      EXPECT_TRUE(seen.insert(cpu).second) << "CPU " << cpu << " is on two nodes";
+    }
+  }
+  EXPECT_FALSE(seen.empty());
+}
+
+static FTVMParallelLambda numa_check_task_id = [](int task_id, TVMParallelGroupEnv* penv,
+                                                  void* cdata) -> int {
+#if defined(__linux__)
+  auto* allowed = reinterpret_cast<std::unordered_set<unsigned int>*>(cdata);
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+  for (unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpuset) && !allowed->count(cpu)) return -1;
+  }
+#endif
+  return 0;
+};
+
+TEST(ThreadingBackend, BindToNumaNode) {
+  // Bind from a fresh thread so the thread pool of the test runner is left alone.
+  std::thread t([]() {
+    const auto& nodes = tvm::runtime::threading::NumaNodes();
+    // Memory-only nodes have no CPUs to bind to.
+    const auto& node = *std::find_if(nodes.begin(), nodes.end(),
+                                     [](const auto& n) { return !n.cpus.empty(); });
+    EXPECT_EQ(tvm::runtime::threading::CurrentNumaNode(), -1);
+    int nthreads = tvm::runtime::threading::BindToNumaNode(node.id);
+    EXPECT_EQ(nthreads, node.num_cores);
+    EXPECT_EQ(tvm::runtime::threading::CurrentNumaNode(), node.id);
+    EXPECT_EQ(tvm::runtime::threading::NumThreads(), nthreads);
+
+    std::atomic<size_t> acc(0);
+    TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+    EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+
+    std::unordered_set<unsigned int> allowed(node.cpus.begin(), node.cpus.end());
+    EXPECT_EQ(TVMBackendParallelLaunch(numa_check_task_id, &allowed, 0), 0);
+  });
+  t.join();
+}
+
+TEST(ThreadingBackend, WorkerPool) {
+  using tvm::runtime::threading::WorkerPool;
+  using tvm::runtime::threading::WorkerPoolScope;
+  WorkerPool pool_a(2), pool_b(3);
+  EXPECT_EQ(pool_a->NumThreads(), 2);
+  EXPECT_EQ(WorkerPoolScope::Current(), nullptr);
+  {
+    WorkerPoolScope scope_a(pool_a);
+    EXPECT_EQ(tvm::runtime::threading::NumThreads(), 2);
+    {
+      WorkerPoolScope scope_b(pool_b);
+      EXPECT_EQ(tvm::runtime::threading::NumThreads(), 3);
+      WorkerPoolScope keep(std::nullopt);
+      EXPECT_EQ(WorkerPoolScope::Current(), pool_b.get());
+    }
+    EXPECT_EQ(WorkerPoolScope::Current(), pool_a.get());
+  }
+  EXPECT_EQ(WorkerPoolScope::Current(), nullptr);
+
+  // Launch on both pools, and twice on the same pool, from different threads at once.
+  std::vector<std::unique_ptr<std::thread>> ts;
+  for (WorkerPool pool : {pool_a, pool_b, pool_b}) {
+    ts.emplace_back(new std::thread([pool]() {
+      WorkerPoolScope scope(pool);
+      for (int i = 0; i < 100; ++i) {
+        std::atomic<size_t> acc(0);
+        TVMBackendParallelLaunch(atomic_add_task_id, &acc, 0);
+        EXPECT_EQ(acc.load(std::memory_order_relaxed), N * (N - 1) / 2);
+      }
+    }));
+  }
+  for (auto& t : ts) {
+    t->join();
+  }
+}
+
 TEST(ThreadingBackend, TVMBackendParallelForWithThreadingBackend) {
   int n = 100;
   std::vector<int> vec(/*size=*/n, /*value=*/0);
@@ -15,6 +15,7 @@
 # specific language governing permissions and limitations
 # under the License.
 import math
+import os
 import re
 
 import numpy as np
@@ -333,6 +334,80 @@ def test_multiple_func():
     tvm.testing.assert_allclose(c.numpy(), a.numpy() + b.numpy())
 
 
+@tvm.testing.requires_llvm
+@pytest.mark.parametrize("background", ["0", "1"])
+def test_lazy_orcjit(monkeypatch, background):
+    n = te.size_var("n")
+    A = te.placeholder((n,), name="A")
+    B = te.placeholder((n,), name="B")
+    C = te.compute((n,), lambda i: A[i] + B[i], name="C")
+    func = te.create_prim_func([A, B, C])
+    mod = tvm.IRModule(
+        {
+            "fadd1": func.with_attr("global_symbol", "fadd1"),
+            "fadd2": func.with_attr("global_symbol", "fadd2"),
+        }
+    )
+
+    temp = utils.tempdir()
+    cache_dir = temp.relpath("jit_cache")
+    monkeypatch.setenv("TVM_LLVM_JIT_CACHE_DIR", cache_dir)
+    monkeypatch.setenv("TVM_LLVM_JIT_BACKGROUND_COMPILE", background)
+
+    cache_stats = tvm.get_global_func("target.llvm_jit_object_cache_stats")
+    dev = tvm.cpu(0)
+    a = tvm.nd.array(np.random.uniform(size=10).astype(A.dtype), dev)
+    b = tvm.nd.array(np.random.uniform(size=10).astype(B.dtype), dev)
+    for i in range(2):
+        hits_before, compiled_before = cache_stats()
+        f = tvm.compile(mod, target="llvm -jit=orcjit-lazy")
+        for name in ["fadd1", "fadd2"]:
+            c = tvm.nd.array(np.zeros(10, dtype=C.dtype), dev)
+            f[name](a, b, c)
+            tvm.testing.assert_allclose(c.numpy(), a.numpy() + b.numpy())
+        hits = cache_stats()[0] - hits_before
+        compiled = cache_stats()[1] - compiled_before
+        if i == 0:
+            assert compiled > 0
+            assert len(os.listdir(cache_dir)) > 0
+        else:
+            # The second load reuses the objects stored by the first one. The
+            # background thread of the first load may have been stopped before
+            # it compiled every function, so only the eager case is exact.
+            assert hits > 0
+            if background == "0":
+                assert compiled == 0
+
+
+@tvm.testing.requires_llvm
+def test_llvm_pgo():
+    @T.prim_func
+    def relu(A: T.Buffer((64,), "float32"), B: T.Buffer((64,), "float32")):
+        for i in range(64):
+            if A[i] > T.float32(0):
+                B[i] = A[i]
+            else:
+                B[i] = T.float32(0)
+
+    mod = tvm.IRModule({"relu": relu.with_attr("global_symbol", "relu")})
+    dev = tvm.cpu(0)
+    a = tvm.nd.array(np.random.uniform(-1, 1, size=64).astype("float32"), dev)
+
+    temp = utils.tempdir()
+    profile = temp.relpath("relu.profdata")
+    f = tvm.compile(mod, target="llvm -profile-generate")
+    b = tvm.nd.array(np.zeros(64, dtype="float32"), dev)
+    f["relu"](a, b)
+    tvm.testing.assert_allclose(b.numpy(), np.maximum(a.numpy(), 0))
+    tvm.target.codegen.llvm_pgo_write_profile(f, profile)
+    assert os.path.getsize(profile) > 0
+
+    f = tvm.compile(mod, target=f"llvm -profile-use={profile}")
+    b = tvm.nd.array(np.zeros(64, dtype="float32"), dev)
+    f["relu"](a, b)
+    tvm.testing.assert_allclose(b.numpy(), np.maximum(a.numpy(), 0))
+
+
 @tvm.testing.requires_llvm
 def test_llvm_condition():
     def check_llvm(n, offset):
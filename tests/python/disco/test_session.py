@@ -311,5 +311,23 @@ def test_num_workers(session_kind, num_workers):
     assert sess.num_workers == num_workers
 
 
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+def test_batch(session_kind):
+    num_workers = 2
+    sess = session_kind(num_workers=num_workers)
+    func: di.DPackedFunc = sess.get_global_func("tests.disco.add_one")
+    # More commands than a single batched message holds
+    sess.begin_batch()
+    results = [func(i) for i in range(300)]
+    fence = sess.end_batch()
+    sess.wait_fence(fence)
+    with sess.batch():
+        result = func(results[-1])
+    for i in range(num_workers):
+        assert results[0].debug_get_from_remote(i) == 1
+        assert results[-1].debug_get_from_remote(i) == 300
+        assert result.debug_get_from_remote(i) == 301
+
+
 if __name__ == "__main__":
     tvm.testing.main()
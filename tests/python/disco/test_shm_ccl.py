@@ -0,0 +1,128 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+# pylint: disable=missing-docstring
+"""Tests for the shared-memory CPU collective backend"""
+import numpy as np
+import pytest
+
+import tvm
+import tvm.testing
+from tvm.runtime import disco as di
+
+_all_session_kinds = [di.ThreadedSession, di.ProcessSession]
+
+pytestmark = pytest.mark.skipif(
+    tvm.get_global_func("runtime.disco.shm.init_ccl", allow_missing=True) is None,
+    reason="The shared-memory CCL is not built",
+)
+
+
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+@pytest.mark.parametrize("dtype", ["float32", "float16", "int32"])
+def test_allreduce(session_kind, dtype):
+    sess = session_kind(num_workers=2)
+    sess.init_ccl("shm", 0, 1)
+
+    array_1 = np.arange(12).astype(dtype).reshape(3, 4)
+    array_2 = np.arange(start=1, stop=-11, step=-1).astype(dtype).reshape(3, 4)
+    d_array = sess.empty((3, 4), dtype)
+    d_array.debug_copy_from(0, array_1)
+    d_array.debug_copy_from(1, array_2)
+    for op, np_op in [  # pylint: disable=invalid-name
+        ("sum", np.add),
+        ("prod", np.multiply),
+        ("min", np.minimum),
+        ("max", np.maximum),
+    ]:
+        dst_array = sess.empty((3, 4), dtype)
+        sess.allreduce(d_array, dst_array, op=op)
+        expected = np_op(array_1, array_2)
+        for worker_id in range(2):
+            np.testing.assert_equal(dst_array.debug_get_from_remote(worker_id).numpy(), expected)
+
+
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+def test_allreduce_chunked(session_kind, monkeypatch):
+    # A single-page slot forces the reduction to proceed in several chunks.
+    monkeypatch.setenv("TVM_DISCO_SHM_SLOT_BYTES", "4096")
+    num_workers = 3
+    sess = session_kind(num_workers=num_workers)
+    sess.init_ccl("shm", *range(num_workers))
+
+    arrays = [np.random.uniform(size=(5000,)).astype("float32") for _ in range(num_workers)]
+    d_array = sess.empty((5000,), "float32")
+    for worker_id, array in enumerate(arrays):
+        d_array.debug_copy_from(worker_id, array)
+    dst_array = sess.empty((5000,), "float32")
+    sess.allreduce(d_array, dst_array, op="avg")
+    tvm.testing.assert_allclose(
+        dst_array.debug_get_from_remote(2).numpy(), sum(arrays) / num_workers, rtol=1e-6
+    )
+
+
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+def test_group_allreduce(session_kind):
+    sess = session_kind(num_workers=4, num_groups=2)
+    sess.init_ccl("shm", 0, 1, 2, 3)
+
+    arrays = [np.arange(12, dtype="float32").reshape(3, 4) * (i + 1) for i in range(4)]
+    d_array = sess.empty((3, 4), "float32")
+    for worker_id, array in enumerate(arrays):
+        d_array.debug_copy_from(worker_id, array)
+    dst_array = sess.empty((3, 4), "float32")
+    sess.allreduce(d_array, dst_array, op="sum", in_group=True)
+    np.testing.assert_equal(dst_array.debug_get_from_remote(1).numpy(), arrays[0] + arrays[1])
+    np.testing.assert_equal(dst_array.debug_get_from_remote(3).numpy(), arrays[2] + arrays[3])
+
+
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+def test_allgather(session_kind):
+    sess = session_kind(num_workers=2)
+    sess.init_ccl("shm", 0, 1)
+
+    array = np.arange(36, dtype="float32")
+    d_src = sess.empty((3, 3, 2), "float32")
+    d_dst = sess.empty((3, 4, 3), "float32")
+    d_src.debug_copy_from(0, array[:18])
+    d_src.debug_copy_from(1, array[18:])
+    sess.allgather(d_src, d_dst)
+    for worker_id in range(2):
+        np.testing.assert_equal(
+            d_dst.debug_get_from_remote(worker_id).numpy(), array.reshape(3, 4, 3)
+        )
+
+
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+def test_broadcast_scatter_gather(session_kind):
+    sess = session_kind(num_workers=2)
+    sess.init_ccl("shm", 0, 1)
+
+    array = np.arange(36, dtype="float32").reshape(2, 6, 3)
+    d_bcast = sess.broadcast(array)
+    np.testing.assert_equal(d_bcast.debug_get_from_remote(1).numpy(), array)
+
+    d_shard = sess.scatter(array)
+    np.testing.assert_equal(d_shard.debug_get_from_remote(0).numpy(), array[0])
+    np.testing.assert_equal(d_shard.debug_get_from_remote(1).numpy(), array[1])
+
+    d_gathered = sess.empty((2, 6, 3), "float32", worker0_only=True)
+    sess.gather_to_worker0(d_shard, d_gathered)
+    np.testing.assert_equal(d_gathered.debug_get_from_remote(0).numpy(), array)
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
@@ -0,0 +1,87 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+# pylint: disable=missing-docstring
+"""Tests for the point-to-point socket communication backend"""
+import numpy as np
+import pytest
+
+import tvm
+import tvm.testing
+from tvm.runtime import disco as di
+
+_all_session_kinds = [di.ThreadedSession, di.ProcessSession]
+
+pytestmark = pytest.mark.skipif(
+    tvm.get_global_func("runtime.disco.socket.init_ccl", allow_missing=True) is None,
+    reason="The socket CCL is not built",
+)
+
+
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+def test_send_to_next_group_receive_from_prev_group(session_kind):
+    sess = session_kind(num_workers=4, num_groups=2)
+    sess.init_ccl("socket", 0, 1, 2, 3)
+
+    array_1 = np.arange(12, dtype="float32").reshape(3, 4)
+    array_2 = np.arange(start=1, stop=-11, step=-1, dtype="float32").reshape(3, 4)
+    d_array = sess.empty((3, 4), "float32")
+    d_array.debug_copy_from(0, array_1)
+    d_array.debug_copy_from(1, array_2)
+    sess.get_global_func("runtime.disco.socket.test_send_to_next_group_recv_from_prev_group")(
+        d_array
+    )
+
+    np.testing.assert_equal(d_array.debug_get_from_remote(2).numpy(), array_1)
+    np.testing.assert_equal(d_array.debug_get_from_remote(3).numpy(), array_2)
+
+
+@pytest.mark.parametrize("session_kind", _all_session_kinds)
+def test_worker2_send_to_worker0(session_kind):
+    sess = session_kind(num_workers=4, num_groups=2)
+    sess.init_ccl("socket", 0, 1, 2, 3)
+
+    # Large enough to need many non-blocking writes.
+    array = np.random.uniform(size=(1 << 22,)).astype("float32")
+    d_array = sess.empty(array.shape, "float32")
+    d_array.debug_copy_from(2, array)
+    f_send = sess.get_global_func("runtime.disco.socket.test_worker2_sends_to_worker0")
+    for _ in range(3):
+        f_send(d_array)
+    sess.sync_worker_0()
+
+    np.testing.assert_equal(d_array.debug_get_from_remote(0).numpy(), array)
+
+
+def test_pipeline_of_three_groups():
+    sess = di.ProcessSession(num_workers=3, num_groups=3)
+    sess.init_ccl("socket", 0, 1, 2)
+
+    arrays = [np.full((64,), i, dtype="int32") for i in range(3)]
+    d_array = sess.empty((64,), "int32")
+    for worker_id, array in enumerate(arrays):
+        d_array.debug_copy_from(worker_id, array)
+    # Every stage forwards its own array and then takes over the one of the previous stage.
+    sess.get_global_func("runtime.disco.socket.test_send_to_next_group_recv_from_prev_group")(
+        d_array
+    )
+
+    np.testing.assert_equal(d_array.debug_get_from_remote(1).numpy(), arrays[0])
+    np.testing.assert_equal(d_array.debug_get_from_remote(2).numpy(), arrays[1])
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
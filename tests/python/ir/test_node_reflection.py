@@ -195,5 +195,55 @@ def test_alloc_const():
     np.testing.assert_array_equal(np_data, alloc_const2.data.numpy())
 
 
+def test_saveload_binary():
+    x = tvm.tir.Var("x", "int32")
+    y = tvm.tir.const(-10, "int32")
+    z = tvm.tir.Let(x, y, x * x + tvm.tir.const(2.5, "float32").astype("int32"))
+    blob = tvm.ir.save_binary(z)
+    assert isinstance(blob, bytes)
+    tvm.ir.assert_structural_equal(tvm.ir.load_binary(blob), z)
+
+    smap = tvm.runtime.convert({"z": 2, "x": 3})
+    tvm.ir.assert_structural_equal(tvm.ir.load_binary(tvm.ir.save_binary(smap)), smap)
+
+
+def test_ndarray_binary():
+    dev = tvm.cpu(0)
+    m1 = {
+        "key1": tvm.nd.array(np.random.rand(4), device=dev),
+        "key2": tvm.nd.array(np.random.rand(3, 5).astype("float16"), device=dev),
+    }
+    blob = tvm.ir.save_binary(m1)
+    m2 = tvm.ir.load_binary(blob)
+    tvm.ir.assert_structural_equal(m1, m2)
+    for key in m1:
+        np.testing.assert_array_equal(m1[key].numpy(), m2[key].numpy())
+    # the binary format stores tensor data without base64 expansion
+    assert len(blob) < len(tvm.ir.save_json(m1))
+
+
+@pytest.mark.skipif(not sys.platform.startswith("linux"), reason="relies on mmap of the file")
+def test_ndarray_binary_file_lazy(tmp_path):
+    dev = tvm.cpu(0)
+    small = np.arange(4).astype("int32")
+    large = np.random.rand(1 << 18).astype("float32")
+    path = tmp_path / "params.bin"
+    params = {"small": tvm.nd.array(small, dev), "large": tvm.nd.array(large, dev)}
+    path.write_bytes(tvm.ir.save_binary(params))
+
+    loaded = tvm.ir.load_binary_file(path)
+    np.testing.assert_array_equal(loaded["small"].numpy(), small)
+    # Rewrite the large blob in the file after loading. The tensor still reads the new
+    # data, which shows that the blob was not read by load_binary_file.
+    payload = path.read_bytes()
+    offset = payload.find(large.tobytes())
+    assert offset >= 0 and offset % 64 == 0
+    updated = large + 1
+    with open(path, "r+b") as f:
+        f.seek(offset)
+        f.write(updated.tobytes())
+    np.testing.assert_array_equal(loaded["large"].numpy(), updated)
+
+
 if __name__ == "__main__":
     tvm.testing.main()
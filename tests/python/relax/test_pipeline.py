@@ -48,6 +48,30 @@ def test_pipeline_compile():
     tvm.testing.assert_allclose(z.numpy(), x_np + y_np, rtol=1e-7, atol=1e-7)
 
 
+def test_pipeline_with_object_arena():
+    target = tvm.target.Target("llvm", host="llvm")
+
+    @tvm.script.ir_module
+    class Mod:
+        @R.function
+        def main(x: R.Tensor((3, 4), "float32"), y: R.Tensor((3, 4), "float32")):
+            lv0 = R.add(x, y)
+            lv1 = R.multiply(lv0, y)
+            return lv1
+
+    # The nodes created by the pipeline outlive its arena scope.
+    with tvm.transform.PassContext(config={"transform.use_object_arena": True}):
+        mod = relax.pipeline.get_default_pipeline(target)(Mod)
+        ex = tvm.compile(mod, target)
+
+    x_np = np.random.rand(3, 4).astype(np.float32)
+    y_np = np.random.rand(3, 4).astype(np.float32)
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    z = vm["main"](tvm.nd.array(x_np), tvm.nd.array(y_np))
+    tvm.testing.assert_allclose(z.numpy(), (x_np + y_np) * y_np, rtol=1e-6, atol=1e-6)
+    assert "main" in [gv.name_hint for gv in mod.get_global_vars()]
+
+
 def test_pipeline_with_kv_cache():
     """A dummy pipline that simulates KV update."""
     target = tvm.target.Target("llvm", host="llvm")
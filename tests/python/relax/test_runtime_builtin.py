@@ -213,6 +213,26 @@ def test_ndarray_cache_update():
         np.testing.assert_allclose(v.numpy(), v_np, atol=1e-6, rtol=1e-6)
 
 
+def test_ndarray_cache_stream():
+    fcreate = tvm.get_global_func("vm.builtin.ndarray_cache_stream.create")
+    fget = tvm.get_global_func("vm.builtin.ndarray_cache_stream.get")
+    fas_fget_param = tvm.get_global_func("vm.builtin.ndarray_cache_stream.as_fget_param")
+
+    # Each parameter is larger than half of the shard cap, and is stored in its own shard.
+    param_dict = {f"x_{i}": np.random.uniform(size=[256, 1024]).astype("float32") for i in range(4)}
+    temp = utils.tempdir()
+    tvmjs.dump_ndarray_cache(param_dict, temp.path, encode_format="raw", shard_cap_mb=1)
+
+    stream = fcreate(str(temp.path), tvm.cpu().device_type, 0, 2)
+    for name in ["x_2", "x_0", "x_3", "x_1", "x_2"]:
+        np.testing.assert_equal(fget(stream, name).numpy(), param_dict[name])
+
+    fget_param = fas_fget_param(fcreate(str(temp.path), tvm.cpu().device_type, 0, 1))
+    for i in range(4):
+        np.testing.assert_equal(fget_param(i).numpy(), param_dict[f"x_{i}"])
+        np.testing.assert_equal(fget_param(i, f"x_{3 - i}").numpy(), param_dict[f"x_{3 - i}"])
+
+
 def test_attention_kv_cache_window_override():
     fcreate = tvm.get_global_func("vm.builtin.attention_kv_cache_create")
     foverride = tvm.get_global_func("vm.builtin.attention_kv_cache_window_override")
@@ -0,0 +1,226 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import ir as I
+from tvm.script import relax as R
+from tvm.script import tir as T
+
+
+def test_remove_permute_dims_round_trip():
+    @I.ir_module
+    class Before:
+        @R.function
+        def main(x: R.Tensor((2, 3, 4), "float32")):
+            with R.dataflow():
+                a = R.permute_dims(x, axes=[1, 0, 2])
+                b = R.permute_dims(a, axes=[1, 0, 2])
+                c = R.add(b, b)
+                R.output(c)
+            return c
+
+    @I.ir_module
+    class Expected:
+        @R.function
+        def main(x: R.Tensor((2, 3, 4), "float32")):
+            with R.dataflow():
+                c = R.add(x, x)
+                R.output(c)
+            return c
+
+    after = relax.transform.EliminateRedundantCopies()(Before)
+    tvm.ir.assert_structural_equal(after, Expected)
+
+
+def test_fold_permute_dims_chain():
+    @I.ir_module
+    class Before:
+        @R.function
+        def main(x: R.Tensor((2, 3, 4), "float32")):
+            with R.dataflow():
+                a = R.permute_dims(x, axes=[1, 0, 2])
+                b = R.permute_dims(a, axes=[0, 2, 1])
+                R.output(b)
+            return b
+
+    @I.ir_module
+    class Expected:
+        @R.function
+        def main(x: R.Tensor((2, 3, 4), "float32")):
+            with R.dataflow():
+                b = R.permute_dims(x, axes=[1, 2, 0])
+                R.output(b)
+            return b
+
+    after = relax.transform.EliminateRedundantCopies()(Before)
+    tvm.ir.assert_structural_equal(after, Expected)
+
+
+def test_fold_reshape_chain():
+    @I.ir_module
+    class Before:
+        @R.function
+        def main(x: R.Tensor((2, 3, 4), "float32")):
+            with R.dataflow():
+                a = R.reshape(x, (6, 4))
+                b = R.reshape(a, (4, 6))
+                R.output(b)
+            return b
+
+    @I.ir_module
+    class Expected:
+        @R.function
+        def main(x: R.Tensor((2, 3, 4), "float32")):
+            with R.dataflow():
+                b = R.reshape(x, (4, 6))
+                R.output(b)
+            return b
+
+    after = relax.transform.EliminateRedundantCopies()(Before)
+    tvm.ir.assert_structural_equal(after, Expected)
+
+
+def test_remove_identity_astype():
+    @I.ir_module
+    class Before:
+        @R.function
+        def main(x: R.Tensor((4, 4), "float32")):
+            with R.dataflow():
+                a = R.astype(x, "float32")
+                b = R.add(a, x)
+                R.output(b)
+            return b
+
+    @I.ir_module
+    class Expected:
+        @R.function
+        def main(x: R.Tensor((4, 4), "float32")):
+            with R.dataflow():
+                b = R.add(x, x)
+                R.output(b)
+            return b
+
+    after = relax.transform.EliminateRedundantCopies()(Before)
+    tvm.ir.assert_structural_equal(after, Expected)
+
+
+def test_remove_identity_copy_prim_func():
+    @I.ir_module
+    class Before:
+        @T.prim_func(private=True)
+        def copy(A: T.Buffer((4, 4), "float32"), B: T.Buffer((4, 4), "float32")):
+            for i, j in T.grid(4, 4):
+                with T.block("copy"):
+                    vi, vj = T.axis.remap("SS", [i, j])
+                    B[vi, vj] = A[vi, vj]
+
+        @R.function
+        def main(x: R.Tensor((4, 4), "float32")):
+            cls = Before
+            with R.dataflow():
+                a = R.call_tir(cls.copy, (x,), out_sinfo=R.Tensor((4, 4), "float32"))
+                b = R.add(a, a)
+                R.output(b)
+            return b
+
+    @I.ir_module
+    class Expected:
+        @T.prim_func(private=True)
+        def copy(A: T.Buffer((4, 4), "float32"), B: T.Buffer((4, 4), "float32")):
+            for i, j in T.grid(4, 4):
+                with T.block("copy"):
+                    vi, vj = T.axis.remap("SS", [i, j])
+                    B[vi, vj] = A[vi, vj]
+
+        @R.function
+        def main(x: R.Tensor((4, 4), "float32")):
+            with R.dataflow():
+                b = R.add(x, x)
+                R.output(b)
+            return b
+
+    after = relax.transform.EliminateRedundantCopies()(Before)
+    tvm.ir.assert_structural_equal(after, Expected)
+
+
+def test_keep_transposing_prim_func():
+    @I.ir_module
+    class Before:
+        @T.prim_func(private=True)
+        def transpose(A: T.Buffer((4, 4), "float32"), B: T.Buffer((4, 4), "float32")):
+            for i, j in T.grid(4, 4):
+                with T.block("transpose"):
+                    vi, vj = T.axis.remap("SS", [i, j])
+                    B[vi, vj] = A[vj, vi]
+
+        @R.function
+        def main(x: R.Tensor((4, 4), "float32")):
+            cls = Before
+            with R.dataflow():
+                a = R.call_tir(cls.transpose, (x,), out_sinfo=R.Tensor((4, 4), "float32"))
+                R.output(a)
+            return a
+
+    after = relax.transform.EliminateRedundantCopies()(Before)
+    tvm.ir.assert_structural_equal(after, Before)
+
+
+def test_no_alias_with_inplace_call():
+    @I.ir_module
+    class Before:
+        @T.prim_func(private=True)
+        def add_inplace(A: T.Buffer((4, 4), "float32"), B: T.Buffer((4, 4), "float32")):
+            for i, j in T.grid(4, 4):
+                with T.block("add"):
+                    vi, vj = T.axis.remap("SS", [i, j])
+                    A[vi, vj] = A[vi, vj] + B[vi, vj]
+
+        @R.function
+        def main(x: R.Tensor((4, 4), "float32")):
+            cls = Before
+            with R.dataflow():
+                a = R.astype(x, "float32")
+                b = R.call_tir_inplace(
+                    cls.add_inplace,
+                    (a, x),
+                    inplace_indices=[0],
+                    out_sinfo=R.Tensor((4, 4), "float32"),
+                )
+                R.output(b)
+            return b
+
+    after = relax.transform.EliminateRedundantCopies()(Before)
+    tvm.ir.assert_structural_equal(after, Before)
+
+
+def test_no_alias_with_impure_call():
+    @I.ir_module
+    class Before:
+        @R.function(pure=False)
+        def main(x: R.Tensor((4, 4), "float32")):
+            a = R.astype(x, "float32")
+            _ = R.call_packed("test.fill_zeros", a, sinfo_args=R.Tuple())
+            b = R.add(a, x)
+            return b
+
+    after = relax.transform.EliminateRedundantCopies()(Before)
+    tvm.ir.assert_structural_equal(after, Before)
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
@@ -324,6 +324,76 @@ def test_fold_multiple_relax_ops():
     tvm.ir.assert_structural_equal(after, expected)
 
 
+def test_fold_independent_relax_ops_with_scalar():
+    # The independent ops are evaluated together, and the scalar read by legalization of the
+    # last op is evaluated before it.
+    @tvm.script.ir_module
+    class Module:
+        @R.function
+        def before(c0: R.Tensor((16, 16), "float32"), c1: R.Tensor((16, 16), "float32")):
+            with R.dataflow():
+                lv0 = R.permute_dims(c0)
+                lv1 = R.add(c1, c1)
+                lv2 = R.sum(c1)
+                lv3 = R.multiply(lv0, lv1)
+                gv = R.add(lv3, lv2)
+                R.output(gv)
+            return gv
+
+        @R.function
+        def expected(c2: R.Tensor((16, 16), "float32")):
+            return c2
+
+    c0_np = np.arange((16 * 16)).astype("float32").reshape(16, 16)
+    c1_np = np.arange((16 * 16)).astype("float32").reshape(16, 16) * 2
+    c2_np = c0_np.T * (c1_np + c1_np) + c1_np.sum()
+    before = gen_mod(Module, "before", {"c0": c0_np, "c1": c1_np})
+    expected = gen_mod(Module, "expected", {"c2": c2_np})
+
+    after = relax.transform.FoldConstant()(before)
+    tvm.ir.assert_structural_equal(after, expected)
+
+
+def test_fold_independent_parallel_prim_funcs():
+    # The folded kernels launch parallel jobs of their own.
+    @tvm.script.ir_module
+    class Module:
+        @T.prim_func
+        def addone(A: T.Buffer((16, 16), "float32"), B: T.Buffer((16, 16), "float32")) -> None:
+            for i in T.parallel(16):
+                for j in T.serial(16):
+                    with T.block("addone"):
+                        vi, vj = T.axis.remap("SS", [i, j])
+                        B[vi, vj] = A[vi, vj] + T.float32(1)
+
+        @T.prim_func
+        def double(A: T.Buffer((16, 16), "float32"), B: T.Buffer((16, 16), "float32")) -> None:
+            for i in T.parallel(16):
+                for j in T.serial(16):
+                    with T.block("double"):
+                        vi, vj = T.axis.remap("SS", [i, j])
+                        B[vi, vj] = A[vi, vj] * T.float32(2)
+
+        @R.function
+        def before(c0: R.Tensor((16, 16), "float32"), c1: R.Tensor((16, 16), "float32")):
+            cls = Module
+            lv0 = relax.call_tir(cls.addone, (c0,), R.Tensor((16, 16), dtype="float32"))
+            lv1 = relax.call_tir(cls.double, (c1,), R.Tensor((16, 16), dtype="float32"))
+            return (lv0, lv1)
+
+        @R.function
+        def expected(c2: R.Tensor((16, 16), "float32"), c3: R.Tensor((16, 16), "float32")):
+            return (c2, c3)
+
+    c0_np = np.arange((16 * 16)).astype("float32").reshape(16, 16)
+    c1_np = np.arange((16 * 16)).astype("float32").reshape(16, 16) * 3
+    before = gen_mod(Module, "before", {"c0": c0_np, "c1": c1_np})
+    expected = gen_mod(Module, "expected", {"c2": c0_np + 1, "c3": c1_np * 2})
+
+    after = relax.transform.FoldConstant()(before)
+    tvm.ir.assert_structural_equal(after, expected)
+
+
 def test_do_not_fold_ops_outside_dataflow():
     # put before after in a single module
     @tvm.script.ir_module
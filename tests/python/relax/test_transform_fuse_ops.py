@@ -1694,5 +1694,65 @@ def test_packed_params():
     _check(Before, Expected)
 
 
+def _fuse_with_cost_model(mod, **config):
+    mod = relax.transform.LegalizeOps()(mod)
+    mod = relax.transform.AnnotateTIROpPattern()(mod)
+    config = {"relax.FuseOps." + key: value for key, value in config.items()}
+    with tvm.transform.PassContext(config={"relax.FuseOps.cost_model": True, **config}):
+        return relax.transform.FuseOps()(mod)
+
+
+def _num_fused_functions(mod):
+    return len(
+        [
+            func
+            for func in mod.functions.values()
+            if isinstance(func, relax.Function) and "Primitive" in func.attrs
+        ]
+    )
+
+
+def test_cost_model_max_fused_flops():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((16, 16), "float32")):
+            with R.dataflow():
+                a = R.add(x, x)
+                b = R.add(a, a)
+                c = R.add(b, b)
+                R.output(c)
+            return c
+
+    # Each add takes 256 flops, so only two of them fit in a fused function.
+    after = _fuse_with_cost_model(Module, max_fused_flops=512)
+    assert _num_fused_functions(after) == 1
+    assert len(after["main"].body.blocks[0].bindings) == 2
+
+    after = _fuse_with_cost_model(Module, max_fused_flops=1024)
+    assert _num_fused_functions(after) == 1
+    assert len(after["main"].body.blocks[0].bindings) == 1
+
+
+def test_cost_model_no_recompute_for_broadcast():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((16,), "float32"), y: R.Tensor((64, 16), "float32")):
+            with R.dataflow():
+                a = R.add(x, x)
+                b = R.add(y, a)
+                R.output(b)
+            return b
+
+    # The broadcast reads each element of a 64 times, so fusing recomputes the add 63 times
+    # per element. That is cheaper than the memory traffic of a only at the default weight.
+    after = _fuse_with_cost_model(Module)
+    assert _num_fused_functions(after) == 1
+
+    after = _fuse_with_cost_model(Module, flops_per_byte=1)
+    assert _num_fused_functions(after) == 0
+
+
 if __name__ == "__main__":
     tvm.testing.main()
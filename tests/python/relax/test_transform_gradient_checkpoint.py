@@ -751,5 +751,56 @@ def test_checkpoint_with_intermediate_require_grads():
     assert_structural_equal(After, Expected)
 
 
+@I.ir_module
+class PowerChain:
+    @R.function
+    def main(x: R.Tensor((3, 3), "float32")):
+        with R.dataflow():
+            lv1 = R.power(x, R.const(3, "float32"))
+            lv2 = R.power(lv1, R.const(3, "float32"))
+            lv3 = R.power(lv2, R.const(3, "float32"))
+            lv4 = R.power(lv3, R.const(3, "float32"))
+            gv = R.sum(lv4)
+            R.output(gv)
+        return gv
+
+
+def test_checkpoint_activations():
+    # The four activations take 144 bytes. Recomputing lv1 and lv3 keeps 72 bytes of
+    # checkpoints, and 36 bytes are recomputed at a time.
+    @I.ir_module
+    class Expected:
+        @R.function
+        def main(x: R.Tensor((3, 3), "float32")) -> R.Tensor((), "float32"):
+            with R.dataflow():
+                x_scp = R.grad.start_checkpoint(x)
+                lv1 = R.power(x_scp, R.const(3, "float32"))
+                lv1_ecp = R.grad.end_checkpoint(lv1)
+                lv2 = R.power(lv1_ecp, R.const(3, "float32"))
+                lv2_scp = R.grad.start_checkpoint(lv2)
+                lv3 = R.power(lv2_scp, R.const(3, "float32"))
+                lv3_ecp = R.grad.end_checkpoint(lv3)
+                lv4 = R.power(lv3_ecp, R.const(3, "float32"))
+                gv = R.sum(lv4)
+                R.output(gv)
+            return gv
+
+    After = relax.transform.CheckpointActivations("main", memory_budget=120)(PowerChain)
+    assert_structural_equal(After, Expected)
+
+    After = relax.transform.Gradient("main")(After)
+    recomputed = [
+        binding.var.name_hint
+        for binding in After["main_adjoint"].body.blocks[0].bindings
+        if binding.var.name_hint.endswith("_cp")
+    ]
+    assert sorted(recomputed) == ["lv1_cp", "lv3_cp"]
+
+
+def test_checkpoint_activations_within_budget():
+    After = relax.transform.CheckpointActivations("main", memory_budget=1024)(PowerChain)
+    assert_structural_equal(After, PowerChain)
+
+
 if __name__ == "__main__":
     tvm.testing.main()
@@ -0,0 +1,159 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import numpy as np
+
+import tvm
+import tvm.testing
+from tvm import relax, tir
+from tvm.script import ir as I
+from tvm.script import relax as R
+
+
+def _lower(mod):
+    mod = relax.transform.LegalizeOps()(mod)
+    return relax.transform.AnnotateTIROpPattern()(mod)
+
+
+def _call_tir_callees(func):
+    callees = []
+
+    def fvisit(expr):
+        if isinstance(expr, relax.Call) and expr.op == tvm.ir.Op.get("relax.call_tir"):
+            callees.append(expr.args[0].name_hint)
+
+    relax.analysis.post_order_visit(func.body, fvisit)
+    return callees
+
+
+def _fused_prim_funcs(mod):
+    return [
+        func
+        for gv, func in mod.functions.items()
+        if isinstance(func, tir.PrimFunc) and gv.name_hint.startswith("fused_")
+    ]
+
+
+def _num_blocks(func):
+    blocks = []
+    tir.stmt_functor.post_order_visit(
+        func.body, lambda stmt: blocks.append(stmt) if isinstance(stmt, tir.Block) else None
+    )
+    # Exclude the root block.
+    return len(blocks) - 1
+
+
+def _check_numerics(before, after, *inputs):
+    dev = tvm.cpu()
+    results = []
+    for mod in [before, after]:
+        vm = relax.VirtualMachine(tvm.compile(mod, target="llvm"), dev)
+        results.append(vm["main"](*[tvm.nd.array(x, dev) for x in inputs]).numpy())
+    tvm.testing.assert_allclose(results[0], results[1], rtol=1e-5, atol=1e-5)
+
+
+def test_fuse_independent_elementwise():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((16, 16), "float32"), y: R.Tensor((16, 16), "float32")):
+            with R.dataflow():
+                a = R.add(x, y)
+                b = R.multiply(x, y)
+                c = R.exp(x)
+                d = R.subtract(a, b)
+                e = R.add(d, c)
+                R.output(e)
+            return e
+
+    before = _lower(Module)
+    after = relax.transform.HorizontalFuseOps()(before)
+
+    # a, b and c are fused, d and e depend on them and stay as they are.
+    assert len(_call_tir_callees(after["main"])) == 3
+    fused = _fused_prim_funcs(after)
+    assert len(fused) == 1
+    assert _num_blocks(fused[0]) == 3
+    # The three kernels share their loops.
+    assert isinstance(fused[0].body.block.body, tir.For)
+
+    x = np.random.uniform(size=(16, 16)).astype("float32")
+    y = np.random.uniform(size=(16, 16)).astype("float32")
+    _check_numerics(before, after, x, y)
+
+
+def test_fuse_reduction_with_elementwise():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((16, 32), "float32"), y: R.Tensor((16,), "float32")):
+            with R.dataflow():
+                a = R.sum(x, axis=[1])
+                b = R.add(y, y)
+                c = R.multiply(a, b)
+                R.output(c)
+            return c
+
+    before = _lower(Module)
+    after = relax.transform.HorizontalFuseOps()(before)
+
+    assert len(_call_tir_callees(after["main"])) == 2
+    fused = _fused_prim_funcs(after)
+    assert len(fused) == 1
+    assert isinstance(fused[0].body.block.body, tir.For)
+
+    x = np.random.uniform(size=(16, 32)).astype("float32")
+    y = np.random.uniform(size=(16,)).astype("float32")
+    _check_numerics(before, after, x, y)
+
+
+def test_no_fusion_of_dependent_or_mismatched_kernels():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((16, 16), "float32"), y: R.Tensor((16,), "float32")):
+            with R.dataflow():
+                a = R.add(x, x)
+                b = R.multiply(y, y)
+                c = R.exp(a)
+                R.output(b, c)
+            return (b, c)
+
+    before = _lower(Module)
+    after = relax.transform.HorizontalFuseOps()(before)
+    tvm.ir.assert_structural_equal(after, before)
+
+
+def test_max_group_size():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((16, 16), "float32")):
+            with R.dataflow():
+                a = R.add(x, x)
+                b = R.multiply(x, x)
+                c = R.exp(x)
+                d = R.tuple(a, b, c)
+                R.output(d)
+            return d
+
+    after = relax.transform.HorizontalFuseOps(max_group_size=2)(_lower(Module))
+    assert len(_call_tir_callees(after["main"])) == 2
+    assert len(_fused_prim_funcs(after)) == 1
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
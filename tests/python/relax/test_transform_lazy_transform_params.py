@@ -20,6 +20,7 @@ import tvm
 import tvm.testing
 
 from tvm import relax
+from tvm.contrib import tvmjs, utils
 from tvm.script import relax as R, tir as T
 from tvm.script import ir as I
 from tvm.relax.transform import LazyTransformParams
@@ -1186,5 +1187,94 @@ def test_set_output_callback_with_non_tuple_output():
     tvm.ir.assert_structural_equal(After, Expected)
 
 
+def test_stream_params_from_ndarray_cache():
+    """The lazy transform can read its inputs from an NDArray cache stream"""
+
+    @I.ir_module
+    class Module:
+        @R.function
+        def transform_params(A: R.Tensor([16, 16], "float32"), B: R.Tensor([16, 16], "float32")):
+            C = R.multiply(A, R.const(2, "float32"))
+            D = R.add(C, B)
+            return (D, C)
+
+    mod = relax.transform.LazyGetInput()(Module)
+    mod = relax.transform.LazySetOutput()(mod)
+    built = tvm.compile(mod, target="llvm")
+    dev = tvm.cpu()
+
+    params = {
+        "A": np.random.random(size=(16, 16)).astype("float32"),
+        "B": np.random.random(size=(16, 16)).astype("float32"),
+    }
+    temp = utils.tempdir()
+    tvmjs.dump_ndarray_cache(params, temp.path, encode_format="raw", show_progress=False)
+    stream = tvm.get_global_func("vm.builtin.ndarray_cache_stream.create")(
+        str(temp.path), dev.device_type, dev.device_id, 2
+    )
+    fget_param = tvm.get_global_func("vm.builtin.ndarray_cache_stream.as_fget_param")(stream)
+
+    transformed = {}
+
+    def fset_output(i, value):
+        transformed[i] = value.numpy()
+
+    vm = relax.VirtualMachine(built, dev)
+    vm["transform_params"](fget_param, fset_output)
+
+    tvm.testing.assert_allclose(transformed[0], params["A"] * 2 + params["B"])
+    tvm.testing.assert_allclose(transformed[1], params["A"] * 2)
+
+
+def test_stream_params_frees_each_param_after_last_use():
+    """Only the parameters in use are alive when streaming from an NDArray cache"""
+
+    @I.ir_module
+    class Module:
+        @R.function
+        def transform_params(
+            A: R.Tensor([256, 256], "float32"),
+            B: R.Tensor([256, 256], "float32"),
+            C: R.Tensor([256, 256], "float32"),
+            D: R.Tensor([256, 256], "float32"),
+        ):
+            A_out = R.multiply(A, R.const(2, "float32"))
+            B_out = R.multiply(B, R.const(2, "float32"))
+            C_out = R.multiply(C, R.const(2, "float32"))
+            D_out = R.multiply(D, R.const(2, "float32"))
+            return (A_out, B_out, C_out, D_out)
+
+    mod = relax.transform.LazyGetInput()(Module)
+    mod = relax.transform.LazySetOutput()(mod)
+    built = tvm.compile(mod, target="llvm")
+    dev = tvm.cpu()
+
+    params = {
+        name: np.random.random(size=(256, 256)).astype("float32") for name in ["A", "B", "C", "D"]
+    }
+    param_bytes = params["A"].nbytes
+    temp = utils.tempdir()
+    tvmjs.dump_ndarray_cache(params, temp.path, encode_format="raw", show_progress=False)
+    stream = tvm.get_global_func("vm.builtin.ndarray_cache_stream.create")(
+        str(temp.path), dev.device_type, dev.device_id, 2
+    )
+    fget_param = tvm.get_global_func("vm.builtin.ndarray_cache_stream.as_fget_param")(stream)
+
+    num_outputs = [0]
+
+    def fset_output(i, value):
+        num_outputs[0] += 1
+
+    vm = relax.VirtualMachine(built, dev)
+    vm["transform_params"](fget_param, fset_output)
+    del fget_param
+
+    assert num_outputs[0] == 4
+    peak_live_bytes = tvm.get_global_func("vm.builtin.ndarray_cache_stream.peak_live_bytes")
+    # Each parameter is freed after its last use, instead of all of them being kept alive
+    # until the transform returns.
+    assert param_bytes <= peak_live_bytes(stream) < 2 * param_bytes
+
+
 if __name__ == "__main__":
     tvm.testing.main()
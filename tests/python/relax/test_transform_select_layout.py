@@ -0,0 +1,178 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import re
+
+import numpy as np
+
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import ir as I
+from tvm.script import relax as R
+
+
+@I.ir_module
+class TwoConv:
+    @R.function
+    def main(
+        x: R.Tensor((1, 16, 28, 28), "float32"),
+        w1: R.Tensor((16, 16, 3, 3), "float32"),
+        w2: R.Tensor((16, 16, 3, 3), "float32"),
+    ):
+        with R.dataflow():
+            a = R.nn.conv2d(x, w1, padding=[1, 1, 1, 1])
+            b = R.nn.relu(a)
+            c = R.nn.conv2d(b, w2, padding=[1, 1, 1, 1])
+            R.output(c)
+        return c
+
+
+def _bindings(mod, op_name):
+    op = tvm.ir.Op.get(op_name)
+    return [
+        binding
+        for binding in mod["main"].body.blocks[0].bindings
+        if isinstance(binding.value, relax.Call) and binding.value.op == op
+    ]
+
+
+def test_select_blocked_layout():
+    def fcost(call, data_layout, kernel_layout):
+        return 1e4 if data_layout == "NCHW4c" else 1e6
+
+    with tvm.target.Target("llvm"):
+        after = relax.transform.SelectLayout(fcost)(TwoConv)
+
+    convs = _bindings(after, "relax.nn.conv2d")
+    assert [conv.value.attrs.data_layout for conv in convs] == ["NCHW4c", "NCHW4c"]
+    assert [conv.value.attrs.kernel_layout for conv in convs] == ["OIHW4i4o", "OIHW4i4o"]
+    # The relu between the conv2d ops stays in the blocked layout.
+    (relu,) = _bindings(after, "relax.nn.relu")
+    assert relu.var.struct_info.ndim == 5
+    # The input, the two kernels and the output are transformed.
+    assert len(_bindings(after, "relax.layout_transform")) == 4
+    assert after["main"].ret_struct_info.ndim == 4
+
+
+def test_transform_cost_keeps_layout():
+    # Blocking saves less than the layout transforms of the input and the output cost.
+    def fcost(call, data_layout, kernel_layout):
+        return 1e5 if data_layout == "NCHW" else 1e5 - 1e3
+
+    with tvm.target.Target("llvm"):
+        after = relax.transform.SelectLayout(fcost)(TwoConv)
+    tvm.ir.assert_structural_equal(after, TwoConv)
+
+
+def test_no_blocked_layout_without_target():
+    # The NCHW[x]c conv2d is only legalized under a target, so it is not selected without one.
+    def fcost(call, data_layout, kernel_layout):
+        assert not re.fullmatch(r"NCHW\d+c", data_layout)
+        return 1e5 if data_layout == "NCHW" else 1e3
+
+    after = relax.transform.SelectLayout(fcost)(TwoConv)
+    convs = _bindings(after, "relax.nn.conv2d")
+    assert [conv.value.attrs.data_layout for conv in convs] == ["NHWC", "NHWC"]
+    after = relax.transform.LegalizeOps()(after)
+    assert not _bindings(after, "relax.nn.conv2d")
+
+
+def test_keep_grouped_conv():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(x: R.Tensor((1, 16, 28, 28), "float32"), w: R.Tensor((16, 8, 3, 3), "float32")):
+            with R.dataflow():
+                a = R.nn.conv2d(x, w, padding=[1, 1, 1, 1], groups=2)
+                R.output(a)
+            return a
+
+    after = relax.transform.SelectLayout(lambda call, data_layout, kernel_layout: 0.0)(Module)
+    tvm.ir.assert_structural_equal(after, Module)
+
+
+def test_numerics_with_default_cost():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(
+            x: R.Tensor((1, 16, 7, 7), "float32"),
+            w1: R.Tensor((16, 16, 3, 3), "float32"),
+            w2: R.Tensor((16, 16, 3, 3), "float32"),
+        ):
+            with R.dataflow():
+                a = R.nn.conv2d(x, w1, padding=[1, 1, 1, 1])
+                b = R.nn.relu(a)
+                c = R.nn.conv2d(b, w2, padding=[1, 1, 1, 1])
+                R.output(c)
+            return c
+
+    target = tvm.target.Target("llvm")
+    with target:
+        after = relax.transform.SelectLayout()(Module)
+        # The output width 7 fills the vector lanes poorly, so the default cost blocks the
+        # channels by the vector width of the target.
+        convs = _bindings(after, "relax.nn.conv2d")
+        assert len(convs) == 2
+        for conv in convs:
+            assert re.fullmatch(r"NCHW\d+c", conv.value.attrs.data_layout)
+            assert re.fullmatch(r"OIHW\d+i\d+o", conv.value.attrs.kernel_layout)
+        after = relax.transform.LegalizeOps()(after)
+        assert not _bindings(after, "relax.nn.conv2d")
+
+    dev = tvm.cpu()
+    inputs = [
+        np.random.uniform(size=(1, 16, 7, 7)).astype("float32"),
+        np.random.uniform(size=(16, 16, 3, 3)).astype("float32"),
+        np.random.uniform(size=(16, 16, 3, 3)).astype("float32"),
+    ]
+    results = []
+    for mod in [Module, after]:
+        vm = relax.VirtualMachine(tvm.compile(mod, target=target), dev)
+        results.append(vm["main"](*[tvm.nd.array(x, dev) for x in inputs]).numpy())
+    tvm.testing.assert_allclose(results[0], results[1], rtol=1e-4, atol=1e-4)
+
+
+def test_legalize_blocked_conv_keeps_input_dtype():
+    @I.ir_module
+    class Module:
+        @R.function
+        def main(
+            x: R.Tensor((1, 4, 7, 7, 4), "float16"), w: R.Tensor((4, 4, 3, 3, 4, 4), "float16")
+        ):
+            with R.dataflow():
+                a = R.nn.conv2d(
+                    x,
+                    w,
+                    padding=[1, 1, 1, 1],
+                    data_layout="NCHW4c",
+                    kernel_layout="OIHW4i4o",
+                    out_layout="NCHW4c",
+                )
+                R.output(a)
+            return a
+
+    assert Module["main"].ret_struct_info.dtype == "float16"
+    with tvm.target.Target("llvm"):
+        after = relax.transform.LegalizeOps()(Module)
+    (prim_func,) = [func for func in after.functions.values() if isinstance(func, tvm.tir.PrimFunc)]
+    output = prim_func.buffer_map[prim_func.params[-1]]
+    assert output.dtype == "float16"
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
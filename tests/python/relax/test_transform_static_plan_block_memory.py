@@ -1545,5 +1545,151 @@ def test_with_dataflow():
     tvm.ir.assert_structural_equal(after, Expected)
 
 
+def test_offset_packing():
+    """Two small tensors share the space of a dead large tensor when packed by offset"""
+
+    @I.ir_module
+    class Before:
+        @T.prim_func
+        def exp(A: T.handle, B: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def add(A: T.handle, B: T.handle, C: T.handle):
+            T.evaluate(0)
+
+        @R.function
+        def main(
+            x: R.Tensor((64,), dtype="float32"), y: R.Tensor((16,), dtype="float32")
+        ) -> R.Tensor((16,), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Before
+            alloc: R.Tensor((64,), dtype="float32") = R.builtin.alloc_tensor(
+                R.shape([64]), R.dtype("float32"), R.prim_value(0), R.str("global")
+            )
+            cls.exp(x, alloc)
+            alloc1: R.Tensor((16,), dtype="float32") = R.builtin.alloc_tensor(
+                R.shape([16]), R.dtype("float32"), R.prim_value(0), R.str("global")
+            )
+            cls.exp(y, alloc1)
+            alloc2: R.Tensor((16,), dtype="float32") = R.builtin.alloc_tensor(
+                R.shape([16]), R.dtype("float32"), R.prim_value(0), R.str("global")
+            )
+            cls.exp(alloc1, alloc2)
+            alloc3: R.Tensor((16,), dtype="float32") = R.builtin.alloc_tensor(
+                R.shape([16]), R.dtype("float32"), R.prim_value(0), R.str("global")
+            )
+            cls.add(alloc1, alloc2, alloc3)
+            return alloc3
+
+    @I.ir_module
+    class Expected:
+        @T.prim_func
+        def exp(A: T.handle, B: T.handle):
+            T.evaluate(0)
+
+        @T.prim_func
+        def add(A: T.handle, B: T.handle, C: T.handle):
+            T.evaluate(0)
+
+        @R.function
+        def main(
+            x: R.Tensor((64,), dtype="float32"), y: R.Tensor((16,), dtype="float32")
+        ) -> R.Tensor((16,), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            cls = Expected
+            storage: R.Object = R.memory.alloc_storage(
+                R.shape([256]), R.prim_value(0), R.str("global"), R.dtype("float32")
+            )
+            alloc: R.Tensor((64,), dtype="float32") = R.memory.alloc_tensor(
+                storage, R.prim_value(0), R.shape([64]), R.dtype("float32")
+            )
+            cls.exp(x, alloc)
+            alloc1: R.Tensor((16,), dtype="float32") = R.memory.alloc_tensor(
+                storage, R.prim_value(0), R.shape([16]), R.dtype("float32")
+            )
+            cls.exp(y, alloc1)
+            alloc2: R.Tensor((16,), dtype="float32") = R.memory.alloc_tensor(
+                storage, R.prim_value(64), R.shape([16]), R.dtype("float32")
+            )
+            cls.exp(alloc1, alloc2)
+            alloc3: R.Tensor((16,), dtype="float32") = R.builtin.alloc_tensor(
+                R.shape([16]), R.dtype("float32"), R.prim_value(0), R.str("global")
+            )
+            cls.add(alloc1, alloc2, alloc3)
+            return alloc3
+
+    with tvm.transform.PassContext(config={"relax.StaticPlanBlockMemory.offset_packing": True}):
+        after = relax.transform.StaticPlanBlockMemory()(Before)
+    tvm.ir.assert_structural_equal(after, Expected)
+
+
+def test_offset_packing_symbolic_shape():
+    """Symbolic-size tensors are packed at symbolic offsets of one arena, and at constant
+    offsets once the shape has an upper bound"""
+
+    @I.ir_module
+    class Module:
+        @T.prim_func
+        def exp(A: T.handle, B: T.handle):
+            T.evaluate(0)
+
+        @R.function
+        def main(x: R.Tensor(("n",), dtype="float32")) -> R.Tensor(("n",), dtype="float32"):
+            R.func_attr({"relax.force_pure": True})
+            n = T.int64()
+            cls = Module
+            alloc: R.Tensor((n,), dtype="float32") = R.builtin.alloc_tensor(
+                R.shape([n]), R.dtype("float32"), R.prim_value(0), R.str("global")
+            )
+            cls.exp(x, alloc)
+            alloc1: R.Tensor((n,), dtype="float32") = R.builtin.alloc_tensor(
+                R.shape([n]), R.dtype("float32"), R.prim_value(0), R.str("global")
+            )
+            cls.exp(alloc, alloc1)
+            alloc2: R.Tensor((n,), dtype="float32") = R.builtin.alloc_tensor(
+                R.shape([n]), R.dtype("float32"), R.prim_value(0), R.str("global")
+            )
+            cls.exp(alloc1, alloc2)
+            alloc3: R.Tensor((n,), dtype="float32") = R.builtin.alloc_tensor(
+                R.shape([n]), R.dtype("float32"), R.prim_value(0), R.str("global")
+            )
+            cls.exp(alloc2, alloc3)
+            return alloc3
+
+    def plan(mod):
+        with tvm.transform.PassContext(
+            config={"relax.StaticPlanBlockMemory.offset_packing": True}
+        ):
+            after = relax.transform.StaticPlanBlockMemory()(mod)
+        bindings = {}
+        for block in after["main"].body.blocks:
+            for binding in block.bindings:
+                bindings[binding.var.name_hint] = binding.value
+        storages = [name for name in bindings if name.startswith("storage")]
+        assert len(storages) == 1
+        offsets = {}
+        for name in ["alloc", "alloc1", "alloc2"]:
+            assert bindings[name].op == tvm.ir.Op.get("relax.memory.alloc_tensor")
+            offsets[name] = bindings[name].args[1].value
+        assert bindings["alloc3"].op == tvm.ir.Op.get("relax.builtin.alloc_tensor")
+        return bindings[storages[0]].args[0].values[0], offsets
+
+    # Without an upper bound, alloc2 takes the slot of the dead alloc, after which alloc1 is placed.
+    size, offsets = plan(Module)
+    assert not isinstance(size, tvm.tir.IntImm)
+    assert offsets["alloc"].value == 0 and offsets["alloc2"].value == 0
+    assert not isinstance(offsets["alloc1"], tvm.tir.IntImm)
+
+    # With an upper bound, the sizes and the offsets are constant.
+    bounded = Module.clone()
+    bounded["main"] = bounded["main"].with_attr(
+        "tir_var_upper_bound", {"n": tvm.tir.IntImm("int64", 32)}
+    )
+    size, offsets = plan(bounded)
+    assert size.value == 256
+    assert [offsets[name].value for name in ["alloc", "alloc1", "alloc2"]] == [0, 128, 0]
+
+
 if __name__ == "__main__":
     tvm.testing.main()
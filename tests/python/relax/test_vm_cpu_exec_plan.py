@@ -0,0 +1,146 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import numpy as np
+
+import tvm
+import tvm.testing
+from tvm import relax
+from tvm.script import ir as I
+from tvm.script import relax as R
+from tvm.script import tir as T
+
+
+@I.ir_module
+class Module:
+    @R.function
+    def main(x: R.Tensor((16, 16), dtype="float32")) -> R.Tensor((16, 16), dtype="float32"):
+        with R.dataflow():
+            lv0 = R.add(x, R.const(1, "float32"))
+            lv1 = R.multiply(lv0, R.const(2, "float32"))
+            lv2 = R.add(lv1, R.const(1, "float32"))
+            lv3 = R.multiply(lv2, R.const(2, "float32"))
+            gv = R.add(lv3, x)
+            R.output(gv)
+        return gv
+
+
+def build(mod):
+    with tvm.transform.PassContext(config={"relax.backend.use_cpu_exec_plan": True}):
+        return tvm.compile(mod, target="llvm")
+
+
+def test_rewrite_to_cpu_exec_plan():
+    with tvm.transform.PassContext(config={"relax.backend.use_cpu_exec_plan": True}):
+        after = tvm.ir.transform.Sequential(
+            [
+                relax.transform.LegalizeOps(),
+                relax.transform.ToNonDataflow(),
+                relax.transform.RemovePurityChecking(),
+                relax.transform.CallTIRRewrite(),
+                relax.transform.StaticPlanBlockMemory(),
+                relax.transform.RewriteCPUExecPlan(),
+            ]
+        )(Module)
+    assert "cpu_exec_plan_alloc" in [gv.name_hint for gv in after.get_global_vars()]
+    assert "main_cpu_exec_plan_capture" in [gv.name_hint for gv in after.get_global_vars()]
+    assert "vm.builtin.cpu_exec_plan.run_or_capture" in after["main"].script()
+    assert "vm.builtin.cuda_graph" not in after.script()
+
+
+def test_vm_run_and_replay():
+    ex = build(Module)
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    # The first call captures the plan and the later ones replay it with new inputs.
+    for _ in range(3):
+        x_np = np.random.uniform(size=(16, 16)).astype("float32")
+        y = vm["main"](tvm.nd.array(x_np, tvm.cpu()))
+        y_np = ((x_np + 1) * 2 + 1) * 2 + x_np
+        tvm.testing.assert_allclose(y.numpy(), y_np, rtol=1e-5, atol=1e-5)
+
+
+def test_cpu_pipeline_ignores_cuda_graph_config():
+    x_np = np.random.uniform(size=(16, 16)).astype("float32")
+    y_np = ((x_np + 1) * 2 + 1) * 2 + x_np
+    for use_cpu_exec_plan in [False, True]:
+        config = {
+            "relax.backend.use_cuda_graph": True,
+            "relax.backend.use_cpu_exec_plan": use_cpu_exec_plan,
+        }
+        with tvm.transform.PassContext(config=config):
+            after = relax.get_default_pipeline(tvm.target.Target("llvm"))(Module)
+            ex = tvm.compile(Module, target="llvm")
+        assert "vm.builtin.cuda_graph" not in after.script()
+        assert ("vm.builtin.cpu_exec_plan" in after.script()) == use_cpu_exec_plan
+        vm = relax.VirtualMachine(ex, tvm.cpu())
+        y = vm["main"](tvm.nd.array(x_np, tvm.cpu()))
+        tvm.testing.assert_allclose(y.numpy(), y_np, rtol=1e-5, atol=1e-5)
+
+
+def test_vm_replay_symbolic_shape():
+    @I.ir_module
+    class SymbolicModule:
+        @T.prim_func(private=True)
+        def add_n(x_handle: T.handle, y_handle: T.handle, n: T.int64):
+            m = T.int64()
+            x = T.match_buffer(x_handle, (m,), "float32")
+            y = T.match_buffer(y_handle, (m,), "float32")
+            for i in range(m):
+                with T.block("add"):
+                    vi = T.axis.remap("S", [i])
+                    y[vi] = x[vi] + T.Cast("float32", n)
+
+        @R.function
+        def main(x: R.Tensor(("m",), "float32")) -> R.Tensor(("m",), "float32"):
+            R.func_attr(
+                {
+                    "tir_var_upper_bound": {"m": 16},
+                    "relax.rewrite_cuda_graph.capture_symbolic_vars": ["m"],
+                }
+            )
+            m = T.int64()
+            cls = SymbolicModule
+            with R.dataflow():
+                lv0 = R.call_tir(
+                    cls.add_n, (x,), out_sinfo=R.Tensor((m,), "float32"), tir_vars=R.shape([m])
+                )
+                lv1 = R.call_tir(
+                    cls.add_n, (lv0,), out_sinfo=R.Tensor((m,), "float32"), tir_vars=R.shape([m])
+                )
+                lv2 = R.call_tir(
+                    cls.add_n, (lv1,), out_sinfo=R.Tensor((m,), "float32"), tir_vars=R.shape([m])
+                )
+                gv = R.add(lv2, x)
+                R.output(gv)
+            return gv
+
+    with tvm.transform.PassContext(config={"relax.backend.use_cpu_exec_plan": True}):
+        after = relax.get_default_pipeline(tvm.target.Target("llvm"))(SymbolicModule)
+    # The kernels with tir_vars are launched by vm.builtin.call_tir_dyn inside the region.
+    assert "vm.builtin.call_tir_dyn" in after["main_cpu_exec_plan_capture"].script()
+
+    ex = build(SymbolicModule)
+    vm = relax.VirtualMachine(ex, tvm.cpu())
+    # A plan is captured for each value of m and replayed with new inputs.
+    for m in [8, 16, 8, 16, 8]:
+        x_np = np.random.uniform(size=(m,)).astype("float32")
+        y = vm["main"](tvm.nd.array(x_np, tvm.cpu()))
+        tvm.testing.assert_allclose(y.numpy(), 2 * x_np + 3 * m, rtol=1e-5, atol=1e-5)
+
+
+if __name__ == "__main__":
+    tvm.testing.main()
@@ -17,10 +17,12 @@
 import time
 import ctypes
 
+import numpy as np
+
 import tvm
 from tvm import te
 from tvm.contrib.utils import tempdir
-from tvm.runtime.module import BenchmarkResult
+from tvm.runtime.module import AdaptiveBenchmarkResult, BenchmarkResult
 
 
 def test_min_repeat_ms():
@@ -65,6 +67,52 @@ def test_benchmark_result():
     assert r.std == 1.5
 
 
+def test_adaptive_time_evaluator():
+    n = 4096
+    A = te.placeholder((n,), name="A")
+    B = te.compute((n,), lambda i: A[i] + 1.0, name="B")
+    C = te.compute((n,), lambda i: A[i] * 2.0, name="C")
+    mod = tvm.IRModule(
+        {
+            "add_one": te.create_prim_func([A, B]).with_attr("global_symbol", "add_one"),
+            "mul_two": te.create_prim_func([A, C]).with_attr("global_symbol", "mul_two"),
+        }
+    )
+    func = tvm.tir.build(mod)
+
+    a = tvm.nd.array(np.random.uniform(size=n).astype(A.dtype))
+    b = tvm.nd.empty((n,), A.dtype)
+    ftimer = func.adaptive_time_evaluator(
+        ["add_one", "mul_two"], tvm.cpu(), min_repeat=3, max_repeat=20, target_rel_ci=1e9
+    )
+    results = ftimer(a, b)
+    assert len(results) == 2
+    for r in results:
+        # A huge target converges as soon as the minimum number of samples is reached.
+        assert r.converged
+        assert len(r.results) == 3
+        assert r.number >= 1
+        assert r.mean > 0
+
+    ftimer = func.adaptive_time_evaluator(
+        "add_one", tvm.cpu(), min_repeat=2, max_repeat=4, target_rel_ci=1e-12
+    )
+    (r,) = ftimer(a, b)
+    assert len(r.results) == 4
+    assert not r.converged
+
+
+def test_adaptive_benchmark_result():
+    r = AdaptiveBenchmarkResult([1, 2, 2, 2, 3, 2, 100], number=10, converged=False, ci=0.5)
+    assert r.median == 2.0
+    assert r.percentiles[50] == 2.0
+    assert r.num_outliers == 2
+    assert r.number == 10
+    assert not r.converged
+
+
 if __name__ == "__main__":
     test_min_repeat_ms()
     test_benchmark_result()
+    test_adaptive_time_evaluator()
+    test_adaptive_benchmark_result()
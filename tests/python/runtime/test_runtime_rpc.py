@@ -17,7 +17,9 @@
 
 import multiprocessing
 import os
+import socket
 import stat
+import subprocess
 import sys
 import tempfile
 import time
@@ -160,6 +162,64 @@ def test_rpc_large_array():
     check_remote()
 
 
+@tvm.testing.requires_rpc
+def test_rpc_compressed_array(monkeypatch):
+    # Compression is negotiated on the first large copy of the session.
+    monkeypatch.setenv("TVM_RPC_COMPRESSION", "1")
+    server = rpc.Server()
+    remote = rpc.connect("127.0.0.1", server.port)
+    dev = remote.cpu(0)
+
+    # Spans several compressed frames, one of them partial.
+    a_np = np.tile(np.arange(1000, dtype="float32"), 2600)
+    # Random data does not compress and falls back to plain copies.
+    b_np = np.random.uniform(size=(300, 1000)).astype("float32")
+    c_np = np.arange(16, dtype="int32")
+    for x_np in [a_np, b_np, c_np]:
+        x = tvm.nd.array(x_np, dev)
+        np.testing.assert_equal(x.numpy(), x_np)
+
+
+@tvm.testing.requires_rpc
+def test_rpc_multiplexed_session():
+    import threading  # pylint: disable=import-outside-toplevel
+
+    server = rpc.Server()
+    remote = rpc.connect("127.0.0.1", server.port, num_streams=4)
+    fbarrier = remote.get_function("rpc.test.barrier")
+    faddone = remote.get_function("rpc.test.addone")
+
+    # Calls from different threads are in flight at the same time: the remote
+    # barrier only releases once all four calls have reached it, and times out
+    # with an error if the calls were serialized.
+    results = [None] * 4
+    errors = []
+
+    def worker(i):
+        try:
+            assert fbarrier("multiplexed_session", 4, 60.0)
+            results[i] = faddone(i)
+        except Exception as err:  # pylint: disable=broad-except
+            errors.append(err)
+
+    threads = [threading.Thread(target=worker, args=(i,)) for i in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert not errors, errors
+    assert results == [i + 1 for i in range(4)]
+
+    # Remote handles are shared by all the streams.
+    x_np = np.arange(1024, dtype="float32")
+    x = tvm.nd.array(x_np, remote.cpu(0))
+    y = [None]
+    thread = threading.Thread(target=lambda: y.__setitem__(0, x.numpy()))
+    thread.start()
+    thread.join()
+    np.testing.assert_equal(y[0], x_np)
+
+
 @tvm.testing.skip_if_32bit(reason="skipping test for i386.")
 @tvm.testing.requires_rpc
 def test_rpc_echo():
@@ -626,6 +686,77 @@ def test_rpc_tracker_via_proxy(device_key):
     tracker_server.terminate()
 
 
+def _find_cpp_rpc():
+    # tvm_rpc is built next to libtvm when USE_CPP_RPC is on.
+    lib_dir = os.path.dirname(tvm.libinfo.find_lib_path()[0])
+    path = os.path.join(lib_dir, "tvm_rpc")
+    return path if os.path.isfile(path) else None
+
+
+def _free_port():
+    with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as sock:
+        sock.bind(("127.0.0.1", 0))
+        return sock.getsockname()[1]
+
+
+def _wait_for_port(port, timeout=30):
+    deadline = time.time() + timeout
+    while True:
+        try:
+            socket.create_connection(("127.0.0.1", port), timeout=1).close()
+            return
+        except OSError:
+            if time.time() > deadline:
+                raise
+            time.sleep(0.1)
+
+
+@tvm.testing.requires_rpc
+def test_cpp_rpc_tracker_via_proxy():
+    """
+       C++ tracker
+         /     \
+    Host   --   C++ proxy -- RPC server
+    """
+    tvm_rpc = _find_cpp_rpc()
+    if tvm_rpc is None:
+        pytest.skip("tvm_rpc is not built, set USE_CPP_RPC=ON")
+
+    tracker_port = _free_port()
+    proxy_port = _free_port()
+    tracker_addr = ("127.0.0.1", tracker_port)
+    tracker = subprocess.Popen(
+        [tvm_rpc, "tracker", "--host=127.0.0.1", f"--port={tracker_port}"]
+        + [f"--port-end={tracker_port + 1}"]
+    )
+    proxy = subprocess.Popen(
+        [tvm_rpc, "proxy", "--host=127.0.0.1", f"--port={proxy_port}"]
+        + [f"--port-end={proxy_port + 1}", f"--tracker=127.0.0.1:{tracker_port}"]
+    )
+    server = None
+    try:
+        _wait_for_port(tracker_port)
+        _wait_for_port(proxy_port)
+        server = rpc.Server(
+            host="127.0.0.1",
+            port=proxy_port,
+            key="cpp_proxy",
+            tracker_addr=tracker_addr,
+            is_proxy=True,
+        )
+        client = rpc.connect_tracker(*tracker_addr)
+        remote = client.request("cpp_proxy", session_timeout=30)
+        assert remote.get_function("rpc.test.addone")(10) == 11
+        x_np = np.arange(1024, dtype="float32")
+        np.testing.assert_equal(tvm.nd.array(x_np, remote.cpu(0)).numpy(), x_np)
+    finally:
+        if server is not None:
+            server.terminate()
+        for proc in (proxy, tracker):
+            proc.terminate()
+            proc.wait()
+
+
 @tvm.testing.requires_rpc
 @pytest.mark.parametrize("with_proxy", (True, False))
 def test_rpc_session_timeout_error(with_proxy):
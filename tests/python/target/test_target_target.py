@@ -74,6 +74,8 @@ def test_target_llvm_jit_options():
     assert target.attrs["jit"] == "mcjit"
     target = tvm.target.Target("llvm -jit=orcjit")
     assert target.attrs["jit"] == "orcjit"
+    target = tvm.target.Target("llvm -jit=orcjit-lazy")
+    assert target.attrs["jit"] == "orcjit-lazy"
 
 
 def test_target_llvm_vector_width():